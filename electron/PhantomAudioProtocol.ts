@@ -0,0 +1,157 @@
+/**
+ * PhantomAudioProtocol - Decoder for the phantom-audio stdout stream.
+ *
+ * phantom-audio starts out speaking newline-delimited JSON (protocol v1).
+ * After a {"cmd":"hello","protocol":2} handshake the reply is the last JSON
+ * line and the rest of the stream is length-prefixed binary frames, see
+ * native/phantom-audio/src/json_protocol.h for the layout.
+ */
+
+import { Buffer } from "buffer";
+
+export const PROTOCOL_VERSION = 2;
+export const FRAME_HEADER_BYTES = 16;
+
+export enum FrameType {
+  Event = 1,
+  AudioF32 = 2,
+  Flac = 3,
+  AudioS16 = 4,
+}
+
+export type PcmFormat = "f32" | "s16";
+
+// Flags carried by Flac frames (and the "flags" field of JSON flac events)
+export const FLAC_SEGMENT_START = 0x01;
+export const FLAC_SEGMENT_END = 0x02;
+
+export interface AudioFrame {
+  type: FrameType;
+  flags: number;
+  streamId: number;
+  timestampUs: number;
+  payload: Buffer;
+}
+
+export interface ProtocolMessage {
+  type: string;
+  [key: string]: any;
+}
+
+/**
+ * Convert float32 LE PCM to int16 LE (full scale 32768, rounded and
+ * saturated the same way as the native floatToS16 kernel)
+ */
+export function f32ToS16(pcm: Buffer): Buffer {
+  const count = Math.floor(pcm.length / 4);
+  const out = Buffer.alloc(count * 2);
+  for (let i = 0; i < count; i++) {
+    const scaled = pcm.readFloatLE(i * 4) * 32768;
+    const clamped = scaled >= -32768 ? Math.min(32767, scaled) : -32768;
+    out.writeInt16LE(roundHalfEven(clamped), i * 2);
+  }
+  return out;
+}
+
+function roundHalfEven(value: number): number {
+  const floor = Math.floor(value);
+  const diff = value - floor;
+  if (diff > 0.5) return floor + 1;
+  if (diff < 0.5) return floor;
+  return floor % 2 === 0 ? floor : floor + 1;
+}
+
+interface DecoderHandlers {
+  onMessage: (msg: ProtocolMessage) => void;
+  onAudio: (frame: AudioFrame) => void;
+  onInvalid?: (line: string) => void;
+}
+
+export class PhantomAudioStreamDecoder {
+  private buffer: Buffer = Buffer.alloc(0);
+  private binary = false;
+
+  constructor(private handlers: DecoderHandlers) {}
+
+  /**
+   * Whether the stream has switched to binary framing
+   */
+  isBinary(): boolean {
+    return this.binary;
+  }
+
+  /**
+   * Drop buffered bytes and return to line mode (new process)
+   */
+  reset(): void {
+    this.buffer = Buffer.alloc(0);
+    this.binary = false;
+  }
+
+  /**
+   * Feed a chunk of stdout data
+   */
+  push(data: Buffer | string): void {
+    const chunk = typeof data === "string" ? Buffer.from(data) : data;
+    this.buffer = this.buffer.length ? Buffer.concat([this.buffer, chunk]) : chunk;
+
+    let offset = 0;
+    while (offset < this.buffer.length) {
+      const consumed = this.binary ? this.readFrame(offset) : this.readLine(offset);
+      if (consumed === 0) break;
+      offset += consumed;
+    }
+
+    this.buffer = offset > 0 ? this.buffer.subarray(offset) : this.buffer;
+  }
+
+  private readLine(offset: number): number {
+    const newline = this.buffer.indexOf(0x0a, offset);
+    if (newline === -1) return 0;
+
+    const line = this.buffer.toString("utf8", offset, newline).trim();
+    if (line) {
+      try {
+        const msg: ProtocolMessage = JSON.parse(line);
+        if (msg.type === "hello" && msg.framing === "binary") {
+          this.binary = true;
+        }
+        this.handlers.onMessage(msg);
+      } catch (error) {
+        this.handlers.onInvalid?.(line);
+      }
+    }
+
+    return newline - offset + 1;
+  }
+
+  private readFrame(offset: number): number {
+    if (this.buffer.length - offset < FRAME_HEADER_BYTES) return 0;
+
+    const payloadLength = this.buffer.readUInt32LE(offset);
+    const total = FRAME_HEADER_BYTES + payloadLength;
+    if (this.buffer.length - offset < total) return 0;
+
+    const type = this.buffer.readUInt8(offset + 4) as FrameType;
+    const flags = this.buffer.readUInt8(offset + 5);
+    const streamId = this.buffer.readUInt16LE(offset + 6);
+    const timestampUs =
+      this.buffer.readUInt32LE(offset + 12) * 0x100000000 + this.buffer.readUInt32LE(offset + 8);
+    const payloadStart = offset + FRAME_HEADER_BYTES;
+    // Copy so the frame does not pin the whole receive buffer
+    const payload = Buffer.from(this.buffer.subarray(payloadStart, payloadStart + payloadLength));
+
+    if (type === FrameType.Event) {
+      const json = payload.toString("utf8");
+      try {
+        this.handlers.onMessage(JSON.parse(json));
+      } catch (error) {
+        this.handlers.onInvalid?.(json);
+      }
+    } else {
+      this.handlers.onAudio({ type, flags, streamId, timestampUs, payload });
+    }
+
+    return total;
+  }
+}
@@ -0,0 +1,152 @@
+/**
+ * SharedAudioRingReader - Reads 16kHz audio that phantom-audio publishes into
+ * its shared-memory ring (PHANTOM_AUDIO_TRANSPORT=shm).
+ *
+ * Node cannot map shared memory without an addon, so the ring is read through
+ * its backing file (/dev/shm/<name> on Linux, a temporary file on Windows).
+ * The layout mirrors SharedAudioRingHeader in
+ * native/phantom-audio/src/shared_audio_ring.h.
+ */
+
+import fs from "fs";
+import { Buffer } from "buffer";
+import { PcmFormat } from "./PhantomAudioProtocol";
+
+const RING_MAGIC = "PHAURING";
+const RING_VERSION = 2;
+const VERSION_OFFSET = 8;
+const FORMAT_OFFSET = 28;
+const WRITE_SEQ_OFFSET = 32;
+const CLAIM_SEQ_OFFSET = 48;
+const FORMAT_S16 = 2;
+
+export interface SharedRingInfo {
+  name: string;
+  path: string;
+  capacity: number;
+  sample_rate: number;
+  format?: PcmFormat;
+  header_bytes: number;
+}
+
+export class SharedAudioRingReader {
+  private fd: number | null = null;
+  private readSeq = 0;
+  private header = Buffer.alloc(64);
+  private pollTimer: NodeJS.Timeout | null = null;
+  private droppedSamples = 0;
+  private format: PcmFormat = "f32";
+  private bytesPerSample = 4;
+
+  constructor(private info: SharedRingInfo, private onAudio: (pcm: Buffer, format: PcmFormat) => void) {}
+
+  /**
+   * Open the ring; reading starts at the current write position
+   */
+  open(): void {
+    this.fd = fs.openSync(this.info.path, "r");
+    this.readHeader();
+    if (this.header.toString("latin1", 0, 8) !== RING_MAGIC) {
+      this.close();
+      throw new Error(`Not a phantom-audio ring: ${this.info.path}`);
+    }
+    if (this.header.readUInt32LE(VERSION_OFFSET) !== RING_VERSION) {
+      this.close();
+      throw new Error(`Unsupported ring version: ${this.info.path}`);
+    }
+    this.format = this.header.readUInt32LE(FORMAT_OFFSET) === FORMAT_S16 ? "s16" : "f32";
+    this.bytesPerSample = this.format === "s16" ? 2 : 4;
+    this.readSeq = this.readWriteSeq();
+  }
+
+  /**
+   * Poll the ring periodically
+   */
+  startPolling(intervalMs: number = 50): void {
+    this.stopPolling();
+    this.pollTimer = setInterval(() => this.drain(), intervalMs);
+  }
+
+  stopPolling(): void {
+    if (this.pollTimer) {
+      clearInterval(this.pollTimer);
+      this.pollTimer = null;
+    }
+  }
+
+  getDroppedSamples(): number {
+    return this.droppedSamples;
+  }
+
+  /**
+   * Copy everything published since the last call and hand it to onAudio
+   */
+  drain(): void {
+    if (this.fd === null) return;
+
+    const capacity = this.info.capacity;
+    const writeSeq = this.readHeader();
+    if (writeSeq - this.readSeq > capacity) {
+      this.droppedSamples += writeSeq - capacity - this.readSeq;
+      this.readSeq = writeSeq - capacity;
+    }
+
+    const count = writeSeq - this.readSeq;
+    if (count === 0) return;
+
+    const pcm = Buffer.alloc(count * this.bytesPerSample);
+    const start = this.readSeq % capacity;
+    const first = Math.min(count, capacity - start);
+    this.readSamples(pcm, 0, start, first);
+    if (first < count) {
+      this.readSamples(pcm, first * this.bytesPerSample, 0, count - first);
+    }
+
+    // Discard the copy if any write, even one still in progress, reached
+    // the range we just read
+    this.readHeader();
+    const claimed = this.readSeqAt(CLAIM_SEQ_OFFSET);
+    if (claimed - this.readSeq > capacity) {
+      this.droppedSamples += claimed - capacity - this.readSeq;
+      this.readSeq = claimed - capacity;
+      return;
+    }
+
+    this.readSeq = writeSeq;
+    this.onAudio(pcm, this.format);
+  }
+
+  close(): void {
+    this.stopPolling();
+    if (this.fd !== null) {
+      fs.closeSync(this.fd);
+      this.fd = null;
+    }
+  }
+
+  private readHeader(): number {
+    fs.readSync(this.fd as number, this.header, 0, this.header.length, 0);
+    return this.readWriteSeq();
+  }
+
+  private readWriteSeq(): number {
+    return this.readSeqAt(WRITE_SEQ_OFFSET);
+  }
+
+  private readSeqAt(offset: number): number {
+    // uint64 sample counter; exact as a double for ~17,000 years of audio
+    const low = this.header.readUInt32LE(offset);
+    const high = this.header.readUInt32LE(offset + 4);
+    return high * 0x100000000 + low;
+  }
+
+  private readSamples(target: Buffer, targetOffset: number, startSample: number, count: number): void {
+    fs.readSync(
+      this.fd as number,
+      target,
+      targetOffset,
+      count * this.bytesPerSample,
+      this.info.header_bytes + startSample * this.bytesPerSample
+    );
+  }
+}
@@ -9,11 +9,69 @@ import path from "path";
 import fs from "fs";
 import https from "https";
 import { Buffer } from "buffer";
+import {
+  AudioFrame,
+  f32ToS16,
+  FLAC_SEGMENT_END,
+  FLAC_SEGMENT_START,
+  FrameType,
+  PcmFormat,
+  PhantomAudioStreamDecoder,
+  PROTOCOL_VERSION,
+} from "./PhantomAudioProtocol";
+import { SharedAudioRingReader, SharedRingInfo } from "./SharedAudioRingReader";
 
-interface TranscriptMessage {
-  type: "ready" | "started" | "stopped" | "partial" | "final" | "error" | "audio";
+/**
+ * Live transcription settings accepted by {"cmd":"config"}; omitted fields
+ * are left unchanged.
+ */
+export interface TranscriptionConfig {
+  chunk_ms?: number;
+  threads?: number;
+  beam_size?: number;
+  language?: string;
+  vad?: "off" | "normal" | "aggressive";
+  context_tokens?: number;
+  decode_budget_ms?: number;
+  denoise?: boolean;
+  silence_flush_ms?: number;
+}
+
+interface TranscriptMessage extends TranscriptionConfig {
+  type:
+    | "ready"
+    | "hello"
+    | "shm"
+    | "started"
+    | "stopped"
+    | "partial"
+    | "final"
+    | "error"
+    | "audio"
+    | "flac"
+    | "config"
+    | "metrics"
+    | "trace"
+    | "silence";
   text?: string;
+  segment?: number;
+  keep?: number;
   message?: string;
+  data?: string;
+  format?: PcmFormat;
+  flags?: number;
+  protocol?: number;
+  framing?: "json" | "binary";
+  audio_format?: PcmFormat | "flac";
+  enabled?: boolean;
+  simd?: string;
+  kernels?: Record<string, string>;
+  path?: string;
+  events?: number;
+  dropped?: number;
+  start_ms?: number;
+  duration_ms?: number;
+  samples?: number;
 }
 
 interface SystemAudioState {
@@ -30,7 +88,15 @@ export class SystemAudioHelper {
     isReady: false,
     lastError: null,
   };
-  private dataBuffer: string = "";
+  private decoder = new PhantomAudioStreamDecoder({
+    onMessage: (msg) => {
+      this.handleMessage(msg as TranscriptMessage).catch((error) => {
+        console.error("[SystemAudio] Failed to handle message:", error);
+      });
+    },
+    onAudio: (frame) => this.handleAudioFrame(frame),
+    onInvalid: (line) => console.warn("[SystemAudio] Failed to parse message:", line),
+  });
   private idleTimer: NodeJS.Timeout | null = null;
   private lastStopTime: number | null = null;
   private static readonly IDLE_TIMEOUT_MS = 10 * 60 * 1000; // 10 minutes
@@ -38,14 +104,19 @@ export class SystemAudioHelper {
   private groqModel: string | null = null;
   private groqApiKey: string | null = null;
   private cloudAudioBuffers: Buffer[] = [];
+  private audioRingReader: SharedAudioRingReader | null = null;
   private pendingCloudStopResolve: (() => void) | null = null;
   private cloudStreamBuffers: Buffer[] = [];
   private cloudStreamProcessing: Promise<void> | null = null;
   private cloudStreamLastSend = 0;
   private cloudStreamProcessedBytes = 0;
+  private flacNegotiated = false;
+  private flacSegmentParts: Buffer[] = [];
+  private flacUploads: Promise<void> = Promise.resolve();
   private static readonly CLOUD_STREAM_MIN_DURATION_MS = 20 * 60 * 1000; // 20 minutes per chunk to stay under 25MB limits after downsampling
   private static readonly CLOUD_STREAM_FORCE_INTERVAL_MS = 20 * 60 * 1000;
-  private static readonly CLOUD_AUDIO_BYTES_PER_SECOND = 16000 * 4; // 16kHz mono float32
+  private static readonly CLOUD_AUDIO_BYTES_PER_SECOND = 16000 * 2; // 16kHz mono int16
+  private static readonly AUDIO_BATCH_MS = 100; // Batch 10ms capture packets into 100ms frames
 
   constructor() {}
 
@@ -328,12 +399,12 @@ export class SystemAudioHelper {
   }
 
   /**
-   * Convert raw float32 mono PCM to a minimal WAV buffer
+   * Wrap raw int16 mono PCM in a minimal WAV buffer
    */
   private toWaveBuffer(pcm: Buffer): Buffer {
     const sampleRate = 16000;
     const numChannels = 1;
-    const bitsPerSample = 32;
+    const bitsPerSample = 16;
     const byteRate = sampleRate * numChannels * (bitsPerSample / 8);
     const blockAlign = numChannels * (bitsPerSample / 8);
     const dataSize = pcm.length;
@@ -344,7 +415,7 @@ export class SystemAudioHelper {
     buffer.write("WAVE", 8);
     buffer.write("fmt ", 12);
     buffer.writeUInt32LE(16, 16); // PCM header size
-    buffer.writeUInt16LE(3, 20); // WAVE_FORMAT_IEEE_FLOAT
+    buffer.writeUInt16LE(1, 20); // WAVE_FORMAT_PCM
     buffer.writeUInt16LE(numChannels, 22);
     buffer.writeUInt32LE(sampleRate, 24);
     buffer.writeUInt32LE(byteRate, 28);
@@ -358,14 +429,14 @@ export class SystemAudioHelper {
   }
 
   /**
-   * Downsample float32 PCM to 16-bit mono WAV (default 8 kHz) to reduce upload size.
+   * Downsample int16 PCM to 16-bit mono WAV (default 8 kHz) to reduce upload size.
    */
   private toDownsampledWav16(pcm: Buffer, targetSampleRate: number = 8000): Buffer {
     const sourceSampleRate = 16000;
     const downsampleFactor = Math.max(1, Math.round(sourceSampleRate / targetSampleRate));
     const actualSampleRate = Math.floor(sourceSampleRate / downsampleFactor);
 
-    const totalSamples = Math.floor(pcm.length / 4);
+    const totalSamples = Math.floor(pcm.length / 2);
     const downsampledSamples = Math.floor(totalSamples / downsampleFactor);
     const dataSize = downsampledSamples * 2; // int16
     const buffer = Buffer.alloc(44 + dataSize);
@@ -385,14 +456,10 @@ export class SystemAudioHelper {
     buffer.write("data", 36);
     buffer.writeUInt32LE(dataSize, 40);
 
-    // Downsample and convert to int16
+    // Downsample
     let writeOffset = 44;
     for (let i = 0; i < downsampledSamples; i++) {
-      const srcIndex = i * downsampleFactor * 4;
-      const sample = pcm.readFloatLE(srcIndex);
-      const clamped = Math.max(-1, Math.min(1, sample));
-      const int16 = clamped < 0 ? clamped * 0x8000 : clamped * 0x7fff;
-      buffer.writeInt16LE(int16, writeOffset);
+      buffer.writeInt16LE(pcm.readInt16LE(i * downsampleFactor * 2), writeOffset);
       writeOffset += 2;
     }
 
@@ -400,7 +467,7 @@ export class SystemAudioHelper {
   }
 
   /**
-   * "Convert" raw float32 PCM to FLAC.
+   * "Convert" raw int16 PCM to FLAC.
    * In this environment ffmpeg is not available, so this helper simply passes
    * through the PCM and signals that FLAC encoding was not performed.
    * Callers then wrap the PCM in a downsampled WAV via toDownsampledWav16.
@@ -586,6 +653,17 @@ export class SystemAudioHelper {
       return { success: true, data: this.state };
     });
 
+    // Retune local transcription without restarting the process
+    ipcMain.handle("system-audio:configure", async (_event, config: TranscriptionConfig) => {
+      try {
+        this.configure(config);
+        return { success: true };
+      } catch (error: any) {
+        console.error("[SystemAudio] Configure error:", error);
+        return { success: false, error: error.message || String(error) };
+      }
+    });
+
     // Check if system audio is available
     ipcMain.handle("system-audio:check-availability", async () => {
       const check = await this.checkRequirements(false);
@@ -613,6 +691,7 @@ export class SystemAudioHelper {
     this.cloudStreamProcessing = null;
     this.cloudStreamLastSend = Date.now();
     this.cloudStreamProcessedBytes = 0;
+    this.flacSegmentParts = [];
 
     if (this.isCloudMode && !this.groqApiKey) {
       throw new Error("Groq API key is missing. Set it in Settings before enabling cloud whisper.");
@@ -657,7 +736,8 @@ export class SystemAudioHelper {
           env,
         });
 
-        this.dataBuffer = "";
+        this.decoder.reset();
+        this.flacNegotiated = false;
 
         // Handle stdout (JSON messages)
         this.audioProcess.stdout.on("data", (data: Buffer) => {
@@ -672,6 +752,7 @@ export class SystemAudioHelper {
         // Handle process exit
         this.audioProcess.on("exit", (code, signal) => {
           console.log(`[SystemAudio] Process exited with code ${code}, signal ${signal}`);
+          this.closeAudioRing();
           this.audioProcess = null;
           this.state.isCapturing = false;
           this.state.isReady = false;
@@ -771,6 +852,8 @@ export class SystemAudioHelper {
     // Give it a moment to exit gracefully
     await new Promise((resolve) => setTimeout(resolve, 500));
 
+    this.closeAudioRing();
+
     // Force kill if still running
     if (this.audioProcess) {
       this.audioProcess.kill("SIGTERM");
@@ -781,6 +864,17 @@ export class SystemAudioHelper {
     this.state.isReady = false;
   }
 
+  /**
+   * Change local transcription settings. They apply from the next chunk and
+   * are confirmed by a "config" event (or rejected with an "error" event).
+   */
+  configure(config: TranscriptionConfig): void {
+    if (!this.audioProcess) {
+      throw new Error("Audio process is not running");
+    }
+    this.sendCommand({ cmd: "config", ...config });
+  }
+
   /**
    * Send a command to the audio process
    */
@@ -798,23 +892,108 @@ export class SystemAudioHelper {
    * Handle stdout data from the audio process
    */
   private handleStdout(data: Buffer): void {
-    this.dataBuffer += data.toString();
+    // JSON lines until the hello handshake, binary frames afterwards
+    this.decoder.push(data);
+  }
 
-    // Process complete lines
-    const lines = this.dataBuffer.split("\n");
-    this.dataBuffer = lines.pop() || "";
+  /**
+   * Handle a binary audio frame (protocol v2)
+   */
+  private handleAudioFrame(frame: AudioFrame): void {
+    if (frame.type === FrameType.Flac) {
+      this.handleFlacPayload(frame.payload, frame.flags);
+    } else {
+      this.handleAudioPayload(frame.payload, frame.type === FrameType.AudioS16 ? "s16" : "f32");
+    }
+  }
 
-    for (const line of lines) {
-      if (!line.trim()) continue;
+  /**
+   * Attach to the shared-memory audio ring announced by phantom-audio.
+   * Enabled by launching with PHANTOM_AUDIO_TRANSPORT=shm (inherited by the child).
+   */
+  private openAudioRing(info: SharedRingInfo): void {
+    this.closeAudioRing();
+    if (!info.path) {
+      console.warn(`[SystemAudio] Shared ring ${info.name} has no readable path`);
+      return;
+    }
 
-      try {
-        const msg: TranscriptMessage = JSON.parse(line);
-        this.handleMessage(msg).catch((error) => {
-          console.error("[SystemAudio] Failed to handle message:", error);
-        });
-      } catch (error) {
-        console.warn("[SystemAudio] Failed to parse message:", line);
-      }
+    try {
+      const reader = new SharedAudioRingReader(info, (pcm, format) => this.handleAudioPayload(pcm, format));
+      reader.open();
+      reader.startPolling();
+      this.audioRingReader = reader;
+      console.log(`[SystemAudio] Reading audio from shared ring ${info.name}`);
+    } catch (error) {
+      console.warn("[SystemAudio] Failed to open shared audio ring:", error);
+    }
+  }
+
+  private closeAudioRing(): void {
+    if (this.audioRingReader) {
+      this.audioRingReader.close();
+      this.audioRingReader = null;
+    }
+  }
+
+  /**
+   * Buffer raw PCM for cloud transcription. Recordings are kept as int16
+   * (half the memory of float32 for long sessions).
+   */
+  private handleAudioPayload(payload: Buffer, format: PcmFormat): void {
+    // With FLAC negotiated the segments carry the upload; the shared ring
+    // keeps running for other local readers
+    if (!this.isCloudMode || this.flacNegotiated || payload.length === 0) return;
+
+    const buf = format === "s16" ? payload : f32ToS16(payload);
+
+    this.cloudAudioBuffers.push(buf);
+    this.cloudStreamBuffers.push(buf);
+    this.maybeStreamCloudChunk().catch((e) => {
+      console.warn("[SystemAudio] Stream chunk scheduling failed:", e);
+    });
+  }
+
+  /**
+   * Collect a piece of a native FLAC segment; complete segments are uploaded
+   * in order, each as a standalone file.
+   */
+  private handleFlacPayload(buf: Buffer, flags: number): void {
+    if (!this.isCloudMode) return;
+
+    if (flags & FLAC_SEGMENT_START) {
+      this.flacSegmentParts = [];
+    }
+    if (buf.length) {
+      this.flacSegmentParts.push(buf);
+    }
+    if (!(flags & FLAC_SEGMENT_END)) return;
+
+    const segment = Buffer.concat(this.flacSegmentParts);
+    this.flacSegmentParts = [];
+    this.flacUploads = this.flacUploads
+      .then(() => this.transcribeFlacSegment(segment))
+      .catch((error) => {
+        console.error("[SystemAudio] Cloud FLAC segment failed:", error);
+        this.state.lastError = error?.message || "Cloud transcription failed";
+        this.sendToRenderer("system-audio:error", { message: this.state.lastError });
+      });
+  }
+
+  private async transcribeFlacSegment(segment: Buffer): Promise<void> {
+    if (!this.groqApiKey) return;
+
+    const transcript = await this.transcribeWithGroq(
+      segment,
+      this.groqModel || "whisper-large-v3",
+      this.groqApiKey,
+      { format: "flac" }
+    );
+    if (transcript) {
+      this.sendToRenderer("system-audio:transcript", {
+        type: "final",
+        text: transcript,
+      });
     }
   }
 
@@ -826,19 +1005,51 @@ export class SystemAudioHelper {
 
     switch (msg.type) {
       case "ready":
+        if (msg.simd) {
+          console.log(`[SystemAudio] Native SIMD level: ${msg.simd}`, msg.kernels || {});
+        }
+        // Negotiate binary framing before anything else is sent. Cloud mode
+        // has the native side encode FLAC segments ready for upload; otherwise
+        // audio is forwarded as int16.
+        this.sendCommand({
+          cmd: "hello",
+          protocol: PROTOCOL_VERSION,
+          batch_ms: SystemAudioHelper.AUDIO_BATCH_MS,
+          ...(this.isCloudMode
+            ? { audio_format: "flac", segment_ms: SystemAudioHelper.CLOUD_STREAM_MIN_DURATION_MS }
+            : { audio_format: "s16" }),
+        });
         this.state.isReady = true;
         this.sendToRenderer("system-audio:ready", {});
         break;
 
+      case "hello":
+        console.log(
+          `[SystemAudio] Negotiated protocol v${msg.protocol} (${msg.framing} framing, ${msg.audio_format || "f32"} audio)`
+        );
+        this.flacNegotiated = msg.audio_format === "flac";
+        break;
+
+      case "shm":
+        this.openAudioRing(msg as unknown as SharedRingInfo);
+        break;
+
       case "started":
         this.state.isCapturing = true;
         this.sendToRenderer("system-audio:started", {});
         break;
 
       case "stopped":
+        // Pick up the tail of the recording before flushing
+        this.audioRingReader?.drain();
         this.state.isCapturing = false;
         this.sendToRenderer("system-audio:stopped", {});
 
+        // The last FLAC segment is closed before "stopped"; wait for its upload
+        if (this.isCloudMode && this.flacNegotiated) {
+          await this.flacUploads;
+        }
+
         if (this.isCloudMode && this.cloudAudioBuffers.length && this.groqApiKey) {
           try {
             await this.flushCloudStream();
@@ -884,9 +1095,12 @@ export class SystemAudioHelper {
         break;
 
       case "partial":
+        // A delta: the renderer keeps `keep` units of the segment's last partial
         this.sendToRenderer("system-audio:transcript", {
           type: "partial",
           text: msg.text || "",
+          segment: msg.segment,
+          keep: msg.keep ?? 0,
         });
         break;
 
@@ -894,23 +1108,70 @@ export class SystemAudioHelper {
         this.sendToRenderer("system-audio:transcript", {
           type: "final",
           text: msg.text || "",
+          segment: msg.segment,
         });
         break;
 
-      case "audio":
-        if (this.isCloudMode && msg.text) {
+      case "audio": {
+        // JSON fallback; older builds used "text" for the payload
+        const encoded = msg.data || msg.text;
+        if (this.isCloudMode && encoded) {
           try {
-            const buf = Buffer.from(msg.text, "base64");
-            this.cloudAudioBuffers.push(buf);
-            this.cloudStreamBuffers.push(buf);
-            this.maybeStreamCloudChunk().catch((e) => {
-              console.warn("[SystemAudio] Stream chunk scheduling failed:", e);
-            });
+            this.handleAudioPayload(Buffer.from(encoded, "base64"), msg.format || "f32");
           } catch (e) {
             console.warn("[SystemAudio] Failed to decode audio chunk:", e);
           }
         }
         break;
+      }
+
+      case "flac":
+        if (msg.data !== undefined) {
+          this.handleFlacPayload(Buffer.from(msg.data, "base64"), msg.flags || 0);
+        }
+        break;
+
+      case "config": {
+        const config: TranscriptionConfig = {
+          chunk_ms: msg.chunk_ms,
+          threads: msg.threads,
+          beam_size: msg.beam_size,
+          language: msg.language,
+          vad: msg.vad,
+          context_tokens: msg.context_tokens,
+          decode_budget_ms: msg.decode_budget_ms,
+          denoise: msg.denoise,
+          silence_flush_ms: msg.silence_flush_ms,
+        };
+        console.log("[SystemAudio] Transcription config:", config);
+        this.sendToRenderer("system-audio:config", config);
+        break;
+      }
+
+      case "metrics":
+        // Pipeline latency/counter snapshot (requested with {"cmd":"metrics"})
+        this.sendToRenderer("system-audio:metrics", msg);
+        break;
+
+      case "trace":
+        // Chrome trace recording started, or written (open in ui.perfetto.dev)
+        if (msg.enabled) {
+          console.log("[SystemAudio] Recording trace to", msg.path);
+        } else {
+          console.log(
+            `[SystemAudio] Trace written to ${msg.path} (${msg.events} spans, ${msg.dropped} dropped)`
+          );
+        }
+        break;
+
+      case "silence":
+        // Digital silence that was not forwarded as audio; stream time still
+        // advanced by duration_ms
+        this.sendToRenderer("system-audio:silence", {
+          startMs: msg.start_ms || 0,
+          durationMs: msg.duration_ms || 0,
+        });
+        break;
 
       case "error":
         this.state.lastError = msg.message || "Unknown error";
@@ -0,0 +1,102 @@
+/**
+ * Unit tests for PhantomAudioProtocol
+ * Tests JSON line parsing, the hello handshake and binary frame decoding
+ */
+
+import {
+  f32ToS16,
+  FLAC_SEGMENT_END,
+  FLAC_SEGMENT_START,
+  FRAME_HEADER_BYTES,
+  FrameType,
+  PhantomAudioStreamDecoder,
+} from '../PhantomAudioProtocol';
+
+function makeFrame(type: number, streamId: number, timestampUs: number, payload: Buffer, flags = 0): Buffer {
+  const header = Buffer.alloc(FRAME_HEADER_BYTES);
+  header.writeUInt32LE(payload.length, 0);
+  header.writeUInt8(type, 4);
+  header.writeUInt8(flags, 5);
+  header.writeUInt16LE(streamId, 6);
+  header.writeUInt32LE(timestampUs % 0x100000000, 8);
+  header.writeUInt32LE(Math.floor(timestampUs / 0x100000000), 12);
+  return Buffer.concat([header, payload]);
+}
+
+describe('PhantomAudioStreamDecoder', () => {
+  let messages: any[];
+  let frames: any[];
+  let decoder: PhantomAudioStreamDecoder;
+
+  beforeEach(() => {
+    messages = [];
+    frames = [];
+    decoder = new PhantomAudioStreamDecoder({
+      onMessage: (msg) => messages.push(msg),
+      onAudio: (frame) => frames.push(frame),
+    });
+  });
+
+  it('should parse JSON lines split across chunks', () => {
+    decoder.push('{"type":"re');
+    decoder.push('ady"}\n{"type":"started"}\n');
+
+    expect(messages).toEqual([{ type: 'ready' }, { type: 'started' }]);
+    expect(decoder.isBinary()).toBe(false);
+  });
+
+  it('should switch to binary framing after hello', () => {
+    const samples = Buffer.alloc(8);
+    samples.writeFloatLE(0.5, 0);
+    samples.writeFloatLE(-0.25, 4);
+
+    const hello = Buffer.from('{"type":"hello","protocol":2,"framing":"binary"}\n');
+    const event = makeFrame(FrameType.Event, 0, 0, Buffer.from('{"type":"started"}'));
+    const audio = makeFrame(FrameType.AudioF32, 1, 100000, samples);
+    const stream = Buffer.concat([hello, event, audio]);
+
+    // Feed byte by byte to exercise partial headers and payloads
+    for (let i = 0; i < stream.length; i++) {
+      decoder.push(stream.subarray(i, i + 1));
+    }
+
+    expect(decoder.isBinary()).toBe(true);
+    expect(messages.map((m) => m.type)).toEqual(['hello', 'started']);
+    expect(frames).toHaveLength(1);
+    expect(frames[0].streamId).toBe(1);
+    expect(frames[0].timestampUs).toBe(100000);
+    expect(frames[0].payload.readFloatLE(4)).toBeCloseTo(-0.25);
+  });
+
+  it('should pass FLAC segment flags through', () => {
+    const hello = Buffer.from('{"type":"hello","protocol":2,"framing":"binary","audio_format":"flac"}\n');
+    const first = makeFrame(FrameType.Flac, 1, 0, Buffer.from('fLaC'), FLAC_SEGMENT_START);
+    const last = makeFrame(FrameType.Flac, 1, 256000, Buffer.from([0xff, 0xf8]), FLAC_SEGMENT_END);
+    decoder.push(Buffer.concat([hello, first, last]));
+
+    expect(frames.map((f) => f.type)).toEqual([FrameType.Flac, FrameType.Flac]);
+    expect(frames[0].flags).toBe(FLAC_SEGMENT_START);
+    expect(frames[0].payload.toString('latin1')).toBe('fLaC');
+    expect(frames[1].flags).toBe(FLAC_SEGMENT_END);
+    expect(frames[1].timestampUs).toBe(256000);
+  });
+
+  it('should stay in line mode when hello falls back to JSON', () => {
+    decoder.push('{"type":"hello","protocol":1,"framing":"json"}\n{"type":"started"}\n');
+
+    expect(decoder.isBinary()).toBe(false);
+    expect(messages).toHaveLength(2);
+  });
+});
+
+describe('f32ToS16', () => {
+  it('should round and saturate like the native kernel', () => {
+    const input = [0, 0.5, -0.5, 1, -1, 2, -2, 1.5 / 32768, 2.5 / 32768];
+    const pcm = Buffer.alloc(input.length * 4);
+    input.forEach((v, i) => pcm.writeFloatLE(v, i * 4));
+
+    const out = f32ToS16(pcm);
+    const values = input.map((_, i) => out.readInt16LE(i * 2));
+    expect(values).toEqual([0, 16384, -16384, 32767, -32768, 32767, -32768, 2, 2]);
+  });
+});
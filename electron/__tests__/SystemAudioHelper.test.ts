@@ -82,6 +82,20 @@ describe('SystemAudioHelper', () => {
       expect(systemAudioHelper.isCapturing()).toBe(true);
     });
 
+    it('should negotiate binary framing once ready', async () => {
+      (mockProcess as any).stdin.writable = true;
+      setTimeout(() => {
+        (mockProcess.stdout as any).emit('data', JSON.stringify({ type: 'ready' }) + '\n');
+        (mockProcess.stdout as any).emit('data', JSON.stringify({ type: 'started' }) + '\n');
+      }, 10);
+
+      await systemAudioHelper.start();
+
+      const written = (mockProcess as any).stdin.write.mock.calls.map((c: any[]) => JSON.parse(c[0]));
+      expect(written[0]).toMatchObject({ cmd: 'hello', protocol: 2 });
+      expect(written[1]).toEqual({ cmd: 'start' });
+    });
+
     it('should not start if already capturing', async () => {
       setTimeout(() => {
         (mockProcess.stdout as any).emit('data', JSON.stringify({ type: 'ready' }) + '\n');
@@ -6,6 +6,21 @@ import { contextBridge, ipcRenderer } from "electron";
 interface TranscriptMessage {
   type: "partial" | "final";
   text: string;
+  segment?: number;
+  keep?: number;
+}
+
+// Live transcription settings (omitted fields are unchanged)
+interface TranscriptionConfig {
+  chunk_ms?: number;
+  threads?: number;
+  beam_size?: number;
+  language?: string;
+  vad?: "off" | "normal" | "aggressive";
+  context_tokens?: number;
+  decode_budget_ms?: number;
+  denoise?: boolean;
+  silence_flush_ms?: number;
 }
 
 // Types for the exposed Electron API
@@ -304,11 +319,13 @@ interface SystemAudioAPI {
     available: boolean;
     error?: string;
   }>;
+  configure: (config: TranscriptionConfig) => Promise<{ success: boolean; error?: string }>;
   onTranscript: (callback: (msg: TranscriptMessage) => void) => () => void;
   onStarted: (callback: () => void) => () => void;
   onStopped: (callback: () => void) => () => void;
   onReady: (callback: () => void) => () => void;
   onError: (callback: (error: { message: string }) => void) => () => void;
+  onConfig: (callback: (config: TranscriptionConfig) => void) => () => void;
   onToggled: (callback: (data: { isCapturing: boolean; mode?: "audio-only" | "audio-screenshot" }) => void) => () => void;
 }
 
@@ -624,6 +641,14 @@ const systemAudioAPI: SystemAudioAPI = {
   shutdown: () => ipcRenderer.invoke("system-audio:shutdown"),
   getState: () => ipcRenderer.invoke("system-audio:get-state"),
   checkAvailability: () => ipcRenderer.invoke("system-audio:check-availability"),
+  configure: (config: TranscriptionConfig) => ipcRenderer.invoke("system-audio:configure", config),
+  onConfig: (callback: (config: TranscriptionConfig) => void) => {
+    const subscription = (_event: any, config: TranscriptionConfig) => callback(config);
+    ipcRenderer.on("system-audio:config", subscription);
+    return () => {
+      ipcRenderer.removeListener("system-audio:config", subscription);
+    };
+  },
   onTranscript: (callback: (msg: TranscriptMessage) => void) => {
     const subscription = (_event: any, msg: TranscriptMessage) => callback(msg);
     ipcRenderer.on("system-audio:transcript", subscription);
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace phantom {
+namespace bench {
+
+/**
+ * Minimal self-registering benchmark harness (no external dependencies).
+ *
+ *   BENCHMARK(Protocol, Base64) {
+ *       while (state.keepRunning()) { ...; doNotOptimize(out); }
+ *       state.setBytesProcessed(bytesPerIteration);
+ *   }
+ *
+ * Each benchmark body runs repeatedly with a growing iteration count until
+ * one run takes long enough to time; phantom-audio-bench reports the
+ * per-iteration time of that run.
+ */
+class State {
+public:
+    explicit State(uint64_t iterations) : m_iterations(iterations) {}
+
+    bool keepRunning() {
+        if (m_done == 0) {
+            m_start = std::chrono::steady_clock::now();
+        }
+        if (m_done++ < m_iterations) return true;
+        m_elapsed = std::chrono::steady_clock::now() - m_start;
+        return false;
+    }
+
+    // Throughput is reported when either is set (per iteration)
+    void setBytesProcessed(uint64_t bytes) { m_bytes = bytes; }
+    void setItemsProcessed(uint64_t items) { m_items = items; }
+    void setLabel(const std::string& label) { m_label = label; }
+
+    uint64_t iterations() const { return m_iterations; }
+    double elapsedSeconds() const { return m_elapsed.count(); }
+    uint64_t bytesProcessed() const { return m_bytes; }
+    uint64_t itemsProcessed() const { return m_items; }
+    const std::string& label() const { return m_label; }
+
+private:
+    uint64_t m_iterations;
+    uint64_t m_done = 0;
+    uint64_t m_bytes = 0;
+    uint64_t m_items = 0;
+    std::string m_label;
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::duration<double> m_elapsed{0.0};
+};
+
+struct Benchmark {
+    std::string name;
+    std::function<void(State&)> body;
+};
+
+std::vector<Benchmark>& registry();
+
+struct Registrar {
+    Registrar(const char* group, const char* name, std::function<void(State&)> body) {
+        registry().push_back({std::string(group) + "." + name, std::move(body)});
+    }
+};
+
+// Keep a result alive so the compiler cannot drop the work producing it
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static const void* volatile sink;
+    sink = &value;
+#endif
+}
+
+} // namespace bench
+} // namespace phantom
+
+#define BENCHMARK(group, name)                                                   \
+    static void group##_##name##_bench(::phantom::bench::State& state);          \
+    static ::phantom::bench::Registrar group##_##name##_registrar(               \
+        #group, #name, group##_##name##_bench);                                  \
+    static void group##_##name##_bench(::phantom::bench::State& state)
@@ -0,0 +1,152 @@
+#include "bench_harness.h"
+#include "cpu_features.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace phantom {
+namespace bench {
+
+std::vector<Benchmark>& registry() {
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+} // namespace bench
+} // namespace phantom
+
+namespace {
+
+struct Result {
+    std::string name;
+    std::string label;
+    uint64_t iterations = 0;
+    double nsPerIteration = 0.0;
+    double bytesPerSecond = 0.0;
+    double itemsPerSecond = 0.0;
+};
+
+// Grow the iteration count until one timed run reaches minSeconds
+Result run(const phantom::bench::Benchmark& benchmark, double minSeconds) {
+    uint64_t iterations = 1;
+    for (;;) {
+        phantom::bench::State state(iterations);
+        benchmark.body(state);
+        const double elapsed = state.elapsedSeconds();
+
+        if (elapsed >= minSeconds || iterations >= (1ULL << 40)) {
+            Result r;
+            r.name = benchmark.name;
+            r.label = state.label();
+            r.iterations = iterations;
+            r.nsPerIteration = elapsed * 1e9 / static_cast<double>(iterations);
+            if (elapsed > 0.0) {
+                r.bytesPerSecond = static_cast<double>(state.bytesProcessed()) * iterations / elapsed;
+                r.itemsPerSecond = static_cast<double>(state.itemsProcessed()) * iterations / elapsed;
+            }
+            return r;
+        }
+
+        // Aim a little past the target, growing at most 10x per step
+        double scale = elapsed > 0.0 ? (minSeconds * 1.4) / elapsed : 10.0;
+        if (scale > 10.0) scale = 10.0;
+        if (scale < 2.0) scale = 2.0;
+        iterations = static_cast<uint64_t>(static_cast<double>(iterations) * scale);
+    }
+}
+
+std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+const char* compilerName() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    static const std::string name = "MSVC " + std::to_string(_MSC_VER);
+    return name.c_str();
+#elif defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#else
+    return "unknown";
+#endif
+}
+
+void printUsage() {
+    std::cerr << "Usage: phantom-audio-bench [--json] [--min-time=SECONDS] [FILTER]" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    bool json = false;
+    double minSeconds = 0.2;
+    std::string filter;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--json") == 0) {
+            json = true;
+        } else if (std::strncmp(arg, "--min-time=", 11) == 0) {
+            minSeconds = std::atof(arg + 11);
+        } else if (std::strcmp(arg, "--help") == 0) {
+            printUsage();
+            return 0;
+        } else if (arg[0] == '-') {
+            printUsage();
+            return 1;
+        } else {
+            filter = arg;
+        }
+    }
+
+    if (!json) {
+        std::printf("CPU dispatch: %s\n\n", phantom::simdIsaName(phantom::preferredIsa()));
+        std::printf("%-44s %14s %12s %12s  %s\n", "Benchmark", "ns/iter", "MB/s", "items/s", "");
+    }
+
+    std::vector<Result> results;
+    for (const phantom::bench::Benchmark& benchmark : phantom::bench::registry()) {
+        if (!filter.empty() && benchmark.name.find(filter) == std::string::npos) continue;
+
+        Result r = run(benchmark, minSeconds);
+        if (!json) {
+            char mbs[32] = "";
+            char items[32] = "";
+            if (r.bytesPerSecond > 0.0) std::snprintf(mbs, sizeof(mbs), "%.1f", r.bytesPerSecond / 1e6);
+            if (r.itemsPerSecond > 0.0) std::snprintf(items, sizeof(items), "%.3g", r.itemsPerSecond);
+            std::printf("%-44s %14.1f %12s %12s  %s\n", r.name.c_str(), r.nsPerIteration, mbs, items,
+                        r.label.c_str());
+            std::fflush(stdout);
+        }
+        results.push_back(std::move(r));
+    }
+
+    if (json) {
+        // One object on stdout for scripts and CI comparisons across commits
+        std::cout << "{\"isa\":" << jsonString(phantom::simdIsaName(phantom::preferredIsa()))
+                  << ",\"compiler\":" << jsonString(compilerName())
+                  << ",\"min_time_s\":" << minSeconds
+                  << ",\"benchmarks\":[";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            std::cout << (i ? "," : "") << "{\"name\":" << jsonString(r.name)
+                      << ",\"iterations\":" << r.iterations
+                      << ",\"ns_per_iter\":" << r.nsPerIteration
+                      << ",\"bytes_per_second\":" << r.bytesPerSecond
+                      << ",\"items_per_second\":" << r.itemsPerSecond
+                      << ",\"label\":" << jsonString(r.label) << "}";
+        }
+        std::cout << "]}" << std::endl;
+    }
+
+    return results.empty() ? 1 : 0;
+}
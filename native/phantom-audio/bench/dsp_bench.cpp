@@ -0,0 +1,381 @@
+#include "bench_harness.h"
+#include "audio_chunk_buffer.h"
+#include "audio_resampler.h"
+#include "flac_encoder.h"
+#include "frame_features.h"
+#include "noise_suppressor.h"
+#include "sample_format.h"
+#include "silence_detect.h"
+#include "silence_trim.h"
+
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace phantom;
+using phantom::bench::State;
+using phantom::bench::doNotOptimize;
+
+namespace {
+
+constexpr size_t WHISPER_RATE = 16000;
+constexpr double PI = 3.14159265358979323846;
+
+const char* isaLabel(SimdIsa isa) {
+    return isaSupported(isa) ? simdIsaName(isa) : "unsupported, scalar";
+}
+
+// Deterministic "speech-like" signal: two tones with a syllable-rate
+// envelope plus a little noise, so every run sees identical input
+std::vector<float> speechLike(size_t frames, uint32_t rate, uint16_t channels, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> noise(-0.01f, 0.01f);
+    std::vector<float> out(frames * channels);
+    for (size_t i = 0; i < frames; ++i) {
+        const double t = static_cast<double>(i) / rate;
+        const double envelope = 0.5 + 0.5 * std::sin(2.0 * PI * 4.0 * t);
+        const float v = static_cast<float>(
+            envelope * (0.3 * std::sin(2.0 * PI * 220.0 * t) + 0.1 * std::sin(2.0 * PI * 1330.0 * t)));
+        for (uint16_t ch = 0; ch < channels; ++ch) {
+            out[i * channels + ch] = v + noise(rng);
+        }
+    }
+    return out;
+}
+
+// 2s chunk at 16kHz: 0.5s silence, 1s speech, 0.5s silence
+std::vector<float> paddedChunk() {
+    std::vector<float> chunk(2 * WHISPER_RATE, 0.0f);
+    const std::vector<float> speech = speechLike(WHISPER_RATE, WHISPER_RATE, 1, 7);
+    std::copy(speech.begin(), speech.end(), chunk.begin() + WHISPER_RATE / 2);
+    return chunk;
+}
+
+// Feed 10ms capture packets of the given format through the resampler
+// the way AudioCapture does (convert to float, then resample)
+void runResampler(State& state, uint32_t rate, uint16_t channels, size_t frames, SampleFormat format) {
+    constexpr size_t PACKETS = 100;  // 1s of audio at 10ms packets
+    const std::vector<float> source = speechLike(frames * PACKETS, rate, channels, 42);
+
+    std::vector<int16_t> sourceS16(source.size());
+    floatToS16(source.data(), sourceS16.data(), source.size());
+    std::vector<float> converted(frames * channels);
+
+    AudioResampler resampler(rate, channels, WHISPER_RATE);
+    size_t packet = 0;
+    while (state.keepRunning()) {
+        const size_t offset = (packet++ % PACKETS) * frames * channels;
+        const float* input = source.data() + offset;
+        if (format == SampleFormat::S16) {
+            s16ToFloat(sourceS16.data() + offset, converted.data(), converted.size());
+            input = converted.data();
+        }
+        std::vector<float> out = resampler.process(input, frames);
+        doNotOptimize(out);
+    }
+    state.setBytesProcessed(frames * channels * bytesPerSample(format));
+    state.setItemsProcessed(frames);
+}
+
+void runTrimSilence(State& state, const std::vector<float>& chunk, float threshold) {
+    std::vector<float> work;
+    while (state.keepRunning()) {
+        work = chunk;
+        trimSilence(work, threshold, WHISPER_RATE);
+        doNotOptimize(work);
+    }
+    state.setBytesProcessed(chunk.size() * sizeof(float));
+    state.setItemsProcessed(chunk.size());
+}
+
+// Trim with the chunk's frames already computed by the feature stage, as
+// WhisperWrapper does it (the scan is paid once, on append)
+void runTrimFromFeatures(State& state, const std::vector<float>& chunk, float threshold) {
+    const std::vector<FrameFeatures> frames = computeFrameFeatures(chunk.data(), chunk.size());
+    std::vector<float> work;
+    while (state.keepRunning()) {
+        work = chunk;
+        trimSilence(work, threshold, WHISPER_RATE, frames, 0);
+        doNotOptimize(work);
+    }
+    state.setBytesProcessed(chunk.size() * sizeof(float));
+    state.setItemsProcessed(chunk.size());
+}
+
+// Features of 1s of 16kHz audio, 100 frames per iteration
+void runFrameFeatures(State& state, SimdIsa isa) {
+    const std::vector<float> audio = speechLike(WHISPER_RATE, WHISPER_RATE, 1, 5);
+    std::vector<FrameFeatures> frames(WHISPER_RATE / FEATURE_FRAME_SAMPLES);
+    while (state.keepRunning()) {
+        computeFrameFeatures(audio.data(), frames.size(), FEATURE_FRAME_SAMPLES, 0.0f, frames.data(), isa);
+        doNotOptimize(frames);
+    }
+    state.setBytesProcessed(audio.size() * sizeof(float));
+    state.setItemsProcessed(audio.size());
+    state.setLabel(isaLabel(isa));
+}
+
+// Denoise 1s of noisy 16kHz audio in 10ms packets, as the capture thread
+// does; the noise floor settles in the first iterations
+void runNoiseSuppressor(State& state, SimdIsa isa) {
+    std::vector<float> audio = speechLike(WHISPER_RATE, WHISPER_RATE, 1, 17);
+    std::mt19937 rng(19);
+    std::uniform_real_distribution<float> hiss(-0.05f, 0.05f);
+    for (float& v : audio) v += hiss(rng);
+    const size_t packet = WHISPER_RATE / 100;
+    NoiseSuppressor denoiser(isa);
+    std::vector<float> out;
+    out.reserve(packet);
+    while (state.keepRunning()) {
+        for (size_t i = 0; i + packet <= audio.size(); i += packet) {
+            out.clear();
+            denoiser.process(audio.data() + i, packet, out);
+        }
+        doNotOptimize(out);
+    }
+    state.setBytesProcessed(audio.size() * sizeof(float));
+    state.setItemsProcessed(audio.size());
+    state.setLabel(isaLabel(isa));
+}
+
+// One 512-point real FFT and its inverse per iteration (items = samples)
+void runRealFft(State& state, SimdIsa isa) {
+    const std::vector<float> input = speechLike(NoiseSuppressor::FFT_SIZE, WHISPER_RATE, 1, 23);
+    RealFft fft(NoiseSuppressor::FFT_SIZE, isa);
+    std::vector<float> re(NoiseSuppressor::BINS), im(NoiseSuppressor::BINS), output(input.size());
+    while (state.keepRunning()) {
+        fft.forward(input.data(), re.data(), im.data());
+        fft.inverse(re.data(), im.data(), output.data());
+        doNotOptimize(output);
+    }
+    state.setBytesProcessed(input.size() * sizeof(float));
+    state.setItemsProcessed(input.size());
+    state.setLabel(isaLabel(isa));
+}
+
+// One 10ms 48kHz stereo packet per iteration (items = samples)
+void runFloatToS16(State& state, SimdIsa isa) {
+    const std::vector<float> input = speechLike(480, 48000, 2, 13);
+    std::vector<int16_t> output(input.size());
+    while (state.keepRunning()) {
+        floatToS16(input.data(), output.data(), input.size(), isa);
+        doNotOptimize(output);
+    }
+    state.setBytesProcessed(input.size() * sizeof(float));
+    state.setItemsProcessed(input.size());
+    state.setLabel(isaLabel(isa));
+}
+
+void runS16ToFloat(State& state, SimdIsa isa) {
+    const std::vector<float> source = speechLike(480, 48000, 2, 13);
+    std::vector<int16_t> input(source.size());
+    floatToS16(source.data(), input.data(), source.size());
+    std::vector<float> output(input.size());
+    while (state.keepRunning()) {
+        s16ToFloat(input.data(), output.data(), input.size(), isa);
+        doNotOptimize(output);
+    }
+    state.setBytesProcessed(input.size() * sizeof(int16_t));
+    state.setItemsProcessed(input.size());
+    state.setLabel(isaLabel(isa));
+}
+
+// Stereo to mono, the resampler's first step (items = frames)
+void runDownmix(State& state, SimdIsa isa) {
+    const std::vector<float> input = speechLike(480, 48000, 2, 17);
+    std::vector<float> output(480);
+    while (state.keepRunning()) {
+        downmixToMono(input.data(), output.data(), output.size(), 2, isa);
+        doNotOptimize(output);
+    }
+    state.setBytesProcessed(input.size() * sizeof(float));
+    state.setItemsProcessed(output.size());
+    state.setLabel(isaLabel(isa));
+}
+
+// Capture-thread handoff into the transcription buffer as WhisperWrapper
+// does it (lock, append, notify), with a 2s chunk taken whenever one is ready
+template <typename Sample>
+void runChunkHandoff(State& state, SampleFormat storage) {
+    constexpr size_t PACKET = WHISPER_RATE / 100;        // 10ms at 16kHz
+    constexpr size_t CHUNK = 2 * WHISPER_RATE;
+    const std::vector<float> source = speechLike(PACKET, WHISPER_RATE, 1, 3);
+    std::vector<Sample> packet(PACKET);
+    if constexpr (sizeof(Sample) == sizeof(int16_t)) {
+        floatToS16(source.data(), packet.data(), PACKET);
+    } else {
+        packet = source;
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    AudioChunkBuffer buffer;
+    buffer.setFormat(storage);
+    std::vector<float> chunk;
+
+    while (state.keepRunning()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            buffer.append(packet.data(), PACKET);
+        }
+        cv.notify_one();
+
+        if (buffer.size() >= CHUNK) {
+            std::lock_guard<std::mutex> lock(mutex);
+            buffer.takeChunk(chunk, CHUNK, WHISPER_RATE / 2, false);
+            doNotOptimize(chunk);
+        }
+    }
+    state.setBytesProcessed(PACKET * sizeof(Sample));
+    state.setItemsProcessed(PACKET);
+    state.setLabel(sampleFormatName(storage));
+}
+
+// Full scan of one silent 10ms 48kHz stereo packet (the worst case: a
+// loud packet stops at its first block)
+void runSilenceCheck(State& state, SimdIsa isa) {
+    const std::vector<float> packet(480 * 2, 0.0f);
+    while (state.keepRunning()) {
+        bool silent = isSilent(packet.data(), packet.size(), DIGITAL_SILENCE_FLOOR, isa);
+        doNotOptimize(silent);
+    }
+    state.setBytesProcessed(packet.size() * sizeof(float));
+    state.setItemsProcessed(packet.size());
+    state.setLabel(isaLabel(isa));
+}
+
+// What a silent packet cost before the fast path (resample zeros) and after
+void runSilentPacket(State& state, bool skip) {
+    const std::vector<float> packet(480 * 2, 0.0f);
+    AudioResampler resampler(48000, 2, WHISPER_RATE);
+    while (state.keepRunning()) {
+        if (skip) {
+            size_t samples = isSilent(packet.data(), packet.size(), DIGITAL_SILENCE_FLOOR)
+                ? resampler.skip(480) : 0;
+            doNotOptimize(samples);
+        } else {
+            std::vector<float> out = resampler.process(packet.data(), 480);
+            doNotOptimize(out);
+        }
+    }
+    state.setItemsProcessed(480);
+}
+
+// FLAC forwarding (audio_format "flac"): 10ms packets of a 1s signal; the
+// label carries the encoded size of the whole signal as a share of 16-bit PCM
+void runFlacEncode(State& state, const std::vector<float>& source) {
+    constexpr size_t PACKET = WHISPER_RATE / 100;
+    std::vector<int16_t> pcm(source.size());
+    floatToS16(source.data(), pcm.data(), pcm.size());
+
+    FlacEncoder encoder(WHISPER_RATE);
+    std::vector<uint8_t> out;
+    encoder.encode(pcm.data(), pcm.size(), out);
+    encoder.finishSegment(out);
+    const size_t percent = out.size() * 100 / (pcm.size() * sizeof(int16_t));
+
+    const size_t packets = pcm.size() / PACKET;
+    size_t packet = 0;
+    out.clear();
+    while (state.keepRunning()) {
+        encoder.encode(pcm.data() + (packet++ % packets) * PACKET, PACKET, out);
+        if (out.size() > (1u << 20)) out.clear();
+        doNotOptimize(out);
+    }
+    state.setBytesProcessed(PACKET * sizeof(int16_t));
+    state.setItemsProcessed(PACKET);
+    state.setLabel(std::to_string(percent) + "% of PCM");
+}
+
+} // namespace
+
+// ============================================================================
+// Capture resampling, one 10ms packet per iteration (items = input frames)
+// ============================================================================
+
+BENCHMARK(Resampler, F32Stereo48k) { runResampler(state, 48000, 2, 480, SampleFormat::F32); }
+BENCHMARK(Resampler, S16Stereo44k1) { runResampler(state, 44100, 2, 441, SampleFormat::S16); }
+BENCHMARK(Resampler, F32Mono16k) { runResampler(state, 16000, 1, 160, SampleFormat::F32); }
+
+// ============================================================================
+// Sample conversion and downmix per SIMD level, one 10ms 48kHz stereo packet
+// ============================================================================
+
+BENCHMARK(Convert, FloatToS16Scalar) { runFloatToS16(state, SimdIsa::Scalar); }
+BENCHMARK(Convert, FloatToS16SSE2) { runFloatToS16(state, SimdIsa::SSE2); }
+BENCHMARK(Convert, FloatToS16AVX2) { runFloatToS16(state, SimdIsa::AVX2); }
+BENCHMARK(Convert, S16ToFloatScalar) { runS16ToFloat(state, SimdIsa::Scalar); }
+BENCHMARK(Convert, S16ToFloatSSE2) { runS16ToFloat(state, SimdIsa::SSE2); }
+BENCHMARK(Convert, S16ToFloatSSE41) { runS16ToFloat(state, SimdIsa::SSE41); }
+BENCHMARK(Convert, S16ToFloatAVX2) { runS16ToFloat(state, SimdIsa::AVX2); }
+BENCHMARK(Convert, DownmixScalar) { runDownmix(state, SimdIsa::Scalar); }
+BENCHMARK(Convert, DownmixSSE2) { runDownmix(state, SimdIsa::SSE2); }
+BENCHMARK(Convert, DownmixAVX2) { runDownmix(state, SimdIsa::AVX2); }
+
+// ============================================================================
+// Silence trimming of one 2s chunk (items = samples)
+// ============================================================================
+
+BENCHMARK(TrimSilence, PaddedSpeech) { runTrimSilence(state, paddedChunk(), 0.01f); }
+BENCHMARK(TrimSilence, ContinuousSpeech) {
+    runTrimSilence(state, speechLike(2 * WHISPER_RATE, WHISPER_RATE, 1, 9), 0.01f);
+}
+BENCHMARK(TrimSilence, AllSilence) {
+    runTrimSilence(state, std::vector<float>(2 * WHISPER_RATE, 0.0f), 0.01f);
+}
+BENCHMARK(TrimSilence, PaddedSpeechFromFeatures) { runTrimFromFeatures(state, paddedChunk(), 0.01f); }
+
+// ============================================================================
+// Per-10ms feature frames (RMS, peak, ZCR), 1s of audio (items = samples)
+// ============================================================================
+
+BENCHMARK(FrameFeatures, Scalar) { runFrameFeatures(state, SimdIsa::Scalar); }
+BENCHMARK(FrameFeatures, SSE2) { runFrameFeatures(state, SimdIsa::SSE2); }
+BENCHMARK(FrameFeatures, AVX2) { runFrameFeatures(state, SimdIsa::AVX2); }
+
+// ============================================================================
+// Noise suppression (config "denoise"): 1s in 10ms packets, and the FFT pair
+// ============================================================================
+
+BENCHMARK(NoiseSuppressor, Scalar) { runNoiseSuppressor(state, SimdIsa::Scalar); }
+BENCHMARK(NoiseSuppressor, SSE2) { runNoiseSuppressor(state, SimdIsa::SSE2); }
+BENCHMARK(NoiseSuppressor, AVX2) { runNoiseSuppressor(state, SimdIsa::AVX2); }
+BENCHMARK(NoiseSuppressor, RealFftScalar) { runRealFft(state, SimdIsa::Scalar); }
+BENCHMARK(NoiseSuppressor, RealFftSSE2) { runRealFft(state, SimdIsa::SSE2); }
+BENCHMARK(NoiseSuppressor, RealFftAVX2) { runRealFft(state, SimdIsa::AVX2); }
+
+// ============================================================================
+// addAudioChunk buffer handoff, one 10ms packet per iteration
+// ============================================================================
+
+BENCHMARK(AddAudioChunk, F32IntoF32) { runChunkHandoff<float>(state, SampleFormat::F32); }
+BENCHMARK(AddAudioChunk, F32IntoS16) { runChunkHandoff<float>(state, SampleFormat::S16); }
+BENCHMARK(AddAudioChunk, S16IntoS16) { runChunkHandoff<int16_t>(state, SampleFormat::S16); }
+
+// ============================================================================
+// Digital-silence check, one 10ms 48kHz stereo packet per iteration
+// ============================================================================
+
+BENCHMARK(SilenceCheck, Scalar) { runSilenceCheck(state, SimdIsa::Scalar); }
+BENCHMARK(SilenceCheck, SSE2) { runSilenceCheck(state, SimdIsa::SSE2); }
+BENCHMARK(SilenceCheck, AVX2) { runSilenceCheck(state, SimdIsa::AVX2); }
+BENCHMARK(SilenceCheck, ResampleSilentPacket) { runSilentPacket(state, false); }
+BENCHMARK(SilenceCheck, SkipSilentPacket) { runSilentPacket(state, true); }
+
+// ============================================================================
+// FLAC encoding, one 10ms 16kHz packet per iteration (items = samples)
+// ============================================================================
+
+BENCHMARK(FlacEncoder, Speech) { runFlacEncode(state, speechLike(WHISPER_RATE, WHISPER_RATE, 1, 5)); }
+BENCHMARK(FlacEncoder, PaddedSpeech) { runFlacEncode(state, paddedChunk()); }
+BENCHMARK(FlacEncoder, WhiteNoise) {
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    std::vector<float> source(WHISPER_RATE);
+    for (float& s : source) s = noise(rng);
+    runFlacEncode(state, source);
+}
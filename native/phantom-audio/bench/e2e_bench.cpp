@@ -0,0 +1,393 @@
+/**
+ * phantom-audio-e2e - end-to-end transcription benchmark
+ *
+ * Replays a directory of WAV files through the live pipeline (10ms packets
+ * -> AudioResampler -> WhisperWrapper chunking -> whisper) and reports
+ * speed and accuracy together as one JSON object on stdout:
+ *
+ *   phantom-audio-e2e --model ggml-small.en.q5_1.bin --corpus corpus/ [--paced]
+ *   phantom-audio-e2e --engine mock:latency_ms=200,rtf=0.1 --corpus corpus/
+ *
+ * Each <name>.wav may have a <name>.txt reference transcript beside it;
+ * WER is computed over the files that do. Unpaced (default) feeds audio as
+ * fast as the decoder drains it, so wall time measures throughput; --paced
+ * feeds in real time, so latency matches live capture.
+ *
+ * Reported: real-time factor (inference and wall clock), p50/p95/p99
+ * latency from the end of a chunk's audio to the first transcript update
+ * (partial or final) covering it, CPU time, peak RSS
+ * and WER (with substitution/deletion/insertion counts).
+ *
+ * With --engine mock (see MockEngine::configure) no model is loaded and
+ * each chunk gets scripted text after a scripted delay: everything but
+ * inference is measured, deterministically. WER is meaningless then.
+ */
+
+#include "audio_resampler.h"
+#include "mock_engine.h"
+#include "pipeline_metrics.h"
+#include "process_stats.h"
+#include "text_encoding.h"
+#include "transcription_config.h"
+#include "wav_reader.h"
+#include "whisper_wrapper.h"
+#include "word_error_rate.h"
+#if PHANTOM_AUDIO_HAVE_WHISPER
+#include "whisper_engine.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace phantom;
+
+namespace {
+
+constexpr uint32_t WHISPER_RATE = 16000;
+
+struct Options {
+    std::string modelPath;
+    std::string engine = "whisper";     // Or a MockEngine spec
+    std::string corpusDir;
+    bool paced = false;
+    SampleFormat sampleFormat = SampleFormat::F32;
+    TranscriptionConfig config;
+};
+
+struct FileResult {
+    std::string name;
+    double audioSeconds = 0.0;
+    double wallSeconds = 0.0;
+    size_t finals = 0;
+    std::string hypothesis;
+    bool hasReference = false;
+    WordErrorCounts errors;
+};
+
+void printUsage() {
+    std::cerr << "Usage: phantom-audio-e2e --model <ggml model> --corpus <dir of .wav/.txt>\n"
+                 "                         [--engine mock[:latency_ms=N,rtf=X,text=...]]\n"
+                 "                         [--paced] [--s16] [--chunk-ms N] [--threads N]\n"
+                 "                         [--beam-size N] [--language CODE] [--vad off|normal|aggressive]"
+              << std::endl;
+}
+
+bool parseInt(const char* text, int* out) {
+    char* end = nullptr;
+    const long value = std::strtol(text, &end, 10);
+    if (!end || *end != '\0' || end == text) return false;
+    *out = static_cast<int>(value);
+    return true;
+}
+
+bool parseOptions(int argc, char* argv[], Options* options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--paced") {
+            options->paced = true;
+        } else if (arg == "--s16") {
+            options->sampleFormat = SampleFormat::S16;
+        } else if (!hasValue) {
+            return false;
+        } else if (arg == "--model" || arg == "-m") {
+            options->modelPath = argv[++i];
+        } else if (arg == "--engine") {
+            options->engine = argv[++i];
+        } else if (arg == "--corpus") {
+            options->corpusDir = argv[++i];
+        } else if (arg == "--chunk-ms") {
+            if (!parseInt(argv[++i], &options->config.chunkMs)) return false;
+        } else if (arg == "--threads") {
+            if (!parseInt(argv[++i], &options->config.threads)) return false;
+        } else if (arg == "--beam-size") {
+            if (!parseInt(argv[++i], &options->config.beamSize)) return false;
+        } else if (arg == "--language") {
+            options->config.language = argv[++i];
+        } else if (arg == "--vad") {
+            if (!parseVadMode(argv[++i], &options->config.vad)) return false;
+        } else {
+            return false;
+        }
+    }
+    const TranscriptionConfig& c = options->config;
+    const bool needsModel = options->engine == "whisper";
+    return (!needsModel || !options->modelPath.empty()) && !options->corpusDir.empty() &&
+           c.chunkMs >= MIN_CHUNK_MS && c.chunkMs <= MAX_CHUNK_MS &&
+           c.threads >= 0 && c.threads <= MAX_THREADS &&
+           c.beamSize >= 1 && c.beamSize <= MAX_BEAM_SIZE;
+}
+
+std::string readTextFile(const fs::path& path) {
+    std::ifstream in(path.string(), std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+// Nearest-rank percentile of a sorted sample
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Replay one file. Latencies (ms) are appended to `latencies`: for each
+ * chunk, the time from feeding the packet that held its last sample to
+ * the first update reaching that far. The hypothesis is made of finals.
+ */
+bool runFile(WhisperWrapper& whisper, const Options& options, const fs::path& wavPath,
+             FileResult* result, std::vector<double>* latencies) {
+    WavReader reader;
+    if (!reader.open(wavPath.string())) {
+        std::cerr << "[E2E] " << reader.getLastError() << std::endl;
+        return false;
+    }
+    result->name = wavPath.filename().string();
+    result->audioSeconds = reader.durationSeconds();
+
+    // When each stream position was handed over: (samples fed, time)
+    std::vector<std::pair<uint64_t, uint64_t>> fed;
+    std::mutex resultMutex;
+
+    uint64_t reachedSample = 0;
+
+    whisper.start([&](const std::string& text, bool isFinal, const TranscriptSource& source) {
+        const uint64_t now = metricsNowUs();
+        std::lock_guard<std::mutex> lock(resultMutex);
+        if (source.endSample > reachedSample) {
+            reachedSample = source.endSample;
+            auto it = std::lower_bound(fed.begin(), fed.end(), source.endSample,
+                                       [](const std::pair<uint64_t, uint64_t>& entry, uint64_t sample) {
+                                           return entry.first < sample;
+                                       });
+            if (it != fed.end()) {
+                latencies->push_back(static_cast<double>(now - it->second) / 1000.0);
+            }
+        }
+        if (!isFinal || text.empty()) return;
+        if (!result->hypothesis.empty()) result->hypothesis += ' ';
+        result->hypothesis += text;
+        result->finals++;
+    });
+
+    AudioResampler resampler(reader.sampleRate(), reader.channels(), WHISPER_RATE);
+    const size_t packetFrames = reader.sampleRate() / 100;  // 10ms, like WASAPI
+    const size_t chunkSamples = static_cast<size_t>(options.config.chunkMs) * WHISPER_RATE / 1000;
+    std::vector<float> packet(packetFrames * reader.channels());
+    uint64_t streamSamples = 0;
+    uint64_t packets = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (;;) {
+        const size_t frames = reader.read(packet.data(), packetFrames);
+        if (frames == 0) break;
+
+        if (options.paced) {
+            std::this_thread::sleep_until(start + std::chrono::milliseconds(10 * packets));
+        } else {
+            // Stay at most one chunk ahead of the decoder
+            while (whisper.pendingSamples() >= chunkSamples) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        packets++;
+
+        const std::vector<float> resampled = resampler.process(packet.data(), frames);
+        {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            streamSamples += resampled.size();
+            fed.emplace_back(streamSamples, metricsNowUs());
+        }
+        whisper.addAudioChunk(resampled.data(), resampled.size());
+    }
+    whisper.stop();  // Drains the tail
+    result->wallSeconds = secondsSince(start);
+
+    const fs::path referencePath = fs::path(wavPath).replace_extension(".txt");
+    if (fs::exists(referencePath)) {
+        result->hasReference = true;
+        result->errors = countWordErrors(readTextFile(referencePath), result->hypothesis);
+    }
+    return true;
+}
+
+void appendJsonString(std::string& out, const std::string& value) {
+    out += '"';
+    appendJsonEscaped(out, value.data(), value.size());
+    out += '"';
+}
+
+void appendNumber(std::string& out, const char* key, double value) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "\"%s\":%.6g", key, value);
+    out += buffer;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<fs::path> files;
+    std::error_code ec;
+    for (const fs::directory_entry& entry : fs::directory_iterator(options.corpusDir, ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".wav") {
+            files.push_back(entry.path());
+        }
+    }
+    if (ec || files.empty()) {
+        std::cerr << "[E2E] No .wav files in " << options.corpusDir << std::endl;
+        return 1;
+    }
+    std::sort(files.begin(), files.end());
+
+    WhisperWrapper whisper;
+    whisper.setSampleFormat(options.sampleFormat);
+    if (options.engine == "whisper") {
+#if PHANTOM_AUDIO_HAVE_WHISPER
+        auto engine = std::make_unique<WhisperEngine>();
+        if (!engine->loadModel(options.modelPath)) {
+            std::cerr << "[E2E] " << engine->getLastError() << std::endl;
+            return 1;
+        }
+        whisper.setEngine(std::move(engine));
+#else
+        std::cerr << "[E2E] Built without whisper.cpp; use --engine mock" << std::endl;
+        return 1;
+#endif
+    } else {
+        auto engine = std::make_unique<MockEngine>();
+        if (!engine->configure(options.engine)) {
+            std::cerr << "[E2E] " << engine->getLastError() << std::endl;
+            return 1;
+        }
+        whisper.setEngine(std::move(engine));
+    }
+    if (!whisper.setConfig(options.config)) {
+        std::cerr << "[E2E] " << whisper.getLastError() << std::endl;
+        return 1;
+    }
+
+    // Model loading is not part of the measurement
+    metrics().reset();
+    const ProcessStats before = currentProcessStats();
+
+    std::vector<FileResult> results;
+    std::vector<double> latencies;
+    for (const fs::path& path : files) {
+        FileResult result;
+        if (runFile(whisper, options, path, &result, &latencies)) {
+            std::cerr << "[E2E] " << result.name << ": " << result.audioSeconds << "s audio in "
+                      << result.wallSeconds << "s" << std::endl;
+            results.push_back(std::move(result));
+        }
+    }
+    const ProcessStats after = currentProcessStats();
+
+    double audioSeconds = 0.0;
+    double wallSeconds = 0.0;
+    WordErrorCounts errors;
+    size_t referenced = 0;
+    for (const FileResult& r : results) {
+        audioSeconds += r.audioSeconds;
+        wallSeconds += r.wallSeconds;
+        if (r.hasReference) {
+            errors += r.errors;
+            referenced++;
+        }
+    }
+    std::sort(latencies.begin(), latencies.end());
+    const LatencyHistogram& inference = metrics().inference;
+    const double inferenceSeconds = inference.mean() * static_cast<double>(inference.count()) / 1e6;
+
+    std::string json = "{\"mode\":";
+    appendJsonString(json, options.paced ? "paced" : "unpaced");
+    json += ",\"engine\":";
+    appendJsonString(json, options.engine);
+    json += ",\"model\":";
+    appendJsonString(json, fs::path(options.modelPath).filename().string());
+    json += ",\"config\":{\"chunk_ms\":" + std::to_string(options.config.chunkMs) +
+            ",\"threads\":" + std::to_string(options.config.threads) +
+            ",\"beam_size\":" + std::to_string(options.config.beamSize) + ",\"language\":";
+    appendJsonString(json, options.config.language);
+    json += ",\"vad\":";
+    appendJsonString(json, vadModeName(options.config.vad));
+    json += ",\"sample_format\":";
+    appendJsonString(json, sampleFormatName(options.sampleFormat));
+    json += "},\"files\":" + std::to_string(results.size()) + ',';
+    appendNumber(json, "audio_s", audioSeconds);
+    json += ',';
+    appendNumber(json, "wall_s", wallSeconds);
+    json += ',';
+    appendNumber(json, "rtf", audioSeconds > 0.0 ? inferenceSeconds / audioSeconds : 0.0);
+    json += ',';
+    appendNumber(json, "wall_rtf", audioSeconds > 0.0 ? wallSeconds / audioSeconds : 0.0);
+    json += ",\"latency_ms\":{\"count\":" + std::to_string(latencies.size()) + ',';
+    appendNumber(json, "p50", percentile(latencies, 50.0));
+    json += ',';
+    appendNumber(json, "p95", percentile(latencies, 95.0));
+    json += ',';
+    appendNumber(json, "p99", percentile(latencies, 99.0));
+    json += ',';
+    appendNumber(json, "max", latencies.empty() ? 0.0 : latencies.back());
+    json += "},";
+    appendNumber(json, "cpu_s", after.cpuSeconds() - before.cpuSeconds());
+    json += ',';
+    appendNumber(json, "cpu_user_s", after.userCpuSeconds - before.userCpuSeconds);
+    json += ',';
+    appendNumber(json, "peak_rss_mb", static_cast<double>(after.peakRssBytes) / (1024.0 * 1024.0));
+    json += ",\"wer\":{\"files\":" + std::to_string(referenced) + ',';
+    appendNumber(json, "rate", errors.rate());
+    json += ",\"reference_words\":" + std::to_string(errors.referenceWords) +
+            ",\"substitutions\":" + std::to_string(errors.substitutions) +
+            ",\"deletions\":" + std::to_string(errors.deletions) +
+            ",\"insertions\":" + std::to_string(errors.insertions) + "},\"per_file\":[";
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const FileResult& r = results[i];
+        json += i ? ",{\"name\":" : "{\"name\":";
+        appendJsonString(json, r.name);
+        json += ',';
+        appendNumber(json, "audio_s", r.audioSeconds);
+        json += ',';
+        appendNumber(json, "wall_s", r.wallSeconds);
+        json += ",\"finals\":" + std::to_string(r.finals);
+        if (r.hasReference) {
+            json += ',';
+            appendNumber(json, "wer", r.errors.rate());
+        }
+        json += ",\"text\":";
+        appendJsonString(json, r.hypothesis);
+        json += '}';
+    }
+    json += "]}";
+
+    std::cout << json << std::endl;
+    return results.size() == files.size() ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+#include "bench_harness.h"
+#include "text_encoding.h"
+
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace phantom;
+using phantom::bench::State;
+using phantom::bench::doNotOptimize;
+
+namespace {
+
+// Implementations json_protocol.cpp used before the SIMD kernels, kept as
+// the baseline for comparison
+std::string legacyBase64Encode(const uint8_t* data, size_t len) {
+    static const char* table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve(((len + 2) / 3) * 4);
+
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t triple = (data[i] << 16);
+        if (i + 1 < len) triple |= (data[i + 1] << 8);
+        if (i + 2 < len) triple |= data[i + 2];
+
+        out.push_back(table[(triple >> 18) & 0x3F]);
+        out.push_back(table[(triple >> 12) & 0x3F]);
+        out.push_back((i + 1 < len) ? table[(triple >> 6) & 0x3F] : '=');
+        out.push_back((i + 2 < len) ? table[triple & 0x3F] : '=');
+    }
+
+    return out;
+}
+
+std::string legacyEscapeJson(const std::string& str) {
+    std::ostringstream ss;
+    for (char c : str) {
+        switch (c) {
+            case '"':  ss << "\\\""; break;
+            case '\\': ss << "\\\\"; break;
+            case '\b': ss << "\\b"; break;
+            case '\f': ss << "\\f"; break;
+            case '\n': ss << "\\n"; break;
+            case '\r': ss << "\\r"; break;
+            case '\t': ss << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    ss << "\\u" << std::hex << std::setfill('0') << std::setw(4)
+                       << static_cast<int>(static_cast<unsigned char>(c));
+                } else {
+                    ss << c;
+                }
+        }
+    }
+    return ss.str();
+}
+
+// 100 ms of 16 kHz f32 audio, the size of one batched audio event
+const std::vector<uint8_t>& audioPayload() {
+    static const std::vector<uint8_t> bytes = [] {
+        std::vector<float> samples(1600);
+        for (size_t i = 0; i < samples.size(); ++i) {
+            samples[i] = 0.25f * std::sin(0.07f * static_cast<float>(i));
+        }
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(samples.data());
+        return std::vector<uint8_t>(p, p + samples.size() * sizeof(float));
+    }();
+    return bytes;
+}
+
+// A long final transcript (~2 KB)
+std::string transcript(bool withEscapes) {
+    const char* sentence = withEscapes
+        ? "He said \"we should ship it\\today\"\nand then\tpaused. "
+        : "So the plan for this quarter is to ship the streaming pipeline first. ";
+    std::string text;
+    while (text.size() < 2048) text += sentence;
+    return text;
+}
+
+void runBase64(State& state, SimdIsa isa) {
+    const std::vector<uint8_t>& payload = audioPayload();
+    std::string out;
+    while (state.keepRunning()) {
+        out.clear();
+        appendBase64(out, payload.data(), payload.size(), isa);
+        doNotOptimize(out);
+    }
+    state.setBytesProcessed(payload.size());
+    state.setLabel(isaSupported(isa) ? simdIsaName(isa) : "unsupported, scalar");
+}
+
+void runEscape(State& state, bool withEscapes, SimdIsa isa) {
+    const std::string text = transcript(withEscapes);
+    std::string out;
+    while (state.keepRunning()) {
+        out.clear();
+        appendJsonEscaped(out, text.data(), text.size(), isa);
+        doNotOptimize(out);
+    }
+    state.setBytesProcessed(text.size());
+    state.setLabel(isaSupported(isa) ? simdIsaName(isa) : "unsupported, scalar");
+}
+
+void runLegacyEscape(State& state, bool withEscapes) {
+    const std::string text = transcript(withEscapes);
+    while (state.keepRunning()) {
+        std::string out = legacyEscapeJson(text);
+        doNotOptimize(out);
+    }
+    state.setBytesProcessed(text.size());
+    state.setLabel("ostringstream");
+}
+
+} // namespace
+
+// ============================================================================
+// Base64 of one 100 ms audio event (6400 bytes)
+// ============================================================================
+
+BENCHMARK(Base64, Legacy) {
+    const std::vector<uint8_t>& payload = audioPayload();
+    while (state.keepRunning()) {
+        std::string out = legacyBase64Encode(payload.data(), payload.size());
+        doNotOptimize(out);
+    }
+    state.setBytesProcessed(payload.size());
+    state.setLabel("push_back");
+}
+
+BENCHMARK(Base64, Scalar) { runBase64(state, SimdIsa::Scalar); }
+BENCHMARK(Base64, SSSE3) { runBase64(state, SimdIsa::SSSE3); }
+BENCHMARK(Base64, AVX2) { runBase64(state, SimdIsa::AVX2); }
+
+BENCHMARK(Base64, Dispatched) {
+    const std::vector<uint8_t>& payload = audioPayload();
+    std::string out;
+    while (state.keepRunning()) {
+        out.clear();
+        appendBase64(out, payload.data(), payload.size());
+        doNotOptimize(out);
+    }
+    state.setBytesProcessed(payload.size());
+    state.setLabel(simdIsaName(preferredIsa()));
+}
+
+// ============================================================================
+// JSON escaping of a ~2 KB transcript
+// ============================================================================
+
+BENCHMARK(EscapeJson, LegacyClean) { runLegacyEscape(state, false); }
+BENCHMARK(EscapeJson, ScalarClean) { runEscape(state, false, SimdIsa::Scalar); }
+BENCHMARK(EscapeJson, SSE2Clean) { runEscape(state, false, SimdIsa::SSE2); }
+BENCHMARK(EscapeJson, AVX2Clean) { runEscape(state, false, SimdIsa::AVX2); }
+
+BENCHMARK(EscapeJson, LegacyEscapes) { runLegacyEscape(state, true); }
+BENCHMARK(EscapeJson, ScalarEscapes) { runEscape(state, true, SimdIsa::Scalar); }
+BENCHMARK(EscapeJson, SSE2Escapes) { runEscape(state, true, SimdIsa::SSE2); }
+BENCHMARK(EscapeJson, AVX2Escapes) { runEscape(state, true, SimdIsa::AVX2); }
@@ -1,5 +1,7 @@
 #include "audio_capture.h"
-#include "audio_resampler.h"
+#include "pipeline_metrics.h"
+#include "silence_detect.h"
+#include "trace_recorder.h"
 #include <iostream>
 #include <cstring>
 #include <string>
@@ -65,11 +67,29 @@ bool AudioCapture::initialize() {
     hr = m_audioClient->GetMixFormat(&m_captureFormat);
     RETURN_ON_ERROR(hr, "Failed to get mix format");
 
-    std::cout << "[AudioCapture] Device format: " 
+    std::cerr << "[AudioCapture] Device format: " 
               << m_captureFormat->nSamplesPerSec << " Hz, "
               << m_captureFormat->nChannels << " channels, "
               << m_captureFormat->wBitsPerSample << " bits" << std::endl;
 
+    // Conversion happens downstream (CaptureConverter), so only layouts it
+    // reads are accepted
+    if (m_captureFormat->wFormatTag == WAVE_FORMAT_IEEE_FLOAT ||
+        m_captureFormat->wFormatTag == WAVE_FORMAT_EXTENSIBLE) {
+        m_deviceFormat.type = DeviceSampleType::F32;
+    } else if (m_captureFormat->wBitsPerSample == 16) {
+        m_deviceFormat.type = DeviceSampleType::S16;
+    } else if (m_captureFormat->wBitsPerSample == 32) {
+        m_deviceFormat.type = DeviceSampleType::S32;
+    } else {
+        m_lastError = "Unsupported capture format (" + std::to_string(m_captureFormat->wBitsPerSample) +
+                      "-bit PCM)";
+        cleanup();
+        return false;
+    }
+    m_deviceFormat.sampleRate = m_captureFormat->nSamplesPerSec;
+    m_deviceFormat.channels = m_captureFormat->nChannels;
+
     // Initialize audio client in loopback mode
     // Buffer duration: 100ms (in 100-nanosecond units)
     REFERENCE_TIME bufferDuration = 1000000;  // 100ms
@@ -92,12 +112,12 @@ bool AudioCapture::initialize() {
     RETURN_ON_ERROR(hr, "Failed to get capture client");
 
     m_initialized = true;
-    std::cout << "[AudioCapture] Initialized successfully" << std::endl;
+    std::cerr << "[AudioCapture] Initialized successfully" << std::endl;
     
     return true;
 }
 
-bool AudioCapture::start(AudioChunkCallback callback) {
+bool AudioCapture::start(DeviceAudioCallback callback, SilenceCallback onSilence) {
     if (!m_initialized) {
         m_lastError = "Audio capture not initialized";
         return false;
@@ -108,6 +128,7 @@ bool AudioCapture::start(AudioChunkCallback callback) {
     }
 
     m_callback = std::move(callback);
+    m_silenceCallback = std::move(onSilence);
     m_shouldStop.store(false);
 
     // Start the audio client
@@ -122,7 +143,7 @@ bool AudioCapture::start(AudioChunkCallback callback) {
     // Start capture thread
     m_captureThread = std::thread(&AudioCapture::captureLoop, this);
 
-    std::cout << "[AudioCapture] Started capturing" << std::endl;
+    std::cerr << "[AudioCapture] Started capturing" << std::endl;
     return true;
 }
 
@@ -142,16 +163,30 @@ void AudioCapture::stop() {
     }
 
     m_capturing.store(false);
-    std::cout << "[AudioCapture] Stopped capturing" << std::endl;
+    std::cerr << "[AudioCapture] Stopped capturing" << std::endl;
+}
+
+// Digital silence: flagged by the engine, or every sample within one LSB.
+// Integer PCM other than 16-bit always takes the normal path.
+bool AudioCapture::isSilentPacket(const BYTE* data, UINT32 numFrames, DWORD flags) const {
+    if (flags & AUDCLNT_BUFFERFLAGS_SILENT) {
+        return true;
+    }
+
+    const size_t numSamples = static_cast<size_t>(numFrames) * m_captureFormat->nChannels;
+    if (m_captureFormat->wFormatTag == WAVE_FORMAT_IEEE_FLOAT ||
+        m_captureFormat->wFormatTag == WAVE_FORMAT_EXTENSIBLE) {
+        return isSilent(reinterpret_cast<const float*>(data), numSamples, DIGITAL_SILENCE_FLOOR);
+    }
+    if (m_captureFormat->wBitsPerSample == 16) {
+        return isSilent(reinterpret_cast<const int16_t*>(data), numSamples, DIGITAL_SILENCE_FLOOR_S16);
+    }
+    return false;
 }
 
 void AudioCapture::captureLoop() {
-    // Create resampler for converting to 16kHz mono
-    AudioResampler resampler(
-        m_captureFormat->nSamplesPerSec,
-        m_captureFormat->nChannels,
-        m_outputFormat.sampleRate
-    );
+    TraceRecorder& trace = TraceRecorder::instance();
+    trace.setThreadName("capture");
 
     UINT32 packetLength = 0;
     BYTE* data = nullptr;
@@ -167,6 +202,8 @@ void AudioCapture::captureLoop() {
         }
 
         while (packetLength != 0) {
+            TraceSpan packetSpan("capture_packet");
+
             // Get the buffer
             hr = m_captureClient->GetBuffer(
                 &data,
@@ -181,46 +218,19 @@ void AudioCapture::captureLoop() {
                 break;
             }
 
-            if (numFramesAvailable > 0) {
-                // Convert to float if needed and resample to 16kHz mono
-                std::vector<float> inputSamples;
-                
-                if (m_captureFormat->wFormatTag == WAVE_FORMAT_IEEE_FLOAT ||
-                    (m_captureFormat->wFormatTag == WAVE_FORMAT_EXTENSIBLE)) {
-                    // Already float format
-                    const float* floatData = reinterpret_cast<const float*>(data);
-                    size_t numSamples = numFramesAvailable * m_captureFormat->nChannels;
-                    inputSamples.assign(floatData, floatData + numSamples);
-                } else if (m_captureFormat->wBitsPerSample == 16) {
-                    // Convert from 16-bit PCM to float
-                    const int16_t* pcmData = reinterpret_cast<const int16_t*>(data);
-                    size_t numSamples = numFramesAvailable * m_captureFormat->nChannels;
-                    inputSamples.resize(numSamples);
-                    for (size_t i = 0; i < numSamples; ++i) {
-                        inputSamples[i] = static_cast<float>(pcmData[i]) / 32768.0f;
-                    }
-                } else if (m_captureFormat->wBitsPerSample == 32) {
-                    // 32-bit PCM to float
-                    const int32_t* pcmData = reinterpret_cast<const int32_t*>(data);
-                    size_t numSamples = numFramesAvailable * m_captureFormat->nChannels;
-                    inputSamples.resize(numSamples);
-                    for (size_t i = 0; i < numSamples; ++i) {
-                        inputSamples[i] = static_cast<float>(pcmData[i]) / 2147483648.0f;
-                    }
-                }
-
-                if (!inputSamples.empty()) {
-                    // Resample to 16kHz mono
-                    std::vector<float> outputSamples = resampler.process(
-                        inputSamples.data(),
-                        numFramesAvailable
-                    );
-
-                    // Send to callback
-                    if (m_callback && !outputSamples.empty()) {
-                        m_callback(outputSamples.data(), outputSamples.size());
-                    }
-                }
+            if (flags & AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY) {
+                metrics().captureDiscontinuities.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            packetSpan.setArg("frames", numFramesAvailable);
+
+            // Conversion and resampling happen in the pipeline; this thread
+            // only hands the buffer over before releasing it
+            if (numFramesAvailable > 0 && m_silenceCallback &&
+                isSilentPacket(data, numFramesAvailable, flags)) {
+                m_silenceCallback(numFramesAvailable);
+            } else if (numFramesAvailable > 0 && m_callback) {
+                m_callback(data, numFramesAvailable);
             }
 
             // Release buffer
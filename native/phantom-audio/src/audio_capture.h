@@ -10,17 +10,17 @@
 #include <thread>
 #include <mutex>
 
+#include "capture_converter.h"
+
 namespace phantom {
 
-// Audio format for processing (16kHz mono float32, as required by Whisper)
-struct AudioFormat {
-    uint32_t sampleRate = 16000;
-    uint16_t channels = 1;
-    uint16_t bitsPerSample = 32;  // float32
-};
+// Raw device buffer: numFrames interleaved frames in the device format.
+// The pointer is only valid during the call.
+using DeviceAudioCallback = std::function<void(const uint8_t* data, size_t numFrames)>;
 
-// Callback type for audio chunks
-using AudioChunkCallback = std::function<void(const float* samples, size_t numSamples)>;
+// Called instead of DeviceAudioCallback for a digitally silent packet,
+// with the number of device frames it stands for
+using SilenceCallback = std::function<void(size_t numFrames)>;
 
 class AudioCapture {
 public:
@@ -30,8 +30,10 @@ public:
     // Initialize WASAPI loopback on default output device
     bool initialize();
 
-    // Start capturing audio
-    bool start(AudioChunkCallback callback);
+    // Start capturing audio. Packets are handed over as the device gives
+    // them (see CaptureConverter); without a silence callback, silent
+    // packets are delivered as audio like any other.
+    bool start(DeviceAudioCallback callback, SilenceCallback onSilence = nullptr);
 
     // Stop capturing
     void stop();
@@ -42,12 +44,13 @@ public:
     // Get last error message
     const std::string& getLastError() const { return m_lastError; }
 
-    // Get current audio format
-    const AudioFormat& getFormat() const { return m_outputFormat; }
+    // Layout of the buffers passed to the callback (valid once initialized)
+    const DeviceFormat& getDeviceFormat() const { return m_deviceFormat; }
 
 private:
     void captureLoop();
     void cleanup();
+    bool isSilentPacket(const BYTE* data, UINT32 numFrames, DWORD flags) const;
 
     // COM interfaces
     IMMDeviceEnumerator* m_enumerator = nullptr;
@@ -57,9 +60,7 @@ private:
 
     // Capture format from device
     WAVEFORMATEX* m_captureFormat = nullptr;
-    
-    // Output format (for Whisper)
-    AudioFormat m_outputFormat;
+    DeviceFormat m_deviceFormat;
 
     // Capture state
     std::atomic<bool> m_capturing{false};
@@ -68,14 +69,12 @@ private:
     std::mutex m_mutex;
 
     // Callback for audio data
-    AudioChunkCallback m_callback;
+    DeviceAudioCallback m_callback;
+    SilenceCallback m_silenceCallback;
 
     // Error handling
     std::string m_lastError;
     bool m_initialized = false;
-
-    // Resampling buffer
-    std::vector<float> m_resampleBuffer;
 };
 
 } // namespace phantom
@@ -0,0 +1,72 @@
+#include "audio_chunk_buffer.h"
+
+namespace phantom {
+
+void AudioChunkBuffer::setFormat(SampleFormat format) {
+    m_format = format;
+    clear();
+}
+
+void AudioChunkBuffer::append(const float* samples, size_t numSamples) {
+    if (m_format == SampleFormat::S16) {
+        const size_t offset = m_s16.size();
+        m_s16.resize(offset + numSamples);
+        floatToS16(samples, m_s16.data() + offset, numSamples);
+    } else {
+        m_f32.insert(m_f32.end(), samples, samples + numSamples);
+    }
+}
+
+void AudioChunkBuffer::append(const int16_t* samples, size_t numSamples) {
+    if (m_format == SampleFormat::S16) {
+        m_s16.insert(m_s16.end(), samples, samples + numSamples);
+    } else {
+        const size_t offset = m_f32.size();
+        m_f32.resize(offset + numSamples);
+        s16ToFloat(samples, m_f32.data() + offset, numSamples);
+    }
+}
+
+size_t AudioChunkBuffer::size() const {
+    return m_format == SampleFormat::S16 ? m_s16.size() : m_f32.size();
+}
+
+void AudioChunkBuffer::clear() {
+    m_f32.clear();
+    m_s16.clear();
+}
+
+template <typename T>
+static bool takeChunkFrom(std::vector<T>& buffer, std::vector<T>& chunk,
+                          size_t chunkSamples, size_t overlap, bool draining) {
+    if (draining) {
+        if (buffer.size() <= overlap) return false;
+        chunk = std::move(buffer);
+        buffer.clear();
+        return true;
+    }
+    if (buffer.size() < chunkSamples) return false;
+
+    chunk.assign(buffer.begin(), buffer.begin() + chunkSamples);
+    if (buffer.size() > overlap) {
+        buffer.erase(buffer.begin(), buffer.begin() + chunkSamples - overlap);
+    }
+    return true;
+}
+
+bool AudioChunkBuffer::takeChunk(std::vector<float>& chunk, size_t chunkSamples, size_t overlap,
+                                 bool draining) {
+    if (m_format == SampleFormat::F32) {
+        return takeChunkFrom(m_f32, chunk, chunkSamples, overlap, draining);
+    }
+
+    if (!takeChunkFrom(m_s16, m_chunkS16, chunkSamples, overlap, draining)) {
+        return false;
+    }
+    // Single conversion point: whisper's feature extraction needs float
+    chunk.resize(m_chunkS16.size());
+    s16ToFloat(m_chunkS16.data(), chunk.data(), chunk.size());
+    return true;
+}
+
+} // namespace phantom
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "sample_format.h"
+
+namespace phantom {
+
+/**
+ * Audio waiting to be transcribed, stored as float32 or int16.
+ *
+ * Capture packets are appended in either format and converted to the
+ * storage format on the way in; chunks always come out as float, since
+ * that is what whisper consumes. Not thread-safe: WhisperWrapper guards
+ * it with its buffer mutex.
+ */
+class AudioChunkBuffer {
+public:
+    // Changing the format drops anything buffered
+    void setFormat(SampleFormat format);
+    SampleFormat getFormat() const { return m_format; }
+
+    void append(const float* samples, size_t numSamples);
+    void append(const int16_t* samples, size_t numSamples);
+
+    size_t size() const;
+    void clear();
+
+    /**
+     * Move the next chunk out, keeping `overlap` samples buffered as
+     * context for the following chunk. When draining, take whatever is
+     * left as long as it is longer than the overlap.
+     * @return false if not enough audio is buffered
+     */
+    bool takeChunk(std::vector<float>& chunk, size_t chunkSamples, size_t overlap, bool draining);
+
+private:
+    SampleFormat m_format = SampleFormat::F32;
+    std::vector<float> m_f32;
+    std::vector<int16_t> m_s16;
+    std::vector<int16_t> m_chunkS16;    // Scratch for s16 chunks
+};
+
+} // namespace phantom
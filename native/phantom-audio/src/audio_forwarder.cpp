@@ -0,0 +1,98 @@
+#include "audio_forwarder.h"
+#include "json_protocol.h"
+#include "shared_audio_ring.h"
+
+namespace phantom {
+
+AudioForwarder::~AudioForwarder() {
+    delete m_flac.exchange(nullptr);
+}
+
+void AudioForwarder::enableFlac(uint64_t segmentSamples) {
+    if (m_flac.load()) return;
+    m_flacSegmentSamples = segmentSamples;
+    m_flac.store(new FlacEncoder(16000), std::memory_order_release);
+}
+
+void AudioForwarder::setSilenceFlushMs(int ms) {
+    m_silenceFlushSamples.store(static_cast<uint64_t>(ms > 0 ? ms : 0) * 16, std::memory_order_relaxed);
+}
+
+void AudioForwarder::forward(const float* samples, size_t numSamples) {
+    placeSilenceRun();
+    forwardAudio(samples, numSamples);
+}
+
+void AudioForwarder::forward(const int16_t* samples, size_t numSamples) {
+    placeSilenceRun();
+    forwardAudio(samples, numSamples);
+}
+
+void AudioForwarder::forwardSilence(size_t numSamples) {
+    m_silenceRunSamples += numSamples;
+
+    // Long enough to end the utterance: upload the speech before it now
+    if (m_silenceRunSamples >= m_silenceFlushSamples.load(std::memory_order_relaxed)) {
+        finishFlacSegment();
+    }
+    if (m_silenceRunSamples >= MAX_SILENCE_RUN_SAMPLES) {
+        flushSilenceRun();
+    }
+}
+
+void AudioForwarder::placeSilenceRun() {
+    FlacEncoder* encoder = m_flac.load(std::memory_order_acquire);
+    if (m_silenceRunSamples == 0 || !encoder || !encoder->inSegment()) {
+        flushSilenceRun();
+        return;
+    }
+
+    // The segment is still open, so the gap was too short to close it
+    m_silence.assign(static_cast<size_t>(m_silenceRunSamples), 0);
+    m_silenceRunSamples = 0;
+    encodeFlac(*encoder, m_silence.data(), m_silence.size());
+}
+
+void AudioForwarder::flushSilenceRun() {
+    if (m_silenceRunSamples == 0) return;
+    sendSilence(static_cast<size_t>(m_silenceRunSamples));
+    m_silenceRunSamples = 0;
+}
+
+void AudioForwarder::finishFlacSegment() {
+    FlacEncoder* encoder = m_flac.load(std::memory_order_acquire);
+    if (!encoder || !encoder->inSegment()) return;
+
+    m_flacBuffer.clear();
+    encoder->finishSegment(m_flacBuffer);
+    sendFlacData(m_flacBuffer.data(), m_flacBuffer.size(), FRAME_FLAG_SEGMENT_END, 0);
+}
+
+template <typename Sample>
+void AudioForwarder::forwardAudio(const Sample* samples, size_t numSamples) {
+    if (m_ring) {
+        m_ring->write(samples, numSamples);
+    }
+    if (FlacEncoder* encoder = m_flac.load(std::memory_order_acquire)) {
+        encodeFlac(*encoder, samples, numSamples);
+    } else if (m_streamAudio && !m_ring) {  // The ring replaces PCM on stdout
+        sendAudioChunk(samples, numSamples);
+    }
+}
+
+// Encode forwarded audio and emit whatever complete blocks it produced
+template <typename Sample>
+void AudioForwarder::encodeFlac(FlacEncoder& encoder, const Sample* samples, size_t numSamples) {
+    m_flacBuffer.clear();
+    uint8_t flags = encoder.inSegment() ? 0 : FRAME_FLAG_SEGMENT_START;
+
+    encoder.encode(samples, numSamples, m_flacBuffer);
+    if (m_flacSegmentSamples > 0 && encoder.getSegmentSamples() >= m_flacSegmentSamples) {
+        encoder.finishSegment(m_flacBuffer);
+        flags |= FRAME_FLAG_SEGMENT_END;
+    }
+
+    sendFlacData(m_flacBuffer.data(), m_flacBuffer.size(), flags, numSamples);
+}
+
+} // namespace phantom
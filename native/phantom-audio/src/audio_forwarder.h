@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "flac_encoder.h"
+#include "transcription_config.h"
+
+namespace phantom {
+
+class SharedAudioRing;
+
+/**
+ * The pipeline's forward stage: hands the 16kHz stream to the transports
+ * and reports digital silence between the audio it forwards.
+ *
+ * The shared ring, when there is one, gets every audio packet whatever
+ * stdout carries, so local readers keep tapping the stream in cloud mode.
+ * stdout carries FLAC segments once a hello asks for them, otherwise PCM
+ * frames if STREAM_AUDIO is set and there is no ring.
+ *
+ * Digital silence is reported as silence events. A run that reaches
+ * config.silenceFlushMs, the point where whisper decodes what it has, also
+ * closes the open FLAC segment so the speech before it is uploaded now.
+ * A shorter gap is held; when audio resumes, it is encoded into the open
+ * segment as zeros instead, so pauses between words do not split uploads.
+ *
+ * Apart from enableFlac(), calls come from the forward stage, or from the
+ * stdin thread while the pipeline is drained.
+ */
+class AudioForwarder {
+public:
+    // Silence runs are reported every 10s so clients' clocks never lag far
+    static constexpr uint64_t MAX_SILENCE_RUN_SAMPLES = 16000 * 10;
+
+    AudioForwarder() = default;
+    ~AudioForwarder();
+
+    AudioForwarder(const AudioForwarder&) = delete;
+    AudioForwarder& operator=(const AudioForwarder&) = delete;
+
+    // Set before the pipeline starts
+    void setRing(SharedAudioRing* ring) { m_ring = ring; }
+    void setStreamAudio(bool enabled) { m_streamAudio = enabled; }
+
+    /**
+     * Send stdout audio as FLAC from now on, in segments of `segmentSamples`
+     * (0 = until silence or stop). Only the first call has an effect. Safe
+     * from any thread: the encoder is published after its settings.
+     */
+    void enableFlac(uint64_t segmentSamples);
+    bool isFlacEnabled() const { return flacEncoder() != nullptr; }
+
+    // Silence that closes a FLAC segment (config.silenceFlushMs); any thread
+    void setSilenceFlushMs(int ms);
+    const FlacEncoder* flacEncoder() const { return m_flac.load(std::memory_order_acquire); }
+
+    void forward(const float* samples, size_t numSamples);
+    void forward(const int16_t* samples, size_t numSamples);
+    void forwardSilence(size_t numSamples);
+
+    // Report the silence run so far, before any audio that follows it
+    void flushSilenceRun();
+
+    // Close the open segment so the client has a complete file before "stopped"
+    void finishFlacSegment();
+
+    // Forget a silence run left over from the last capture
+    void reset() { m_silenceRunSamples = 0; }
+
+private:
+    template <typename Sample>
+    void forwardAudio(const Sample* samples, size_t numSamples);
+
+    template <typename Sample>
+    void encodeFlac(FlacEncoder& encoder, const Sample* samples, size_t numSamples);
+
+    // Encode a held gap into the open segment, or report it as silence
+    void placeSilenceRun();
+
+    SharedAudioRing* m_ring = nullptr;
+    bool m_streamAudio = false;
+
+    std::atomic<FlacEncoder*> m_flac{nullptr};
+    uint64_t m_flacSegmentSamples = 0;
+    std::vector<uint8_t> m_flacBuffer;
+
+    uint64_t m_silenceRunSamples = 0;
+    std::vector<int16_t> m_silence;     // Zeros standing in for a held gap
+    std::atomic<uint64_t> m_silenceFlushSamples{
+        static_cast<uint64_t>(TranscriptionConfig().silenceFlushMs) * 16};
+};
+
+} // namespace phantom
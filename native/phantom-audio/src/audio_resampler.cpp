@@ -1,4 +1,5 @@
 #include "audio_resampler.h"
+#include "sample_format.h"
 #include <cmath>
 #include <algorithm>
 
@@ -15,37 +16,42 @@ AudioResampler::AudioResampler(uint32_t inputSampleRate, uint16_t inputChannels,
 }
 
 std::vector<float> AudioResampler::process(const float* input, size_t numFrames) {
+    std::vector<float> output;
+    process(input, numFrames, output);
+    return output;
+}
+
+void AudioResampler::process(const float* input, size_t numFrames, std::vector<float>& output) {
+    output.clear();
     if (numFrames == 0 || input == nullptr) {
-        return {};
+        return;
     }
 
-    // First, convert to mono by averaging channels
-    std::vector<float> mono(numFrames);
-    if (m_inputChannels == 1) {
-        std::copy(input, input + numFrames, mono.begin());
-    } else {
-        for (size_t i = 0; i < numFrames; ++i) {
-            float sum = 0.0f;
-            for (uint16_t ch = 0; ch < m_inputChannels; ++ch) {
-                sum += input[i * m_inputChannels + ch];
-            }
-            mono[i] = sum / m_inputChannels;
+    // If sample rates match, the mono mix is the output
+    if (m_inputSampleRate == m_outputSampleRate) {
+        output.resize(numFrames);
+        if (m_inputChannels == 1) {
+            std::copy(input, input + numFrames, output.begin());
+        } else {
+            downmixToMono(input, output.data(), numFrames, m_inputChannels);
         }
+        return;
     }
 
-    // If sample rates match, just return mono
-    if (m_inputSampleRate == m_outputSampleRate) {
-        return mono;
+    // First, convert to mono by averaging channels
+    const float* mono = input;
+    if (m_inputChannels != 1) {
+        m_mono.resize(numFrames);
+        downmixToMono(input, m_mono.data(), numFrames, m_inputChannels);
+        mono = m_mono.data();
     }
 
     // Calculate output size
     size_t outputFrames = static_cast<size_t>(std::ceil(numFrames / m_ratio));
-    std::vector<float> output;
     output.reserve(outputFrames);
 
     // Linear interpolation resampling
     double position = m_fractionalPosition;
-    float prevSample = m_lastSample;
 
     while (position < numFrames) {
         size_t index = static_cast<size_t>(position);
@@ -62,12 +68,29 @@ std::vector<float> AudioResampler::process(const float* input, size_t numFrames)
     }
 
     // Save state for next call
-    if (numFrames > 0) {
-        m_lastSample = mono[numFrames - 1];
-    }
+    m_lastSample = mono[numFrames - 1];
     m_fractionalPosition = position - numFrames;
+}
 
-    return output;
+size_t AudioResampler::skip(size_t numFrames) {
+    if (numFrames == 0) {
+        return 0;
+    }
+    m_lastSample = 0.0f;
+
+    if (m_inputSampleRate == m_outputSampleRate) {
+        return numFrames;
+    }
+
+    // Same stepping as process(), without the interpolation
+    double position = m_fractionalPosition;
+    size_t outputFrames = 0;
+    while (position < numFrames) {
+        ++outputFrames;
+        position += m_ratio;
+    }
+    m_fractionalPosition = position - numFrames;
+    return outputFrames;
 }
 
 void AudioResampler::reset() {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <cstddef>
 #include <cstdint>
 
 namespace phantom {
@@ -30,6 +31,20 @@ public:
      */
     std::vector<float> process(const float* input, size_t numFrames);
 
+    /**
+     * As process(), into a caller-owned vector whose capacity is reused
+     * @param output Replaced with the resampled mono samples
+     */
+    void process(const float* input, size_t numFrames, std::vector<float>& output);
+
+    /**
+     * Advance over numFrames of silence without touching samples, as if
+     * process() had been given zeros. Keeps the output clock (and the
+     * fractional phase) exactly where process() would have left it.
+     * @return Number of output samples the silence corresponds to
+     */
+    size_t skip(size_t numFrames);
+
     /**
      * Reset the resampler state
      */
@@ -44,6 +59,9 @@ private:
     // For interpolation
     float m_lastSample = 0.0f;
     double m_fractionalPosition = 0.0;
+
+    // Downmix scratch, reused across calls
+    std::vector<float> m_mono;
 };
 
 } // namespace phantom
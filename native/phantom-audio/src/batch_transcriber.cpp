@@ -0,0 +1,376 @@
+#include "batch_transcriber.h"
+#include "audio_resampler.h"
+#include "pipeline_metrics.h"
+#include "session_recorder.h"
+#include "text_encoding.h"
+#include "trace_recorder.h"
+#include "wav_reader.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <string_view>
+#include <thread>
+
+namespace phantom {
+
+namespace {
+    // Frames read from a file per resampler call (~1s at 48kHz)
+    constexpr size_t READ_FRAMES = 48000;
+
+    // Decoder threads per worker when the config leaves it at 0; whisper
+    // scales poorly past a handful, so more workers beat more threads
+    constexpr int DEFAULT_THREADS_PER_WORKER = 4;
+    constexpr int MAX_WORKERS = 32;
+
+    // Offline nothing waits on a segment, so re-decodes are never cut short
+    constexpr uint64_t NO_DECODE_BUDGET = std::numeric_limits<uint64_t>::max();
+
+    void appendFileField(std::string& out, const std::string& file) {
+        out += "\"file\":\"";
+        appendJsonEscaped(out, file.data(), file.size());
+        out += '"';
+    }
+
+    void appendErrorLine(std::string& out, const std::string& file, const std::string& message) {
+        out += "{\"type\":\"error\",";
+        appendFileField(out, file);
+        out += ",\"message\":\"";
+        appendJsonEscaped(out, message.data(), message.size());
+        out += "\"}\n";
+    }
+}
+
+BatchTranscriber::BatchTranscriber(EngineFactory engines)
+    : m_engines(std::move(engines))
+{
+}
+
+bool BatchTranscriber::run(const BatchOptions& options) {
+    const int hardware = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    m_threadsPerWorker = options.config.threads > 0
+        ? options.config.threads
+        : std::min(DEFAULT_THREADS_PER_WORKER, hardware);
+    int workers = options.workers > 0 ? options.workers : std::max(1, hardware / m_threadsPerWorker);
+    workers = std::min(workers, MAX_WORKERS);
+
+    std::vector<std::unique_ptr<TranscriptionEngine>> engines;
+    for (int i = 0; i < workers && m_engines; ++i) {
+        std::unique_ptr<TranscriptionEngine> engine = m_engines();
+        if (!engine) break;
+        engines.push_back(std::move(engine));
+    }
+    if (engines.empty()) {
+        m_lastError = "Failed to create a transcription engine";
+        return false;
+    }
+    if (options.config.language != "auto" && engines[0]->languageId(options.config.language) < 0) {
+        m_lastError = "Unsupported language: " + options.config.language;
+        return false;
+    }
+
+    m_out = stdout;
+    if (!options.outputPath.empty()) {
+        m_out = std::fopen(options.outputPath.c_str(), "wb");
+        if (!m_out) {
+            m_lastError = "Cannot create output file: " + options.outputPath;
+            return false;
+        }
+    }
+
+    m_options = &options;
+    m_queue.clear();
+    m_maxQueued = static_cast<size_t>(workers) * 2;
+    m_loadingDone = false;
+    m_nextSeq = 0;
+    m_finished.clear();
+    m_nextToWrite = 0;
+    m_fileSegments = 0;
+    m_fileFailed = false;
+    m_audioSeconds = 0.0;
+    m_failedFiles = 0;
+    m_writeFailed = false;
+
+    std::cerr << "[Batch] " << options.files.size() << " file(s), " << engines.size() << " worker(s) x "
+              << m_threadsPerWorker << " thread(s), " << engines[0]->name() << std::endl;
+
+    const uint64_t startUs = metricsNowUs();
+    std::vector<std::thread> threads;
+    for (const std::unique_ptr<TranscriptionEngine>& engine : engines) {
+        threads.emplace_back(&BatchTranscriber::workerLoop, this, engine.get());
+    }
+
+    // This thread reads and splits files while the workers decode
+    for (size_t i = 0; i < options.files.size(); ++i) {
+        loadFile(i);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_loadingDone = true;
+    }
+    m_queueCv.notify_all();
+
+    for (std::thread& thread : threads) thread.join();
+
+    const double wallSeconds = static_cast<double>(metricsNowUs() - startUs) / 1e6;
+    char summary[256];
+    std::snprintf(summary, sizeof(summary),
+                  "{\"type\":\"summary\",\"files\":%zu,\"failed\":%zu,\"audio_s\":%.3f,\"wall_s\":%.3f,"
+                  "\"rtf\":%.4f,\"workers\":%zu}\n",
+                  options.files.size(), m_failedFiles, m_audioSeconds, wallSeconds,
+                  m_audioSeconds > 0.0 ? wallSeconds / m_audioSeconds : 0.0, engines.size());
+    m_writeFailed |= std::fputs(summary, m_out) < 0;
+    m_writeFailed |= std::fflush(m_out) != 0;
+    if (m_out != stdout) m_writeFailed |= std::fclose(m_out) != 0;
+    m_out = nullptr;
+    m_options = nullptr;
+
+    std::cerr << "[Batch] " << m_audioSeconds << "s of audio in " << wallSeconds << "s" << std::endl;
+
+    if (m_writeFailed) {
+        m_lastError = "Failed writing transcript output";
+        return false;
+    }
+    if (m_failedFiles > 0) {
+        m_lastError = std::to_string(m_failedFiles) + " file(s) could not be transcribed";
+        return false;
+    }
+    return true;
+}
+
+// The requested range of a session recording; it is already 16kHz mono
+bool BatchTranscriber::readSession(const std::string& path, std::vector<float>& audio, uint64_t* firstSample,
+                                   std::string* error) const {
+    SessionReader reader;
+    if (!reader.open(path) || reader.sampleRate() != SAMPLE_RATE) {
+        *error = reader.getLastError().empty() ? "Unsupported session sample rate: " + path : reader.getLastError();
+        return false;
+    }
+    const uint64_t first = std::min(static_cast<uint64_t>(m_options->fromSeconds * SAMPLE_RATE), reader.samples());
+    const uint64_t end = m_options->toSeconds > 0.0 ? static_cast<uint64_t>(m_options->toSeconds * SAMPLE_RATE)
+                                                    : reader.samples();
+    if (!reader.read(first, end, audio)) {
+        *error = reader.getLastError();
+        return false;
+    }
+    *firstSample = first;
+    return true;
+}
+
+// Read a file (or its requested range) as 16kHz mono and queue one job per
+// speech segment
+void BatchTranscriber::loadFile(size_t fileIndex) {
+    const std::string& path = m_options->files[fileIndex];
+    TraceSpan span("batch_load");
+
+    Job job;
+    job.fileIndex = fileIndex;
+    job.lastOfFile = true;
+
+    auto audio = std::make_shared<std::vector<float>>();
+    uint64_t firstSample = 0;
+    if (SessionReader::isSessionFile(path)) {
+        if (!readSession(path, *audio, &firstSample, &job.error)) {
+            pushJob(std::move(job));
+            return;
+        }
+    } else {
+        WavReader reader;
+        if (!reader.open(path)) {
+            job.error = reader.getLastError();
+            pushJob(std::move(job));
+            return;
+        }
+
+        audio->reserve(static_cast<size_t>(reader.durationSeconds() * SAMPLE_RATE) + SAMPLE_RATE);
+        AudioResampler resampler(reader.sampleRate(), reader.channels(), SAMPLE_RATE);
+        std::vector<float> block(READ_FRAMES * reader.channels());
+        while (const size_t frames = reader.read(block.data(), READ_FRAMES)) {
+            const std::vector<float> resampled = resampler.process(block.data(), frames);
+            audio->insert(audio->end(), resampled.begin(), resampled.end());
+        }
+
+        // WAVs are decoded whole and cut to the range afterwards
+        const size_t end = m_options->toSeconds > 0.0
+            ? std::min(audio->size(), static_cast<size_t>(m_options->toSeconds * SAMPLE_RATE))
+            : audio->size();
+        firstSample = std::min(static_cast<size_t>(m_options->fromSeconds * SAMPLE_RATE), end);
+        audio->erase(audio->begin() + static_cast<ptrdiff_t>(end), audio->end());
+        audio->erase(audio->begin(), audio->begin() + static_cast<ptrdiff_t>(firstSample));
+    }
+    job.audio = audio;
+    job.firstSample = firstSample;
+
+    const std::vector<AudioSpan> spans = splitAtSilences(audio->data(), audio->size(), m_options->split);
+    if (spans.empty()) {
+        // Nothing but silence: still report the file
+        pushJob(std::move(job));
+        return;
+    }
+    for (size_t i = 0; i < spans.size(); ++i) {
+        Job segment;
+        segment.fileIndex = fileIndex;
+        segment.audio = audio;
+        segment.firstSample = firstSample;
+        segment.span = spans[i];
+        segment.lastOfFile = i + 1 == spans.size();
+        pushJob(std::move(segment));
+    }
+}
+
+void BatchTranscriber::pushJob(Job job) {
+    {
+        std::unique_lock<std::mutex> lock(m_queueMutex);
+        m_queueCv.wait(lock, [&] { return m_queue.size() < m_maxQueued; });
+        job.seq = m_nextSeq++;
+        m_queue.push_back(std::move(job));
+    }
+    m_queueCv.notify_all();
+}
+
+void BatchTranscriber::workerLoop(TranscriptionEngine* engine) {
+    TraceRecorder::instance().setThreadName("batch_worker");
+
+    // Decode costs are learned per worker, like the live policy's
+    DecodePolicy policy;
+
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_queueCv.wait(lock, [&] { return !m_queue.empty() || m_loadingDone; });
+            if (m_queue.empty()) return;
+            job = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        // Room for the loader again
+        m_queueCv.notify_all();
+
+        const uint64_t seq = job.seq;
+        complete(seq, transcribeJob(*engine, policy, job));
+    }
+}
+
+BatchTranscriber::Result BatchTranscriber::transcribeJob(TranscriptionEngine& engine, DecodePolicy& policy,
+                                                         const Job& job) {
+    const std::string& file = m_options->files[job.fileIndex];
+    Result result;
+    result.fileIndex = job.fileIndex;
+    result.lastOfFile = job.lastOfFile;
+    result.fileSamples = job.audio ? job.audio->size() : 0;
+
+    if (!job.error.empty()) {
+        result.failed = true;
+        appendErrorLine(result.lines, file, job.error);
+        return result;
+    }
+    if (job.span.end <= job.span.start) return result;
+
+    // Segments are decoded out of order, so none can prompt the next.
+    // Tokens come back on the file's clock.
+    const TranscriptionConfig& config = m_options->config;
+    DecodeRequest request;
+    request.samples = job.audio->data() + job.span.start;
+    request.numSamples = job.span.end - job.span.start;
+    request.firstSample = job.firstSample + job.span.start;
+    request.language = config.language.c_str();
+    request.threads = m_threadsPerWorker;
+
+    TraceSpan span("batch_segment", "samples", static_cast<int64_t>(request.numSamples));
+    const uint64_t audioUs = static_cast<uint64_t>(request.numSamples) * 1000000 / SAMPLE_RATE;
+    const uint64_t startUs = metricsNowUs();
+
+    // As WhisperWrapper::transcribe, keeping the most plausible decode
+    DecodeAttempt attempt = policy.first(config.beamSize);
+    DecodeResult best;
+    DecodeQuality bestQuality;
+    bool decoded = false;
+    for (size_t attempts = 1;; ++attempts) {
+        request.attempt = attempt;
+        DecodeResult candidate;
+        DecodeQuality quality;
+        const uint64_t attemptStartUs = metricsNowUs();
+        const bool ok = decodeGuarded(engine, request, candidate, &quality);
+        const uint64_t elapsedUs = metricsNowUs() - attemptStartUs;
+        metrics().inference.record(elapsedUs);
+        if (ok) {
+            policy.recordCost(attempt.tier, elapsedUs, audioUs);
+            if (!decoded || DecodePolicy::isBetter(quality, bestQuality)) {
+                best = std::move(candidate);
+                bestQuality = quality;
+            }
+            decoded = true;
+        } else if (!decoded) {
+            break;
+        }
+
+        DecodeAttempt retry;
+        if (!policy.next(attempt, quality, attempts, metricsNowUs() - startUs, NO_DECODE_BUDGET, audioUs, 0,
+                         &retry)) {
+            break;
+        }
+        metrics().redecodes.fetch_add(1, std::memory_order_relaxed);
+        attempt = retry;
+    }
+    metrics().chunksTranscribed.fetch_add(1, std::memory_order_relaxed);
+
+    if (!decoded) {
+        result.failed = true;
+        appendErrorLine(result.lines, file, engine.getLastError());
+        return result;
+    }
+
+    std::string text;
+    for (const StreamToken& token : best.tokens) text += token.text;
+    std::string_view trimmed(text);
+    const size_t first = trimmed.find_first_not_of(" \t\n\r");
+    if (first == std::string_view::npos) return result;
+    trimmed = trimmed.substr(first, trimmed.find_last_not_of(" \t\n\r") - first + 1);
+
+    const uint64_t startMs = best.tokens.front().startSample * 1000 / SAMPLE_RATE;
+    const uint64_t endMs = best.tokens.back().endSample * 1000 / SAMPLE_RATE;
+    result.lines += "{\"type\":\"segment\",";
+    appendFileField(result.lines, file);
+    result.lines += ",\"start_ms\":" + std::to_string(startMs);
+    result.lines += ",\"end_ms\":" + std::to_string(endMs);
+    result.lines += ",\"text\":\"";
+    appendJsonEscaped(result.lines, trimmed.data(), trimmed.size());
+    result.lines += "\"}\n";
+    result.segments = 1;
+    return result;
+}
+
+// Store a finished job and write out every job that is now next in order
+void BatchTranscriber::complete(uint64_t seq, Result result) {
+    std::lock_guard<std::mutex> lock(m_outputMutex);
+    m_finished.emplace(seq, std::move(result));
+
+    for (auto it = m_finished.find(m_nextToWrite); it != m_finished.end();
+         it = m_finished.find(m_nextToWrite)) {
+        Result& ready = it->second;
+        m_fileSegments += ready.segments;
+        m_fileFailed |= ready.failed;
+
+        if (ready.lastOfFile) {
+            if (m_fileFailed) ++m_failedFiles;
+            // An unreadable file gets only its error line
+            if (ready.fileSamples > 0 || !ready.failed) {
+                m_audioSeconds += static_cast<double>(ready.fileSamples) / SAMPLE_RATE;
+                ready.lines += "{\"type\":\"file\",";
+                appendFileField(ready.lines, m_options->files[ready.fileIndex]);
+                ready.lines += ",\"duration_ms\":" +
+                               std::to_string(static_cast<uint64_t>(ready.fileSamples) * 1000 / SAMPLE_RATE);
+                ready.lines += ",\"segments\":" + std::to_string(m_fileSegments) + "}\n";
+            }
+            m_fileSegments = 0;
+            m_fileFailed = false;
+        }
+
+        m_writeFailed |= std::fwrite(ready.lines.data(), 1, ready.lines.size(), m_out) != ready.lines.size();
+        m_finished.erase(it);
+        ++m_nextToWrite;
+    }
+    std::fflush(m_out);
+}
+
+} // namespace phantom
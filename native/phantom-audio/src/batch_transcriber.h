@@ -0,0 +1,133 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "decode_policy.h"
+#include "silence_split.h"
+#include "transcription_config.h"
+#include "transcription_engine.h"
+
+namespace phantom {
+
+// Makes one worker's engine; nullptr when no more can be made
+using EngineFactory = std::function<std::unique_ptr<TranscriptionEngine>()>;
+
+struct BatchOptions {
+    std::vector<std::string> files;
+    std::string outputPath;          // Empty = stdout
+    int workers = 0;                 // 0 = hardware threads / threads per worker
+    TranscriptionConfig config;      // threads = per worker (0 = 4); chunkMs unused
+    SplitOptions split;
+    double fromSeconds = 0.0;        // Part of each file to transcribe;
+    double toSeconds = 0.0;          // toSeconds 0 = to the end
+};
+
+/**
+ * Offline transcription of recorded audio: WAV files, or session
+ * recordings (see session_recorder.h), of which only the requested range
+ * is read. Files are decoded and resampled
+ * to 16kHz, cut at pauses into segments of at most ~28s and spread over a
+ * pool of workers, each with its own engine. With WhisperEngine workers
+ * share one model (see WhisperEngine::createWorker), so memory grows by a
+ * state (not a model) per worker and throughput scales with cores.
+ *
+ * Segments are decoded like live chunks (see decodeGuarded): a token
+ * limit for their length, loops cut back, and doubtful results decoded
+ * again as DecodePolicy decides. Offline there is no latency budget, so
+ * a segment gets every retry the policy allows.
+ *
+ * Output is JSONL, in input order regardless of which worker finished
+ * first. Times are from the start of the file, also when only a range is
+ * transcribed:
+ *   {"type":"segment","file":"a.wav","start_ms":N,"end_ms":N,"text":"..."}
+ *   {"type":"file","file":"a.wav","duration_ms":N,"segments":N}
+ *   {"type":"error","file":"b.wav","message":"..."}
+ *   {"type":"summary","files":N,"failed":N,"audio_s":X,"wall_s":X,"rtf":X,"workers":N}
+ */
+class BatchTranscriber {
+public:
+    /**
+     * @param engines Called once per worker at the start of each run
+     */
+    explicit BatchTranscriber(EngineFactory engines);
+
+    BatchTranscriber(const BatchTranscriber&) = delete;
+    BatchTranscriber& operator=(const BatchTranscriber&) = delete;
+
+    /**
+     * Transcribe every file and write the JSONL
+     * @return false (see getLastError) if the run could not start or any
+     *         file failed; failed files are also reported in the output
+     */
+    bool run(const BatchOptions& options);
+
+    const std::string& getLastError() const { return m_lastError; }
+
+private:
+    struct Job {
+        uint64_t seq = 0;
+        size_t fileIndex = 0;
+        std::shared_ptr<const std::vector<float>> audio;  // 16kHz mono, the requested range
+        uint64_t firstSample = 0;                          // Where audio[0] sits in the file
+        AudioSpan span;
+        bool lastOfFile = false;
+        std::string error;  // Set for a file that could not be read
+    };
+
+    // A job's output, held until every earlier job has been written
+    struct Result {
+        std::string lines;
+        size_t segments = 0;
+        size_t fileIndex = 0;
+        size_t fileSamples = 0;
+        bool lastOfFile = false;
+        bool failed = false;
+    };
+
+    void workerLoop(TranscriptionEngine* engine);
+    void loadFile(size_t fileIndex);
+    bool readSession(const std::string& path, std::vector<float>& audio, uint64_t* firstSample,
+                     std::string* error) const;
+    void pushJob(Job job);
+    Result transcribeJob(TranscriptionEngine& engine, DecodePolicy& policy, const Job& job);
+    void complete(uint64_t seq, Result result);
+
+    EngineFactory m_engines;
+    std::string m_lastError;
+
+    // Run inputs, fixed while workers are running
+    const BatchOptions* m_options = nullptr;
+    int m_threadsPerWorker = 1;
+    std::FILE* m_out = nullptr;
+
+    // Job queue, bounded so only a few files' audio is held at once
+    std::mutex m_queueMutex;
+    std::condition_variable m_queueCv;
+    std::deque<Job> m_queue;
+    size_t m_maxQueued = 0;
+    bool m_loadingDone = false;
+    uint64_t m_nextSeq = 0;
+
+    // Finished jobs waiting for their turn in the output
+    std::mutex m_outputMutex;
+    std::map<uint64_t, Result> m_finished;
+    uint64_t m_nextToWrite = 0;
+    size_t m_fileSegments = 0;  // Segments written so far for the current file
+    bool m_fileFailed = false;  // Any of the current file's jobs failed
+    double m_audioSeconds = 0.0;
+    size_t m_failedFiles = 0;
+    bool m_writeFailed = false;
+
+    static constexpr size_t SAMPLE_RATE = 16000;
+};
+
+} // namespace phantom
@@ -0,0 +1,54 @@
+#include "capture_converter.h"
+#include "sample_format.h"
+
+namespace phantom {
+
+size_t DeviceFormat::bytesPerFrame() const {
+    const size_t sampleBytes = type == DeviceSampleType::S16 ? sizeof(int16_t) : sizeof(float);
+    return sampleBytes * channels;
+}
+
+CaptureConverter::CaptureConverter(const DeviceFormat& format, uint32_t outputSampleRate)
+    : m_format(format)
+    , m_outputSampleRate(outputSampleRate)
+    , m_resampler(format.sampleRate, format.channels, outputSampleRate)
+{
+}
+
+void CaptureConverter::process(const uint8_t* data, size_t numFrames, std::vector<float>& output) {
+    if (numFrames == 0 || data == nullptr) {
+        output.clear();
+        return;
+    }
+
+    const size_t numSamples = numFrames * m_format.channels;
+    const float* samples = reinterpret_cast<const float*>(data);
+    if (m_format.type == DeviceSampleType::S16) {
+        m_samples.resize(numSamples);
+        s16ToFloat(reinterpret_cast<const int16_t*>(data), m_samples.data(), numSamples);
+        samples = m_samples.data();
+    } else if (m_format.type == DeviceSampleType::S32) {
+        const int32_t* pcm = reinterpret_cast<const int32_t*>(data);
+        m_samples.resize(numSamples);
+        for (size_t i = 0; i < numSamples; ++i) {
+            m_samples[i] = static_cast<float>(pcm[i]) / 2147483648.0f;
+        }
+        samples = m_samples.data();
+    }
+
+    m_resampler.process(samples, numFrames, output);
+}
+
+size_t CaptureConverter::skip(size_t numFrames) {
+    return m_resampler.skip(numFrames);
+}
+
+size_t CaptureConverter::outputSamples(size_t numFrames) const {
+    return static_cast<size_t>(static_cast<uint64_t>(numFrames) * m_outputSampleRate / m_format.sampleRate);
+}
+
+void CaptureConverter::reset() {
+    m_resampler.reset();
+}
+
+} // namespace phantom
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "audio_resampler.h"
+
+namespace phantom {
+
+// Sample encodings a capture device hands over
+enum class DeviceSampleType : uint8_t {
+    F32,    // IEEE float
+    S16,    // 16-bit PCM
+    S32     // 32-bit PCM
+};
+
+// Interleaved layout of a capture device's buffers
+struct DeviceFormat {
+    DeviceSampleType type = DeviceSampleType::F32;
+    uint32_t sampleRate = 48000;
+    uint16_t channels = 2;
+
+    size_t bytesPerFrame() const;
+};
+
+/**
+ * Turns raw capture buffers into 16kHz mono float: device samples to
+ * float, then downmix and resample. The capture thread only copies the
+ * device buffer into the pipeline; this runs in its convert stage.
+ *
+ * Output goes into caller-owned vectors and the scratch is kept between
+ * packets, so a steady stream does not allocate.
+ */
+class CaptureConverter {
+public:
+    explicit CaptureConverter(const DeviceFormat& format, uint32_t outputSampleRate = 16000);
+
+    /**
+     * Convert numFrames of interleaved device data
+     * @param output Replaced with the mono samples at the output rate
+     */
+    void process(const uint8_t* data, size_t numFrames, std::vector<float>& output);
+
+    // Silence of numFrames device frames, as AudioResampler::skip()
+    size_t skip(size_t numFrames);
+
+    // Output samples for numFrames, without moving the clock (estimate
+    // for metrics; off by at most one)
+    size_t outputSamples(size_t numFrames) const;
+
+    void reset();
+
+    const DeviceFormat& getFormat() const { return m_format; }
+
+private:
+    DeviceFormat m_format;
+    uint32_t m_outputSampleRate;
+    AudioResampler m_resampler;
+    std::vector<float> m_samples;     // Integer PCM as float
+};
+
+} // namespace phantom
@@ -0,0 +1,134 @@
+#include "cpu_features.h"
+#include <cstdlib>
+#include <cstring>
+
+#if defined(PHANTOM_ARCH_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace phantom {
+
+#if defined(PHANTOM_ARCH_X86)
+
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#if defined(_MSC_VER)
+    int out[4];
+    __cpuidex(out, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) regs[i] = static_cast<uint32_t>(out[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static uint64_t xgetbv0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax = 0, edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+static CpuFeatures detect() {
+    CpuFeatures f;
+    uint32_t regs[4] = {0};
+
+    cpuid(0, 0, regs);
+    const uint32_t maxLeaf = regs[0];
+    if (maxLeaf < 1) return f;
+
+    cpuid(1, 0, regs);
+    f.sse2 = (regs[3] >> 26) & 1;
+    f.ssse3 = (regs[2] >> 9) & 1;
+    f.sse41 = (regs[2] >> 19) & 1;
+    const bool osxsave = (regs[2] >> 27) & 1;
+    const bool avx = (regs[2] >> 28) & 1;
+
+    // AVX2 also needs the OS to save YMM registers
+    const bool ymmEnabled = osxsave && avx && (xgetbv0() & 0x6) == 0x6;
+    if (ymmEnabled && maxLeaf >= 7) {
+        cpuid(7, 0, regs);
+        f.avx2 = (regs[1] >> 5) & 1;
+    }
+    return f;
+}
+
+#else
+
+static CpuFeatures detect() {
+    CpuFeatures f;
+#if defined(PHANTOM_ARCH_ARM64)
+    f.neon = true;  // Mandatory on arm64
+#endif
+    return f;
+}
+
+#endif
+
+const CpuFeatures& cpuFeatures() {
+    static const CpuFeatures features = detect();
+    return features;
+}
+
+bool isaSupported(SimdIsa isa) {
+    const CpuFeatures& f = cpuFeatures();
+    switch (isa) {
+        case SimdIsa::Scalar: return true;
+        case SimdIsa::SSE2: return f.sse2;
+        case SimdIsa::SSSE3: return f.ssse3;
+        case SimdIsa::SSE41: return f.sse41;
+        case SimdIsa::AVX2: return f.avx2;
+        case SimdIsa::NEON: return f.neon;
+    }
+    return false;
+}
+
+static SimdIsa detectPreferred() {
+    const SimdIsa order[] = {SimdIsa::AVX2, SimdIsa::SSE41, SimdIsa::SSSE3, SimdIsa::SSE2, SimdIsa::NEON};
+
+    SimdIsa best = SimdIsa::Scalar;
+    for (SimdIsa isa : order) {
+        if (isaSupported(isa)) {
+            best = isa;
+            break;
+        }
+    }
+
+    const char* cap = std::getenv("PHANTOM_AUDIO_SIMD");
+    if (!cap) return best;
+
+    const SimdIsa all[] = {SimdIsa::Scalar, SimdIsa::SSE2, SimdIsa::SSSE3, SimdIsa::SSE41, SimdIsa::AVX2, SimdIsa::NEON};
+    for (SimdIsa isa : all) {
+        if (std::strcmp(cap, simdIsaName(isa)) == 0) {
+            if (isa == SimdIsa::Scalar || !isaSupported(isa)) return SimdIsa::Scalar;
+            // Only cap downwards within the same family
+            return (best != SimdIsa::NEON && isa != SimdIsa::NEON && isa < best) ? isa : best;
+        }
+    }
+    return best;
+}
+
+SimdIsa preferredIsa() {
+    static const SimdIsa isa = detectPreferred();
+    return isa;
+}
+
+const char* simdIsaName(SimdIsa isa) {
+    switch (isa) {
+        case SimdIsa::Scalar: return "scalar";
+        case SimdIsa::SSE2: return "sse2";
+        case SimdIsa::SSSE3: return "ssse3";
+        case SimdIsa::SSE41: return "sse41";
+        case SimdIsa::AVX2: return "avx2";
+        case SimdIsa::NEON: return "neon";
+    }
+    return "unknown";
+}
+
+} // namespace phantom
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define PHANTOM_ARCH_X86 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PHANTOM_ARCH_ARM64 1
+#endif
+
+// Compile a single function for a higher ISA than the translation unit
+// (MSVC allows the intrinsics without a flag)
+#if defined(__GNUC__) || defined(__clang__)
+#define PHANTOM_TARGET(isa) __attribute__((target(isa)))
+#else
+#define PHANTOM_TARGET(isa)
+#endif
+
+namespace phantom {
+
+/**
+ * Instruction set levels with hand-written kernels, in increasing order
+ * on x86. NEON is the only level on arm64.
+ */
+enum class SimdIsa : uint8_t {
+    Scalar = 0,
+    SSE2,
+    SSSE3,
+    SSE41,
+    AVX2,
+    NEON
+};
+
+struct CpuFeatures {
+    bool sse2 = false;
+    bool ssse3 = false;
+    bool sse41 = false;
+    bool avx2 = false;      // Includes OS support for YMM state
+    bool neon = false;
+};
+
+// Features of the running CPU (detected once)
+const CpuFeatures& cpuFeatures();
+
+// Whether kernels for `isa` can run here
+bool isaSupported(SimdIsa isa);
+
+/**
+ * Best supported level. PHANTOM_AUDIO_SIMD=scalar|sse2|ssse3|sse41|avx2|neon
+ * caps it, e.g. to compare kernels on one machine.
+ */
+SimdIsa preferredIsa();
+
+const char* simdIsaName(SimdIsa isa);
+
+} // namespace phantom
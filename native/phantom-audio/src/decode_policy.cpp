@@ -0,0 +1,160 @@
+#include "decode_policy.h"
+
+#include <cstring>
+
+namespace phantom {
+
+namespace {
+
+constexpr size_t MIN_MATCH = 3;
+constexpr size_t HASH_BITS = 12;
+
+// Beam width and samples per temperature for re-decodes, whisper's defaults
+constexpr int RETRY_BEAM_SIZE = 5;
+constexpr int RETRY_BEST_OF = 5;
+constexpr float TEMPERATURE_STEP = 0.2f;
+
+// Until a tier has run: greedy at 0.3x real time, the others relative to it
+constexpr float PRIOR_GREEDY_COST = 300000.0f;
+constexpr float PRIOR_RELATIVE_COST[] = {1.0f, 2.5f, 2.0f};
+
+constexpr float COST_SMOOTHING = 0.2f;
+
+uint32_t hash3(const char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return ((value & 0xFFFFFF) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+} // namespace
+
+const char* decodeTierName(DecodeTier tier) {
+    switch (tier) {
+        case DecodeTier::Greedy: return "greedy";
+        case DecodeTier::Beam: return "beam";
+        case DecodeTier::Temperature: return "temperature";
+    }
+    return "greedy";
+}
+
+float compressionRatio(const std::string& text) {
+    const size_t size = text.size();
+    if (size < MIN_MATCH + 1) return 1.0f;
+
+    // Greedy LZ77 over the whole text, one candidate per hash slot
+    std::vector<int32_t> last(size_t(1) << HASH_BITS, -1);
+    size_t cost = 0;
+    size_t pos = 0;
+    while (pos < size) {
+        size_t length = 0;
+        if (pos + sizeof(uint32_t) <= size) {
+            const uint32_t slot = hash3(text.data() + pos);
+            const int32_t candidate = last[slot];
+            last[slot] = static_cast<int32_t>(pos);
+            if (candidate >= 0) {
+                while (pos + length < size && text[candidate + length] == text[pos + length]) ++length;
+            }
+        }
+        if (length >= MIN_MATCH) {
+            cost += 2;
+            pos += length;
+        } else {
+            cost += 1;
+            pos += 1;
+        }
+    }
+    return static_cast<float>(size) / static_cast<float>(cost);
+}
+
+bool DecodeQuality::repeats() const {
+    return looped || compressionRatio > DecodePolicy::COMPRESSION_THRESHOLD;
+}
+
+DecodeQuality measureDecodeQuality(const std::vector<float>& logprobs, const std::string& text) {
+    DecodeQuality quality;
+    quality.tokens = logprobs.size();
+    if (!logprobs.empty()) {
+        double sum = 0.0;
+        for (float logprob : logprobs) sum += logprob;
+        quality.avgLogprob = static_cast<float>(sum / static_cast<double>(logprobs.size()));
+    }
+    quality.compressionRatio = compressionRatio(text);
+    return quality;
+}
+
+DecodePolicy::DecodePolicy() {
+    for (size_t i = 0; i < 3; ++i) {
+        m_costPerSecond[i] = PRIOR_GREEDY_COST * PRIOR_RELATIVE_COST[i];
+    }
+}
+
+DecodeAttempt DecodePolicy::first(int beamSize) const {
+    DecodeAttempt attempt;
+    if (beamSize > 1) {
+        attempt.tier = DecodeTier::Beam;
+        attempt.beamSize = beamSize;
+    }
+    return attempt;
+}
+
+bool DecodePolicy::looksPoor(const DecodeQuality& quality) const {
+    if (quality.tokens == 0) return false;  // Nothing said; nothing to improve
+    return quality.avgLogprob < LOGPROB_THRESHOLD || quality.repeats();
+}
+
+bool DecodePolicy::next(const DecodeAttempt& last, const DecodeQuality& quality, size_t attempts,
+                        uint64_t spentUs, uint64_t budgetUs, uint64_t audioUs, uint64_t backlogUs,
+                        DecodeAttempt* attempt) const {
+    if (attempts >= MAX_ATTEMPTS || budgetUs == 0 || !looksPoor(quality)) return false;
+
+    // Loops, and whatever beam search could not fix, go to sampling
+    DecodeAttempt candidate;
+    if (quality.repeats() || last.tier != DecodeTier::Greedy) {
+        candidate.tier = DecodeTier::Temperature;
+        candidate.temperature =
+            last.tier == DecodeTier::Temperature ? last.temperature + TEMPERATURE_STEP : TEMPERATURE_STEP;
+        candidate.bestOf = RETRY_BEST_OF;
+    } else {
+        candidate.tier = DecodeTier::Beam;
+        candidate.beamSize = RETRY_BEAM_SIZE;
+    }
+
+    // Queued audio still has to be decoded at least greedily
+    const uint64_t owedUs = estimateUs(DecodeTier::Greedy, backlogUs);
+    if (spentUs + owedUs + estimateUs(candidate.tier, audioUs) > budgetUs) return false;
+
+    *attempt = candidate;
+    return true;
+}
+
+void DecodePolicy::recordCost(DecodeTier tier, uint64_t elapsedUs, uint64_t audioUs) {
+    if (audioUs == 0) return;
+    const size_t index = static_cast<size_t>(tier);
+    const float cost = static_cast<float>(elapsedUs) * 1e6f / static_cast<float>(audioUs);
+    if (!m_measured[index]) {
+        m_costPerSecond[index] = cost;
+        m_measured[index] = true;
+
+        // Greedy timing is the best guide to tiers that have not run yet
+        if (tier == DecodeTier::Greedy) {
+            for (size_t i = 1; i < 3; ++i) {
+                if (!m_measured[i]) m_costPerSecond[i] = cost * PRIOR_RELATIVE_COST[i];
+            }
+        }
+        return;
+    }
+    m_costPerSecond[index] += COST_SMOOTHING * (cost - m_costPerSecond[index]);
+}
+
+uint64_t DecodePolicy::estimateUs(DecodeTier tier, uint64_t audioUs) const {
+    return static_cast<uint64_t>(m_costPerSecond[static_cast<size_t>(tier)] * static_cast<float>(audioUs) / 1e6f);
+}
+
+bool DecodePolicy::isBetter(const DecodeQuality& candidate, const DecodeQuality& best) {
+    if (candidate.tokens == 0) return false;
+    if (best.tokens == 0) return true;
+    if (candidate.repeats() != best.repeats()) return !candidate.repeats();
+    return candidate.avgLogprob > best.avgLogprob;
+}
+
+} // namespace phantom
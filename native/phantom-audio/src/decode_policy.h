@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace phantom {
+
+/**
+ * Decoding strategies, cheapest first. Greedy is what most chunks need;
+ * beam search helps on low-confidence speech; sampling at a raised
+ * temperature breaks the repetition loops the other two get stuck in.
+ */
+enum class DecodeTier : uint8_t {
+    Greedy,
+    Beam,
+    Temperature
+};
+
+const char* decodeTierName(DecodeTier tier);
+
+struct DecodeAttempt {
+    DecodeTier tier = DecodeTier::Greedy;
+    int beamSize = 1;
+    float temperature = 0.0f;
+    int bestOf = 1;             // Samples drawn per step at a temperature
+};
+
+// How trustworthy a decode looks
+struct DecodeQuality {
+    float avgLogprob = 0.0f;        // Mean log-probability of the text tokens
+    float compressionRatio = 1.0f;  // Text bytes over their compressed size
+    size_t tokens = 0;
+    bool looped = false;            // Cut short on a repetition loop (see repetition_guard.h)
+
+    bool repeats() const;
+};
+
+/**
+ * How well `text` compresses under an LZ77-style estimate (literals one
+ * byte, back-references two). Ordinary speech stays near 1; a decoder
+ * looping on a phrase goes well past 2.
+ */
+float compressionRatio(const std::string& text);
+
+DecodeQuality measureDecodeQuality(const std::vector<float>& logprobs, const std::string& text);
+
+/**
+ * Chooses when a chunk is decoded again with a more expensive strategy.
+ *
+ * Every chunk starts greedy (or at the configured beam width). A result
+ * whose tokens are unlikely (mean log-probability below -1) is retried
+ * with beam search, and one that repeats itself (compression ratio above
+ * 2.4, or a loop cut short while decoding) with sampling at a
+ * temperature, as whisper's own fallback does. A retry only runs if its
+ * estimated cost, plus the time spent on the chunk so far and the greedy
+ * cost of the audio queued behind it, fits the chunk's latency budget; so
+ * re-decoding backs off by itself when transcription falls behind. Costs
+ * are learned per tier from the decodes actually run.
+ */
+class DecodePolicy {
+public:
+    DecodePolicy();
+
+    static constexpr float LOGPROB_THRESHOLD = -1.0f;
+    static constexpr float COMPRESSION_THRESHOLD = 2.4f;
+    static constexpr size_t MAX_ATTEMPTS = 3;
+
+    // First decode of a chunk; `beamSize` > 1 starts at beam search
+    DecodeAttempt first(int beamSize) const;
+
+    bool looksPoor(const DecodeQuality& quality) const;
+
+    /**
+     * After `attempts` decodes of a chunk holding `audioUs` of audio, the
+     * last being `last` with `quality`: pick the next decode, or return
+     * false to keep the best result so far. `spentUs` is the decode time
+     * used on the chunk, `budgetUs` its limit (0 = never re-decode), and
+     * `backlogUs` the audio waiting behind it.
+     */
+    bool next(const DecodeAttempt& last, const DecodeQuality& quality, size_t attempts, uint64_t spentUs,
+              uint64_t budgetUs, uint64_t audioUs, uint64_t backlogUs, DecodeAttempt* attempt) const;
+
+    // Feed back the wall time one decode took
+    void recordCost(DecodeTier tier, uint64_t elapsedUs, uint64_t audioUs);
+
+    // Expected wall time to decode `audioUs` of audio with `tier`
+    uint64_t estimateUs(DecodeTier tier, uint64_t audioUs) const;
+
+    // Whether `candidate` should replace `best` as the chunk's result
+    static bool isBetter(const DecodeQuality& candidate, const DecodeQuality& best);
+
+private:
+    // Decode microseconds per second of audio, smoothed
+    float m_costPerSecond[3];
+    bool m_measured[3] = {false, false, false};
+};
+
+} // namespace phantom
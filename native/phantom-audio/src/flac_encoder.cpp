@@ -0,0 +1,660 @@
+#include "flac_encoder.h"
+#include "sample_format.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PHANTOM_FLAC_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define PHANTOM_FLAC_NEON 1
+#endif
+
+namespace phantom {
+
+namespace {
+
+constexpr int MAX_FIXED_ORDER = 4;
+constexpr int MAX_PARTITION_ORDER = 8;
+constexpr uint32_t MAX_RICE_PARAM = 14;  // 15 is the escape code
+constexpr int BITS_PER_SAMPLE = 16;
+constexpr double PI = 3.14159265358979323846;
+
+// ============================================================================
+// Bit output
+// ============================================================================
+
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+    // Write the low `bits` bits of value (bits <= 32)
+    void write(uint32_t value, int bits) {
+        if (bits == 0) return;
+        const uint64_t mask = (bits == 32) ? 0xFFFFFFFFULL : ((1ULL << bits) - 1);
+        m_acc = (m_acc << bits) | (value & mask);
+        m_bits += bits;
+        while (m_bits >= 8) {
+            m_bits -= 8;
+            m_out.push_back(static_cast<uint8_t>(m_acc >> m_bits));
+        }
+    }
+
+    void writeSigned(int32_t value, int bits) {
+        write(static_cast<uint32_t>(value), bits);
+    }
+
+    void writeRice(uint32_t value, uint32_t param) {
+        uint32_t quotient = value >> param;
+        const uint32_t low = value & ((1u << param) - 1);
+        if (quotient + 1 + param <= 32) {
+            write((1u << param) | low, static_cast<int>(quotient + 1 + param));
+            return;
+        }
+        while (quotient >= 32) {
+            write(0, 32);
+            quotient -= 32;
+        }
+        write(1, static_cast<int>(quotient + 1));
+        write(low, static_cast<int>(param));
+    }
+
+    void alignToByte() {
+        if (m_bits > 0) write(0, 8 - m_bits);
+    }
+
+private:
+    std::vector<uint8_t>& m_out;
+    uint64_t m_acc = 0;
+    int m_bits = 0;
+};
+
+// ============================================================================
+// CRCs used by the frame header/footer
+// ============================================================================
+
+uint8_t crc8(const uint8_t* data, size_t len) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; ++b) {
+            crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+struct Crc16Table {
+    uint16_t table[256];
+    Crc16Table() {
+        for (int i = 0; i < 256; ++i) {
+            uint16_t crc = static_cast<uint16_t>(i << 8);
+            for (int b = 0; b < 8; ++b) {
+                crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x8005) : static_cast<uint16_t>(crc << 1);
+            }
+            table[i] = crc;
+        }
+    }
+};
+
+uint16_t crc16(const uint8_t* data, size_t len) {
+    static const Crc16Table t;
+    uint16_t crc = 0;
+    for (size_t i = 0; i < len; ++i) {
+        crc = static_cast<uint16_t>((crc << 8) ^ t.table[((crc >> 8) ^ data[i]) & 0xFF]);
+    }
+    return crc;
+}
+
+// ============================================================================
+// Residual kernels
+// ============================================================================
+
+// Fixed polynomial predictors; writes res[begin..n), begin >= order
+void fixedResidualScalar(const int32_t* x, uint32_t begin, uint32_t n, int order, int32_t* res) {
+    for (uint32_t i = begin; i < n; ++i) {
+        switch (order) {
+            case 0: res[i] = x[i]; break;
+            case 1: res[i] = x[i] - x[i - 1]; break;
+            case 2: res[i] = x[i] - 2 * x[i - 1] + x[i - 2]; break;
+            case 3: res[i] = x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3]; break;
+            default: res[i] = x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4]; break;
+        }
+    }
+}
+
+// LPC predictor: res[i] = x[i] - (sum coefs[j] * x[i-1-j]) >> shift, for i in [begin, n)
+void lpcResidualScalar(const int16_t* x, uint32_t begin, uint32_t n, const int32_t* coefs, int order, int shift,
+                       int32_t* res) {
+    for (uint32_t i = begin; i < n; ++i) {
+        int32_t sum = 0;
+        for (int j = 0; j < order; ++j) {
+            sum += coefs[j] * x[i - 1 - j];
+        }
+        res[i] = x[i] - (sum >> shift);
+    }
+}
+
+#if defined(PHANTOM_FLAC_SSE2)
+
+void fixedResidual(const int32_t* x, uint32_t n, int order, int32_t* res) {
+    uint32_t i = static_cast<uint32_t>(order);
+    for (; i + 4 <= n; i += 4) {
+        const __m128i x0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+        __m128i r;
+        if (order == 0) {
+            r = x0;
+        } else {
+            const __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i - 1));
+            if (order == 1) {
+                r = _mm_sub_epi32(x0, x1);
+            } else {
+                const __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i - 2));
+                if (order == 2) {
+                    // x0 - 2*x1 + x2
+                    r = _mm_add_epi32(_mm_sub_epi32(x0, _mm_slli_epi32(x1, 1)), x2);
+                } else {
+                    const __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i - 3));
+                    // 3 * (x2 - x1)
+                    const __m128i d = _mm_sub_epi32(x2, x1);
+                    const __m128i d3 = _mm_add_epi32(_mm_slli_epi32(d, 1), d);
+                    if (order == 3) {
+                        r = _mm_sub_epi32(_mm_add_epi32(x0, d3), x3);
+                    } else {
+                        const __m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i - 4));
+                        // x0 - 4*x1 + 6*x2 - 4*x3 + x4
+                        const __m128i t = _mm_add_epi32(x0, x4);
+                        const __m128i m4 = _mm_slli_epi32(_mm_add_epi32(x1, x3), 2);
+                        const __m128i m6 = _mm_add_epi32(_mm_slli_epi32(x2, 2), _mm_slli_epi32(x2, 1));
+                        r = _mm_add_epi32(_mm_sub_epi32(t, m4), m6);
+                    }
+                }
+            }
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(res + i), r);
+    }
+    fixedResidualScalar(x, i, n, order, res);
+}
+
+void lpcResidual(const int16_t* x, uint32_t n, const int32_t* coefs, int order, int shift, int32_t* res) {
+    // Pair coefficients so _mm_madd_epi16 does two taps per instruction
+    const int evenOrder = (order + 1) & ~1;
+    __m128i pairs[FlacEncoder::MAX_LPC_ORDER / 2];
+    for (int j = 0; j < evenOrder; j += 2) {
+        const int32_t c0 = coefs[j];
+        const int32_t c1 = (j + 1 < order) ? coefs[j + 1] : 0;
+        pairs[j / 2] = _mm_set1_epi32(static_cast<int32_t>((static_cast<uint32_t>(c1) << 16) |
+                                                           (static_cast<uint32_t>(c0) & 0xFFFF)));
+    }
+    const __m128i shiftCount = _mm_cvtsi32_si128(shift);
+
+    // The padded tap reads x[i - 1 - evenOrder]; start where that is in range
+    uint32_t i = std::min(static_cast<uint32_t>(evenOrder), n);
+    lpcResidualScalar(x, static_cast<uint32_t>(order), i, coefs, order, shift, res);
+
+    for (; i + 4 <= n; i += 4) {
+        __m128i acc = _mm_setzero_si128();
+        for (int j = 0; j < evenOrder; j += 2) {
+            const __m128i a = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(x + i - 1 - j));
+            const __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(x + i - 2 - j));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), pairs[j / 2]));
+        }
+        const __m128i pred = _mm_sra_epi32(acc, shiftCount);
+        const __m128i cur16 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(x + i));
+        const __m128i cur = _mm_srai_epi32(_mm_unpacklo_epi16(cur16, cur16), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(res + i), _mm_sub_epi32(cur, pred));
+    }
+
+    lpcResidualScalar(x, i, n, coefs, order, shift, res);
+}
+
+#elif defined(PHANTOM_FLAC_NEON)
+
+void fixedResidual(const int32_t* x, uint32_t n, int order, int32_t* res) {
+    uint32_t i = static_cast<uint32_t>(order);
+    for (; i + 4 <= n; i += 4) {
+        const int32x4_t x0 = vld1q_s32(x + i);
+        int32x4_t r;
+        switch (order) {
+            case 0: r = x0; break;
+            case 1: r = vsubq_s32(x0, vld1q_s32(x + i - 1)); break;
+            case 2:
+                r = vaddq_s32(vsubq_s32(x0, vshlq_n_s32(vld1q_s32(x + i - 1), 1)), vld1q_s32(x + i - 2));
+                break;
+            case 3: {
+                const int32x4_t d = vsubq_s32(vld1q_s32(x + i - 2), vld1q_s32(x + i - 1));
+                r = vsubq_s32(vmlaq_n_s32(x0, d, 3), vld1q_s32(x + i - 3));
+                break;
+            }
+            default: {
+                int32x4_t t = vaddq_s32(x0, vld1q_s32(x + i - 4));
+                t = vmlsq_n_s32(t, vaddq_s32(vld1q_s32(x + i - 1), vld1q_s32(x + i - 3)), 4);
+                r = vmlaq_n_s32(t, vld1q_s32(x + i - 2), 6);
+                break;
+            }
+        }
+        vst1q_s32(res + i, r);
+    }
+    fixedResidualScalar(x, i, n, order, res);
+}
+
+void lpcResidual(const int16_t* x, uint32_t n, const int32_t* coefs, int order, int shift, int32_t* res) {
+    const int32x4_t negShift = vdupq_n_s32(-shift);
+    uint32_t i = static_cast<uint32_t>(order);
+    for (; i + 4 <= n; i += 4) {
+        int32x4_t acc = vdupq_n_s32(0);
+        for (int j = 0; j < order; ++j) {
+            acc = vmlal_n_s16(acc, vld1_s16(x + i - 1 - j), static_cast<int16_t>(coefs[j]));
+        }
+        const int32x4_t cur = vmovl_s16(vld1_s16(x + i));
+        vst1q_s32(res + i, vsubq_s32(cur, vshlq_s32(acc, negShift)));
+    }
+    lpcResidualScalar(x, i, n, coefs, order, shift, res);
+}
+
+#else
+
+void fixedResidual(const int32_t* x, uint32_t n, int order, int32_t* res) {
+    fixedResidualScalar(x, static_cast<uint32_t>(order), n, order, res);
+}
+
+void lpcResidual(const int16_t* x, uint32_t n, const int32_t* coefs, int order, int shift, int32_t* res) {
+    lpcResidualScalar(x, static_cast<uint32_t>(order), n, coefs, order, shift, res);
+}
+
+#endif
+
+// ============================================================================
+// Rice partition search
+// ============================================================================
+
+inline uint32_t foldSigned(int32_t v) {
+    return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+
+struct RiceChoice {
+    int partitionOrder = 0;
+    uint32_t params[1 << MAX_PARTITION_ORDER] = {};
+    uint64_t bits = UINT64_MAX;
+};
+
+uint64_t riceCost(uint64_t sum, uint32_t count, uint32_t param) {
+    return static_cast<uint64_t>(count) * (param + 1) + (sum >> param);
+}
+
+uint32_t bestRiceParam(uint64_t sum, uint32_t count, uint64_t* cost) {
+    uint32_t param = 0;
+    if (count > 0 && sum > count) {
+        const uint64_t mean = sum / count;
+        while (param < MAX_RICE_PARAM && (1ULL << (param + 1)) <= mean) ++param;
+    }
+    uint64_t best = riceCost(sum, count, param);
+    if (param < MAX_RICE_PARAM) {
+        const uint64_t up = riceCost(sum, count, param + 1);
+        if (up < best) {
+            best = up;
+            ++param;
+        }
+    }
+    *cost = best;
+    return param;
+}
+
+// Choose the partition order and parameters for res[predOrder..blockSize);
+// sums is scratch kept by the caller
+RiceChoice chooseRice(const int32_t* res, uint32_t blockSize, int predOrder, std::vector<uint64_t>& sums) {
+    int maxOrder = 0;
+    while (maxOrder < MAX_PARTITION_ORDER &&
+           (blockSize % (1u << (maxOrder + 1))) == 0 &&
+           (blockSize >> (maxOrder + 1)) > static_cast<uint32_t>(predOrder)) {
+        ++maxOrder;
+    }
+
+    // Sums at the finest partitioning, merged pairwise for coarser orders
+    sums.assign(static_cast<size_t>(1) << maxOrder, 0);
+    const uint32_t finest = blockSize >> maxOrder;
+    for (size_t p = 0; p < sums.size(); ++p) {
+        const uint32_t begin = (p == 0) ? static_cast<uint32_t>(predOrder) : static_cast<uint32_t>(p) * finest;
+        const uint32_t end = static_cast<uint32_t>(p + 1) * finest;
+        uint64_t s = 0;
+        for (uint32_t i = begin; i < end; ++i) s += foldSigned(res[i]);
+        sums[p] = s;
+    }
+
+    RiceChoice best;
+    for (int order = maxOrder; order >= 0; --order) {
+        const size_t parts = static_cast<size_t>(1) << order;
+        const uint32_t partSize = blockSize >> order;
+        RiceChoice candidate;
+        candidate.partitionOrder = order;
+        candidate.bits = 2 + 4;
+        for (size_t p = 0; p < parts; ++p) {
+            const uint32_t count = (p == 0) ? partSize - static_cast<uint32_t>(predOrder) : partSize;
+            uint64_t cost = 0;
+            candidate.params[p] = bestRiceParam(sums[p], count, &cost);
+            candidate.bits += 4 + cost;
+        }
+        if (candidate.bits < best.bits) best = candidate;
+
+        // Merge sums for the next coarser order
+        for (size_t p = 0; p < parts / 2; ++p) sums[p] = sums[2 * p] + sums[2 * p + 1];
+    }
+    return best;
+}
+
+void writeResidual(BitWriter& bw, const int32_t* res, uint32_t blockSize, int predOrder, const RiceChoice& rice) {
+    bw.write(0, 2);  // Rice coding with 4-bit parameters
+    bw.write(static_cast<uint32_t>(rice.partitionOrder), 4);
+    const size_t parts = static_cast<size_t>(1) << rice.partitionOrder;
+    const uint32_t partSize = blockSize >> rice.partitionOrder;
+    for (size_t p = 0; p < parts; ++p) {
+        const uint32_t param = rice.params[p];
+        bw.write(param, 4);
+        const uint32_t begin = (p == 0) ? static_cast<uint32_t>(predOrder) : static_cast<uint32_t>(p) * partSize;
+        const uint32_t end = static_cast<uint32_t>(p + 1) * partSize;
+        for (uint32_t i = begin; i < end; ++i) bw.writeRice(foldSigned(res[i]), param);
+    }
+}
+
+// ============================================================================
+// LPC analysis
+// ============================================================================
+
+// Levinson-Durbin; lpc[order-1][0..order) receives the coefficients per order
+void levinsonDurbin(const double* autoc, int maxOrder, double lpc[][FlacEncoder::MAX_LPC_ORDER]) {
+    double err = autoc[0];
+    double a[FlacEncoder::MAX_LPC_ORDER] = {0};
+    for (int i = 0; i < maxOrder; ++i) {
+        double r = -autoc[i + 1];
+        for (int j = 0; j < i; ++j) r -= a[j] * autoc[i - j];
+        r /= err;
+
+        a[i] = r;
+        for (int j = 0; j < i / 2; ++j) {
+            const double tmp = a[j];
+            a[j] += r * a[i - 1 - j];
+            a[i - 1 - j] += r * tmp;
+        }
+        if (i % 2) a[i / 2] += a[i / 2] * r;
+
+        err *= (1.0 - r * r);
+        for (int j = 0; j <= i; ++j) lpc[i][j] = -a[j];
+        if (err <= 0.0) err = 1e-12;
+    }
+}
+
+// Quantize to `precision`-bit coefficients; returns the shift, or -1 if unusable
+int quantizeLpc(const double* lpc, int order, int precision, int32_t* qcoefs) {
+    double cmax = 0.0;
+    for (int j = 0; j < order; ++j) cmax = std::max(cmax, std::fabs(lpc[j]));
+    if (cmax <= 0.0) return -1;
+
+    const int32_t qmax = (1 << (precision - 1)) - 1;
+    const int32_t qmin = -(1 << (precision - 1));
+    int shift = static_cast<int>(std::floor(std::log2(qmax / cmax)));
+    shift = std::min(shift, 15);
+    if (shift < 0) return -1;
+
+    double error = 0.0;
+    const double scale = static_cast<double>(1 << shift);
+    for (int j = 0; j < order; ++j) {
+        error += lpc[j] * scale;
+        const int32_t q = std::max(qmin, std::min(qmax, static_cast<int32_t>(std::lround(error))));
+        error -= q;
+        qcoefs[j] = q;
+    }
+    return shift;
+}
+
+int sampleRateCode(uint32_t rate) {
+    switch (rate) {
+        case 8000: return 4;
+        case 16000: return 5;
+        case 22050: return 6;
+        case 24000: return 7;
+        case 32000: return 8;
+        case 44100: return 9;
+        case 48000: return 10;
+        case 96000: return 11;
+        default: return 0;  // Taken from STREAMINFO
+    }
+}
+
+int blockSizeCode(uint32_t size) {
+    if (size == 192) return 1;
+    for (int n = 2; n <= 5; ++n) {
+        if (size == (576u << (n - 2))) return n;
+    }
+    for (int n = 8; n <= 15; ++n) {
+        if (size == (256u << (n - 8))) return n;
+    }
+    return size <= 256 ? 6 : 7;
+}
+
+void writeUtf8Number(BitWriter& bw, uint32_t value) {
+    if (value < 0x80) {
+        bw.write(value, 8);
+        return;
+    }
+    int extra = 1;
+    while (extra < 6 && value >= (1u << (6 + 5 * extra))) ++extra;
+    const uint32_t lead = (0xFF00u >> (extra + 1)) & 0xFF;
+    bw.write(lead | (value >> (6 * extra)), 8);
+    for (int i = extra - 1; i >= 0; --i) {
+        bw.write(0x80 | ((value >> (6 * i)) & 0x3F), 8);
+    }
+}
+
+} // namespace
+
+FlacEncoder::FlacEncoder(uint32_t sampleRate, uint32_t blockSize)
+    : m_sampleRate(sampleRate)
+    , m_blockSize(std::max<uint32_t>(16, std::min<uint32_t>(blockSize, 65535)))
+{
+    m_pending.reserve(m_blockSize);
+}
+
+void FlacEncoder::beginSegment(std::vector<uint8_t>& out) {
+    m_inSegment = true;
+    m_frameNumber = 0;
+    m_segmentSamples = 0;
+    m_pending.clear();
+
+    out.insert(out.end(), {'f', 'L', 'a', 'C'});
+
+    BitWriter bw(out);
+    bw.write(1, 1);                     // Last metadata block
+    bw.write(0, 7);                     // STREAMINFO
+    bw.write(34, 24);                   // Block length
+    bw.write(m_blockSize, 16);          // Min block size
+    bw.write(m_blockSize, 16);          // Max block size
+    bw.write(0, 24);                    // Min frame size (unknown)
+    bw.write(0, 24);                    // Max frame size (unknown)
+    bw.write(m_sampleRate, 20);
+    bw.write(0, 3);                     // Channels - 1
+    bw.write(BITS_PER_SAMPLE - 1, 5);
+    bw.write(0, 4);                     // Total samples (unknown), high bits
+    bw.write(0, 32);                    // Total samples, low bits
+    for (int i = 0; i < 4; ++i) bw.write(0, 32);  // MD5 (unset)
+}
+
+void FlacEncoder::encode(const int16_t* samples, size_t numSamples, std::vector<uint8_t>& out) {
+    if (!m_inSegment) beginSegment(out);
+
+    m_segmentSamples += numSamples;
+    while (numSamples > 0) {
+        const size_t take = std::min(numSamples, static_cast<size_t>(m_blockSize) - m_pending.size());
+        m_pending.insert(m_pending.end(), samples, samples + take);
+        samples += take;
+        numSamples -= take;
+
+        if (m_pending.size() == m_blockSize) {
+            encodeBlock(m_pending.data(), m_blockSize, out);
+            m_pending.clear();
+        }
+    }
+}
+
+void FlacEncoder::encode(const float* samples, size_t numSamples, std::vector<uint8_t>& out) {
+    int16_t converted[512];
+    while (numSamples > 0) {
+        const size_t take = std::min(numSamples, sizeof(converted) / sizeof(converted[0]));
+        floatToS16(samples, converted, take);
+        encode(converted, take, out);
+        samples += take;
+        numSamples -= take;
+    }
+}
+
+void FlacEncoder::finishSegment(std::vector<uint8_t>& out) {
+    if (!m_inSegment) return;
+    if (!m_pending.empty()) {
+        encodeBlock(m_pending.data(), static_cast<uint32_t>(m_pending.size()), out);
+        m_pending.clear();
+    }
+    m_inSegment = false;
+}
+
+void FlacEncoder::encodeBlock(const int16_t* block, uint32_t blockSize, std::vector<uint8_t>& out) {
+    m_residual.resize(blockSize);
+    m_bestResidual.resize(blockSize);
+
+    m_wide.assign(block, block + blockSize);
+
+    // Candidate subframes; bits exclude the shared 8-bit subframe header
+    enum class Kind { Constant, Verbatim, Fixed, Lpc } bestKind = Kind::Verbatim;
+    uint64_t bestBits = static_cast<uint64_t>(blockSize) * BITS_PER_SAMPLE;
+    int bestOrder = 0;
+    RiceChoice bestRice;
+    int32_t bestCoefs[MAX_LPC_ORDER] = {0};
+    int bestShift = 0;
+
+    if (std::all_of(block, block + blockSize, [&](int16_t s) { return s == block[0]; })) {
+        bestKind = Kind::Constant;
+        bestBits = BITS_PER_SAMPLE;
+    } else {
+        // Fixed predictors
+        const int maxFixed = static_cast<int>(std::min<uint32_t>(MAX_FIXED_ORDER, blockSize - 1));
+        for (int order = 0; order <= maxFixed; ++order) {
+            fixedResidual(m_wide.data(), blockSize, order, m_residual.data());
+            RiceChoice rice = chooseRice(m_residual.data(), blockSize, order, m_riceSums);
+            const uint64_t bits = static_cast<uint64_t>(order) * BITS_PER_SAMPLE + rice.bits;
+            if (bits < bestBits) {
+                bestBits = bits;
+                bestKind = Kind::Fixed;
+                bestOrder = order;
+                bestRice = rice;
+                m_bestResidual.swap(m_residual);
+            }
+        }
+
+        // LPC with a Tukey(0.5) window
+        const int maxLpc = static_cast<int>(std::min<uint32_t>(MAX_LPC_ORDER, blockSize / 4));
+        if (maxLpc > 0) {
+            if (m_window.size() != blockSize) {
+                m_window.resize(blockSize);
+                const double taper = 0.25 * blockSize;
+                for (uint32_t i = 0; i < blockSize; ++i) {
+                    double w = 1.0;
+                    if (i < taper) {
+                        w = 0.5 * (1.0 - std::cos(PI * i / taper));
+                    } else if (i >= blockSize - taper) {
+                        w = 0.5 * (1.0 - std::cos(PI * (blockSize - 1 - i) / taper));
+                    }
+                    m_window[i] = static_cast<float>(w);
+                }
+            }
+
+            m_windowed.resize(blockSize);
+            for (uint32_t i = 0; i < blockSize; ++i) m_windowed[i] = block[i] * static_cast<double>(m_window[i]);
+
+            double autoc[MAX_LPC_ORDER + 1] = {0};
+            for (int lag = 0; lag <= maxLpc; ++lag) {
+                double sum = 0.0;
+                for (uint32_t i = static_cast<uint32_t>(lag); i < blockSize; ++i) {
+                    sum += m_windowed[i] * m_windowed[i - lag];
+                }
+                autoc[lag] = sum;
+            }
+
+            if (autoc[0] > 0.0) {
+                double lpc[MAX_LPC_ORDER][MAX_LPC_ORDER] = {{0}};
+                levinsonDurbin(autoc, maxLpc, lpc);
+
+                for (int order = 1; order <= maxLpc; ++order) {
+                    int32_t coefs[MAX_LPC_ORDER] = {0};
+                    const int shift = quantizeLpc(lpc[order - 1], order, LPC_PRECISION, coefs);
+                    if (shift < 0) continue;
+
+                    lpcResidual(block, blockSize, coefs, order, shift, m_residual.data());
+                    RiceChoice rice = chooseRice(m_residual.data(), blockSize, order, m_riceSums);
+                    const uint64_t bits = static_cast<uint64_t>(order) * BITS_PER_SAMPLE + 4 + 5 +
+                                          static_cast<uint64_t>(order) * LPC_PRECISION + rice.bits;
+                    if (bits < bestBits) {
+                        bestBits = bits;
+                        bestKind = Kind::Lpc;
+                        bestOrder = order;
+                        bestRice = rice;
+                        bestShift = shift;
+                        std::copy(coefs, coefs + order, bestCoefs);
+                        m_bestResidual.swap(m_residual);
+                    }
+                }
+            }
+        }
+    }
+
+    // The frame is written straight into out; its CRCs start at frameStart
+    const size_t frameStart = out.size();
+    BitWriter bw(out);
+
+    // Frame header
+    const int bsCode = blockSizeCode(blockSize);
+    bw.write(0x3FFE, 14);               // Sync code
+    bw.write(0, 1);                     // Reserved
+    bw.write(0, 1);                     // Fixed block size stream
+    bw.write(static_cast<uint32_t>(bsCode), 4);
+    bw.write(static_cast<uint32_t>(sampleRateCode(m_sampleRate)), 4);
+    bw.write(0, 4);                     // Mono
+    bw.write(4, 3);                     // 16 bits per sample
+    bw.write(0, 1);                     // Reserved
+    writeUtf8Number(bw, m_frameNumber++);
+    if (bsCode == 6) bw.write(blockSize - 1, 8);
+    if (bsCode == 7) bw.write(blockSize - 1, 16);
+    out.push_back(crc8(out.data() + frameStart, out.size() - frameStart));
+
+    // Subframe
+    switch (bestKind) {
+        case Kind::Constant:
+            bw.write(0x00, 8);
+            bw.writeSigned(block[0], BITS_PER_SAMPLE);
+            break;
+        case Kind::Verbatim:
+            bw.write(0x02, 8);
+            for (uint32_t i = 0; i < blockSize; ++i) bw.writeSigned(block[i], BITS_PER_SAMPLE);
+            break;
+        case Kind::Fixed:
+            bw.write(static_cast<uint32_t>(0x08 | bestOrder) << 1, 8);
+            for (int i = 0; i < bestOrder; ++i) bw.writeSigned(block[i], BITS_PER_SAMPLE);
+            writeResidual(bw, m_bestResidual.data(), blockSize, bestOrder, bestRice);
+            break;
+        case Kind::Lpc:
+            bw.write(static_cast<uint32_t>(0x20 | (bestOrder - 1)) << 1, 8);
+            for (int i = 0; i < bestOrder; ++i) bw.writeSigned(block[i], BITS_PER_SAMPLE);
+            bw.write(LPC_PRECISION - 1, 4);
+            bw.writeSigned(bestShift, 5);
+            for (int i = 0; i < bestOrder; ++i) bw.writeSigned(bestCoefs[i], LPC_PRECISION);
+            writeResidual(bw, m_bestResidual.data(), blockSize, bestOrder, bestRice);
+            break;
+    }
+
+    // Footer
+    bw.alignToByte();
+    const uint16_t crc = crc16(out.data() + frameStart, out.size() - frameStart);
+    out.push_back(static_cast<uint8_t>(crc >> 8));
+    out.push_back(static_cast<uint8_t>(crc & 0xFF));
+}
+
+} // namespace phantom
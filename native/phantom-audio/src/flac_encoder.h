@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace phantom {
+
+/**
+ * Streaming FLAC encoder for 16-bit mono audio.
+ *
+ * Each block is coded as CONSTANT, FIXED (orders 0-4) or LPC (orders up to 8,
+ * 12-bit coefficients) with partitioned Rice residuals, whichever is smallest.
+ * Residuals are computed with SSE2/NEON where available.
+ *
+ * Output is organised in segments: beginSegment() emits a complete stream
+ * header, so the bytes between beginSegment() and finishSegment() form a
+ * standalone .flac file that can be uploaded as-is. STREAMINFO leaves the
+ * total sample count and MD5 unset, which the format allows for streams.
+ */
+class FlacEncoder {
+public:
+    static constexpr uint32_t DEFAULT_BLOCK_SIZE = 4096;
+    static constexpr int MAX_LPC_ORDER = 8;
+    static constexpr int LPC_PRECISION = 12;
+
+    explicit FlacEncoder(uint32_t sampleRate = 16000, uint32_t blockSize = DEFAULT_BLOCK_SIZE);
+
+    /**
+     * Start a new segment and append the stream header ("fLaC" + STREAMINFO)
+     */
+    void beginSegment(std::vector<uint8_t>& out);
+
+    /**
+     * Append samples; complete blocks are encoded into out
+     */
+    void encode(const int16_t* samples, size_t numSamples, std::vector<uint8_t>& out);
+    void encode(const float* samples, size_t numSamples, std::vector<uint8_t>& out);
+
+    /**
+     * Encode any buffered partial block and close the segment
+     */
+    void finishSegment(std::vector<uint8_t>& out);
+
+    bool inSegment() const { return m_inSegment; }
+
+    // Samples encoded (or buffered) in the current segment
+    uint64_t getSegmentSamples() const { return m_segmentSamples; }
+
+private:
+    void encodeBlock(const int16_t* block, uint32_t blockSize, std::vector<uint8_t>& out);
+
+    uint32_t m_sampleRate;
+    uint32_t m_blockSize;
+    bool m_inSegment = false;
+    uint32_t m_frameNumber = 0;
+    uint64_t m_segmentSamples = 0;
+
+    // Pending samples for the next block
+    std::vector<int16_t> m_pending;
+
+    // Scratch buffers reused between blocks
+    std::vector<int32_t> m_wide;
+    std::vector<int32_t> m_residual;
+    std::vector<int32_t> m_bestResidual;
+    std::vector<double> m_windowed;
+    std::vector<float> m_window;
+    std::vector<uint64_t> m_riceSums;
+};
+
+} // namespace phantom
@@ -0,0 +1,393 @@
+#include "frame_features.h"
+#include "sample_format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(PHANTOM_ARCH_X86)
+#include <immintrin.h>
+#elif defined(PHANTOM_ARCH_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace phantom {
+
+namespace {
+
+using FeaturesKernel = void (*)(const float* samples, size_t numFrames, size_t frameSamples,
+                                float previous, FrameFeatures* out);
+
+inline bool signBit(float x) {
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return (bits >> 31) != 0;
+}
+
+// Running totals for one frame
+struct FrameTotals {
+    float sumAbs = 0.0f;
+    float sumSquares = 0.0f;
+    float peak = 0.0f;
+    uint32_t crossings = 0;
+
+    // One sample; `previous` is the sample before it
+    void add(float x, float previous) {
+        const float a = std::fabs(x);
+        sumAbs += a;
+        sumSquares += x * x;
+        peak = a > peak ? a : peak;  // NaN leaves the peak alone, as _mm_max_ps does
+        crossings += signBit(x) != signBit(previous) ? 1u : 0u;
+    }
+
+    FrameFeatures finish(size_t frameSamples) const {
+        const float n = static_cast<float>(frameSamples);
+        FrameFeatures f;
+        f.meanAbs = sumAbs / n;
+        f.rms = std::sqrt(sumSquares / n);
+        f.peak = peak;
+        f.zcr = static_cast<float>(crossings) / n;
+        return f;
+    }
+};
+
+// ============================================================================
+// Scalar kernel
+// ============================================================================
+
+void featuresScalar(const float* samples, size_t numFrames, size_t frameSamples,
+                    float previous, FrameFeatures* out) {
+    for (size_t f = 0; f < numFrames; ++f) {
+        const float* frame = samples + f * frameSamples;
+        FrameTotals totals;
+        for (size_t i = 0; i < frameSamples; ++i) {
+            totals.add(frame[i], i == 0 ? previous : frame[i - 1]);
+        }
+        out[f] = totals.finish(frameSamples);
+        previous = frame[frameSamples - 1];
+    }
+}
+
+#if defined(PHANTOM_ARCH_X86)
+
+// ============================================================================
+// SSE2 kernel
+// ============================================================================
+
+PHANTOM_TARGET("sse2")
+inline float horizontalSum(__m128 v) {
+    const __m128 pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+}
+
+PHANTOM_TARGET("sse2")
+inline float horizontalMax(__m128 v) {
+    const __m128 pairs = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_max_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+}
+
+PHANTOM_TARGET("sse2")
+inline uint32_t horizontalSum(__m128i v) {
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(v));
+}
+
+PHANTOM_TARGET("sse2")
+void featuresSse2(const float* samples, size_t numFrames, size_t frameSamples,
+                  float previous, FrameFeatures* out) {
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+    for (size_t f = 0; f < numFrames; ++f) {
+        const float* frame = samples + f * frameSamples;
+        FrameTotals totals;
+        totals.add(frame[0], previous);
+
+        __m128 sumAbs = _mm_setzero_ps();
+        __m128 sumSquares = _mm_setzero_ps();
+        __m128 peak = _mm_setzero_ps();
+        __m128i crossings = _mm_setzero_si128();
+        size_t i = 1;
+        for (; i + 4 <= frameSamples; i += 4) {
+            const __m128 x = _mm_loadu_ps(frame + i);
+            const __m128 before = _mm_loadu_ps(frame + i - 1);
+            const __m128 a = _mm_and_ps(x, absMask);
+            sumAbs = _mm_add_ps(sumAbs, a);
+            sumSquares = _mm_add_ps(sumSquares, _mm_mul_ps(x, x));
+            peak = _mm_max_ps(a, peak);
+            // Sign bits differ -> top bit of the xor, shifted down to 0/1
+            const __m128i flips = _mm_castps_si128(_mm_xor_ps(x, before));
+            crossings = _mm_add_epi32(crossings, _mm_srli_epi32(flips, 31));
+        }
+        for (; i < frameSamples; ++i) {
+            totals.add(frame[i], frame[i - 1]);
+        }
+
+        totals.sumAbs += horizontalSum(sumAbs);
+        totals.sumSquares += horizontalSum(sumSquares);
+        totals.peak = std::max(totals.peak, horizontalMax(peak));
+        totals.crossings += horizontalSum(crossings);
+        out[f] = totals.finish(frameSamples);
+        previous = frame[frameSamples - 1];
+    }
+}
+
+// ============================================================================
+// AVX2 kernel
+// ============================================================================
+
+PHANTOM_TARGET("avx2")
+void featuresAvx2(const float* samples, size_t numFrames, size_t frameSamples,
+                  float previous, FrameFeatures* out) {
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+
+    for (size_t f = 0; f < numFrames; ++f) {
+        const float* frame = samples + f * frameSamples;
+        FrameTotals totals;
+        totals.add(frame[0], previous);
+
+        __m256 sumAbs = _mm256_setzero_ps();
+        __m256 sumSquares = _mm256_setzero_ps();
+        __m256 peak = _mm256_setzero_ps();
+        __m256i crossings = _mm256_setzero_si256();
+        size_t i = 1;
+        for (; i + 8 <= frameSamples; i += 8) {
+            const __m256 x = _mm256_loadu_ps(frame + i);
+            const __m256 before = _mm256_loadu_ps(frame + i - 1);
+            const __m256 a = _mm256_and_ps(x, absMask);
+            sumAbs = _mm256_add_ps(sumAbs, a);
+            sumSquares = _mm256_add_ps(sumSquares, _mm256_mul_ps(x, x));
+            peak = _mm256_max_ps(a, peak);
+            const __m256i flips = _mm256_castps_si256(_mm256_xor_ps(x, before));
+            crossings = _mm256_add_epi32(crossings, _mm256_srli_epi32(flips, 31));
+        }
+        for (; i < frameSamples; ++i) {
+            totals.add(frame[i], frame[i - 1]);
+        }
+
+        const __m128 abs4 = _mm_add_ps(_mm256_castps256_ps128(sumAbs), _mm256_extractf128_ps(sumAbs, 1));
+        const __m128 sq4 = _mm_add_ps(_mm256_castps256_ps128(sumSquares),
+                                      _mm256_extractf128_ps(sumSquares, 1));
+        const __m128 peak4 = _mm_max_ps(_mm256_castps256_ps128(peak), _mm256_extractf128_ps(peak, 1));
+        const __m128i crossings4 = _mm_add_epi32(_mm256_castsi256_si128(crossings),
+                                                 _mm256_extracti128_si256(crossings, 1));
+        totals.sumAbs += horizontalSum(abs4);
+        totals.sumSquares += horizontalSum(sq4);
+        totals.peak = std::max(totals.peak, horizontalMax(peak4));
+        totals.crossings += horizontalSum(crossings4);
+        out[f] = totals.finish(frameSamples);
+        previous = frame[frameSamples - 1];
+    }
+}
+
+#elif defined(PHANTOM_ARCH_ARM64)
+
+// ============================================================================
+// NEON kernel
+// ============================================================================
+
+void featuresNeon(const float* samples, size_t numFrames, size_t frameSamples,
+                  float previous, FrameFeatures* out) {
+    for (size_t f = 0; f < numFrames; ++f) {
+        const float* frame = samples + f * frameSamples;
+        FrameTotals totals;
+        totals.add(frame[0], previous);
+
+        float32x4_t sumAbs = vdupq_n_f32(0.0f);
+        float32x4_t sumSquares = vdupq_n_f32(0.0f);
+        float32x4_t peak = vdupq_n_f32(0.0f);
+        uint32x4_t crossings = vdupq_n_u32(0);
+        size_t i = 1;
+        for (; i + 4 <= frameSamples; i += 4) {
+            const float32x4_t x = vld1q_f32(frame + i);
+            const float32x4_t before = vld1q_f32(frame + i - 1);
+            const float32x4_t a = vabsq_f32(x);
+            sumAbs = vaddq_f32(sumAbs, a);
+            sumSquares = vaddq_f32(sumSquares, vmulq_f32(x, x));
+            // vmaxq would propagate NaN; keep the peak instead, as on x86
+            peak = vbslq_f32(vcgtq_f32(a, peak), a, peak);
+            const uint32x4_t flips = veorq_u32(vreinterpretq_u32_f32(x), vreinterpretq_u32_f32(before));
+            crossings = vaddq_u32(crossings, vshrq_n_u32(flips, 31));
+        }
+        for (; i < frameSamples; ++i) {
+            totals.add(frame[i], frame[i - 1]);
+        }
+
+        totals.sumAbs += vaddvq_f32(sumAbs);
+        totals.sumSquares += vaddvq_f32(sumSquares);
+        totals.peak = std::max(totals.peak, vmaxvq_f32(peak));
+        totals.crossings += vaddvq_u32(crossings);
+        out[f] = totals.finish(frameSamples);
+        previous = frame[frameSamples - 1];
+    }
+}
+
+#endif
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+struct Kernels {
+    SimdIsa isa = SimdIsa::Scalar;
+    FeaturesKernel features = featuresScalar;
+};
+
+Kernels kernelsFor(SimdIsa isa) {
+    Kernels k;
+    if (!isaSupported(isa)) return k;
+#if defined(PHANTOM_ARCH_X86)
+    switch (isa) {
+        case SimdIsa::AVX2:
+            k.isa = SimdIsa::AVX2;
+            k.features = featuresAvx2;
+            break;
+        case SimdIsa::SSE41:
+        case SimdIsa::SSSE3:
+        case SimdIsa::SSE2:
+            k.isa = SimdIsa::SSE2;
+            k.features = featuresSse2;
+            break;
+        default:
+            break;
+    }
+#elif defined(PHANTOM_ARCH_ARM64)
+    if (isa == SimdIsa::NEON) {
+        k.isa = SimdIsa::NEON;
+        k.features = featuresNeon;
+    }
+#endif
+    return k;
+}
+
+const Kernels& defaultKernels() {
+    static const Kernels kernels = kernelsFor(preferredIsa());
+    return kernels;
+}
+
+} // namespace
+
+void computeFrameFeatures(const float* samples, size_t numFrames, size_t frameSamples,
+                          float previous, FrameFeatures* out) {
+    if (numFrames == 0 || frameSamples == 0) return;
+    defaultKernels().features(samples, numFrames, frameSamples, previous, out);
+}
+
+void computeFrameFeatures(const float* samples, size_t numFrames, size_t frameSamples,
+                          float previous, FrameFeatures* out, SimdIsa isa) {
+    if (numFrames == 0 || frameSamples == 0) return;
+    kernelsFor(isa).features(samples, numFrames, frameSamples, previous, out);
+}
+
+SimdIsa frameFeaturesIsa() {
+    return defaultKernels().isa;
+}
+
+std::vector<FrameFeatures> computeFrameFeatures(const float* samples, size_t numSamples,
+                                                size_t frameSamples) {
+    std::vector<FrameFeatures> frames(frameSamples ? numSamples / frameSamples : 0);
+    computeFrameFeatures(samples, frames.size(), frameSamples, 0.0f, frames.data());
+    return frames;
+}
+
+// ============================================================================
+// FrameFeatureStream
+// ============================================================================
+
+FrameFeatureStream::FrameFeatureStream(size_t frameSamples)
+    : m_frameSamples(std::max<size_t>(1, frameSamples)) {
+    m_partial.reserve(m_frameSamples);
+}
+
+void FrameFeatureStream::reset() {
+    m_frames.clear();
+    m_firstFrame = 0;
+    m_partial.clear();
+    m_previous = 0.0f;
+}
+
+void FrameFeatureStream::append(const float* samples, size_t numSamples) {
+    appendFloats(samples, numSamples);
+}
+
+void FrameFeatureStream::append(const int16_t* samples, size_t numSamples) {
+    m_convertScratch.resize(numSamples);
+    s16ToFloat(samples, m_convertScratch.data(), numSamples);
+    appendFloats(m_convertScratch.data(), numSamples);
+}
+
+void FrameFeatureStream::appendFloats(const float* samples, size_t numSamples) {
+    FrameFeatures features;
+
+    // Complete the frame left over from the last append
+    if (!m_partial.empty()) {
+        const size_t take = std::min(numSamples, m_frameSamples - m_partial.size());
+        m_partial.insert(m_partial.end(), samples, samples + take);
+        samples += take;
+        numSamples -= take;
+        if (m_partial.size() < m_frameSamples) return;
+
+        computeFrameFeatures(m_partial.data(), 1, m_frameSamples, m_previous, &features);
+        m_frames.push_back(features);
+        m_previous = m_partial.back();
+        m_partial.clear();
+    }
+
+    const size_t wholeFrames = numSamples / m_frameSamples;
+    if (wholeFrames > 0) {
+        const size_t first = m_frames.size();
+        m_frames.resize(first + wholeFrames);
+        // deque storage is not contiguous, so compute frame by frame into it
+        for (size_t f = 0; f < wholeFrames; ++f) {
+            computeFrameFeatures(samples + f * m_frameSamples, 1, m_frameSamples, m_previous,
+                                 &m_frames[first + f]);
+            m_previous = samples[(f + 1) * m_frameSamples - 1];
+        }
+    }
+
+    const size_t used = wholeFrames * m_frameSamples;
+    m_partial.assign(samples + used, samples + numSamples);
+}
+
+void FrameFeatureStream::skip(size_t numSamples) {
+    if (numSamples == 0) return;
+
+    // Zero-fill the open frame (its real samples still count)
+    if (!m_partial.empty()) {
+        const size_t take = std::min(numSamples, m_frameSamples - m_partial.size());
+        m_partial.resize(m_partial.size() + take, 0.0f);
+        numSamples -= take;
+        if (m_partial.size() < m_frameSamples) return;
+
+        FrameFeatures features;
+        computeFrameFeatures(m_partial.data(), 1, m_frameSamples, m_previous, &features);
+        m_frames.push_back(features);
+        m_partial.clear();
+    }
+
+    m_frames.resize(m_frames.size() + numSamples / m_frameSamples, FrameFeatures{});
+    m_partial.assign(numSamples % m_frameSamples, 0.0f);
+    m_previous = 0.0f;
+}
+
+void FrameFeatureStream::discardBefore(uint64_t frame) {
+    const uint64_t end = std::min(frame, endFrame());
+    while (m_firstFrame < end) {
+        m_frames.pop_front();
+        ++m_firstFrame;
+    }
+}
+
+uint64_t FrameFeatureStream::copyFrames(uint64_t startSample, uint64_t endSample,
+                                        std::vector<FrameFeatures>& out) const {
+    out.clear();
+    const uint64_t first = std::max<uint64_t>((startSample + m_frameSamples - 1) / m_frameSamples,
+                                              beginFrame());
+    const uint64_t last = std::min<uint64_t>(endSample / m_frameSamples, endFrame());
+    for (uint64_t frame = first; frame < last; ++frame) {
+        out.push_back(at(frame));
+    }
+    return first;
+}
+
+} // namespace phantom
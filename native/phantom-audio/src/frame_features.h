@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "cpu_features.h"
+
+namespace phantom {
+
+/**
+ * Per-frame signal statistics shared by everything that looks at levels:
+ * silence trimming, segmentation, VAD and meters. Computed once per 10ms
+ * frame as audio arrives instead of being rescanned by each consumer.
+ */
+struct FrameFeatures {
+    float meanAbs = 0.0f;   // Mean absolute amplitude (what VAD thresholds use)
+    float rms = 0.0f;
+    float peak = 0.0f;      // Max |sample|
+    float zcr = 0.0f;       // Sign changes per sample, in [0, 1]
+};
+
+// 10ms at 16kHz
+constexpr size_t FEATURE_FRAME_SAMPLES = 160;
+
+/**
+ * Features of `numFrames` consecutive frames of `frameSamples` samples.
+ * `previous` is the sample before the first frame (0 at stream start),
+ * so the first crossing is counted. The default overload uses the best
+ * kernel for this CPU; the SimdIsa overload is for tests and benchmarks.
+ */
+void computeFrameFeatures(const float* samples, size_t numFrames, size_t frameSamples,
+                          float previous, FrameFeatures* out);
+void computeFrameFeatures(const float* samples, size_t numFrames, size_t frameSamples,
+                          float previous, FrameFeatures* out, SimdIsa isa);
+
+// Level the default kernel was bound for
+SimdIsa frameFeaturesIsa();
+
+// Features of every whole frame in `samples` (a trailing partial frame is left out)
+std::vector<FrameFeatures> computeFrameFeatures(const float* samples, size_t numSamples,
+                                                size_t frameSamples = FEATURE_FRAME_SAMPLES);
+
+/**
+ * Streaming feature stage. Frames are numbered from the start of the
+ * stream (frame n covers samples [n * frameSamples, (n + 1) * frameSamples)),
+ * so consumers holding stream sample positions can look frames up
+ * directly. Each sample is looked at once; a frame split across appends
+ * is completed by the next one. Not thread-safe.
+ */
+class FrameFeatureStream {
+public:
+    explicit FrameFeatureStream(size_t frameSamples = FEATURE_FRAME_SAMPLES);
+
+    void append(const float* samples, size_t numSamples);
+    void append(const int16_t* samples, size_t numSamples);
+
+    // Account for digital silence without looking at it (all-zero features)
+    void skip(size_t numSamples);
+
+    // Back to stream sample 0 with no frames
+    void reset();
+
+    // Forget frames before `frame` (their audio is no longer needed)
+    void discardBefore(uint64_t frame);
+
+    size_t frameSamples() const { return m_frameSamples; }
+    // Kept frames are [beginFrame(), endFrame())
+    uint64_t beginFrame() const { return m_firstFrame; }
+    uint64_t endFrame() const { return m_firstFrame + m_frames.size(); }
+    const FrameFeatures& at(uint64_t frame) const { return m_frames[frame - m_firstFrame]; }
+
+    /**
+     * Copy the whole frames inside stream samples [startSample, endSample)
+     * that are still kept
+     * @return stream index of the first copied frame
+     */
+    uint64_t copyFrames(uint64_t startSample, uint64_t endSample, std::vector<FrameFeatures>& out) const;
+
+private:
+    void appendFloats(const float* samples, size_t numSamples);
+
+    size_t m_frameSamples;
+    std::deque<FrameFeatures> m_frames;
+    uint64_t m_firstFrame = 0;
+    std::vector<float> m_partial;       // Start of the frame being filled
+    float m_previous = 0.0f;            // Last sample of the last whole frame
+    std::vector<float> m_convertScratch;
+};
+
+} // namespace phantom
@@ -1,149 +1,592 @@
 #include "json_protocol.h"
+#include "text_encoding.h"
+#include "json_reader.h"
+#include "pipeline_metrics.h"
+#include "trace_recorder.h"
+#include "transcript_delta.h"
 #include <iostream>
 #include <sstream>
-#include <iomanip>
 #include <algorithm>
 #include <vector>
 #include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <atomic>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
 
 namespace phantom {
 
-// Simple JSON string extraction (no external dependencies)
-static std::string extractJsonString(const std::string& json, const std::string& key) {
-    std::string searchKey = "\"" + key + "\"";
-    size_t keyPos = json.find(searchKey);
-    if (keyPos == std::string::npos) {
-        return "";
+namespace {
+    constexpr uint64_t SAMPLE_RATE = 16000;
+
+    // All stdout writes go through this mutex; events come from the stdin,
+    // pipeline and transcription threads.
+    std::mutex g_outputMutex;
+    std::atomic<bool> g_binaryFraming{false};
+
+    // Audio batching state (guarded by g_outputMutex)
+    SampleFormat g_wireFormat = SampleFormat::F32;
+    std::vector<uint8_t> g_pendingAudio;
+    std::vector<uint8_t> g_wireScratch;
+    std::string g_lineBuffer;  // Reused for base64 audio lines
+    uint64_t g_pendingStartSample = 0;
+    uint64_t g_streamSamples = 0;
+    size_t g_batchSamples = 0;
+
+    // Last partial per segment, so the next is sent as a delta
+    std::mutex g_partialMutex;
+    TranscriptDeltaEncoder g_partials;
+}
+
+const char* forwardFormatName(ForwardFormat format) {
+    switch (format) {
+        case ForwardFormat::S16: return "s16";
+        case ForwardFormat::Flac: return "flac";
+        default: return "f32";
     }
+}
 
-    // Find the colon after the key
-    size_t colonPos = json.find(':', keyPos + searchKey.length());
-    if (colonPos == std::string::npos) {
-        return "";
+static bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        char c = a[i];
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        if (c != b[i]) return false;
     }
+    return true;
+}
+
+static CommandType commandTypeFromName(const JsonValue& name) {
+    if (name.type != JsonType::String || name.escaped) return CommandType::Unknown;
 
-    // Skip whitespace
-    size_t valueStart = json.find_first_not_of(" \t\n\r", colonPos + 1);
-    if (valueStart == std::string::npos) {
-        return "";
+    const std::string_view text = name.text;
+    if (equalsIgnoreCase(text, "hello")) return CommandType::Hello;
+    if (equalsIgnoreCase(text, "start")) return CommandType::Start;
+    if (equalsIgnoreCase(text, "stop")) return CommandType::Stop;
+    if (equalsIgnoreCase(text, "exit")) return CommandType::Exit;
+    if (equalsIgnoreCase(text, "config")) return CommandType::Config;
+    if (equalsIgnoreCase(text, "metrics")) return CommandType::Metrics;
+    if (equalsIgnoreCase(text, "trace")) return CommandType::Trace;
+    return CommandType::Unknown;
+}
+
+// Hello fields are lenient, as in protocol v1: bad values fall back to defaults
+static void parseHelloField(std::string_view key, const JsonValue& value, Command& cmd) {
+    int number = 0;
+    if (key == "protocol") {
+        if (value.asInt(&number)) cmd.protocol = number;
+    } else if (key == "batch_ms") {
+        if (value.asInt(&number)) cmd.batchMs = std::max(0, number);
+    } else if (key == "segment_ms") {
+        if (value.asInt(&number)) cmd.segmentMs = std::max(0, number);
+    } else if (key == "audio_format") {
+        if (value.equals("s16")) {
+            cmd.audioFormat = ForwardFormat::S16;
+        } else if (value.equals("flac")) {
+            cmd.audioFormat = ForwardFormat::Flac;
+        }
+    }
+}
+
+static bool isLanguageCode(std::string_view text) {
+    if (text.empty() || text.size() > MAX_LANGUAGE_LENGTH) return false;
+    for (char c : text) {
+        if (!(c >= 'a' && c <= 'z') && !(c >= 'A' && c <= 'Z')) return false;
     }
+    return true;
+}
 
-    // Check if it's a string value
-    if (json[valueStart] == '"') {
-        size_t valueEnd = json.find('"', valueStart + 1);
-        if (valueEnd != std::string::npos) {
-            return json.substr(valueStart + 1, valueEnd - valueStart - 1);
+// Config fields are strict so a typo is reported instead of silently ignored.
+// Returns an error message, or nullptr.
+static const char* parseConfigField(std::string_view key, const JsonValue& value, Command& cmd) {
+    int number = 0;
+    if (key == "chunk_ms") {
+        if (!value.asInt(&number) || number < MIN_CHUNK_MS || number > MAX_CHUNK_MS) {
+            return "chunk_ms must be an integer from 1000 to 30000";
+        }
+        cmd.chunkMs = number;
+    } else if (key == "threads") {
+        if (!value.asInt(&number) || number < 0 || number > MAX_THREADS) {
+            return "threads must be an integer from 0 (all cores) to 64";
         }
+        cmd.threads = number;
+    } else if (key == "beam_size") {
+        if (!value.asInt(&number) || number < 1 || number > MAX_BEAM_SIZE) {
+            return "beam_size must be an integer from 1 (greedy) to 8";
+        }
+        cmd.beamSize = number;
+    } else if (key == "language") {
+        if (value.type != JsonType::String || value.escaped || !isLanguageCode(value.text)) {
+            return "language must be a language code such as \"en\" or \"auto\"";
+        }
+        for (size_t i = 0; i < value.text.size(); ++i) {
+            const char c = value.text[i];
+            cmd.language[i] = (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+        cmd.language[value.text.size()] = '\0';
+    } else if (key == "vad") {
+        if (value.type != JsonType::String || !parseVadMode(value.text, &cmd.vad)) {
+            return "vad must be \"off\", \"normal\" or \"aggressive\"";
+        }
+        cmd.hasVad = true;
+    } else if (key == "context_tokens") {
+        if (!value.asInt(&number) || number < 0 || number > MAX_CONTEXT_TOKENS) {
+            return "context_tokens must be an integer from 0 (no carry-over) to 224";
+        }
+        cmd.contextTokens = number;
+    } else if (key == "decode_budget_ms") {
+        if (!value.asInt(&number) || number < 0 || number > MAX_DECODE_BUDGET_MS) {
+            return "decode_budget_ms must be an integer from 0 (never re-decode) to 30000";
+        }
+        cmd.decodeBudgetMs = number;
+    } else if (key == "silence_flush_ms") {
+        if (!value.asInt(&number) || number < 0 || number > MAX_SILENCE_FLUSH_MS) {
+            return "silence_flush_ms must be an integer from 0 to 10000";
+        }
+        cmd.silenceFlushMs = number;
+    } else if (key == "denoise") {
+        if (value.type != JsonType::Bool) return "denoise must be true or false";
+        cmd.hasDenoise = true;
+        cmd.denoise = value.boolean;
+    } else {
+        return "unknown config field";
     }
+    return nullptr;
+}
 
-    return "";
+static const char* parseMetricsField(std::string_view key, const JsonValue& value, Command& cmd) {
+    int number = 0;
+    if (key == "interval_ms") {
+        if (!value.asInt(&number) || number < 0 || number > MAX_METRICS_INTERVAL_MS) {
+            return "interval_ms must be an integer from 0 (off) to 3600000";
+        }
+        cmd.metricsIntervalMs = number;
+    } else if (key == "reset") {
+        if (value.type != JsonType::Bool) return "reset must be true or false";
+        cmd.metricsReset = value.boolean;
+    } else {
+        return "unknown metrics field";
+    }
+    return nullptr;
 }
 
-Command parseCommand(const std::string& json) {
-    Command cmd;
-    
-    std::string cmdValue = extractJsonString(json, "cmd");
-    
-    // Convert to lowercase for comparison
-    std::string lowerCmd = cmdValue;
-    std::transform(lowerCmd.begin(), lowerCmd.end(), lowerCmd.begin(), ::tolower);
-
-    if (lowerCmd == "start") {
-        cmd.type = CommandType::Start;
-    } else if (lowerCmd == "stop") {
-        cmd.type = CommandType::Stop;
-    } else if (lowerCmd == "exit") {
-        cmd.type = CommandType::Exit;
+static const char* parseTraceField(std::string_view key, const JsonValue& value, Command& cmd) {
+    if (key == "enabled") {
+        if (value.type != JsonType::Bool) return "enabled must be true or false";
+        cmd.traceEnabled = value.boolean;
+    } else if (key == "path") {
+        cmd.tracePath.clear();
+        if (!value.decodeString(&cmd.tracePath) || cmd.tracePath.empty()) {
+            return "path must be a non-empty string";
+        }
     } else {
+        return "unknown trace field";
+    }
+    return nullptr;
+}
+
+Command parseCommand(std::string_view json) {
+    Command cmd;
+    JsonObjectReader reader(json);
+    std::string_view key;
+    JsonValue value;
+
+    // "cmd" may appear anywhere, so find it before reading the other fields
+    while (reader.next(&key, &value)) {
+        if (key == "cmd") {
+            cmd.type = commandTypeFromName(value);
+            break;
+        }
+    }
+    if (reader.failed() || cmd.type == CommandType::Unknown) {
+        cmd.type = CommandType::Unknown;
+        return cmd;
+    }
+
+    reader.reset();
+    while (reader.next(&key, &value)) {
+        if (key == "cmd") continue;
+
+        if (cmd.type == CommandType::Hello) {
+            parseHelloField(key, value, cmd);
+        } else if (cmd.type == CommandType::Config && !cmd.error) {
+            cmd.error = parseConfigField(key, value, cmd);
+        } else if (cmd.type == CommandType::Metrics && !cmd.error) {
+            cmd.error = parseMetricsField(key, value, cmd);
+        } else if (cmd.type == CommandType::Trace && !cmd.error) {
+            cmd.error = parseTraceField(key, value, cmd);
+        }
+    }
+    if (reader.failed()) {
         cmd.type = CommandType::Unknown;
     }
 
     return cmd;
 }
 
+void Command::applyTo(TranscriptionConfig& config) const {
+    if (chunkMs >= 0) config.chunkMs = chunkMs;
+    if (threads >= 0) config.threads = threads;
+    if (beamSize >= 0) config.beamSize = beamSize;
+    if (language[0] != '\0') config.language = language;
+    if (hasVad) config.vad = vad;
+    if (contextTokens >= 0) config.contextTokens = contextTokens;
+    if (decodeBudgetMs >= 0) config.decodeBudgetMs = decodeBudgetMs;
+    if (hasDenoise) config.denoise = denoise;
+    if (silenceFlushMs >= 0) config.silenceFlushMs = silenceFlushMs;
+}
+
 std::string escapeJson(const std::string& str) {
-    std::ostringstream ss;
-    for (char c : str) {
-        switch (c) {
-            case '"':  ss << "\\\""; break;
-            case '\\': ss << "\\\\"; break;
-            case '\b': ss << "\\b"; break;
-            case '\f': ss << "\\f"; break;
-            case '\n': ss << "\\n"; break;
-            case '\r': ss << "\\r"; break;
-            case '\t': ss << "\\t"; break;
-            default:
-                if (static_cast<unsigned char>(c) < 0x20) {
-                    // Control character - use unicode escape
-                    ss << "\\u" << std::hex << std::setfill('0') << std::setw(4) 
-                       << static_cast<int>(static_cast<unsigned char>(c));
-                } else {
-                    ss << c;
-                }
-        }
+    std::string out;
+    appendJsonEscaped(out, str.data(), str.size());
+    return out;
+}
+
+static void putLE16(char* dst, uint16_t value) {
+    dst[0] = static_cast<char>(value & 0xFF);
+    dst[1] = static_cast<char>((value >> 8) & 0xFF);
+}
+
+static void putLE32(char* dst, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        dst[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
     }
-    return ss.str();
 }
 
-void sendReady() {
-    std::cout << "{\"type\":\"ready\"}" << std::endl;
+static void putLE64(char* dst, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        dst[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+static uint64_t samplesToMicros(uint64_t samples) {
+    return samples * 1000000ULL / SAMPLE_RATE;
+}
+
+// Write one frame to stdout. Caller must hold g_outputMutex.
+static void writeFrameLocked(FrameType type, uint16_t streamId, uint64_t timestampUs,
+                             const void* payload, size_t payloadSize, uint8_t flags = 0) {
+    StageTimer timer(metrics().outputWrite);
+    TraceSpan span("stdout_write", "bytes", static_cast<int64_t>(FRAME_HEADER_SIZE + payloadSize));
+    char header[FRAME_HEADER_SIZE];
+    putLE32(header, static_cast<uint32_t>(payloadSize));
+    header[4] = static_cast<char>(type);
+    header[5] = static_cast<char>(flags);
+    putLE16(header + 6, streamId);
+    putLE64(header + 8, timestampUs);
+
+    std::cout.write(header, FRAME_HEADER_SIZE);
+    if (payloadSize > 0) {
+        std::cout.write(static_cast<const char*>(payload), static_cast<std::streamsize>(payloadSize));
+    }
     std::cout.flush();
 }
 
-void sendStarted() {
-    std::cout << "{\"type\":\"started\"}" << std::endl;
+// Write a complete newline-terminated line. Caller must hold g_outputMutex.
+static void writeLineLocked(const std::string& line) {
+    StageTimer timer(metrics().outputWrite);
+    TraceSpan span("stdout_write", "bytes", static_cast<int64_t>(line.size()));
+    std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
     std::cout.flush();
 }
 
+// Write one JSON event, as a line (v1) or an event frame (v2)
+static void writeEvent(const std::string& json) {
+    std::lock_guard<std::mutex> lock(g_outputMutex);
+    metrics().eventsWritten.fetch_add(1, std::memory_order_relaxed);
+    if (g_binaryFraming.load()) {
+        writeFrameLocked(FrameType::Event, STREAM_CONTROL, samplesToMicros(g_streamSamples),
+                         json.data(), json.size());
+    } else {
+        StageTimer timer(metrics().outputWrite);
+        TraceSpan span("stdout_write", "bytes", static_cast<int64_t>(json.size() + 1));
+        std::cout << json << std::endl;
+        std::cout.flush();
+    }
+}
+
+// Emit pending batched audio. Caller must hold g_outputMutex.
+static void flushAudioLocked() {
+    if (g_pendingAudio.empty()) return;
+
+    const FrameType type = g_wireFormat == SampleFormat::S16 ? FrameType::AudioS16 : FrameType::AudioF32;
+    writeFrameLocked(type, STREAM_SYSTEM_AUDIO, samplesToMicros(g_pendingStartSample),
+                     g_pendingAudio.data(), g_pendingAudio.size());
+    g_pendingStartSample = g_streamSamples;
+    g_pendingAudio.clear();
+}
+
+int negotiateProtocol(const Command& hello) {
+    std::lock_guard<std::mutex> lock(g_outputMutex);
+
+    // Framing cannot be switched back off: a repeat hello keeps v2 and is
+    // answered in an event frame so the stream stays parseable
+    const bool framed = g_binaryFraming.load();
+    const int version = (framed || hello.protocol >= PROTOCOL_VERSION) ? PROTOCOL_VERSION : 1;
+    if (version >= 2) {
+        g_batchSamples = static_cast<size_t>(hello.batchMs) * SAMPLE_RATE / 1000;
+    }
+
+    // Anything batched so far was queued in the previous format
+    flushAudioLocked();
+    if (hello.audioFormat == ForwardFormat::S16) {
+        g_wireFormat = SampleFormat::S16;
+    } else if (hello.audioFormat == ForwardFormat::F32) {
+        g_wireFormat = SampleFormat::F32;
+    }
+    const char* audioFormat = hello.audioFormat == ForwardFormat::Flac ? "flac" : sampleFormatName(g_wireFormat);
+
+    std::string json = "{\"type\":\"hello\",\"protocol\":";
+    json += std::to_string(version);
+    json += ",\"framing\":\"";
+    json += version >= 2 ? "binary" : "json";
+    json += "\",\"sample_rate\":";
+    json += std::to_string(SAMPLE_RATE);
+    json += ",\"audio_format\":\"";
+    json += audioFormat;
+    json += "\"}";
+
+    if (framed) {
+        metrics().eventsWritten.fetch_add(1, std::memory_order_relaxed);
+        writeFrameLocked(FrameType::Event, STREAM_CONTROL, samplesToMicros(g_streamSamples),
+                         json.data(), json.size());
+        return version;
+    }
+
+    json += '\n';
+    writeLineLocked(json);
+
+    if (version >= 2) {
+#ifdef _WIN32
+        // Frames contain arbitrary bytes; stop the CRT from translating \n
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        g_binaryFraming.store(true);
+    }
+
+    return version;
+}
+
+bool isBinaryFraming() {
+    return g_binaryFraming.load();
+}
+
+void sendReady(const std::vector<KernelBinding>& kernels) {
+    std::string json = "{\"type\":\"ready\",\"simd\":\"";
+    json += simdIsaName(preferredIsa());
+    json += "\",\"kernels\":{";
+    for (size_t i = 0; i < kernels.size(); ++i) {
+        if (i > 0) json += ',';
+        json += '"';
+        json += kernels[i].module;
+        json += "\":\"";
+        json += simdIsaName(kernels[i].isa);
+        json += '"';
+    }
+    json += "}}";
+    writeEvent(json);
+}
+
+void sendStarted() {
+    writeEvent("{\"type\":\"started\"}");
+}
+
 void sendStopped() {
-    std::cout << "{\"type\":\"stopped\"}" << std::endl;
-    std::cout.flush();
+    writeEvent("{\"type\":\"stopped\"}");
 }
 
-void sendPartial(const std::string& text) {
-    std::cout << "{\"type\":\"partial\",\"text\":\"" << escapeJson(text) << "\"}" << std::endl;
-    std::cout.flush();
+void sendPartial(uint64_t segment, const std::string& text) {
+    std::string json;
+    {
+        std::lock_guard<std::mutex> lock(g_partialMutex);
+        TranscriptDelta delta;
+        if (!g_partials.encode(segment, text, delta)) return;
+        json = "{\"type\":\"partial\",\"segment\":" + std::to_string(segment) +
+               ",\"keep\":" + std::to_string(delta.keep) + ",\"text\":\"";
+        appendJsonEscaped(json, delta.text.data(), delta.text.size());
+        json += "\"}";
+    }
+    writeEvent(json);
 }
 
-void sendFinal(const std::string& text) {
-    std::cout << "{\"type\":\"final\",\"text\":\"" << escapeJson(text) << "\"}" << std::endl;
-    std::cout.flush();
+void sendFinal(uint64_t segment, const std::string& text) {
+    {
+        std::lock_guard<std::mutex> lock(g_partialMutex);
+        g_partials.finish(segment);
+    }
+    std::string json = "{\"type\":\"final\",\"segment\":" + std::to_string(segment) + ",\"text\":\"";
+    appendJsonEscaped(json, text.data(), text.size());
+    json += "\"}";
+    writeEvent(json);
 }
 
-// Basic base64 encoding (no line breaks)
-static std::string base64Encode(const uint8_t* data, size_t len) {
-    static const char* table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-    std::string out;
-    out.reserve(((len + 2) / 3) * 4);
+// Emit or batch samples already in the wire format. Caller must hold g_outputMutex.
+static void sendAudioLocked(const uint8_t* bytes, size_t numSamples) {
+    const size_t byteLength = numSamples * bytesPerSample(g_wireFormat);
 
-    for (size_t i = 0; i < len; i += 3) {
-        uint32_t triple = (data[i] << 16);
-        if (i + 1 < len) triple |= (data[i + 1] << 8);
-        if (i + 2 < len) triple |= data[i + 2];
+    if (!g_binaryFraming.load()) {
+        g_lineBuffer.assign("{\"type\":\"audio\",\"data\":\"");
+        appendBase64(g_lineBuffer, bytes, byteLength);
+        g_lineBuffer += "\",\"format\":\"";
+        g_lineBuffer += sampleFormatName(g_wireFormat);
+        g_lineBuffer += "\"}\n";
+        writeLineLocked(g_lineBuffer);
+        g_streamSamples += numSamples;
+        return;
+    }
 
-        out.push_back(table[(triple >> 18) & 0x3F]);
-        out.push_back(table[(triple >> 12) & 0x3F]);
-        out.push_back((i + 1 < len) ? table[(triple >> 6) & 0x3F] : '=');
-        out.push_back((i + 2 < len) ? table[triple & 0x3F] : '=');
+    if (g_pendingAudio.empty()) {
+        g_pendingStartSample = g_streamSamples;
     }
+    g_pendingAudio.insert(g_pendingAudio.end(), bytes, bytes + byteLength);
+    g_streamSamples += numSamples;
 
-    return out;
+    if (g_pendingAudio.size() >= g_batchSamples * bytesPerSample(g_wireFormat)) {
+        flushAudioLocked();
+    }
 }
 
 void sendAudioChunk(const float* samples, size_t numSamples) {
     if (!samples || numSamples == 0) return;
 
-    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(samples);
-    const size_t byteLength = numSamples * sizeof(float);
-    std::string encoded = base64Encode(bytes, byteLength);
+    std::lock_guard<std::mutex> lock(g_outputMutex);
+    if (g_wireFormat == SampleFormat::F32) {
+        sendAudioLocked(reinterpret_cast<const uint8_t*>(samples), numSamples);
+        return;
+    }
 
-    std::cout << "{\"type\":\"audio\",\"text\":\"" << encoded << "\"}" << std::endl;
-    std::cout.flush();
+    g_wireScratch.resize(numSamples * sizeof(int16_t));
+    floatToS16(samples, reinterpret_cast<int16_t*>(g_wireScratch.data()), numSamples);
+    sendAudioLocked(g_wireScratch.data(), numSamples);
+}
+
+void sendAudioChunk(const int16_t* samples, size_t numSamples) {
+    if (!samples || numSamples == 0) return;
+
+    std::lock_guard<std::mutex> lock(g_outputMutex);
+    if (g_wireFormat == SampleFormat::S16) {
+        sendAudioLocked(reinterpret_cast<const uint8_t*>(samples), numSamples);
+        return;
+    }
+
+    g_wireScratch.resize(numSamples * sizeof(float));
+    s16ToFloat(samples, reinterpret_cast<float*>(g_wireScratch.data()), numSamples);
+    sendAudioLocked(g_wireScratch.data(), numSamples);
+}
+
+void sendFlacData(const uint8_t* data, size_t size, uint8_t flags, size_t numSamples) {
+    std::lock_guard<std::mutex> lock(g_outputMutex);
+    const uint64_t startSample = g_streamSamples;
+    g_streamSamples += numSamples;
+
+    // Most capture packets only fill the encoder's block buffer
+    if (size == 0 && flags == 0) return;
+
+    if (g_binaryFraming.load()) {
+        writeFrameLocked(FrameType::Flac, STREAM_SYSTEM_AUDIO, samplesToMicros(startSample),
+                         data, size, flags);
+        return;
+    }
+
+    g_lineBuffer.assign("{\"type\":\"flac\",\"data\":\"");
+    appendBase64(g_lineBuffer, data, size);
+    g_lineBuffer += "\",\"flags\":";
+    g_lineBuffer += std::to_string(static_cast<int>(flags));
+    g_lineBuffer += "}\n";
+    writeLineLocked(g_lineBuffer);
+}
+
+void sendSilence(size_t numSamples) {
+    uint64_t startSample;
+    {
+        std::lock_guard<std::mutex> lock(g_outputMutex);
+        // Audio batched before the silence keeps its place in the stream
+        flushAudioLocked();
+        startSample = g_streamSamples;
+        g_streamSamples += numSamples;
+        g_pendingStartSample = g_streamSamples;
+    }
+
+    std::string json = "{\"type\":\"silence\",\"start_ms\":";
+    json += std::to_string(samplesToMicros(startSample) / 1000);
+    json += ",\"duration_ms\":";
+    json += std::to_string(samplesToMicros(numSamples) / 1000);
+    json += ",\"samples\":";
+    json += std::to_string(numSamples);
+    json += '}';
+    writeEvent(json);
+}
+
+void sendConfig(const TranscriptionConfig& config) {
+    std::string json = "{\"type\":\"config\",\"chunk_ms\":" + std::to_string(config.chunkMs) +
+                       ",\"threads\":" + std::to_string(config.threads) +
+                       ",\"beam_size\":" + std::to_string(config.beamSize) +
+                       ",\"language\":\"";
+    appendJsonEscaped(json, config.language.data(), config.language.size());
+    json += "\",\"vad\":\"";
+    json += vadModeName(config.vad);
+    json += "\",\"context_tokens\":";
+    json += std::to_string(config.contextTokens);
+    json += ",\"decode_budget_ms\":";
+    json += std::to_string(config.decodeBudgetMs);
+    json += ",\"denoise\":";
+    json += config.denoise ? "true" : "false";
+    json += ",\"silence_flush_ms\":";
+    json += std::to_string(config.silenceFlushMs);
+    json += '}';
+    writeEvent(json);
+}
+
+void sendMetrics() {
+    std::string json = "{\"type\":\"metrics\",";
+    metrics().appendJson(json);
+    json += '}';
+    writeEvent(json);
+}
+
+void sendTrace(bool enabled, const std::string& path, uint64_t events, uint64_t dropped) {
+    std::string json = "{\"type\":\"trace\",\"enabled\":";
+    json += enabled ? "true" : "false";
+    json += ",\"path\":\"";
+    appendJsonEscaped(json, path.data(), path.size());
+    json += '"';
+    if (!enabled) {
+        json += ",\"events\":" + std::to_string(events) + ",\"dropped\":" + std::to_string(dropped);
+    }
+    json += '}';
+    writeEvent(json);
+}
+
+void sendSharedRing(const std::string& name, const std::string& path,
+                    uint32_t capacity, uint32_t sampleRate, SampleFormat format, size_t headerBytes) {
+    std::ostringstream ss;
+    ss << "{\"type\":\"shm\",\"name\":\"" << escapeJson(name) << "\""
+       << ",\"path\":\"" << escapeJson(path) << "\""
+       << ",\"capacity\":" << capacity
+       << ",\"sample_rate\":" << sampleRate
+       << ",\"format\":\"" << sampleFormatName(format) << "\""
+       << ",\"header_bytes\":" << headerBytes << "}";
+    writeEvent(ss.str());
+}
+
+void flushAudio() {
+    std::lock_guard<std::mutex> lock(g_outputMutex);
+    flushAudioLocked();
+}
+
+void resetAudioClock() {
+    std::lock_guard<std::mutex> lock(g_outputMutex);
+    g_pendingAudio.clear();
+    g_pendingStartSample = 0;
+    g_streamSamples = 0;
 }
 
 void sendError(const std::string& message) {
-    std::cout << "{\"type\":\"error\",\"message\":\"" << escapeJson(message) << "\"}" << std::endl;
-    std::cout.flush();
+    writeEvent("{\"type\":\"error\",\"message\":\"" + escapeJson(message) + "\"}");
 }
 
 } // namespace phantom
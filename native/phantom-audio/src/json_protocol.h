@@ -1,51 +1,210 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "kernel_dispatch.h"
+#include "sample_format.h"
+#include "transcription_config.h"
 
 namespace phantom {
 
 /**
  * JSON protocol for communicating with Electron main process.
- * 
+ *
  * Input commands (stdin):
+ *   {"cmd":"hello","protocol":2,"batch_ms":100} - Negotiate framing (see below)
+ *   {"cmd":"hello",...,"audio_format":"s16"} - Forward int16 PCM instead of float32
+ *   {"cmd":"hello",...,"audio_format":"flac","segment_ms":N} - Forward FLAC segments instead of PCM
  *   {"cmd":"start"}     - Start audio capture and transcription
  *   {"cmd":"stop"}      - Stop capture (pause)
  *   {"cmd":"exit"}      - Clean shutdown
- * 
+ *   {"cmd":"config","chunk_ms":1500,"threads":6,"beam_size":1,"language":"en","vad":"aggressive"}
+ *                       - Retune transcription live; every field is optional,
+ *                         and {"cmd":"config"} alone just reports the config;
+ *                         "language":"auto" also re-detects the language
+ *   {"cmd":"metrics"}   - Report pipeline metrics once
+ *   {"cmd":"metrics","interval_ms":5000,"reset":true}
+ *                       - ...and every interval_ms from now on (0 = stop);
+ *                         reset clears the histograms after this report
+ *   {"cmd":"trace","enabled":true,"path":"..."}
+ *                       - Record pipeline spans to a Chrome trace file;
+ *                         "enabled":false stops and writes it
+ *
  * Output events (stdout):
- *   {"type":"ready"}                           - Process initialized and ready
+ *   {"type":"ready","simd":"avx2","kernels":{"sample_format":"avx2",...}}
+ *                                              - Process initialized and ready
+ *   {"type":"hello","protocol":2,"framing":"binary"} - Handshake reply
  *   {"type":"started"}                         - Capture started
  *   {"type":"stopped"}                         - Capture stopped
- *   {"type":"partial","text":"..."}            - Partial transcription result
- *   {"type":"final","text":"..."}              - Final transcription result
- *   {"type":"audio","data":"<base64 pcm>"}     - Raw audio chunk (float32 mono)
+ *   {"type":"partial","segment":N,"keep":K,"text":"..."}
+ *                                              - Partial result: segment N's text is its last
+ *                                                partial's first K UTF-16 units, then text
+ *   {"type":"final","segment":N,"text":"..."}  - Final result: segment N's whole text, sent once
+ *   {"type":"audio","data":"<base64 pcm>","format":"f32"} - Raw audio chunk (f32 or s16 mono)
+ *   {"type":"flac","data":"<base64>","flags":N} - Encoded audio (see FLAC segments)
+ *   {"type":"shm","name":"...","path":"...","capacity":N,...} - Audio goes to a shared ring
+ *   {"type":"config","chunk_ms":N,"threads":N,"beam_size":N,"language":"..","vad":".."}
+ *                                              - Config now in effect (reply to config)
+ *   {"type":"metrics","uptime_ms":N,"stages":{...},"counters":{...},"gauges":{...}}
+ *                                              - Latency histograms and counters (see pipeline_metrics.h)
+ *   {"type":"trace","enabled":B,"path":"...","events":N,"dropped":N}
+ *                                              - Trace started or written (counts on stop)
  *   {"type":"error","message":"..."}           - Error occurred
+ *
+ * Protocol v2 (binary framing):
+ *   Until a hello is negotiated, stdout is newline-delimited JSON (protocol v1).
+ *   When the client sends {"cmd":"hello","protocol":2}, the hello reply is the
+ *   last JSON line; every byte after it is a sequence of frames. A later
+ *   hello may change batch_ms or audio_format, but framing stays on and its
+ *   reply arrives as an event frame:
+ *
+ *     offset  size  field
+ *     0       4     payload length in bytes (uint32, little-endian)
+ *     4       1     frame type (FrameType)
+ *     5       1     flags (FRAME_FLAG_*, 0 unless noted)
+ *     6       2     stream id (uint16, little-endian)
+ *     8       8     timestamp in microseconds of stream time (uint64, little-endian)
+ *     16      n     payload
+ *
+ *   Event frames carry the same JSON object as v1 (without the newline).
+ *   Audio frames carry raw mono samples at 16kHz (AudioF32, or AudioS16 when
+ *   audio_format "s16" was negotiated); with batch_ms > 0
+ *   several capture packets are concatenated into one frame and the
+ *   timestamp is that of the first sample.
+ *
+ * FLAC segments:
+ *   With audio_format "flac" the forwarded stream is 16-bit FLAC instead of
+ *   float32 PCM. Audio is cut into segments of segment_ms (0 = one segment
+ *   per start/stop); each segment is a standalone .flac file delivered in
+ *   pieces. The first piece carries FRAME_FLAG_SEGMENT_START and the last
+ *   FRAME_FLAG_SEGMENT_END, and the final segment is closed before
+ *   "stopped" is sent.
  */
 
+constexpr int PROTOCOL_VERSION = 2;
+constexpr int MAX_METRICS_INTERVAL_MS = 3600000;
+constexpr size_t FRAME_HEADER_SIZE = 16;
+
+enum class FrameType : uint8_t {
+    Event = 1,
+    AudioF32 = 2,
+    Flac = 3,
+    AudioS16 = 4
+};
+
+// Frame flags for FrameType::Flac (also the "flags" field of JSON flac events)
+constexpr uint8_t FRAME_FLAG_SEGMENT_START = 0x01;
+constexpr uint8_t FRAME_FLAG_SEGMENT_END = 0x02;
+
+// Stream ids used in frame headers
+constexpr uint16_t STREAM_CONTROL = 0;
+constexpr uint16_t STREAM_SYSTEM_AUDIO = 1;
+
 enum class CommandType {
     Unknown,
+    Hello,
     Start,
     Stop,
-    Exit
+    Exit,
+    Config,
+    Metrics,
+    Trace
+};
+
+// Forwarded audio requested in a hello
+enum class ForwardFormat : uint8_t {
+    F32,
+    S16,
+    Flac
 };
 
+const char* forwardFormatName(ForwardFormat format);
+
+/**
+ * A parsed stdin command. Parsing does not allocate: fields are plain
+ * values and `error` points at a static message. The one exception is a
+ * trace path, which is decoded into tracePath.
+ */
 struct Command {
     CommandType type = CommandType::Unknown;
+
+    // Set when a known command has a malformed or out-of-range field
+    const char* error = nullptr;
+
+    // Hello parameters
+    int protocol = 1;
+    int batchMs = 0;
+    ForwardFormat audioFormat = ForwardFormat::F32;
+    int segmentMs = 0;
+
+    // Config parameters (-1 / empty = leave unchanged)
+    int chunkMs = -1;
+    int threads = -1;
+    int beamSize = -1;
+    char language[MAX_LANGUAGE_LENGTH + 1] = {};
+    bool hasVad = false;
+    VadMode vad = VadMode::Normal;
+    int contextTokens = -1;
+    int decodeBudgetMs = -1;
+    bool hasDenoise = false;
+    bool denoise = false;
+    int silenceFlushMs = -1;
+
+    // Metrics parameters
+    int metricsIntervalMs = -1;     // -1 = leave unchanged, 0 = stop periodic reports
+    bool metricsReset = false;
+
+    // Trace parameters
+    bool traceEnabled = true;
+    std::string tracePath;          // Empty = PHANTOM_AUDIO_TRACE or the default path
+
+    // Apply the config fields that were given
+    void applyTo(TranscriptionConfig& config) const;
 };
 
 // Parse a JSON command from stdin
-Command parseCommand(const std::string& json);
+Command parseCommand(std::string_view json);
+
+// Reply to a hello and switch framing if protocol v2 was requested.
+// Once framed, the reply is an event frame and the version stays 2.
+// Returns the negotiated protocol version.
+int negotiateProtocol(const Command& hello);
+
+// True once binary framing has been negotiated
+bool isBinaryFraming();
 
 // Output JSON messages to stdout
-void sendReady();
+// ready reports the SIMD level picked for this CPU and what each kernel module bound
+void sendReady(const std::vector<KernelBinding>& kernels);
 void sendStarted();
 void sendStopped();
-void sendPartial(const std::string& text);
-void sendFinal(const std::string& text);
+// Partials are sent as a delta from the segment's last partial, and not
+// at all if nothing changed
+void sendPartial(uint64_t segment, const std::string& text);
+void sendFinal(uint64_t segment, const std::string& text);
+// Raw audio is converted to the negotiated wire format if needed
 void sendAudioChunk(const float* samples, size_t numSamples);
+void sendAudioChunk(const int16_t* samples, size_t numSamples);
+// Forward a piece of a FLAC segment covering numSamples of stream time
+void sendFlacData(const uint8_t* data, size_t size, uint8_t flags, size_t numSamples);
+// Stand-in for numSamples of digital silence that were not forwarded;
+// advances the stream clock as if they had been
+void sendSilence(size_t numSamples);
+void sendConfig(const TranscriptionConfig& config);
+void sendMetrics();
+void sendTrace(bool enabled, const std::string& path, uint64_t events, uint64_t dropped);
+void sendSharedRing(const std::string& name, const std::string& path,
+                    uint32_t capacity, uint32_t sampleRate, SampleFormat format, size_t headerBytes);
 void sendError(const std::string& message);
 
+// Emit any audio held back for batching and reset the stream clock
+void flushAudio();
+void resetAudioClock();
+
 // Utility to escape JSON strings
 std::string escapeJson(const std::string& str);
 
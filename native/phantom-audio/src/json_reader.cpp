@@ -0,0 +1,329 @@
+#include "json_reader.h"
+#include <climits>
+#include <cmath>
+
+namespace phantom {
+
+namespace {
+    // Commands are flat; deeper nesting is rejected rather than recursed into
+    constexpr int MAX_DEPTH = 16;
+
+    bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    bool isHexDigit(char c) {
+        return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+    }
+}
+
+bool JsonValue::asInt(int* out) const {
+    if (type != JsonType::Number) return false;
+    if (number != std::floor(number) || number < INT_MIN || number > INT_MAX) return false;
+    *out = static_cast<int>(number);
+    return true;
+}
+
+static unsigned hexValue(char c) {
+    if (c >= '0' && c <= '9') return static_cast<unsigned>(c - '0');
+    if (c >= 'a' && c <= 'f') return static_cast<unsigned>(c - 'a' + 10);
+    return static_cast<unsigned>(c - 'A' + 10);
+}
+
+static void appendUtf8(std::string* out, uint32_t cp) {
+    if (cp < 0x80) {
+        *out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        *out += static_cast<char>(0xC0 | (cp >> 6));
+        *out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        *out += static_cast<char>(0xE0 | (cp >> 12));
+        *out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        *out += static_cast<char>(0xF0 | (cp >> 18));
+        *out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        *out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+bool JsonValue::decodeString(std::string* out) const {
+    if (type != JsonType::String) return false;
+    if (!escaped) {
+        out->append(text.data(), text.size());
+        return true;
+    }
+
+    // Escapes were validated while reading, so only \u pairing can fail here
+    for (size_t i = 0; i < text.size(); ++i) {
+        const char c = text[i];
+        if (c != '\\') {
+            *out += c;
+            continue;
+        }
+        const char e = text[++i];
+        switch (e) {
+            case 'b': *out += '\b'; break;
+            case 'f': *out += '\f'; break;
+            case 'n': *out += '\n'; break;
+            case 'r': *out += '\r'; break;
+            case 't': *out += '\t'; break;
+            case 'u': {
+                uint32_t cp = 0;
+                for (size_t k = 1; k <= 4; ++k) cp = (cp << 4) | hexValue(text[i + k]);
+                i += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    // High surrogate must be followed by \uDC00-\uDFFF
+                    if (i + 6 >= text.size() || text[i + 1] != '\\' || text[i + 2] != 'u') return false;
+                    uint32_t low = 0;
+                    for (size_t k = 3; k <= 6; ++k) low = (low << 4) | hexValue(text[i + k]);
+                    if (low < 0xDC00 || low > 0xDFFF) return false;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    return false;
+                }
+                appendUtf8(out, cp);
+                break;
+            }
+            default: *out += e; break;  // \" \\ \/
+        }
+    }
+    return true;
+}
+
+JsonObjectReader::JsonObjectReader(std::string_view json) : m_json(json) {
+    skipWhitespace();
+    if (m_pos >= m_json.size() || m_json[m_pos] != '{') {
+        fail();
+        return;
+    }
+    ++m_pos;
+    m_firstMember = m_pos;
+}
+
+void JsonObjectReader::reset() {
+    if (m_failed && m_firstMember == 0) return;  // Not an object at all
+    m_pos = m_firstMember;
+    m_failed = false;
+    m_done = false;
+    m_first = true;
+}
+
+bool JsonObjectReader::fail() {
+    m_failed = true;
+    m_done = true;
+    return false;
+}
+
+void JsonObjectReader::skipWhitespace() {
+    while (m_pos < m_json.size()) {
+        const char c = m_json[m_pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') break;
+        ++m_pos;
+    }
+}
+
+bool JsonObjectReader::next(std::string_view* key, JsonValue* value) {
+    if (m_done) return false;
+
+    skipWhitespace();
+    if (m_pos >= m_json.size()) return fail();
+
+    if (m_json[m_pos] == '}') {
+        ++m_pos;
+        m_done = true;
+        return false;
+    }
+    if (!m_first) {
+        if (m_json[m_pos] != ',') return fail();
+        ++m_pos;
+        skipWhitespace();
+    }
+    m_first = false;
+
+    bool keyEscaped = false;
+    if (!parseString(key, &keyEscaped)) return fail();
+
+    skipWhitespace();
+    if (m_pos >= m_json.size() || m_json[m_pos] != ':') return fail();
+    ++m_pos;
+    skipWhitespace();
+
+    *value = JsonValue();
+    if (!parseValue(value, 1)) return fail();
+    return true;
+}
+
+bool JsonObjectReader::parseString(std::string_view* text, bool* escaped) {
+    if (m_pos >= m_json.size() || m_json[m_pos] != '"') return false;
+    const size_t begin = ++m_pos;
+    *escaped = false;
+
+    while (m_pos < m_json.size()) {
+        const char c = m_json[m_pos];
+        if (c == '"') {
+            *text = m_json.substr(begin, m_pos - begin);
+            ++m_pos;
+            return true;
+        }
+        if (static_cast<unsigned char>(c) < 0x20) return false;
+        if (c == '\\') {
+            *escaped = true;
+            if (++m_pos >= m_json.size()) return false;
+            const char e = m_json[m_pos];
+            if (e == 'u') {
+                if (m_pos + 4 >= m_json.size()) return false;
+                for (size_t i = 1; i <= 4; ++i) {
+                    if (!isHexDigit(m_json[m_pos + i])) return false;
+                }
+                m_pos += 4;
+            } else if (e != '"' && e != '\\' && e != '/' && e != 'b' && e != 'f' &&
+                       e != 'n' && e != 'r' && e != 't') {
+                return false;
+            }
+        }
+        ++m_pos;
+    }
+    return false;
+}
+
+bool JsonObjectReader::parseNumber(JsonValue* value) {
+    const size_t begin = m_pos;
+    const size_t n = m_json.size();
+    bool negative = false;
+
+    if (m_pos < n && m_json[m_pos] == '-') {
+        negative = true;
+        ++m_pos;
+    }
+    if (m_pos >= n || !isDigit(m_json[m_pos])) return false;
+
+    double mantissa = 0.0;
+    if (m_json[m_pos] == '0') {
+        ++m_pos;
+    } else {
+        while (m_pos < n && isDigit(m_json[m_pos])) {
+            mantissa = mantissa * 10.0 + (m_json[m_pos] - '0');
+            ++m_pos;
+        }
+    }
+
+    int exponent = 0;
+    if (m_pos < n && m_json[m_pos] == '.') {
+        ++m_pos;
+        if (m_pos >= n || !isDigit(m_json[m_pos])) return false;
+        while (m_pos < n && isDigit(m_json[m_pos])) {
+            mantissa = mantissa * 10.0 + (m_json[m_pos] - '0');
+            --exponent;
+            ++m_pos;
+        }
+    }
+
+    if (m_pos < n && (m_json[m_pos] == 'e' || m_json[m_pos] == 'E')) {
+        ++m_pos;
+        bool expNegative = false;
+        if (m_pos < n && (m_json[m_pos] == '+' || m_json[m_pos] == '-')) {
+            expNegative = m_json[m_pos] == '-';
+            ++m_pos;
+        }
+        if (m_pos >= n || !isDigit(m_json[m_pos])) return false;
+        int e = 0;
+        while (m_pos < n && isDigit(m_json[m_pos])) {
+            if (e < 10000) e = e * 10 + (m_json[m_pos] - '0');
+            ++m_pos;
+        }
+        exponent += expNegative ? -e : e;
+    }
+
+    // Exact for the integers commands use; close enough for anything else
+    double result = mantissa;
+    if (exponent > 0) {
+        result *= std::pow(10.0, exponent);
+    } else if (exponent < 0) {
+        result /= std::pow(10.0, -exponent);
+    }
+    value->type = JsonType::Number;
+    value->number = negative ? -result : result;
+    value->text = m_json.substr(begin, m_pos - begin);
+    return true;
+}
+
+bool JsonObjectReader::parseLiteral(std::string_view literal) {
+    if (m_json.substr(m_pos, literal.size()) != literal) return false;
+    m_pos += literal.size();
+    return true;
+}
+
+// Skip the object or array starting at m_pos
+bool JsonObjectReader::skipNested(int depth) {
+    if (depth > MAX_DEPTH) return false;
+
+    const char close = m_json[m_pos] == '{' ? '}' : ']';
+    const bool isObject = close == '}';
+    ++m_pos;
+    skipWhitespace();
+    if (m_pos < m_json.size() && m_json[m_pos] == close) {
+        ++m_pos;
+        return true;
+    }
+
+    for (;;) {
+        if (isObject) {
+            std::string_view key;
+            bool escaped = false;
+            if (!parseString(&key, &escaped)) return false;
+            skipWhitespace();
+            if (m_pos >= m_json.size() || m_json[m_pos] != ':') return false;
+            ++m_pos;
+            skipWhitespace();
+        }
+
+        JsonValue element;
+        if (!parseValue(&element, depth + 1)) return false;
+        skipWhitespace();
+        if (m_pos >= m_json.size()) return false;
+
+        if (m_json[m_pos] == close) {
+            ++m_pos;
+            return true;
+        }
+        if (m_json[m_pos] != ',') return false;
+        ++m_pos;
+        skipWhitespace();
+    }
+}
+
+bool JsonObjectReader::parseValue(JsonValue* value, int depth) {
+    if (m_pos >= m_json.size()) return false;
+
+    const size_t begin = m_pos;
+    switch (m_json[m_pos]) {
+        case '"':
+            value->type = JsonType::String;
+            return parseString(&value->text, &value->escaped);
+        case '{':
+        case '[':
+            value->type = m_json[m_pos] == '{' ? JsonType::Object : JsonType::Array;
+            if (!skipNested(depth)) return false;
+            value->text = m_json.substr(begin, m_pos - begin);
+            return true;
+        case 't':
+        case 'f':
+            value->type = JsonType::Bool;
+            value->boolean = m_json[m_pos] == 't';
+            if (!parseLiteral(value->boolean ? "true" : "false")) return false;
+            value->text = m_json.substr(begin, m_pos - begin);
+            return true;
+        case 'n':
+            value->type = JsonType::Null;
+            if (!parseLiteral("null")) return false;
+            value->text = m_json.substr(begin, m_pos - begin);
+            return true;
+        default:
+            return parseNumber(value);
+    }
+}
+
+} // namespace phantom
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+namespace phantom {
+
+enum class JsonType : uint8_t {
+    Invalid,
+    String,
+    Number,
+    Bool,
+    Null,
+    Object,
+    Array
+};
+
+/**
+ * One member value, viewing into the input (nothing is copied).
+ * Strings are the raw text between the quotes; escapes are validated but
+ * not decoded (`escaped` says whether there were any).
+ */
+struct JsonValue {
+    JsonType type = JsonType::Invalid;
+    std::string_view text;      // String contents, or the literal/number/nested text
+    double number = 0.0;
+    bool boolean = false;
+    bool escaped = false;
+
+    // Integral number that fits in an int
+    bool asInt(int* out) const;
+    // String without escapes equal to `s`
+    bool equals(std::string_view s) const { return type == JsonType::String && !escaped && text == s; }
+    // Append the decoded string (escapes resolved, \u as UTF-8). Allocates;
+    // meant for the rare free-form values such as file paths.
+    bool decodeString(std::string* out) const;
+};
+
+/**
+ * Allocation-free reader for the members of one flat JSON object, used for
+ * the stdin command protocol:
+ *
+ *   JsonObjectReader reader(line);
+ *   std::string_view key;
+ *   JsonValue value;
+ *   while (reader.next(&key, &value)) { ... }
+ *   if (reader.failed()) { ... }
+ *
+ * Nested objects and arrays are validated and skipped as a whole (their
+ * text is still available). reset() rewinds to the first member.
+ */
+class JsonObjectReader {
+public:
+    explicit JsonObjectReader(std::string_view json);
+
+    // Read the next member. Returns false at the end of the object or on a
+    // syntax error (see failed()).
+    bool next(std::string_view* key, JsonValue* value);
+
+    bool failed() const { return m_failed; }
+    void reset();
+
+private:
+    void skipWhitespace();
+    bool parseString(std::string_view* text, bool* escaped);
+    bool parseNumber(JsonValue* value);
+    bool parseLiteral(std::string_view literal);
+    bool skipNested(int depth);
+    bool parseValue(JsonValue* value, int depth);
+    bool fail();
+
+    std::string_view m_json;
+    size_t m_pos = 0;
+    size_t m_firstMember = 0;
+    bool m_failed = false;
+    bool m_done = false;
+    bool m_first = true;
+};
+
+} // namespace phantom
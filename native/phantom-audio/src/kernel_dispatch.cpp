@@ -0,0 +1,20 @@
+#include "kernel_dispatch.h"
+#include "frame_features.h"
+#include "noise_suppressor.h"
+#include "sample_format.h"
+#include "silence_detect.h"
+#include "text_encoding.h"
+
+namespace phantom {
+
+std::vector<KernelBinding> bindKernels() {
+    return {
+        {"sample_format", sampleFormatIsa()},     // Converters and stereo downmix
+        {"text_encoding", textEncodingIsa()},     // Base64 and JSON escaping
+        {"silence_detect", silenceDetectIsa()},
+        {"frame_features", frameFeaturesIsa()},   // Energy/VAD features
+        {"noise_suppressor", noiseSuppressorIsa()}, // Denoiser FFT
+    };
+}
+
+} // namespace phantom
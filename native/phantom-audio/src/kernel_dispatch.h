@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+#include "cpu_features.h"
+
+namespace phantom {
+
+// The level one module's kernel table was bound for
+struct KernelBinding {
+    const char* module;
+    SimdIsa isa;
+};
+
+/**
+ * Bind every module's kernel table for this CPU. Each table is built once
+ * from preferredIsa(), on first use; calling this at startup moves that
+ * out of the capture path and reports what each module got. A module
+ * without kernels for the preferred level falls back to the best one it
+ * has below it (down to scalar).
+ */
+std::vector<KernelBinding> bindKernels();
+
+} // namespace phantom
@@ -0,0 +1,54 @@
+#include "language_tracker.h"
+
+namespace phantom {
+
+void LanguageTracker::reset() {
+    m_votes.clear();
+    m_totalVotes = 0.0f;
+    m_probedSamples = 0;
+    m_language = -1;
+    m_settled = false;
+    m_poorDecodes = 0;
+}
+
+float LanguageTracker::probability() const {
+    if (m_language < 0 || m_totalVotes <= 0.0f) return 0.0f;
+    return m_votes[static_cast<size_t>(m_language)] / m_totalVotes;
+}
+
+bool LanguageTracker::addDetection(const float* probs, size_t numLanguages, size_t numSamples) {
+    if (m_settled || numLanguages == 0 || numSamples == 0) return false;
+    if (m_votes.size() < numLanguages) m_votes.resize(numLanguages, 0.0f);
+
+    const float weight = static_cast<float>(numSamples);
+    for (size_t i = 0; i < numLanguages; ++i) {
+        m_votes[i] += probs[i] * weight;
+        m_totalVotes += probs[i] * weight;
+    }
+    m_probedSamples += numSamples;
+
+    size_t best = 0;
+    for (size_t i = 1; i < m_votes.size(); ++i) {
+        if (m_votes[i] > m_votes[best]) best = i;
+    }
+    m_language = static_cast<int>(best);
+
+    if (m_probedSamples >= LANGUAGE_PROBE_SAMPLES || probability() >= CERTAIN_PROBABILITY) {
+        m_settled = true;
+        m_poorDecodes = 0;
+    }
+    return m_settled;
+}
+
+bool LanguageTracker::recordDecode(float avgLogprob, size_t tokens) {
+    if (!m_settled || tokens == 0) return false;  // Silence says nothing about the language
+    if (avgLogprob >= POOR_LOGPROB) {
+        m_poorDecodes = 0;
+        return false;
+    }
+    if (++m_poorDecodes < POOR_DECODES_TO_RECHECK) return false;
+    reset();
+    return true;
+}
+
+} // namespace phantom
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace phantom {
+
+/**
+ * The session's language when transcribing with language "auto".
+ *
+ * Language identification costs an extra encoder pass, so it runs only on
+ * the first chunks of speech: their votes (each language's probability,
+ * weighted by the chunk's length) are summed until LANGUAGE_PROBE_SAMPLES
+ * of speech have been heard, or one language is already certain, and the
+ * winner is kept from then on. It is looked for again only when decodes in
+ * that language keep coming out unlikely, as they do once the speaker
+ * switches language, or when reset() is called on request.
+ */
+class LanguageTracker {
+public:
+    static constexpr size_t LANGUAGE_PROBE_SAMPLES = 3 * 16000;
+    static constexpr float CERTAIN_PROBABILITY = 0.9f;
+    static constexpr float POOR_LOGPROB = -1.0f;        // As DecodePolicy::LOGPROB_THRESHOLD
+    static constexpr size_t POOR_DECODES_TO_RECHECK = 3;
+
+    // Forget the language and probe again from the next chunk of speech
+    void reset();
+
+    bool settled() const { return m_settled; }
+
+    // Leading language id so far, or -1 before any detection
+    int language() const { return m_language; }
+
+    // Its share of the votes
+    float probability() const;
+
+    /**
+     * Add one detection: `probs` holds a probability per language id, from
+     * `numSamples` of speech. Returns true when this settles the language.
+     */
+    bool addDetection(const float* probs, size_t numLanguages, size_t numSamples);
+
+    /**
+     * Feed back a chunk decoded in the settled language (its mean token
+     * log-probability). Returns true when this unsettles the language.
+     */
+    bool recordDecode(float avgLogprob, size_t tokens);
+
+private:
+    std::vector<float> m_votes;
+    float m_totalVotes = 0.0f;
+    size_t m_probedSamples = 0;
+    int m_language = -1;
+    bool m_settled = false;
+    size_t m_poorDecodes = 0;
+};
+
+} // namespace phantom
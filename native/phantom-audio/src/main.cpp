@@ -7,38 +7,138 @@
  * 
  * Usage:
  *   phantom-audio.exe --model <path-to-whisper-model>
+ *   phantom-audio.exe --model <path> --transcribe a.wav [b.wav ...] [--output out.jsonl]
+ *                     [--workers N] [--threads N] [--beam-size N] [--language CODE] [--vad MODE]
+ *                     [--from SECONDS] [--to SECONDS]
+ *     Offline batch mode: transcribe recordings (WAV, or session recordings
+ *     made with PHANTOM_AUDIO_RECORD) as fast as the CPU allows and write
+ *     ordered JSONL (see batch_transcriber.h), then exit.
+ *   phantom-audio.exe --model <path> [--quantize off|auto|q5_1|q8_0] ...
+ *     Load a quantized copy of an f16/f32 model, converted on first use and
+ *     cached next to it (see model_cache.h).
+ *   phantom-audio.exe --model <path> --prepare-model [--quantize MODE]
+ *     Do that conversion now, print the path to load and exit.
+ *
+ * Environment:
+ *   DISABLE_WHISPER=1              - Capture-only mode (cloud transcription)
+ *   STREAM_AUDIO=1                 - Forward 16kHz audio over stdout
+ *   PHANTOM_AUDIO_TRANSPORT=shm    - Forward audio through a shared-memory ring instead
+ *   PHANTOM_AUDIO_SAMPLE_FORMAT=s16 - Keep audio as int16 in buffers and the ring
+ *   PHANTOM_AUDIO_DITHER=1         - TPDF dither when converting capture audio to int16
+ *   PHANTOM_AUDIO_TRACE=<path>     - Record a Chrome trace from startup, written on exit
+ *   PHANTOM_AUDIO_SKIP_SILENCE=0   - Process digitally silent packets like any other audio
+ *   PHANTOM_AUDIO_QUANTIZE=auto    - Default for --quantize
+ *   PHANTOM_AUDIO_RECORD=<path>    - Record the session to a crash-safe file ("1" = temp dir)
+ *   PHANTOM_AUDIO_RECORD_MINUTES=N - Room in that file (default 120)
+ *   PHANTOM_AUDIO_ENGINE=mock[:..] - Scripted transcripts instead of whisper, no model
+ *                                    needed (see MockEngine::configure)
  * 
  * Commands (stdin JSON):
+ *   {"cmd":"hello","protocol":2} - Negotiate binary framing (see json_protocol.h)
+ *   {"cmd":"hello",...,"audio_format":"s16"} - Forward int16 PCM
+ *   {"cmd":"hello",...,"audio_format":"flac","segment_ms":N} - Forward FLAC segments
  *   {"cmd":"start"}  - Start audio capture and transcription
  *   {"cmd":"stop"}   - Stop capture
  *   {"cmd":"exit"}   - Clean shutdown
+ *   {"cmd":"config","chunk_ms":1500,"threads":6,"vad":"aggressive","context_tokens":64} - Retune transcription live
+ *   {"cmd":"metrics","interval_ms":5000} - Report pipeline metrics (now, and periodically)
+ *   {"cmd":"trace","enabled":true,"path":"..."} - Start/stop (and write) a Chrome trace
  * 
- * Events (stdout JSON):
- *   {"type":"ready"}
+ * Events (stdout JSON, or event frames once protocol v2 is negotiated):
+ *   {"type":"ready","simd":"avx2","kernels":{...}}
+ *   {"type":"hello","protocol":2,"framing":"binary"}
  *   {"type":"started"}
  *   {"type":"stopped"}
- *   {"type":"partial","text":"..."}
- *   {"type":"final","text":"..."}
+ *   {"type":"shm","name":"...","path":"...","capacity":N}
+ *   {"type":"flac","data":"<base64>","flags":N}  (FrameType::Flac when binary)
+ *   {"type":"silence","start_ms":N,"duration_ms":N,"samples":N}  (audio that was not sent)
+ *   {"type":"partial","segment":N,"keep":K,"text":"..."}  (keep K chars of the last partial, append text)
+ *   {"type":"final","segment":N,"text":"..."}
+ *   {"type":"config","chunk_ms":N,...}
+ *   {"type":"metrics","stages":{...},"counters":{...},"gauges":{...}}
+ *   {"type":"trace","enabled":false,"path":"...","events":N,"dropped":N}
  *   {"type":"error","message":"..."}
  */
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <atomic>
 #include <thread>
 #include <csignal>
 #include <cstdlib>
+#include <vector>
+#include <filesystem>
+#include <memory>
 
 #include "audio_capture.h"
+#include "capture_converter.h"
 #include "whisper_wrapper.h"
+#include "whisper_engine.h"
+#include "mock_engine.h"
+#include "batch_transcriber.h"
 #include "json_protocol.h"
+#include "kernel_dispatch.h"
+#include "model_cache.h"
+#include "model_quantizer.h"
+#include "process_stats.h"
+#include "shared_audio_ring.h"
+#include "session_recorder.h"
+#include "audio_forwarder.h"
+#include "sample_format.h"
+#include "stage_graph.h"
+#include "pipeline_metrics.h"
+#include "trace_recorder.h"
 
 namespace {
     std::atomic<bool> g_shouldExit{false};
     phantom::AudioCapture* g_audioCapture = nullptr;
     phantom::WhisperWrapper* g_whisper = nullptr;
+    phantom::SharedAudioRing* g_audioRing = nullptr;
+    phantom::SessionRecorder* g_sessionRecorder = nullptr;
     bool g_disableWhisper = false;
     bool g_streamAudio = false;
+
+    // Internal sample representation after resampling
+    phantom::SampleFormat g_sampleFormat = phantom::SampleFormat::F32;
+    bool g_dither = false;
+    phantom::DitherState g_ditherState;
+
+    // capture -> convert -> {forward, record, transcribe}; see buildPipeline()
+    phantom::StageGraph g_pipeline;
+    phantom::AudioForwarder g_forwarder;
+    int g_convertStage = -1;
+    std::unique_ptr<phantom::CaptureConverter> g_captureConverter;   // Convert stage
+    uint64_t g_droppedRunFrames = 0;        // Capture thread, then stdin thread at stop
+
+    // Stage workers: forwarding, recording and buffering for whisper
+    // rarely overlap enough to need more
+    constexpr int PIPELINE_WORKERS = 2;
+
+    // ~2.5s of capture packets waiting to be converted before they are dropped
+    constexpr size_t CAPTURE_QUEUE_PACKETS = 256;
+
+    // Capture thread timing
+    uint64_t g_lastCaptureUs = 0;
+
+    // Digitally silent packets skip conversion, forwarding and buffering;
+    // a run of them is reported as one silence event (forward stage)
+    bool g_skipSilence = true;
+
+    // Periodic metrics events (0 = off); written by the stdin thread,
+    // emitted from the main loop
+    std::atomic<int> g_metricsIntervalMs{0};
+
+    // Where a trace goes when the trace command names no path
+    std::string g_defaultTracePath;
+
+    // ~16s of 16kHz audio, so slow readers can catch up
+    constexpr uint32_t SHARED_RING_CAPACITY = 1u << 18;
+
+    constexpr int DEFAULT_RECORD_MINUTES = 120;
+
+    // How often the main loop asks for the recording to be written back
+    constexpr uint64_t RECORD_FLUSH_US = 5000000;
 }
 
 void signalHandler(int signal) {
@@ -56,7 +156,316 @@ std::string parseModelPath(int argc, char* argv[]) {
     return "";
 }
 
+// --quantize, else PHANTOM_AUDIO_QUANTIZE, else `fallback`
+bool parseQuantizeArg(int argc, char* argv[], phantom::QuantizeMode fallback, phantom::QuantizeMode* mode) {
+    const char* value = std::getenv("PHANTOM_AUDIO_QUANTIZE");
+    for (int i = 1; i < argc - 1; ++i) {
+        if (std::string(argv[i]) == "--quantize") value = argv[i + 1];
+    }
+    *mode = fallback;
+    return !value || phantom::parseQuantizeMode(value, mode);
+}
+
+// The file to load for `modelPath`: its cached quantized copy when asked for
+std::string resolveModel(const std::string& modelPath, phantom::QuantizeMode mode) {
+    if (mode == phantom::QuantizeMode::Off) return modelPath;
+
+    phantom::ModelCache cache(phantom::quantizeModel);
+    const std::string resolved =
+        cache.resolve(modelPath, mode, phantom::preferredIsa(), phantom::availableMemoryBytes());
+    if (!cache.getLastError().empty()) {
+        std::cerr << "[Main] Model quantization failed, using the original: " << cache.getLastError() << std::endl;
+    } else if (resolved != modelPath) {
+        std::cerr << "[Main] Quantized model (" << (cache.wasCacheHit() ? "cached" : "converted")
+                  << "): " << resolved << std::endl;
+    }
+    return resolved;
+}
+
+bool parseIntArg(const char* text, int* out) {
+    char* end = nullptr;
+    const long value = std::strtol(text, &end, 10);
+    if (!end || *end != '\0' || end == text) return false;
+    *out = static_cast<int>(value);
+    return true;
+}
+
+bool hasArg(int argc, char* argv[], const char* name) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == name) return true;
+    }
+    return false;
+}
+
+// Options for --transcribe; the files are the arguments following it
+bool parseBatchOptions(int argc, char* argv[], phantom::BatchOptions* options) {
+    phantom::TranscriptionConfig& config = options->config;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--transcribe") {
+            while (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+                options->files.push_back(argv[++i]);
+            }
+            continue;
+        }
+        if (i + 1 >= argc) return false;
+        const char* value = argv[++i];
+        if (arg == "--model" || arg == "-m" || arg == "--quantize") {
+            // Read by parseModelPath and parseQuantizeArg
+        } else if (arg == "--output") {
+            options->outputPath = value;
+        } else if (arg == "--workers") {
+            if (!parseIntArg(value, &options->workers) || options->workers < 0) return false;
+        } else if (arg == "--threads") {
+            if (!parseIntArg(value, &config.threads) || config.threads < 0 || config.threads > phantom::MAX_THREADS) {
+                return false;
+            }
+        } else if (arg == "--beam-size") {
+            if (!parseIntArg(value, &config.beamSize) || config.beamSize < 1 ||
+                config.beamSize > phantom::MAX_BEAM_SIZE) {
+                return false;
+            }
+        } else if (arg == "--language") {
+            config.language = value;
+        } else if (arg == "--vad") {
+            if (!phantom::parseVadMode(value, &config.vad)) return false;
+        } else if (arg == "--from" || arg == "--to") {
+            char* end = nullptr;
+            const double seconds = std::strtod(value, &end);
+            if (!end || *end != '\0' || end == value || !(seconds >= 0.0)) return false;
+            (arg == "--from" ? options->fromSeconds : options->toSeconds) = seconds;
+        } else {
+            return false;
+        }
+    }
+    options->split.threshold = phantom::vadThreshold(config.vad);
+    if (options->toSeconds > 0.0 && options->toSeconds <= options->fromSeconds) return false;
+    return !options->files.empty();
+}
+
+// Offline batch mode: no capture, no protocol, results straight to JSONL
+int runBatchTranscription(int argc, char* argv[], const std::string& modelPath) {
+    phantom::BatchOptions options;
+    phantom::QuantizeMode quantize;
+    if (modelPath.empty() || !parseBatchOptions(argc, argv, &options) ||
+        !parseQuantizeArg(argc, argv, phantom::QuantizeMode::Off, &quantize)) {
+        std::cerr << "Usage: phantom-audio --model <path> --transcribe <file.wav>... [--output out.jsonl]\n"
+                     "                     [--workers N] [--threads N] [--beam-size N] [--language CODE]\n"
+                     "                     [--vad off|normal|aggressive] [--quantize off|auto|q5_1|q8_0]\n"
+                     "                     [--from SECONDS] [--to SECONDS]"
+                  << std::endl;
+        return 2;
+    }
+
+    // One model; every worker decodes on its own state
+    phantom::WhisperEngine model;
+    const std::string loadPath = resolveModel(modelPath, quantize);
+    bool loaded = model.loadSharedModel(loadPath);
+    if (!loaded && loadPath != modelPath) {
+        std::cerr << "[Main] " << model.getLastError() << "; retrying the original model" << std::endl;
+        loaded = model.loadSharedModel(modelPath);
+    }
+    if (!loaded) {
+        std::cerr << "[Main] " << model.getLastError() << std::endl;
+        return 1;
+    }
+    phantom::BatchTranscriber batch([&model]() -> std::unique_ptr<phantom::TranscriptionEngine> {
+        return model.createWorker();
+    });
+    if (!batch.run(options)) {
+        std::cerr << "[Main] " << batch.getLastError() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+void recordCapturePacket(phantom::PipelineMetrics& stats, size_t numSamples) {
+    const uint64_t now = phantom::metricsNowUs();
+    if (g_lastCaptureUs) {
+        stats.captureInterval.record(now - g_lastCaptureUs);
+    }
+    g_lastCaptureUs = now;
+    stats.capturePackets.fetch_add(1, std::memory_order_relaxed);
+    stats.capturedSamples.fetch_add(numSamples, std::memory_order_relaxed);
+}
+
+// A full pipeline drops capture packets. The audio lost is passed on as
+// silence ahead of the next packet that fits, so every stream keeps its
+// clock. Returns false while the pipeline is still full (capture thread).
+bool pushDroppedRun() {
+    if (g_droppedRunFrames == 0) return true;
+    phantom::StagePacket& gap = g_pipeline.acquire();
+    gap.kind = phantom::PacketKind::Silence;
+    gap.numSamples = static_cast<size_t>(g_droppedRunFrames);
+    if (!g_pipeline.push(g_convertStage, gap)) return false;
+    g_droppedRunFrames = 0;
+    return true;
+}
+
+void dropCapturePacket(size_t numFrames, size_t numSamples) {
+    g_droppedRunFrames += numFrames;
+    phantom::metrics().droppedSamples.fetch_add(numSamples, std::memory_order_relaxed);
+}
+
+// Capture callback for a digitally silent packet (capture thread)
+void onCapturedSilence(size_t numFrames) {
+    phantom::PipelineMetrics& stats = phantom::metrics();
+    const size_t numSamples = g_captureConverter->outputSamples(numFrames);
+    recordCapturePacket(stats, numSamples);
+    stats.silentSamples.fetch_add(numSamples, std::memory_order_relaxed);
+
+    if (!pushDroppedRun()) {
+        dropCapturePacket(numFrames, numSamples);
+        return;
+    }
+    phantom::StagePacket& packet = g_pipeline.acquire();
+    packet.kind = phantom::PacketKind::Silence;
+    packet.numSamples = numFrames;
+    if (!g_pipeline.push(g_convertStage, packet)) {
+        dropCapturePacket(numFrames, numSamples);
+    }
+}
+
+// Capture callback (capture thread): copy the device buffer into a pooled
+// packet. Conversion, resampling and everything else run on the workers.
+void onCapturedAudio(const uint8_t* data, size_t numFrames) {
+    phantom::PipelineMetrics& stats = phantom::metrics();
+    const size_t numSamples = g_captureConverter->outputSamples(numFrames);
+    recordCapturePacket(stats, numSamples);
+
+    phantom::StageTimer timer(stats.dispatch);
+    phantom::TraceSpan span("dispatch", "frames", static_cast<int64_t>(numFrames));
+    if (!pushDroppedRun()) {
+        dropCapturePacket(numFrames, numSamples);
+        return;
+    }
+    phantom::StagePacket& packet = g_pipeline.acquire();
+    packet.device.assign(data, data + numFrames * g_captureConverter->getFormat().bytesPerFrame());
+    packet.numSamples = numFrames;
+    if (!g_pipeline.push(g_convertStage, packet)) {
+        dropCapturePacket(numFrames, numSamples);
+    }
+}
+
+// Pipeline stages. Each runs on one worker at a time, so the state each
+// one touches is its own.
+
+// Device frames in, 16kHz mono out: silence is counted through the
+// resampler so its phase holds, and audio is converted, downmixed and
+// resampled into a pooled packet. In s16 mode it is also converted to
+// int16 once here and stays that way until whisper's feature extraction.
+void convertStage(const phantom::StagePacket& packet, phantom::StageOutput& out) {
+    phantom::StagePacket& converted = out.acquire();
+    if (packet.kind == phantom::PacketKind::Silence) {
+        converted.kind = phantom::PacketKind::Silence;
+        converted.numSamples = g_captureConverter->skip(packet.numSamples);
+        if (converted.numSamples > 0) {
+            out.emit(converted);
+        }
+        return;
+    }
+
+    phantom::TraceRecorder& trace = phantom::TraceRecorder::instance();
+    const uint64_t convertStart = phantom::metricsNowUs();
+    g_captureConverter->process(packet.device.data(), packet.numSamples, converted.f32);
+    const uint64_t resampleUs = phantom::metricsNowUs() - convertStart;
+    phantom::metrics().resample.record(resampleUs);
+    if (trace.isEnabled()) {
+        trace.record("resample", convertStart, resampleUs, "frames", static_cast<int64_t>(packet.numSamples));
+    }
+
+    converted.numSamples = converted.f32.size();
+    if (converted.numSamples == 0) {
+        return;
+    }
+    if (g_sampleFormat == phantom::SampleFormat::S16) {
+        converted.format = phantom::SampleFormat::S16;
+        converted.s16.resize(converted.numSamples);
+        if (g_dither) {
+            phantom::floatToS16Dithered(converted.f32.data(), converted.s16.data(), converted.numSamples,
+                                        g_ditherState);
+        } else {
+            phantom::floatToS16(converted.f32.data(), converted.s16.data(), converted.numSamples);
+        }
+    }
+    out.emit(converted);
+}
+
+// Forwarding transports, and silence events between the audio they forward
+void forwardStage(const phantom::StagePacket& packet, phantom::StageOutput&) {
+    if (packet.kind == phantom::PacketKind::Silence) {
+        g_forwarder.forwardSilence(packet.numSamples);
+    } else if (packet.format == phantom::SampleFormat::S16) {
+        g_forwarder.forward(packet.s16.data(), packet.numSamples);
+    } else {
+        g_forwarder.forward(packet.f32.data(), packet.numSamples);
+    }
+}
+
+void recordStage(const phantom::StagePacket& packet, phantom::StageOutput&) {
+    if (packet.kind == phantom::PacketKind::Silence) {
+        g_sessionRecorder->writeSilence(packet.numSamples);
+    } else if (packet.format == phantom::SampleFormat::S16) {
+        g_sessionRecorder->write(packet.s16.data(), packet.numSamples);
+    } else {
+        g_sessionRecorder->write(packet.f32.data(), packet.numSamples);
+    }
+}
+
+// Buffering (and denoising) for whisper; decoding runs on its own thread
+void transcribeStage(const phantom::StagePacket& packet, phantom::StageOutput&) {
+    if (packet.kind == phantom::PacketKind::Silence) {
+        g_whisper->addSilence(packet.numSamples);
+    } else if (packet.format == phantom::SampleFormat::S16) {
+        g_whisper->addAudioChunk(packet.s16.data(), packet.numSamples);
+    } else {
+        g_whisper->addAudioChunk(packet.f32.data(), packet.numSamples);
+    }
+}
+
+// capture -> convert -> {forward, record, transcribe}. The capture thread
+// never waits: convert drops when full. The branches hold convert back
+// instead, so they all see the same audio.
+void buildPipeline() {
+    g_convertStage = g_pipeline.addStage("convert", convertStage, CAPTURE_QUEUE_PACKETS, phantom::Overflow::Drop);
+    const int forward = g_pipeline.addStage("forward", forwardStage);
+    g_pipeline.connect(g_convertStage, forward);
+    if (g_sessionRecorder) {
+        g_pipeline.connect(g_convertStage, g_pipeline.addStage("record", recordStage));
+    }
+    if (g_whisper) {
+        g_pipeline.connect(g_convertStage, g_pipeline.addStage("transcribe", transcribeStage));
+    }
+    g_pipeline.start(PIPELINE_WORKERS);
+}
+
+void logPipelineStats() {
+    for (const phantom::StageStats& stage : g_pipeline.stats()) {
+        std::cerr << "[Pipeline] " << stage.name << ": " << stage.processed << " packets, max queue "
+                  << stage.maxDepth << ", dropped " << stage.dropped << std::endl;
+    }
+}
+
+std::string defaultTracePath() {
+    if (const char* path = std::getenv("PHANTOM_AUDIO_TRACE")) {
+        if (*path) return path;
+    }
+    std::error_code ec;
+    const std::filesystem::path dir = std::filesystem::temp_directory_path(ec);
+    return ec ? "phantom-audio-trace.json" : (dir / "phantom-audio-trace.json").string();
+}
+
+void stopTrace() {
+    phantom::TraceRecorder& trace = phantom::TraceRecorder::instance();
+    if (trace.stop()) {
+        phantom::sendTrace(false, trace.getPath(), trace.eventCount(), trace.droppedCount());
+    } else {
+        phantom::sendError(trace.getLastError());
+    }
+}
+
 void stdinLoop() {
+    phantom::TraceRecorder::instance().setThreadName("stdin");
     std::string line;
     
     while (!g_shouldExit.load() && std::getline(std::cin, line)) {
@@ -65,29 +474,47 @@ void stdinLoop() {
         phantom::Command cmd = phantom::parseCommand(line);
         
         switch (cmd.type) {
+            case phantom::CommandType::Hello: {
+                int version = phantom::negotiateProtocol(cmd);
+                std::cerr << "[Main] Negotiated protocol v" << version
+                          << " (batch " << cmd.batchMs << "ms, "
+                          << phantom::forwardFormatName(cmd.audioFormat) << ")" << std::endl;
+
+                if (cmd.audioFormat == phantom::ForwardFormat::Flac && !g_forwarder.isFlacEnabled()) {
+                    g_forwarder.enableFlac(static_cast<uint64_t>(cmd.segmentMs) * 16);
+                    std::cerr << "[Main] Forwarding FLAC (segment " << cmd.segmentMs << "ms)" << std::endl;
+                }
+                break;
+            }
+
             case phantom::CommandType::Start:
                 std::cerr << "[Main] Received start command" << std::endl;
                 if (g_audioCapture) {
                     // Start whisper first (if enabled)
                     if (g_whisper) {
-                        g_whisper->start([](const std::string& text, bool isFinal) {
+                        g_whisper->start([](const std::string& text, bool isFinal,
+                                            const phantom::TranscriptSource& source) {
                             if (isFinal) {
-                                phantom::sendFinal(text);
+                                phantom::sendFinal(source.segment, text);
                             } else {
-                                phantom::sendPartial(text);
+                                phantom::sendPartial(source.segment, text);
                             }
                         });
                     }
 
+                    if (g_sessionRecorder) {
+                        g_sessionRecorder->markStart();
+                    }
+
                     // Start audio capture
-                    bool started = g_audioCapture->start([](const float* samples, size_t numSamples) {
-                        if (g_streamAudio) {
-                            phantom::sendAudioChunk(samples, numSamples);
-                        }
-                        if (g_whisper) {
-                            g_whisper->addAudioChunk(samples, numSamples);
-                        }
-                    });
+                    phantom::resetAudioClock();
+                    g_lastCaptureUs = 0;
+                    g_forwarder.reset();
+                    g_captureConverter->reset();
+                    g_droppedRunFrames = 0;
+                    bool started = g_audioCapture->start(
+                        onCapturedAudio,
+                        g_skipSilence ? phantom::SilenceCallback(onCapturedSilence) : phantom::SilenceCallback());
 
                     if (started) {
                         phantom::sendStarted();
@@ -104,12 +531,89 @@ void stdinLoop() {
                 if (g_audioCapture) {
                     g_audioCapture->stop();
                 }
+                // Everything captured reaches whisper and the transports first,
+                // including audio dropped after the last packet that fit
+                g_pipeline.drain();
+                if (g_droppedRunFrames > 0 && pushDroppedRun()) {
+                    g_pipeline.drain();
+                }
                 if (g_whisper) {
                     g_whisper->stop();
                 }
+                g_forwarder.flushSilenceRun();
+                phantom::flushAudio();
+                g_forwarder.finishFlacSegment();
                 phantom::sendStopped();
                 break;
 
+            case phantom::CommandType::Config: {
+                if (cmd.error) {
+                    phantom::sendError(std::string("Invalid config: ") + cmd.error);
+                    break;
+                }
+                if (!g_whisper) {
+                    // Only the silence minimum matters without transcription:
+                    // it still decides when FLAC segments close
+                    if (cmd.silenceFlushMs >= 0) {
+                        g_forwarder.setSilenceFlushMs(cmd.silenceFlushMs);
+                    }
+                    phantom::sendError("Config ignored except silence_flush_ms: transcription is disabled");
+                    break;
+                }
+
+                // Takes effect from the next chunk; the model stays loaded
+                phantom::TranscriptionConfig config = g_whisper->getConfig();
+                cmd.applyTo(config);
+                if (g_whisper->setConfig(config)) {
+                    g_forwarder.setSilenceFlushMs(config.silenceFlushMs);
+                    // Naming "auto" again asks for a fresh look at the language
+                    if (std::string_view(cmd.language) == "auto") {
+                        g_whisper->redetectLanguage();
+                    }
+                    phantom::sendConfig(config);
+                } else {
+                    phantom::sendError(g_whisper->getLastError());
+                }
+                break;
+            }
+
+            case phantom::CommandType::Metrics:
+                if (cmd.error) {
+                    phantom::sendError(std::string("Invalid metrics request: ") + cmd.error);
+                    break;
+                }
+                phantom::sendMetrics();
+                if (cmd.metricsReset) {
+                    phantom::metrics().reset();
+                }
+                if (cmd.metricsIntervalMs >= 0) {
+                    g_metricsIntervalMs.store(cmd.metricsIntervalMs);
+                }
+                break;
+
+            case phantom::CommandType::Trace: {
+                if (cmd.error) {
+                    phantom::sendError(std::string("Invalid trace request: ") + cmd.error);
+                    break;
+                }
+                phantom::TraceRecorder& trace = phantom::TraceRecorder::instance();
+                if (!cmd.traceEnabled) {
+                    stopTrace();
+                    break;
+                }
+                // Starting again writes out the running session first
+                if (trace.isEnabled()) {
+                    stopTrace();
+                }
+                const std::string path = cmd.tracePath.empty() ? g_defaultTracePath : cmd.tracePath;
+                if (trace.start(path)) {
+                    phantom::sendTrace(true, path, 0, 0);
+                } else {
+                    phantom::sendError(trace.getLastError());
+                }
+                break;
+            }
+
             case phantom::CommandType::Exit:
                 std::cerr << "[Main] Received exit command" << std::endl;
                 g_shouldExit.store(true);
@@ -128,17 +632,74 @@ int main(int argc, char* argv[]) {
     std::signal(SIGTERM, signalHandler);
 
     std::cerr << "[Main] phantom-audio starting..." << std::endl;
+    phantom::TraceRecorder::instance().setThreadName("main");
+    g_defaultTracePath = defaultTracePath();
+    if (std::getenv("PHANTOM_AUDIO_TRACE") &&
+        !phantom::TraceRecorder::instance().start(g_defaultTracePath)) {
+        std::cerr << "[Main] " << phantom::TraceRecorder::instance().getLastError() << std::endl;
+    }
     g_disableWhisper = std::getenv("DISABLE_WHISPER") != nullptr;
     g_streamAudio = std::getenv("STREAM_AUDIO") != nullptr;
 
+    const char* sampleFormat = std::getenv("PHANTOM_AUDIO_SAMPLE_FORMAT");
+    if (sampleFormat && !phantom::parseSampleFormat(sampleFormat, &g_sampleFormat)) {
+        std::cerr << "[Main] Unknown sample format '" << sampleFormat << "', using f32" << std::endl;
+    }
+    const char* skipSilence = std::getenv("PHANTOM_AUDIO_SKIP_SILENCE");
+    g_skipSilence = !(skipSilence && std::string(skipSilence) == "0");
+    const char* dither = std::getenv("PHANTOM_AUDIO_DITHER");
+    g_dither = dither && std::string(dither) == "1";
+    std::cerr << "[Main] Sample format: " << phantom::sampleFormatName(g_sampleFormat)
+              << (g_dither ? " (dithered)" : "") << std::endl;
+
+    // Pick every SIMD kernel now, before audio starts flowing
+    const std::vector<phantom::KernelBinding> kernels = phantom::bindKernels();
+    std::cerr << "[Main] SIMD: " << phantom::simdIsaName(phantom::preferredIsa()) << " (";
+    for (size_t i = 0; i < kernels.size(); ++i) {
+        std::cerr << (i ? ", " : "") << kernels[i].module << " " << phantom::simdIsaName(kernels[i].isa);
+    }
+    std::cerr << ")" << std::endl;
+
     // Parse command line arguments
     std::string modelPath = parseModelPath(argc, argv);
-    if (!g_disableWhisper && modelPath.empty()) {
+    if (hasArg(argc, argv, "--transcribe")) {
+        // Nothing to shut down cleanly, so let Ctrl+C end the run
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+        const int status = runBatchTranscription(argc, argv, modelPath);
+        // stdout carries the transcript, so trace errors only go to the log
+        phantom::TraceRecorder& trace = phantom::TraceRecorder::instance();
+        if (trace.isEnabled() && !trace.stop()) {
+            std::cerr << "[Main] " << trace.getLastError() << std::endl;
+        }
+        return status;
+    }
+    if (hasArg(argc, argv, "--prepare-model")) {
+        // Conversion can outlast the client's ready timeout, so installers run it up front
+        phantom::QuantizeMode quantize;
+        if (modelPath.empty() || !parseQuantizeArg(argc, argv, phantom::QuantizeMode::Auto, &quantize)) {
+            std::cerr << "Usage: phantom-audio --model <path> --prepare-model [--quantize off|auto|q5_1|q8_0]"
+                      << std::endl;
+            return 2;
+        }
+        std::cout << resolveModel(modelPath, quantize) << std::endl;
+        return 0;
+    }
+    const char* engineSpec = std::getenv("PHANTOM_AUDIO_ENGINE");
+    const bool mockEngine = engineSpec && std::string_view(engineSpec).substr(0, 4) == "mock";
+    if (!g_disableWhisper && !mockEngine && modelPath.empty()) {
         phantom::sendError("No model path specified. Use --model <path>");
         return 1;
     }
+    phantom::QuantizeMode quantize;
+    if (!parseQuantizeArg(argc, argv, phantom::QuantizeMode::Off, &quantize)) {
+        phantom::sendError("Invalid --quantize mode. Use off, auto, q5_1 or q8_0");
+        return 1;
+    }
 
-    if (!g_disableWhisper) {
+    if (!g_disableWhisper && mockEngine) {
+        std::cerr << "[Main] Mock engine: " << engineSpec << std::endl;
+    } else if (!g_disableWhisper) {
         std::cerr << "[Main] Model path: " << modelPath << std::endl;
     } else {
         std::cerr << "[Main] Whisper disabled; capture-only mode" << std::endl;
@@ -151,27 +712,103 @@ int main(int argc, char* argv[]) {
         delete g_audioCapture;
         return 1;
     }
+    g_captureConverter = std::make_unique<phantom::CaptureConverter>(g_audioCapture->getDeviceFormat());
 
     // Initialize Whisper (unless disabled for cloud forwarding)
-    if (!g_disableWhisper) {
+    if (!g_disableWhisper && mockEngine) {
+        auto engine = std::make_unique<phantom::MockEngine>();
+        if (!engine->configure(engineSpec)) {
+            phantom::sendError(engine->getLastError());
+            delete g_audioCapture;
+            return 1;
+        }
         g_whisper = new phantom::WhisperWrapper();
-        if (!g_whisper->loadModel(modelPath)) {
-            phantom::sendError("Failed to load Whisper model: " + g_whisper->getLastError());
+        g_whisper->setSampleFormat(g_sampleFormat);
+        g_whisper->setEngine(std::move(engine));
+    } else if (!g_disableWhisper) {
+        auto engine = std::make_unique<phantom::WhisperEngine>();
+        const std::string loadPath = resolveModel(modelPath, quantize);
+        bool loaded = engine->loadModel(loadPath);
+        if (!loaded && loadPath != modelPath) {
+            std::cerr << "[Main] " << engine->getLastError() << "; retrying the original model" << std::endl;
+            loaded = engine->loadModel(modelPath);
+        }
+        if (!loaded) {
+            phantom::sendError("Failed to load Whisper model: " + engine->getLastError());
             delete g_audioCapture;
-            delete g_whisper;
             return 1;
         }
+        g_whisper = new phantom::WhisperWrapper();
+        g_whisper->setSampleFormat(g_sampleFormat);
+        g_whisper->setEngine(std::move(engine));
+    }
+
+    // Optional shared-memory transport for the 16kHz stream
+    const char* transport = std::getenv("PHANTOM_AUDIO_TRANSPORT");
+    if (transport && std::string(transport) == "shm") {
+        g_audioRing = new phantom::SharedAudioRing();
+        if (!g_audioRing->create(phantom::SharedAudioRing::defaultName(), SHARED_RING_CAPACITY, 16000,
+                                 g_sampleFormat)) {
+            std::cerr << "[Main] Shared ring unavailable, using stdout: "
+                      << g_audioRing->getLastError() << std::endl;
+            delete g_audioRing;
+            g_audioRing = nullptr;
+        }
+    }
+    g_forwarder.setRing(g_audioRing);
+    g_forwarder.setStreamAudio(g_streamAudio);
+
+    // Optional crash-safe recording of the session, for re-transcription
+    const char* record = std::getenv("PHANTOM_AUDIO_RECORD");
+    if (record && *record && std::string(record) != "0") {
+        int minutes = DEFAULT_RECORD_MINUTES;
+        const char* recordMinutes = std::getenv("PHANTOM_AUDIO_RECORD_MINUTES");
+        if (recordMinutes && (!parseIntArg(recordMinutes, &minutes) || minutes <= 0)) {
+            std::cerr << "[Main] Invalid PHANTOM_AUDIO_RECORD_MINUTES, using " << DEFAULT_RECORD_MINUTES << std::endl;
+            minutes = DEFAULT_RECORD_MINUTES;
+        }
+        const std::string path = std::string(record) == "1" ? phantom::SessionRecorder::defaultPath() : record;
+        g_sessionRecorder = new phantom::SessionRecorder();
+        if (!g_sessionRecorder->create(path, static_cast<uint64_t>(minutes) * 60 * 16000)) {
+            std::cerr << "[Main] Session recording unavailable: " << g_sessionRecorder->getLastError() << std::endl;
+            delete g_sessionRecorder;
+            g_sessionRecorder = nullptr;
+        }
     }
 
+    buildPipeline();
+
     // Signal that we're ready
-    phantom::sendReady();
+    phantom::sendReady(kernels);
+    if (g_audioRing) {
+        phantom::sendSharedRing(g_audioRing->getName(), g_audioRing->getPath(),
+                                g_audioRing->getCapacity(), 16000, g_audioRing->getFormat(),
+                                sizeof(phantom::SharedAudioRingHeader));
+    }
 
     // Run the stdin command loop
     std::thread stdinThread(stdinLoop);
 
-    // Wait for exit signal
+    // Wait for exit signal, emitting periodic metrics if requested
+    uint64_t lastMetricsUs = phantom::metricsNowUs();
+    uint64_t lastFlushUs = lastMetricsUs;
     while (!g_shouldExit.load()) {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        // Bounds what a power cut can take; a crash of this process loses nothing
+        if (g_sessionRecorder && phantom::metricsNowUs() - lastFlushUs >= RECORD_FLUSH_US) {
+            g_sessionRecorder->flush();
+            lastFlushUs = phantom::metricsNowUs();
+        }
+
+        const int intervalMs = g_metricsIntervalMs.load();
+        const uint64_t now = phantom::metricsNowUs();
+        if (intervalMs <= 0) {
+            lastMetricsUs = now;
+        } else if (now - lastMetricsUs >= static_cast<uint64_t>(intervalMs) * 1000) {
+            phantom::sendMetrics();
+            lastMetricsUs = now;
+        }
     }
 
     std::cerr << "[Main] Shutting down..." << std::endl;
@@ -180,6 +817,8 @@ int main(int argc, char* argv[]) {
     if (g_audioCapture && g_audioCapture->isCapturing()) {
         g_audioCapture->stop();
     }
+    g_pipeline.stop();
+    logPipelineStats();
     if (g_whisper) {
         g_whisper->stop();
     }
@@ -191,6 +830,18 @@ int main(int argc, char* argv[]) {
     delete g_audioCapture;
     g_audioCapture = nullptr;
 
+    delete g_audioRing;
+    g_audioRing = nullptr;
+
+    delete g_sessionRecorder;
+    g_sessionRecorder = nullptr;
+
+
+    // Write out a trace that is still recording
+    if (phantom::TraceRecorder::instance().isEnabled()) {
+        stopTrace();
+    }
+
     // Wait for stdin thread
     if (stdinThread.joinable()) {
         stdinThread.detach();  // Don't wait for stdin, just exit
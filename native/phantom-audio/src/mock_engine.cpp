@@ -0,0 +1,133 @@
+#include "mock_engine.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+
+namespace phantom {
+
+namespace {
+
+constexpr uint64_t SAMPLE_RATE = 16000;
+
+// Whisper's first language ids, enough to exercise detection
+const char* const LANGUAGES[] = {"en", "zh", "de", "es", "ru", "ko", "fr", "ja", "pt", "tr"};
+constexpr int NUM_LANGUAGES = static_cast<int>(sizeof(LANGUAGES) / sizeof(LANGUAGES[0]));
+
+// Ids stay below whisper's end-of-text token, like real text tokens
+constexpr uint32_t TEXT_VOCAB = 50000;
+
+bool parseNumber(const std::string& text, double* out) {
+    char* end = nullptr;
+    const double value = std::strtod(text.c_str(), &end);
+    if (text.empty() || !end || *end != '\0' || !(value >= 0.0)) return false;
+    *out = value;
+    return true;
+}
+
+} // namespace
+
+MockEngine::MockEngine(MockEngineScript script) : m_script(std::move(script)) {}
+
+bool MockEngine::configure(const std::string& spec) {
+    MockEngineScript script;
+    if (spec != "mock") {
+        if (spec.compare(0, 5, "mock:") != 0) {
+            m_lastError = "Unknown engine: " + spec;
+            return false;
+        }
+        std::stringstream fields(spec.substr(5));
+        std::string field;
+        while (std::getline(fields, field, ',')) {
+            const size_t eq = field.find('=');
+            const std::string key = field.substr(0, eq);
+            const std::string value = eq == std::string::npos ? std::string() : field.substr(eq + 1);
+            double number = 0.0;
+            if (key == "latency_ms" && parseNumber(value, &number)) {
+                script.latencyMs = static_cast<uint32_t>(number);
+            } else if (key == "rtf" && parseNumber(value, &number)) {
+                script.realTimeFactor = number;
+            } else if (key == "text" && !value.empty()) {
+                script.texts.push_back(value);
+            } else {
+                m_lastError = "Invalid mock engine field: " + field;
+                return false;
+            }
+        }
+    }
+    m_script = std::move(script);
+    return true;
+}
+
+int32_t MockEngine::tokenId(const std::string& word) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (const char c : word) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return static_cast<int32_t>(hash % TEXT_VOCAB);
+}
+
+int MockEngine::languageId(const std::string& code) const {
+    for (int i = 0; i < NUM_LANGUAGES; ++i) {
+        if (code == LANGUAGES[i]) return i;
+    }
+    return -1;
+}
+
+const char* MockEngine::languageCode(int id) const {
+    return id >= 0 && id < NUM_LANGUAGES ? LANGUAGES[id] : nullptr;
+}
+
+int MockEngine::maxLanguageId() const {
+    return NUM_LANGUAGES - 1;
+}
+
+bool MockEngine::detectLanguage(const float*, size_t, int, std::vector<float>& probs) {
+    const int id = languageId(m_script.language);
+    if (id < 0) return false;
+    probs.assign(NUM_LANGUAGES, 0.0f);
+    probs[static_cast<size_t>(id)] = 1.0f;
+    return true;
+}
+
+bool MockEngine::decode(const DecodeRequest& request, DecodeResult& result) {
+    const uint64_t index = m_decodes.fetch_add(1);
+
+    const uint64_t audioUs = static_cast<uint64_t>(request.numSamples) * 1000000 / SAMPLE_RATE;
+    uint64_t latencyUs = (m_script.latenciesMs.empty()
+                              ? m_script.latencyMs
+                              : m_script.latenciesMs[index % m_script.latenciesMs.size()]) * uint64_t{1000};
+    latencyUs += static_cast<uint64_t>(m_script.realTimeFactor * static_cast<double>(audioUs));
+    if (latencyUs > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(latencyUs));
+    }
+
+    const std::string text = m_script.texts.empty()
+        ? "chunk " + std::to_string(index + 1)
+        : m_script.texts[index % m_script.texts.size()];
+    std::vector<std::string> words;
+    std::istringstream in(text);
+    for (std::string word; in >> word;) {
+        if (request.maxTokens > 0 && words.size() >= static_cast<size_t>(request.maxTokens)) break;
+        words.push_back(word);
+    }
+
+    // One token per word, the chunk shared out evenly
+    const uint64_t count = words.size();
+    for (uint64_t i = 0; i < count; ++i) {
+        StreamToken token;
+        token.id = tokenId(words[i]);
+        token.startSample = request.firstSample + i * request.numSamples / count;
+        token.endSample = request.firstSample + (i + 1) * request.numSamples / count;
+        token.text = " " + words[i];
+        result.tokens.push_back(std::move(token));
+        result.logprobs.push_back(m_script.logprob);
+    }
+    result.generatedTokens = static_cast<int>(count);
+    return true;
+}
+
+} // namespace phantom
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "transcription_engine.h"
+
+namespace phantom {
+
+/**
+ * What MockEngine answers and how long it takes. Each decode takes
+ * latencyMs (or the next entry of latenciesMs, cycled) plus realTimeFactor
+ * times the chunk's duration, then returns the next entry of texts
+ * (cycled), or "chunk N" when there are none.
+ */
+struct MockEngineScript {
+    uint32_t latencyMs = 0;
+    std::vector<uint32_t> latenciesMs;
+    double realTimeFactor = 0.0;
+    std::vector<std::string> texts;
+    float logprob = -0.1f;              // Every token's
+    std::string language = "en";        // What language detection finds
+};
+
+/**
+ * Deterministic stand-in for a model: scripted text after a scripted
+ * delay, with one token per word spread evenly over the chunk. Lets
+ * chunking, backpressure and the protocol be tested and benchmarked
+ * without a model file.
+ */
+class MockEngine : public TranscriptionEngine {
+public:
+    explicit MockEngine(MockEngineScript script = {});
+
+    /**
+     * Parse "mock[:key=value,...]" with keys latency_ms, rtf and text
+     * (text may be given more than once), e.g. "mock:latency_ms=300,rtf=0.1"
+     * @return false (see getLastError) if the spec is invalid
+     */
+    bool configure(const std::string& spec);
+
+    // Token id a word is given (stable across runs)
+    static int32_t tokenId(const std::string& word);
+
+    // Decodes run so far
+    uint64_t decodes() const { return m_decodes.load(); }
+
+    const char* name() const override { return "mock"; }
+    int languageId(const std::string& code) const override;
+    const char* languageCode(int id) const override;
+    int maxLanguageId() const override;
+    bool detectLanguage(const float* samples, size_t numSamples, int threads,
+                        std::vector<float>& probs) override;
+    bool decode(const DecodeRequest& request, DecodeResult& result) override;
+
+private:
+    MockEngineScript m_script;
+    std::atomic<uint64_t> m_decodes{0};
+};
+
+} // namespace phantom
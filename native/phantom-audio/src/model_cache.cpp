@@ -0,0 +1,242 @@
+#include "model_cache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+#include <vector>
+
+namespace phantom {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t GGML_FILE_MAGIC = 0x67676d6c;  // "ggml"
+constexpr int32_t GGML_QNT_VERSION_FACTOR = 1000;  // ftype = version * 1000 + type
+constexpr size_t WHISPER_HPARAMS = 11;             // n_vocab ... n_mels, ftype
+
+// Bump when the converter's output changes, so old conversions are redone
+constexpr uint64_t MODEL_CACHE_VERSION = 1;
+
+constexpr size_t KEY_PREFIX_BYTES = 1 << 20;
+constexpr uint64_t AUTO_Q8_MIN_RAM = 8ull << 30;
+
+struct Fnv1a {
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    void add(const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+    }
+
+    template <typename T>
+    void addValue(const T& value) { add(&value, sizeof(value)); }
+
+    uint32_t folded() const { return static_cast<uint32_t>(hash ^ (hash >> 32)); }
+};
+
+// The key in a cache file name made for this stem and quantization, if it is one
+bool parseCachedKey(const std::string& name, const std::string& prefix, uint64_t* key) {
+    constexpr size_t HEX_DIGITS = 16;
+    const std::string suffix = ".bin";
+    if (name.size() != prefix.size() + HEX_DIGITS + suffix.size() ||
+        name.compare(0, prefix.size(), prefix) != 0 ||
+        name.compare(prefix.size() + HEX_DIGITS, suffix.size(), suffix) != 0) {
+        return false;
+    }
+    uint64_t value = 0;
+    for (size_t i = prefix.size(); i < prefix.size() + HEX_DIGITS; ++i) {
+        const char c = name[i];
+        const int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+        if (digit < 0) return false;
+        value = (value << 4) | static_cast<uint64_t>(digit);
+    }
+    *key = value;
+    return true;
+}
+
+} // namespace
+
+const char* quantizeModeName(QuantizeMode mode) {
+    switch (mode) {
+        case QuantizeMode::Off: return "off";
+        case QuantizeMode::Auto: return "auto";
+        case QuantizeMode::Q5_1: return "q5_1";
+        case QuantizeMode::Q8_0: return "q8_0";
+    }
+    return "off";
+}
+
+bool parseQuantizeMode(const std::string& name, QuantizeMode* mode) {
+    const QuantizeMode all[] = {QuantizeMode::Off, QuantizeMode::Auto, QuantizeMode::Q5_1, QuantizeMode::Q8_0};
+    for (QuantizeMode candidate : all) {
+        if (name == quantizeModeName(candidate)) {
+            *mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* modelQuantName(ModelQuant quant) {
+    switch (quant) {
+        case ModelQuant::None: return "none";
+        case ModelQuant::Q5_1: return "q5_1";
+        case ModelQuant::Q8_0: return "q8_0";
+    }
+    return "none";
+}
+
+ModelQuant chooseModelQuant(SimdIsa isa, uint64_t availableRamBytes) {
+    const bool fastInt8 = isa == SimdIsa::AVX2 || isa == SimdIsa::NEON;
+    return fastInt8 && availableRamBytes >= AUTO_Q8_MIN_RAM ? ModelQuant::Q8_0 : ModelQuant::Q5_1;
+}
+
+ModelFileInfo readModelFileInfo(const std::string& path) {
+    ModelFileInfo info;
+    std::error_code ec;
+    info.sizeBytes = fs::file_size(path, ec);
+    if (ec) return info;
+
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return info;
+    uint32_t magic = 0;
+    int32_t hparams[WHISPER_HPARAMS] = {};
+    const bool complete = std::fread(&magic, sizeof(magic), 1, file) == 1 &&
+                          std::fread(hparams, sizeof(hparams), 1, file) == 1;
+    std::fclose(file);
+
+    if (!complete || magic != GGML_FILE_MAGIC) return info;
+    info.valid = true;
+    info.ftype = hparams[WHISPER_HPARAMS - 1] % GGML_QNT_VERSION_FACTOR;
+    return info;
+}
+
+uint64_t modelCacheKey(const std::string& modelPath, ModelQuant quant) {
+    std::error_code ec;
+    const uint64_t size = fs::file_size(modelPath, ec);
+    if (ec) return 0;
+    const auto modified = fs::last_write_time(modelPath, ec).time_since_epoch().count();
+    if (ec) return 0;
+
+    std::FILE* file = std::fopen(modelPath.c_str(), "rb");
+    if (!file) return 0;
+    std::vector<unsigned char> prefix(KEY_PREFIX_BYTES);
+    prefix.resize(std::fread(prefix.data(), 1, prefix.size(), file));
+    std::fclose(file);
+
+    Fnv1a content;
+    content.addValue(MODEL_CACHE_VERSION);
+    content.addValue(static_cast<uint8_t>(quant));
+    content.addValue(size);
+    content.addValue(static_cast<int64_t>(modified));
+    content.add(prefix.data(), prefix.size());
+
+    Fnv1a source;
+    const std::string absolute = fs::absolute(modelPath, ec).lexically_normal().string();
+    source.add(absolute.data(), absolute.size());
+    const uint64_t key = (static_cast<uint64_t>(source.folded()) << 32) | content.folded();
+    return key ? key : 1;
+}
+
+std::string cachedModelName(const std::string& modelPath, ModelQuant quant, uint64_t key) {
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(key));
+    return fs::path(modelPath).stem().string() + "-" + modelQuantName(quant) + "-" + hex + ".bin";
+}
+
+ModelCache::ModelCache(ModelConverter convert)
+    : m_convert(std::move(convert)) {
+}
+
+std::string ModelCache::resolve(const std::string& modelPath, QuantizeMode mode, SimdIsa isa,
+                                uint64_t availableRamBytes) {
+    m_cacheHit = false;
+    m_lastError.clear();
+    if (mode == QuantizeMode::Off) return modelPath;
+
+    const ModelFileInfo info = readModelFileInfo(modelPath);
+    if (!info.valid) {
+        m_lastError = "Not a ggml model, loading as is: " + modelPath;
+        return modelPath;
+    }
+    if (!info.quantizable()) return modelPath;  // Already quantized
+
+    const ModelQuant quant = mode == QuantizeMode::Q5_1 ? ModelQuant::Q5_1
+                           : mode == QuantizeMode::Q8_0 ? ModelQuant::Q8_0
+                           : chooseModelQuant(isa, availableRamBytes);
+    const uint64_t key = modelCacheKey(modelPath, quant);
+    if (key == 0) {
+        m_lastError = "Cannot read model: " + modelPath;
+        return modelPath;
+    }
+
+    // Next to the model, or a temp-dir cache when that folder is read-only
+    std::error_code ec;
+    const std::string name = cachedModelName(modelPath, quant, key);
+    std::vector<fs::path> dirs = {fs::absolute(modelPath, ec).parent_path()};
+    const fs::path temp = fs::temp_directory_path(ec);
+    if (!ec) dirs.push_back(temp / "phantom-audio-models");
+
+    for (const fs::path& dir : dirs) {
+        const fs::path cached = dir / name;
+        if (readModelFileInfo(cached.string()).valid) {
+            m_cacheHit = true;
+            return cached.string();
+        }
+    }
+
+    std::string converted;
+    for (const fs::path& dir : dirs) {
+        if (convertInto(dir.string(), modelPath, quant, key, &converted)) return converted;
+    }
+    return modelPath;
+}
+
+bool ModelCache::convertInto(const std::string& dir, const std::string& modelPath, ModelQuant quant,
+                             uint64_t key, std::string* result) {
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+
+    const std::string name = cachedModelName(modelPath, quant, key);
+    const fs::path target = fs::path(dir) / name;
+    const fs::path partial = fs::path(target).concat(".partial");
+
+    std::cerr << "[ModelCache] Converting " << modelPath << " to " << modelQuantName(quant) << " in "
+              << dir << std::endl;
+    std::string error;
+    if (!m_convert(modelPath, partial.string(), quant, &error)) {
+        fs::remove(partial, ec);
+        m_lastError = "Quantizing to " + target.string() + " failed: " + error;
+        return false;
+    }
+    fs::rename(partial, target, ec);
+    if (ec) {
+        m_lastError = "Cannot store " + target.string() + ": " + ec.message();
+        fs::remove(partial, ec);
+        return false;
+    }
+
+    // Conversions of earlier versions of this file are dead weight now. Only
+    // names whose key has this file's path half are touched: a model with the
+    // same name from another folder shares the temp-dir cache
+    const std::string prefix = fs::path(modelPath).stem().string() + "-" + modelQuantName(quant) + "-";
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        const fs::path other = it->path();
+        uint64_t otherKey = 0;
+        if (parseCachedKey(other.filename().string(), prefix, &otherKey) && otherKey != key &&
+            otherKey >> 32 == key >> 32) {
+            std::error_code removeError;
+            fs::remove(other, removeError);
+        }
+    }
+
+    *result = target.string();
+    return true;
+}
+
+} // namespace phantom
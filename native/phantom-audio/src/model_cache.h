@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "cpu_features.h"
+
+namespace phantom {
+
+/**
+ * Optional quantization of the whisper model on first use. Most installs
+ * ship an f16 ggml model; a q5_1 or q8_0 copy is 2-3x smaller and faster
+ * on CPU. The converted file is written next to the original (or to a
+ * temp-dir cache when that folder is read-only), named by a key over the
+ * source file, and loaded from then on.
+ */
+enum class QuantizeMode : uint8_t {
+    Off,
+    Auto,   // Pick from the CPU and free memory
+    Q5_1,
+    Q8_0
+};
+
+enum class ModelQuant : uint8_t {
+    None,
+    Q5_1,
+    Q8_0
+};
+
+// "off", "auto", "q5_1", "q8_0"
+const char* quantizeModeName(QuantizeMode mode);
+bool parseQuantizeMode(const std::string& name, QuantizeMode* mode);
+
+const char* modelQuantName(ModelQuant quant);
+
+/**
+ * q8_0 where int8 dot products are fast (AVX2, NEON) and memory is not
+ * tight, q5_1 otherwise: it is smaller and leans less on bandwidth.
+ */
+ModelQuant chooseModelQuant(SimdIsa isa, uint64_t availableRamBytes);
+
+// What the ggml header says about a model file
+struct ModelFileInfo {
+    bool valid = false;         // ggml magic and a full header
+    int32_t ftype = 0;          // Weight type without the quantization version
+    uint64_t sizeBytes = 0;
+
+    // Only f32/f16 weights are converted; anything else is already quantized
+    bool quantizable() const { return valid && (ftype == 0 || ftype == 1); }
+};
+
+ModelFileInfo readModelFileInfo(const std::string& path);
+
+/**
+ * Cache key for a model converted to `quant`. The high 32 bits hash the
+ * file's absolute path, the low 32 bits its size, modification time and
+ * first megabyte plus the converter version, so any change to the source
+ * gives a new key and conversions of the same file share the high half.
+ * Returns 0 if the file is unreadable.
+ */
+uint64_t modelCacheKey(const std::string& modelPath, ModelQuant quant);
+
+// <stem>-<quant>-<16 hex digits>.bin, e.g. ggml-base.en-q5_1-0123456789abcdef.bin
+std::string cachedModelName(const std::string& modelPath, ModelQuant quant, uint64_t key);
+
+// Writes `dst` from `src` at `quant`; on failure sets `error`
+using ModelConverter =
+    std::function<bool(const std::string& src, const std::string& dst, ModelQuant quant, std::string* error)>;
+
+class ModelCache {
+public:
+    explicit ModelCache(ModelConverter convert);
+
+    /**
+     * Path to load for `modelPath`: the cached conversion (made now if
+     * missing) or, when quantization is off, not applicable or fails, the
+     * original. Failures are reported through getLastError() and never
+     * stop the original from loading.
+     */
+    std::string resolve(const std::string& modelPath, QuantizeMode mode, SimdIsa isa, uint64_t availableRamBytes);
+
+    // Whether the last resolve() found an existing conversion
+    bool wasCacheHit() const { return m_cacheHit; }
+
+    const std::string& getLastError() const { return m_lastError; }
+
+private:
+    bool convertInto(const std::string& dir, const std::string& modelPath, ModelQuant quant, uint64_t key,
+                     std::string* result);
+
+    ModelConverter m_convert;
+    bool m_cacheHit = false;
+    std::string m_lastError;
+};
+
+} // namespace phantom
@@ -0,0 +1,192 @@
+#include "model_quantizer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "ggml.h"
+
+namespace phantom {
+
+namespace {
+
+constexpr uint32_t GGML_FILE_MAGIC = 0x67676d6c;  // "ggml"
+constexpr int WHISPER_HPARAMS = 11;               // n_vocab ... n_mels, ftype
+constexpr int HPARAM_N_VOCAB = 0;
+constexpr int HPARAM_FTYPE = 10;
+constexpr int32_t MAX_TENSOR_DIMS = 4;
+
+// Full precision in whisper.cpp's own quantize tool too
+const char* const KEEP_TENSORS[] = {
+    "encoder.conv1.bias",
+    "encoder.conv2.bias",
+    "encoder.positional_embedding",
+    "decoder.positional_embedding",
+};
+
+class File {
+public:
+    File(const std::string& path, const char* mode) : m_file(std::fopen(path.c_str(), mode)) {}
+    ~File() { if (m_file) std::fclose(m_file); }
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+
+    bool isOpen() const { return m_file != nullptr; }
+
+    // Returns false at end of file as well as on errors
+    bool read(void* data, size_t size) { return size == 0 || std::fread(data, size, 1, m_file) == 1; }
+    bool write(const void* data, size_t size) { return size == 0 || std::fwrite(data, size, 1, m_file) == 1; }
+
+    template <typename T>
+    bool readValue(T* value) { return read(value, sizeof(T)); }
+    template <typename T>
+    bool writeValue(const T& value) { return write(&value, sizeof(T)); }
+
+    bool atEnd() {
+        const int c = std::fgetc(m_file);
+        if (c == EOF) return true;
+        std::ungetc(c, m_file);
+        return false;
+    }
+
+    bool close() {
+        const bool ok = std::fclose(m_file) == 0;
+        m_file = nullptr;
+        return ok;
+    }
+
+private:
+    std::FILE* m_file;
+};
+
+bool fail(std::string* error, const std::string& message) {
+    if (error) *error = message;
+    return false;
+}
+
+bool keepsType(const std::string& name) {
+    for (const char* keep : KEEP_TENSORS) {
+        if (name == keep) return true;
+    }
+    return false;
+}
+
+// Header, mel filters and vocabulary, with the new ftype
+bool copyPreamble(File& in, File& out, int32_t ftype, std::string* error) {
+    uint32_t magic = 0;
+    int32_t hparams[WHISPER_HPARAMS] = {};
+    if (!in.readValue(&magic) || magic != GGML_FILE_MAGIC || !in.read(hparams, sizeof(hparams))) {
+        return fail(error, "not a ggml whisper model");
+    }
+    hparams[HPARAM_FTYPE] = ftype;
+    if (!out.writeValue(magic) || !out.write(hparams, sizeof(hparams))) return fail(error, "write failed");
+
+    int32_t melCount = 0, fftSize = 0;
+    if (!in.readValue(&melCount) || !in.readValue(&fftSize) || melCount < 0 || fftSize < 0) {
+        return fail(error, "truncated mel filters");
+    }
+    std::vector<float> filters(static_cast<size_t>(melCount) * fftSize);
+    if (!in.read(filters.data(), filters.size() * sizeof(float))) return fail(error, "truncated mel filters");
+    if (!out.writeValue(melCount) || !out.writeValue(fftSize) ||
+        !out.write(filters.data(), filters.size() * sizeof(float))) {
+        return fail(error, "write failed");
+    }
+
+    int32_t vocabSize = 0;
+    if (!in.readValue(&vocabSize) || vocabSize < 0 || vocabSize > hparams[HPARAM_N_VOCAB]) {
+        return fail(error, "bad vocabulary");
+    }
+    if (!out.writeValue(vocabSize)) return fail(error, "write failed");
+    std::vector<char> word;
+    for (int32_t i = 0; i < vocabSize; ++i) {
+        uint32_t length = 0;
+        if (!in.readValue(&length) || length > (1u << 16)) return fail(error, "bad vocabulary");
+        word.resize(length);
+        if (!in.read(word.data(), length)) return fail(error, "truncated vocabulary");
+        if (!out.writeValue(length) || !out.write(word.data(), length)) return fail(error, "write failed");
+    }
+    return true;
+}
+
+bool copyTensors(File& in, File& out, ggml_type target, std::string* error) {
+    std::vector<uint8_t> data;
+    std::vector<float> weights;
+    std::vector<uint8_t> quantized;
+    std::string name;
+
+    while (!in.atEnd()) {
+        int32_t dims = 0, nameLength = 0, type = 0;
+        if (!in.readValue(&dims) || !in.readValue(&nameLength) || !in.readValue(&type) ||
+            dims < 1 || dims > MAX_TENSOR_DIMS || nameLength <= 0 || nameLength > 256) {
+            return fail(error, "bad tensor header");
+        }
+        int32_t ne[MAX_TENSOR_DIMS] = {1, 1, 1, 1};
+        int64_t elements = 1;
+        for (int32_t d = 0; d < dims; ++d) {
+            if (!in.readValue(&ne[d]) || ne[d] <= 0) return fail(error, "bad tensor shape");
+            elements *= ne[d];
+        }
+        name.resize(nameLength);
+        if (!in.read(&name[0], nameLength)) return fail(error, "truncated tensor name");
+        if (type != GGML_TYPE_F32 && type != GGML_TYPE_F16) {
+            return fail(error, name + " is already quantized");
+        }
+
+        const ggml_type source = static_cast<ggml_type>(type);
+        data.resize(static_cast<size_t>(elements) * ggml_type_size(source));
+        if (!in.read(data.data(), data.size())) return fail(error, "truncated tensor " + name);
+
+        const bool quantize = dims == 2 && !keepsType(name);
+        if (quantize && ne[0] % ggml_blck_size(target) != 0) {
+            return fail(error, name + " rows do not fit whole quantization blocks");
+        }
+
+        int32_t outType = type;
+        const void* outData = data.data();
+        size_t outSize = data.size();
+        if (quantize) {
+            weights.resize(static_cast<size_t>(elements));
+            if (source == GGML_TYPE_F16) {
+                ggml_fp16_to_fp32_row(reinterpret_cast<const ggml_fp16_t*>(data.data()), weights.data(), elements);
+            } else {
+                std::copy_n(reinterpret_cast<const float*>(data.data()), elements, weights.data());
+            }
+            quantized.resize(ggml_row_size(target, ne[0]) * ne[1]);
+            outSize = ggml_quantize_chunk(target, weights.data(), quantized.data(), 0, ne[1], ne[0], nullptr);
+            outType = target;
+            outData = quantized.data();
+        }
+
+        if (!out.writeValue(dims) || !out.writeValue(nameLength) || !out.writeValue(outType) ||
+            !out.write(ne, sizeof(int32_t) * dims) || !out.write(name.data(), nameLength) ||
+            !out.write(outData, outSize)) {
+            return fail(error, "write failed");
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool quantizeModel(const std::string& src, const std::string& dst, ModelQuant quant, std::string* error) {
+    ggml_type target;
+    ggml_ftype ftype;
+    switch (quant) {
+        case ModelQuant::Q5_1: target = GGML_TYPE_Q5_1; ftype = GGML_FTYPE_MOSTLY_Q5_1; break;
+        case ModelQuant::Q8_0: target = GGML_TYPE_Q8_0; ftype = GGML_FTYPE_MOSTLY_Q8_0; break;
+        default: return fail(error, "no quantization type");
+    }
+
+    File in(src, "rb");
+    if (!in.isOpen()) return fail(error, "cannot open " + src);
+    File out(dst, "wb");
+    if (!out.isOpen()) return fail(error, "cannot create " + dst);
+
+    const int32_t fileType = GGML_QNT_VERSION * GGML_QNT_VERSION_FACTOR + ftype;
+    if (!copyPreamble(in, out, fileType, error) || !copyTensors(in, out, target, error)) return false;
+    if (!out.close()) return fail(error, "write failed");
+    return true;
+}
+
+} // namespace phantom
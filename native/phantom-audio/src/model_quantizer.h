@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+#include "model_cache.h"
+
+namespace phantom {
+
+/**
+ * Rewrite an f32/f16 ggml whisper model at `quant`, the same way
+ * whisper.cpp's quantize tool does: 2D weight matrices are quantized,
+ * biases, norms, convolutions and positional embeddings keep their type.
+ * Usable as the ModelCache converter. Needs ggml, so whisper builds only.
+ */
+bool quantizeModel(const std::string& src, const std::string& dst, ModelQuant quant, std::string* error);
+
+} // namespace phantom
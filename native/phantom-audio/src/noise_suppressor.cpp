@@ -0,0 +1,494 @@
+#include "noise_suppressor.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(PHANTOM_ARCH_X86)
+#include <immintrin.h>
+#elif defined(PHANTOM_ARCH_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace phantom {
+
+namespace {
+
+using ButterflyKernel = void (*)(float* re, float* im, size_t n, const float* twRe,
+                                 const float* twIm);
+
+const double PI = 3.14159265358979323846;
+
+// Power smoothing per frame (~40ms time constant at a 16ms hop)
+const float POWER_SMOOTHING = 0.6f;
+// Minimum statistics: the floor is the minimum over SUB_WINDOWS windows of SUB_FRAMES frames (~1s)
+const size_t SUB_FRAMES = 16;
+const size_t SUB_WINDOWS = 4;
+// The minimum of a noisy level sits below its mean; scale it back up
+const float NOISE_BIAS = 2.0f;
+// Subtract the floor this many times over, so noise that pokes above it is still gated
+const float OVERSUBTRACTION = 2.0f;
+// Strongest attenuation (-20dB)
+const float GAIN_FLOOR = 0.1f;
+// Gains rise at once (onsets) but fall over a few frames (no musical noise)
+const float GAIN_RELEASE = 0.6f;
+const float POWER_EPSILON = 1e-12f;
+
+// ============================================================================
+// Scalar kernel
+// ============================================================================
+
+// One radix-2 stage: butterflies of span h, twiddles at tw[h + t]
+void stageScalar(float* re, float* im, size_t n, size_t h, const float* twRe, const float* twIm) {
+    for (size_t j = 0; j < n; j += 2 * h) {
+        for (size_t t = 0; t < h; ++t) {
+            const size_t a = j + t;
+            const size_t b = a + h;
+            const float wr = twRe[h + t];
+            const float wi = twIm[h + t];
+            const float pr = re[b] * wr - im[b] * wi;
+            const float pi = re[b] * wi + im[b] * wr;
+            re[b] = re[a] - pr;
+            im[b] = im[a] - pi;
+            re[a] += pr;
+            im[a] += pi;
+        }
+    }
+}
+
+void butterfliesScalar(float* re, float* im, size_t n, const float* twRe, const float* twIm) {
+    for (size_t h = 1; h < n; h *= 2) {
+        stageScalar(re, im, n, h, twRe, twIm);
+    }
+}
+
+#if defined(PHANTOM_ARCH_X86)
+
+// ============================================================================
+// SSE2 kernel
+// ============================================================================
+
+// Stages of span 4 and up, four butterflies at a time
+PHANTOM_TARGET("sse2")
+void stageSse2(float* re, float* im, size_t n, size_t h, const float* twRe, const float* twIm) {
+    for (size_t j = 0; j < n; j += 2 * h) {
+        for (size_t t = 0; t < h; t += 4) {
+            const size_t a = j + t;
+            const size_t b = a + h;
+            const __m128 wr = _mm_loadu_ps(twRe + h + t);
+            const __m128 wi = _mm_loadu_ps(twIm + h + t);
+            const __m128 br = _mm_loadu_ps(re + b);
+            const __m128 bi = _mm_loadu_ps(im + b);
+            const __m128 pr = _mm_sub_ps(_mm_mul_ps(br, wr), _mm_mul_ps(bi, wi));
+            const __m128 pi = _mm_add_ps(_mm_mul_ps(br, wi), _mm_mul_ps(bi, wr));
+            const __m128 ar = _mm_loadu_ps(re + a);
+            const __m128 ai = _mm_loadu_ps(im + a);
+            _mm_storeu_ps(re + b, _mm_sub_ps(ar, pr));
+            _mm_storeu_ps(im + b, _mm_sub_ps(ai, pi));
+            _mm_storeu_ps(re + a, _mm_add_ps(ar, pr));
+            _mm_storeu_ps(im + a, _mm_add_ps(ai, pi));
+        }
+    }
+}
+
+PHANTOM_TARGET("sse2")
+void butterfliesSse2(float* re, float* im, size_t n, const float* twRe, const float* twIm) {
+    size_t h = 1;
+    for (; h < n && h < 4; h *= 2) {
+        stageScalar(re, im, n, h, twRe, twIm);
+    }
+    for (; h < n; h *= 2) {
+        stageSse2(re, im, n, h, twRe, twIm);
+    }
+}
+
+// ============================================================================
+// AVX2 kernel
+// ============================================================================
+
+PHANTOM_TARGET("avx2,fma")
+void stageAvx2(float* re, float* im, size_t n, size_t h, const float* twRe, const float* twIm) {
+    for (size_t j = 0; j < n; j += 2 * h) {
+        for (size_t t = 0; t < h; t += 8) {
+            const size_t a = j + t;
+            const size_t b = a + h;
+            const __m256 wr = _mm256_loadu_ps(twRe + h + t);
+            const __m256 wi = _mm256_loadu_ps(twIm + h + t);
+            const __m256 br = _mm256_loadu_ps(re + b);
+            const __m256 bi = _mm256_loadu_ps(im + b);
+            const __m256 pr = _mm256_fmsub_ps(br, wr, _mm256_mul_ps(bi, wi));
+            const __m256 pi = _mm256_fmadd_ps(br, wi, _mm256_mul_ps(bi, wr));
+            const __m256 ar = _mm256_loadu_ps(re + a);
+            const __m256 ai = _mm256_loadu_ps(im + a);
+            _mm256_storeu_ps(re + b, _mm256_sub_ps(ar, pr));
+            _mm256_storeu_ps(im + b, _mm256_sub_ps(ai, pi));
+            _mm256_storeu_ps(re + a, _mm256_add_ps(ar, pr));
+            _mm256_storeu_ps(im + a, _mm256_add_ps(ai, pi));
+        }
+    }
+}
+
+PHANTOM_TARGET("avx2,fma")
+void butterfliesAvx2(float* re, float* im, size_t n, const float* twRe, const float* twIm) {
+    size_t h = 1;
+    for (; h < n && h < 4; h *= 2) {
+        stageScalar(re, im, n, h, twRe, twIm);
+    }
+    for (; h < n && h < 8; h *= 2) {
+        stageSse2(re, im, n, h, twRe, twIm);
+    }
+    for (; h < n; h *= 2) {
+        stageAvx2(re, im, n, h, twRe, twIm);
+    }
+}
+
+#elif defined(PHANTOM_ARCH_ARM64)
+
+// ============================================================================
+// NEON kernel
+// ============================================================================
+
+void stageNeon(float* re, float* im, size_t n, size_t h, const float* twRe, const float* twIm) {
+    for (size_t j = 0; j < n; j += 2 * h) {
+        for (size_t t = 0; t < h; t += 4) {
+            const size_t a = j + t;
+            const size_t b = a + h;
+            const float32x4_t wr = vld1q_f32(twRe + h + t);
+            const float32x4_t wi = vld1q_f32(twIm + h + t);
+            const float32x4_t br = vld1q_f32(re + b);
+            const float32x4_t bi = vld1q_f32(im + b);
+            const float32x4_t pr = vfmsq_f32(vmulq_f32(br, wr), bi, wi);
+            const float32x4_t pi = vfmaq_f32(vmulq_f32(br, wi), bi, wr);
+            const float32x4_t ar = vld1q_f32(re + a);
+            const float32x4_t ai = vld1q_f32(im + a);
+            vst1q_f32(re + b, vsubq_f32(ar, pr));
+            vst1q_f32(im + b, vsubq_f32(ai, pi));
+            vst1q_f32(re + a, vaddq_f32(ar, pr));
+            vst1q_f32(im + a, vaddq_f32(ai, pi));
+        }
+    }
+}
+
+void butterfliesNeon(float* re, float* im, size_t n, const float* twRe, const float* twIm) {
+    size_t h = 1;
+    for (; h < n && h < 4; h *= 2) {
+        stageScalar(re, im, n, h, twRe, twIm);
+    }
+    for (; h < n; h *= 2) {
+        stageNeon(re, im, n, h, twRe, twIm);
+    }
+}
+
+#endif
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+struct Kernels {
+    SimdIsa isa = SimdIsa::Scalar;
+    ButterflyKernel butterflies = butterfliesScalar;
+};
+
+Kernels kernelsFor(SimdIsa isa) {
+    Kernels k;
+    if (!isaSupported(isa)) return k;
+#if defined(PHANTOM_ARCH_X86)
+    switch (isa) {
+        case SimdIsa::AVX2:
+            k.isa = SimdIsa::AVX2;
+            k.butterflies = butterfliesAvx2;
+            break;
+        case SimdIsa::SSE41:
+        case SimdIsa::SSSE3:
+        case SimdIsa::SSE2:
+            k.isa = SimdIsa::SSE2;
+            k.butterflies = butterfliesSse2;
+            break;
+        default:
+            break;
+    }
+#elif defined(PHANTOM_ARCH_ARM64)
+    if (isa == SimdIsa::NEON) {
+        k.isa = SimdIsa::NEON;
+        k.butterflies = butterfliesNeon;
+    }
+#endif
+    return k;
+}
+
+const Kernels& defaultKernels() {
+    static const Kernels kernels = kernelsFor(preferredIsa());
+    return kernels;
+}
+
+} // namespace
+
+SimdIsa noiseSuppressorIsa() {
+    return defaultKernels().isa;
+}
+
+// ============================================================================
+// RealFft
+// ============================================================================
+
+RealFft::RealFft(size_t size) : RealFft(size, defaultKernels().isa) {}
+
+RealFft::RealFft(size_t size, SimdIsa isa) {
+    size_t n = 16;
+    while (n < size) n *= 2;
+    m_size = n;
+    m_half = n / 2;
+
+    const Kernels kernels = kernelsFor(isa);
+    m_isa = kernels.isa;
+    m_butterflies = kernels.butterflies;
+
+    // Bit-reversal permutation of the half-size transform
+    size_t bits = 0;
+    while ((size_t{1} << bits) < m_half) ++bits;
+    for (size_t i = 0; i < m_half; ++i) {
+        size_t r = 0;
+        for (size_t b = 0; b < bits; ++b) {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        if (i < r) {
+            m_swaps.push_back(static_cast<uint32_t>(i));
+            m_swaps.push_back(static_cast<uint32_t>(r));
+        }
+    }
+
+    m_twRe.assign(m_half, 0.0f);
+    m_twIm.assign(m_half, 0.0f);
+    for (size_t h = 1; h < m_half; h *= 2) {
+        for (size_t t = 0; t < h; ++t) {
+            const double angle = -PI * static_cast<double>(t) / static_cast<double>(h);
+            m_twRe[h + t] = static_cast<float>(std::cos(angle));
+            m_twIm[h + t] = static_cast<float>(std::sin(angle));
+        }
+    }
+
+    m_postRe.resize(m_half);
+    m_postIm.resize(m_half);
+    for (size_t k = 0; k < m_half; ++k) {
+        const double angle = -2.0 * PI * static_cast<double>(k) / static_cast<double>(m_size);
+        m_postRe[k] = static_cast<float>(std::cos(angle));
+        m_postIm[k] = static_cast<float>(std::sin(angle));
+    }
+
+    m_workRe.resize(m_half);
+    m_workIm.resize(m_half);
+}
+
+void RealFft::transform(float* re, float* im) {
+    for (size_t i = 0; i < m_swaps.size(); i += 2) {
+        std::swap(re[m_swaps[i]], re[m_swaps[i + 1]]);
+        std::swap(im[m_swaps[i]], im[m_swaps[i + 1]]);
+    }
+    m_butterflies(re, im, m_half, m_twRe.data(), m_twIm.data());
+}
+
+void RealFft::forward(const float* input, float* re, float* im) {
+    const size_t m = m_half;
+    float* zr = m_workRe.data();
+    float* zi = m_workIm.data();
+
+    // Even samples as the real part, odd as the imaginary part
+    for (size_t i = 0; i < m; ++i) {
+        zr[i] = input[2 * i];
+        zi[i] = input[2 * i + 1];
+    }
+    transform(zr, zi);
+
+    re[0] = zr[0] + zi[0];
+    im[0] = 0.0f;
+    re[m] = zr[0] - zi[0];
+    im[m] = 0.0f;
+
+    // Split into the spectra of the even and odd samples, then combine
+    for (size_t k = 1; k < m; ++k) {
+        const float cr = zr[m - k];
+        const float ci = -zi[m - k];
+        const float evenRe = 0.5f * (zr[k] + cr);
+        const float evenIm = 0.5f * (zi[k] + ci);
+        const float oddRe = 0.5f * (zi[k] - ci);
+        const float oddIm = -0.5f * (zr[k] - cr);
+        const float wr = m_postRe[k];
+        const float wi = m_postIm[k];
+        re[k] = evenRe + oddRe * wr - oddIm * wi;
+        im[k] = evenIm + oddRe * wi + oddIm * wr;
+    }
+}
+
+void RealFft::inverse(const float* re, const float* im, float* output) {
+    const size_t m = m_half;
+    float* zr = m_workRe.data();
+    float* zi = m_workIm.data();
+
+    // Undo the split, conjugating so the forward butterflies compute the inverse
+    for (size_t k = 0; k < m; ++k) {
+        const float cr = re[m - k];
+        const float ci = -im[m - k];
+        const float evenRe = 0.5f * (re[k] + cr);
+        const float evenIm = 0.5f * (im[k] + ci);
+        const float diffRe = 0.5f * (re[k] - cr);
+        const float diffIm = 0.5f * (im[k] - ci);
+        const float wr = m_postRe[k];
+        const float wi = m_postIm[k];
+        const float oddRe = diffRe * wr + diffIm * wi;
+        const float oddIm = diffIm * wr - diffRe * wi;
+        zr[k] = evenRe - oddIm;
+        zi[k] = -(evenIm + oddRe);
+    }
+    transform(zr, zi);
+
+    const float scale = 1.0f / static_cast<float>(m);
+    for (size_t i = 0; i < m; ++i) {
+        output[2 * i] = zr[i] * scale;
+        output[2 * i + 1] = -zi[i] * scale;
+    }
+}
+
+// ============================================================================
+// NoiseSuppressor
+// ============================================================================
+
+NoiseSuppressor::NoiseSuppressor() : NoiseSuppressor(noiseSuppressorIsa()) {}
+
+NoiseSuppressor::NoiseSuppressor(SimdIsa isa)
+    : m_fft(FFT_SIZE, isa),
+      m_window(FFT_SIZE),
+      m_frame(FFT_SIZE),
+      m_overlap(FFT_SIZE),
+      m_re(BINS),
+      m_im(BINS),
+      m_time(FFT_SIZE),
+      m_power(BINS),
+      m_windowMin(BINS),
+      m_pastMin(BINS * SUB_WINDOWS),
+      m_gain(BINS) {
+    // Periodic sqrt-Hann on both sides: the squares overlap-add to exactly 1 at 50%
+    for (size_t i = 0; i < FFT_SIZE; ++i) {
+        const double hann = 0.5 - 0.5 * std::cos(2.0 * PI * static_cast<double>(i) / FFT_SIZE);
+        m_window[i] = static_cast<float>(std::sqrt(hann));
+    }
+    m_ready.reserve(2 * HOP);
+    reset();
+}
+
+void NoiseSuppressor::reset() {
+    // The first frame starts with FFT_SIZE - HOP samples of silence and HOP
+    // are ready up front, which makes the delay exactly FFT_SIZE
+    std::fill(m_frame.begin(), m_frame.end(), 0.0f);
+    m_frameFill = FFT_SIZE - HOP;
+    std::fill(m_overlap.begin(), m_overlap.end(), 0.0f);
+    m_ready.assign(HOP, 0.0f);
+
+    std::fill(m_windowMin.begin(), m_windowMin.end(), FLT_MAX);
+    std::fill(m_pastMin.begin(), m_pastMin.end(), FLT_MAX);
+    m_subFrames = 0;
+    m_subIndex = 0;
+    std::fill(m_gain.begin(), m_gain.end(), 1.0f);
+    m_frames = 0;
+    m_frozen = false;
+}
+
+void NoiseSuppressor::process(const float* samples, size_t numSamples, std::vector<float>& out) {
+    feed(samples, numSamples);
+    out.insert(out.end(), m_ready.begin(), m_ready.begin() + numSamples);
+    m_ready.erase(m_ready.begin(), m_ready.begin() + numSamples);
+}
+
+size_t NoiseSuppressor::drain(size_t numSamples, std::vector<float>& out) {
+    const size_t count = std::min(numSamples, LATENCY_SAMPLES);
+    if (count == 0) return 0;
+
+    m_zeros.resize(count, 0.0f);
+    m_frozen = true;
+    process(m_zeros.data(), count, out);
+    m_frozen = false;
+    return count;
+}
+
+void NoiseSuppressor::feed(const float* samples, size_t numSamples) {
+    while (numSamples > 0) {
+        const size_t take = std::min(numSamples, FFT_SIZE - m_frameFill);
+        std::memcpy(m_frame.data() + m_frameFill, samples, take * sizeof(float));
+        m_frameFill += take;
+        samples += take;
+        numSamples -= take;
+
+        if (m_frameFill == FFT_SIZE) {
+            processFrame();
+            std::memmove(m_frame.data(), m_frame.data() + HOP, (FFT_SIZE - HOP) * sizeof(float));
+            m_frameFill = FFT_SIZE - HOP;
+        }
+    }
+}
+
+void NoiseSuppressor::processFrame() {
+    for (size_t i = 0; i < FFT_SIZE; ++i) {
+        m_time[i] = m_frame[i] * m_window[i];
+    }
+    m_fft.forward(m_time.data(), m_re.data(), m_im.data());
+
+    // The first frame is mostly the silence the delay line starts with: pass
+    // it through rather than learn it as the floor
+    if (m_frames++ == 0) {
+        m_fft.inverse(m_re.data(), m_im.data(), m_time.data());
+        overlapAdd();
+        return;
+    }
+
+    const bool track = !m_frozen;
+    const bool subWindowDone = track && ++m_subFrames == SUB_FRAMES;
+
+    for (size_t k = 0; k < BINS; ++k) {
+        const float power = m_re[k] * m_re[k] + m_im[k] * m_im[k];
+        float& smoothed = m_power[k];
+        smoothed = m_frames > 2 ? POWER_SMOOTHING * smoothed + (1.0f - POWER_SMOOTHING) * power : power;
+
+        float* past = &m_pastMin[k * SUB_WINDOWS];
+        if (track) {
+            m_windowMin[k] = std::min(m_windowMin[k], smoothed);
+        }
+        float floor = m_windowMin[k];
+        for (size_t w = 0; w < SUB_WINDOWS; ++w) {
+            floor = std::min(floor, past[w]);
+        }
+        if (subWindowDone) {
+            past[m_subIndex] = m_windowMin[k];
+            m_windowMin[k] = smoothed;
+        }
+
+        // Gate on the smoothed level: the raw power of a noise bin scatters widely around it
+        const float noise = NOISE_BIAS * floor;
+        float gain = 1.0f - OVERSUBTRACTION * noise / std::max(smoothed, POWER_EPSILON);
+        gain = std::min(1.0f, std::max(GAIN_FLOOR, gain));
+        if (gain < m_gain[k]) {
+            gain = GAIN_RELEASE * m_gain[k] + (1.0f - GAIN_RELEASE) * gain;
+        }
+        m_gain[k] = gain;
+        m_re[k] *= gain;
+        m_im[k] *= gain;
+    }
+    if (subWindowDone) {
+        m_subFrames = 0;
+        m_subIndex = (m_subIndex + 1) % SUB_WINDOWS;
+    }
+
+    m_fft.inverse(m_re.data(), m_im.data(), m_time.data());
+    overlapAdd();
+}
+
+void NoiseSuppressor::overlapAdd() {
+    for (size_t i = 0; i < FFT_SIZE; ++i) {
+        m_overlap[i] += m_time[i] * m_window[i];
+    }
+    m_ready.insert(m_ready.end(), m_overlap.begin(), m_overlap.begin() + HOP);
+    std::memmove(m_overlap.data(), m_overlap.data() + HOP, (FFT_SIZE - HOP) * sizeof(float));
+    std::fill(m_overlap.begin() + (FFT_SIZE - HOP), m_overlap.end(), 0.0f);
+}
+
+} // namespace phantom
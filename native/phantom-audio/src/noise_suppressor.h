@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "cpu_features.h"
+
+namespace phantom {
+
+/**
+ * FFT of `size` real samples (a power of two, at least 16), computed as a
+ * complex FFT of half the size on split real/imaginary arrays. Spectra
+ * have size / 2 + 1 bins. forward() is unscaled and inverse() divides by
+ * `size`, so inverse(forward(x)) == x. The butterflies run on the best
+ * kernel for this CPU, or for `isa` (tests and benchmarks).
+ */
+class RealFft {
+public:
+    explicit RealFft(size_t size);
+    RealFft(size_t size, SimdIsa isa);
+
+    void forward(const float* input, float* re, float* im);
+    void inverse(const float* re, const float* im, float* output);
+
+    size_t size() const { return m_size; }
+    SimdIsa isa() const { return m_isa; }
+
+private:
+    void transform(float* re, float* im);
+
+    size_t m_size;
+    size_t m_half;
+    SimdIsa m_isa;
+    void (*m_butterflies)(float* re, float* im, size_t n, const float* twRe, const float* twIm);
+    std::vector<uint32_t> m_swaps;          // Bit-reversal pairs, flattened
+    std::vector<float> m_twRe, m_twIm;      // Stage twiddles: stage h at [h, 2h)
+    std::vector<float> m_postRe, m_postIm;  // Real-FFT split twiddles
+    std::vector<float> m_workRe, m_workIm;
+};
+
+// Level the default FFT kernel was bound for
+SimdIsa noiseSuppressorIsa();
+
+/**
+ * Streaming spectral-gating denoiser for the 16kHz stream.
+ *
+ * 32ms frames (sqrt-Hann windowed, 50% overlap) are gated per frequency
+ * bin against a noise floor: the lowest smoothed level of the bin over
+ * roughly the last second (minimum statistics). Speech rarely holds a bin
+ * up that long, so the floor follows fans, hum and room tone within about
+ * a second and does not learn speech as noise. Bins near the floor are
+ * attenuated, by at most 20dB to keep artifacts down; bins well above it
+ * pass unchanged.
+ *
+ * Output is delayed by exactly LATENCY_SAMPLES; every call returns as many
+ * samples as it was given, so stream positions stay aligned. Not
+ * thread-safe.
+ */
+class NoiseSuppressor {
+public:
+    static constexpr size_t FFT_SIZE = 512;
+    static constexpr size_t HOP = FFT_SIZE / 2;
+    static constexpr size_t BINS = FFT_SIZE / 2 + 1;
+    static constexpr size_t LATENCY_SAMPLES = FFT_SIZE;
+
+    NoiseSuppressor();
+    explicit NoiseSuppressor(SimdIsa isa);
+
+    // Forget the noise floor and any audio in flight
+    void reset();
+
+    // Denoise `numSamples`, appending as many (delayed) samples to `out`
+    void process(const float* samples, size_t numSamples, std::vector<float>& out);
+
+    /**
+     * Push the audio still in flight out ahead of a gap of `numSamples`
+     * of digital silence, without learning the silence as the noise floor.
+     * @return samples appended to `out` (at most LATENCY_SAMPLES); the rest
+     *         of the gap can be skipped
+     */
+    size_t drain(size_t numSamples, std::vector<float>& out);
+
+    SimdIsa isa() const { return m_fft.isa(); }
+
+private:
+    void feed(const float* samples, size_t numSamples);
+    void processFrame();
+    void overlapAdd();
+
+    RealFft m_fft;
+    std::vector<float> m_window;
+    std::vector<float> m_frame;         // Last FFT_SIZE input samples
+    size_t m_frameFill = 0;
+    std::vector<float> m_overlap;       // Synthesis overlap-add
+    std::vector<float> m_ready;         // Output not yet returned
+    std::vector<float> m_re, m_im, m_time;
+    std::vector<float> m_power;         // Smoothed power per bin
+    std::vector<float> m_windowMin;     // Per bin: minimum of the current sub-window...
+    std::vector<float> m_pastMin;       // ...and of the previous ones (bin-major)
+    size_t m_subFrames = 0;
+    size_t m_subIndex = 0;
+    std::vector<float> m_gain;
+    size_t m_frames = 0;                // Frames since reset
+    bool m_frozen = false;              // Draining: keep the noise floor
+    std::vector<float> m_zeros;
+};
+
+} // namespace phantom
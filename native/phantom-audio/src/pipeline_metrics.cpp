@@ -0,0 +1,230 @@
+#include "pipeline_metrics.h"
+#include <cstdio>
+
+namespace phantom {
+
+namespace {
+
+int highestBit(uint64_t value) {
+    int bit = 0;
+    while (value >>= 1) ++bit;
+    return bit;
+}
+
+void updateMax(std::atomic<uint64_t>& target, uint64_t value) {
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (value > current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+void appendNumber(std::string& out, double value) {
+    char buf[32];
+    const int n = std::snprintf(buf, sizeof(buf), "%.6g", value);
+    out.append(buf, n > 0 ? static_cast<size_t>(n) : 0);
+}
+
+// "name":{"count":N,"mean":x,"p50":x,"p90":x,"p99":x,"max":x}, values / divisor
+void appendHistogram(std::string& out, const char* name, const LatencyHistogram& h, double divisor = 1.0) {
+    out += '"';
+    out += name;
+    out += "\":{\"count\":";
+    out += std::to_string(h.count());
+    out += ",\"mean\":";
+    appendNumber(out, h.mean() / divisor);
+    out += ",\"p50\":";
+    appendNumber(out, static_cast<double>(h.percentile(50.0)) / divisor);
+    out += ",\"p90\":";
+    appendNumber(out, static_cast<double>(h.percentile(90.0)) / divisor);
+    out += ",\"p99\":";
+    appendNumber(out, static_cast<double>(h.percentile(99.0)) / divisor);
+    out += ",\"max\":";
+    appendNumber(out, static_cast<double>(h.max()) / divisor);
+    out += '}';
+}
+
+void appendCounter(std::string& out, const char* name, uint64_t value) {
+    out += '"';
+    out += name;
+    out += "\":";
+    out += std::to_string(value);
+}
+
+const uint64_t g_startUs = metricsNowUs();
+
+} // namespace
+
+// ============================================================================
+// LatencyHistogram
+// ============================================================================
+
+int LatencyHistogram::bucketIndex(uint64_t value) {
+    const uint64_t limit = (1ULL << MAX_BITS) - 1;
+    if (value > limit) value = limit;
+    if (value < 2 * SUB_BUCKETS) return static_cast<int>(value);
+
+    // Top SUB_BUCKET_BITS+1 bits select the sub-bucket within the octave
+    const int shift = highestBit(value) - SUB_BUCKET_BITS;
+    return shift * SUB_BUCKETS + static_cast<int>(value >> shift);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index) {
+    if (index < 2 * SUB_BUCKETS) return static_cast<uint64_t>(index);
+
+    const int shift = index / SUB_BUCKETS - 1;
+    const uint64_t subBucket = static_cast<uint64_t>(index - shift * SUB_BUCKETS);
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    updateMax(m_max, value);
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : m_buckets) bucket.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const {
+    const uint64_t n = count();
+    return n ? static_cast<double>(m_sum.load(std::memory_order_relaxed)) / static_cast<double>(n) : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    // Sum the buckets rather than trusting m_count, which may be ahead
+    uint64_t total = 0;
+    for (const auto& bucket : m_buckets) total += bucket.load(std::memory_order_relaxed);
+    if (total == 0) return 0;
+
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(total) + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > total) rank = total;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            // Never report past the largest value actually recorded
+            const uint64_t bound = bucketUpperBound(i);
+            const uint64_t highest = max();
+            return (highest && bound > highest) ? highest : bound;
+        }
+    }
+    return max();
+}
+
+// ============================================================================
+// Gauge
+// ============================================================================
+
+void Gauge::set(uint64_t value) {
+    m_value.store(value, std::memory_order_relaxed);
+    updateMax(m_max, value);
+}
+
+void Gauge::reset() {
+    m_max.store(m_value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+// ============================================================================
+// PipelineMetrics
+// ============================================================================
+
+void PipelineMetrics::reset() {
+    LatencyHistogram* histograms[] = {&captureInterval, &resample, &dispatch, &denoise, &stageWait, &queueWait,
+                                      &vad, &inference, &encode, &decode, &rtfMilli,
+                                      &bufferDepthMs, &outputWrite};
+    for (LatencyHistogram* h : histograms) h->reset();
+
+    std::atomic<uint64_t>* counters[] = {&capturePackets, &capturedSamples, &captureDiscontinuities,
+                                         &silentSamples, &chunksTranscribed, &chunksSkipped, &overlapTokens,
+                                         &redecodes, &redecodesSkipped, &decodeLoops,
+                                         &tokenCapHits, &languageDetections, &droppedSamples, &stageDrops,
+                                         &eventsWritten};
+    for (std::atomic<uint64_t>* c : counters) c->store(0, std::memory_order_relaxed);
+
+    bufferSamples.reset();
+}
+
+void PipelineMetrics::appendJson(std::string& out) const {
+    out += "\"uptime_ms\":";
+    out += std::to_string((metricsNowUs() - g_startUs) / 1000);
+
+    out += ",\"stages\":{";
+    appendHistogram(out, "capture_interval_us", captureInterval);
+    out += ',';
+    appendHistogram(out, "resample_us", resample);
+    out += ',';
+    appendHistogram(out, "dispatch_us", dispatch);
+    out += ',';
+    appendHistogram(out, "denoise_us", denoise);
+    out += ',';
+    appendHistogram(out, "stage_wait_us", stageWait);
+    out += ',';
+    appendHistogram(out, "queue_wait_us", queueWait);
+    out += ',';
+    appendHistogram(out, "vad_us", vad);
+    out += ',';
+    appendHistogram(out, "inference_us", inference);
+    out += ',';
+    appendHistogram(out, "encode_us", encode);
+    out += ',';
+    appendHistogram(out, "decode_us", decode);
+    out += ',';
+    appendHistogram(out, "rtf", rtfMilli, 1000.0);
+    out += ',';
+    appendHistogram(out, "buffer_depth_ms", bufferDepthMs);
+    out += ',';
+    appendHistogram(out, "output_write_us", outputWrite);
+    out += '}';
+
+    out += ",\"counters\":{";
+    appendCounter(out, "capture_packets", capturePackets.load(std::memory_order_relaxed));
+    out += ',';
+    appendCounter(out, "captured_samples", capturedSamples.load(std::memory_order_relaxed));
+    out += ',';
+    appendCounter(out, "capture_discontinuities", captureDiscontinuities.load(std::memory_order_relaxed));
+    out += ',';
+    appendCounter(out, "silent_samples", silentSamples.load(std::memory_order_relaxed));
+    out += ',';
+    appendCounter(out, "chunks_transcribed", chunksTranscribed.load(std::memory_order_relaxed));
+    out += ',';
+    appendCounter(out, "chunks_skipped", chunksSkipped.load(std::memory_order_relaxed));
+    out += ',';
+    appendCounter(out, "overlap_tokens", overlapTokens.load(std::memory_order_relaxed));
+    out += ',';
+    appendCounter(out, "redecodes", redecodes.load(std::memory_order_relaxed));
+    out += ',';
+    appendCounter(out, "redecodes_skipped", redecodesSkipped.load(std::memory_order_relaxed));
+    out += ',';
+    appendCounter(out, "decode_loops", decodeLoops.load(std::memory_order_relaxed));
+    out += ',';
+    appendCounter(out, "token_cap_hits", tokenCapHits.load(std::memory_order_relaxed));
+    out += ',';
+    appendCounter(out, "language_detections", languageDetections.load(std::memory_order_relaxed));
+    out += ',';
+    appendCounter(out, "dropped_samples", droppedSamples.load(std::memory_order_relaxed));
+    out += ',';
+    appendCounter(out, "stage_drops", stageDrops.load(std::memory_order_relaxed));
+    out += ',';
+    appendCounter(out, "events_written", eventsWritten.load(std::memory_order_relaxed));
+    out += '}';
+
+    out += ",\"gauges\":{";
+    appendCounter(out, "buffer_samples", bufferSamples.value());
+    out += ',';
+    appendCounter(out, "buffer_samples_max", bufferSamples.max());
+    out += '}';
+}
+
+PipelineMetrics& metrics() {
+    static PipelineMetrics instance;
+    return instance;
+}
+
+} // namespace phantom
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace phantom {
+
+/**
+ * HDR-style latency histogram: log-linear buckets with 16 sub-buckets per
+ * power of two (about 6% relative precision) from 0 to 2^40. record() is
+ * lock-free and safe from any thread; readers see a slightly torn but
+ * never corrupt view while writers are active.
+ */
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int MAX_BITS = 40;
+    static constexpr int BUCKETS = (MAX_BITS - SUB_BUCKET_BITS) * SUB_BUCKETS + SUB_BUCKETS;
+
+    void record(uint64_t value);
+    void reset();
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+    double mean() const;
+
+    // Upper bound of the bucket holding the p-th percentile (0 < p <= 100)
+    uint64_t percentile(double p) const;
+
+    static int bucketIndex(uint64_t value);
+    static uint64_t bucketUpperBound(int index);
+
+private:
+    std::atomic<uint64_t> m_buckets[BUCKETS] = {};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_sum{0};
+    std::atomic<uint64_t> m_max{0};
+};
+
+// Last and highest value of a level such as buffer depth
+class Gauge {
+public:
+    void set(uint64_t value);
+    void reset();
+
+    uint64_t value() const { return m_value.load(std::memory_order_relaxed); }
+    uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_value{0};
+    std::atomic<uint64_t> m_max{0};
+};
+
+/**
+ * Process-wide pipeline metrics, reported by {"cmd":"metrics"}.
+ * Durations are microseconds unless the name says otherwise.
+ */
+struct PipelineMetrics {
+    // Capture thread
+    LatencyHistogram captureInterval;   // Time between capture packets
+    LatencyHistogram resample;          // Sample conversion + resampling per packet
+    LatencyHistogram dispatch;          // Handing a packet to the pipeline
+
+    // Pipeline workers
+    LatencyHistogram stageWait;         // Time a packet waits in a stage queue
+    LatencyHistogram denoise;           // Noise suppression per packet (when on)
+
+    // Transcription thread
+    LatencyHistogram queueWait;         // Newest sample's age when its chunk is decoded
+    LatencyHistogram vad;               // Silence trimming per chunk
+    LatencyHistogram inference;         // whisper_full wall time
+    LatencyHistogram encode;            // Encoder part of inference
+    LatencyHistogram decode;            // Decoder part of inference (incl. prompt/batch)
+    LatencyHistogram rtfMilli;          // Inference time / audio duration, x1000
+    LatencyHistogram bufferDepthMs;     // Audio buffered when a chunk is taken
+
+    // Output
+    LatencyHistogram outputWrite;       // One stdout write (event, frame or audio line)
+
+    std::atomic<uint64_t> capturePackets{0};
+    std::atomic<uint64_t> capturedSamples{0};
+    std::atomic<uint64_t> captureDiscontinuities{0};  // Glitches reported by the device
+    std::atomic<uint64_t> silentSamples{0};           // Skipped as digital silence (16kHz)
+    std::atomic<uint64_t> chunksTranscribed{0};
+    std::atomic<uint64_t> chunksSkipped{0};           // Too short after silence trimming
+    std::atomic<uint64_t> overlapTokens{0};           // Decoded again in chunk overlap, not emitted
+    std::atomic<uint64_t> redecodes{0};               // Extra decodes of doubtful chunks
+    std::atomic<uint64_t> redecodesSkipped{0};        // Doubtful chunks kept for lack of budget
+    std::atomic<uint64_t> decodeLoops{0};             // Decodes cut short on a repetition loop
+    std::atomic<uint64_t> tokenCapHits{0};            // Decodes that reached the per-chunk token limit
+    std::atomic<uint64_t> languageDetections{0};      // Language ID passes in "auto" mode
+    std::atomic<uint64_t> droppedSamples{0};          // Captured but never decoded
+    std::atomic<uint64_t> stageDrops{0};              // Packets dropped at a full stage queue
+    std::atomic<uint64_t> eventsWritten{0};
+
+    Gauge bufferSamples;                // Samples waiting for transcription
+
+    void reset();
+
+    // Append the body of a metrics event (without the "type" member)
+    void appendJson(std::string& out) const;
+};
+
+PipelineMetrics& metrics();
+
+inline uint64_t metricsNowUs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Records the lifetime of a scope into a histogram
+class StageTimer {
+public:
+    explicit StageTimer(LatencyHistogram& histogram)
+        : m_histogram(histogram), m_start(metricsNowUs()) {}
+    ~StageTimer() { m_histogram.record(metricsNowUs() - m_start); }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    LatencyHistogram& m_histogram;
+    uint64_t m_start;
+};
+
+} // namespace phantom
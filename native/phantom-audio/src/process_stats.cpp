@@ -0,0 +1,81 @@
+#include "process_stats.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+#endif
+
+namespace phantom {
+
+#ifdef _WIN32
+
+static double fileTimeSeconds(const FILETIME& time) {
+    ULARGE_INTEGER value;
+    value.LowPart = time.dwLowDateTime;
+    value.HighPart = time.dwHighDateTime;
+    return static_cast<double>(value.QuadPart) * 1e-7;  // 100ns units
+}
+
+ProcessStats currentProcessStats() {
+    ProcessStats stats;
+    FILETIME created, exited, kernel, user;
+    if (GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) {
+        stats.userCpuSeconds = fileTimeSeconds(user);
+        stats.systemCpuSeconds = fileTimeSeconds(kernel);
+    }
+    PROCESS_MEMORY_COUNTERS memory = {};
+    if (K32GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory))) {
+        stats.peakRssBytes = memory.PeakWorkingSetSize;
+    }
+    return stats;
+}
+
+uint64_t availableMemoryBytes() {
+    MEMORYSTATUSEX status = {};
+    status.dwLength = sizeof(status);
+    return GlobalMemoryStatusEx(&status) ? status.ullAvailPhys : 0;
+}
+
+#else
+
+ProcessStats currentProcessStats() {
+    ProcessStats stats;
+    struct rusage usage = {};
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        stats.userCpuSeconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6;
+        stats.systemCpuSeconds = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+#ifdef __APPLE__
+        stats.peakRssBytes = static_cast<uint64_t>(usage.ru_maxrss);          // bytes
+#else
+        stats.peakRssBytes = static_cast<uint64_t>(usage.ru_maxrss) * 1024;   // KiB
+#endif
+    }
+    return stats;
+}
+
+uint64_t availableMemoryBytes() {
+#ifdef __APPLE__
+    vm_statistics64_data_t vm = {};
+    mach_msg_type_number_t count = HOST_VM_INFO64_COUNT;
+    if (host_statistics64(mach_host_self(), HOST_VM_INFO64, reinterpret_cast<host_info64_t>(&vm), &count) !=
+        KERN_SUCCESS) {
+        return 0;
+    }
+    // Inactive pages are reclaimable, as on the other platforms
+    return (static_cast<uint64_t>(vm.free_count) + vm.inactive_count) * static_cast<uint64_t>(vm_page_size);
+#else
+    const long pages = sysconf(_SC_AVPHYS_PAGES);
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    return pages > 0 && pageSize > 0 ? static_cast<uint64_t>(pages) * static_cast<uint64_t>(pageSize) : 0;
+#endif
+}
+
+#endif
+
+} // namespace phantom
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+namespace phantom {
+
+// CPU time and peak memory of this process so far
+struct ProcessStats {
+    double userCpuSeconds = 0.0;
+    double systemCpuSeconds = 0.0;
+    uint64_t peakRssBytes = 0;      // Peak working set on Windows
+
+    double cpuSeconds() const { return userCpuSeconds + systemCpuSeconds; }
+};
+
+ProcessStats currentProcessStats();
+
+// Physical memory not in use right now, or 0 if the OS will not say
+uint64_t availableMemoryBytes();
+
+} // namespace phantom
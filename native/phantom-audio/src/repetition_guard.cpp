@@ -0,0 +1,56 @@
+#include "repetition_guard.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace phantom {
+
+namespace {
+
+constexpr size_t TOKENS_PER_SECOND = 16;
+constexpr size_t DENSE_TOKENS_PER_SECOND = 48;
+constexpr size_t MIN_MAX_TOKENS = 16;
+
+// Languages whose text takes many more BPE tokens per second of speech:
+// byte-level pieces of CJK, Hangul and Southeast Asian scripts
+const char* const DENSE_LANGUAGES[] = {"zh", "yue", "ja", "ko", "th", "lo", "km", "my", "bo"};
+
+size_t tokensPerSecond(const char* language) {
+    if (!language || std::strcmp(language, "auto") == 0) return DENSE_TOKENS_PER_SECOND;
+    for (const char* dense : DENSE_LANGUAGES) {
+        if (std::strcmp(language, dense) == 0) return DENSE_TOKENS_PER_SECOND;
+    }
+    return TOKENS_PER_SECOND;
+}
+
+} // namespace
+
+RepetitionLoop findRepetitionLoop(const int32_t* tokens, size_t count) {
+    RepetitionLoop loop;
+    for (size_t ngram = 1; ngram <= MAX_LOOP_NGRAM; ++ngram) {
+        const size_t needed = ngram == 1 ? MIN_LOOP_REPEATS_UNIGRAM : MIN_LOOP_REPEATS;
+        if (count < ngram * needed) break;
+
+        // Walk back while each token equals the one a period later
+        size_t periodic = ngram;
+        while (periodic < count && tokens[count - 1 - periodic] == tokens[count - 1 - periodic + ngram]) {
+            ++periodic;
+        }
+        const size_t repeats = periodic / ngram;
+        if (repeats >= needed) {
+            loop.ngram = ngram;
+            loop.repeats = repeats;
+            loop.start = count - repeats * ngram;
+            return loop;
+        }
+    }
+    return loop;
+}
+
+int maxTokensForAudio(size_t numSamples, size_t sampleRate, const char* language) {
+    if (sampleRate == 0) return static_cast<int>(MIN_MAX_TOKENS);
+    const size_t tokens = (numSamples * tokensPerSecond(language) + sampleRate - 1) / sampleRate;
+    return static_cast<int>(std::max(tokens, MIN_MAX_TOKENS));
+}
+
+} // namespace phantom
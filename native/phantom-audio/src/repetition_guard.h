@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace phantom {
+
+/**
+ * A run of one n-gram repeated back to back at the end of a token
+ * sequence, the shape of whisper's loops on noise and music ("you you
+ * you ...", "Thank you. Thank you. ...").
+ */
+struct RepetitionLoop {
+    size_t start = 0;       // First token of the run
+    size_t ngram = 0;       // Tokens per repeat; 0 = no loop
+    size_t repeats = 0;
+
+    bool found() const { return ngram > 0; }
+
+    // Tokens to keep: everything before the run plus its first repeat
+    size_t keep() const { return start + ngram; }
+};
+
+constexpr size_t MAX_LOOP_NGRAM = 4;
+constexpr size_t MIN_LOOP_REPEATS_UNIGRAM = 4;  // "no no no" is still speech
+constexpr size_t MIN_LOOP_REPEATS = 3;
+
+/**
+ * The shortest n-gram (up to MAX_LOOP_NGRAM tokens) that ends `tokens`
+ * and repeats at least MIN_LOOP_REPEATS times in a row (single tokens:
+ * MIN_LOOP_REPEATS_UNIGRAM), or an empty result.
+ */
+RepetitionLoop findRepetitionLoop(const int32_t* tokens, size_t count);
+
+/**
+ * Decoder token limit for a chunk of `numSamples` in `language` (an ISO
+ * code, or "auto" while it is unknown): generous for fast speech, so it
+ * only binds on decodes that have run away. Most languages get 16 tokens
+ * per second; scripts that spend several tokens per syllable (Chinese,
+ * Japanese, Korean, Thai, ...) and unknown languages get 48. At least 16.
+ */
+int maxTokensForAudio(size_t numSamples, size_t sampleRate, const char* language);
+
+} // namespace phantom
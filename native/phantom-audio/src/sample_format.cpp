@@ -0,0 +1,454 @@
+#include "sample_format.h"
+#include <cmath>
+#include <algorithm>
+
+#if defined(PHANTOM_ARCH_X86)
+#include <immintrin.h>
+#elif defined(PHANTOM_ARCH_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace phantom {
+
+namespace {
+
+constexpr float S16_SCALE = 32768.0f;
+constexpr float S16_INV_SCALE = 1.0f / 32768.0f;
+constexpr float S16_MIN = -32768.0f;
+constexpr float S16_MAX = 32767.0f;
+constexpr float UNIFORM_SCALE = 1.0f / 16777216.0f;  // 2^-24
+
+inline uint32_t xorshift32(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Triangular noise in (-1, 1) LSB from two uniform draws
+inline float tpdfNoise(uint32_t& state) {
+    const float a = static_cast<float>(xorshift32(state) >> 8) * UNIFORM_SCALE;
+    const float b = static_cast<float>(xorshift32(state) >> 8) * UNIFORM_SCALE;
+    return a - b;
+}
+
+inline int16_t toS16(float scaled) {
+    // NaN becomes silence rather than a full-scale click, as in the SIMD kernels
+    if (scaled != scaled) return 0;
+    scaled = std::min(S16_MAX, std::max(S16_MIN, scaled));
+    return static_cast<int16_t>(std::lrintf(scaled));
+}
+
+} // namespace
+
+const char* sampleFormatName(SampleFormat format) {
+    return format == SampleFormat::S16 ? "s16" : "f32";
+}
+
+bool parseSampleFormat(const std::string& name, SampleFormat* format) {
+    if (name == "f32") {
+        *format = SampleFormat::F32;
+        return true;
+    }
+    if (name == "s16") {
+        *format = SampleFormat::S16;
+        return true;
+    }
+    return false;
+}
+
+DitherState::DitherState(uint32_t seed) {
+    for (int i = 0; i < 4; ++i) {
+        // Distinct non-zero seeds per lane
+        uint32_t s = seed + 0x6D2B79F5u * static_cast<uint32_t>(i + 1);
+        lanes[i] = s ? s : 1u;
+    }
+}
+
+// ============================================================================
+// Scalar reference
+// ============================================================================
+
+void floatToS16Scalar(const float* input, int16_t* output, size_t numSamples) {
+    for (size_t i = 0; i < numSamples; ++i) {
+        output[i] = toS16(input[i] * S16_SCALE);
+    }
+}
+
+void floatToS16DitheredScalar(const float* input, int16_t* output, size_t numSamples, DitherState& dither) {
+    for (size_t i = 0; i < numSamples; ++i) {
+        const float noise = tpdfNoise(dither.lanes[i & 3]);
+        output[i] = toS16(input[i] * S16_SCALE + noise);
+    }
+}
+
+void s16ToFloatScalar(const int16_t* input, float* output, size_t numSamples) {
+    for (size_t i = 0; i < numSamples; ++i) {
+        output[i] = static_cast<float>(input[i]) * S16_INV_SCALE;
+    }
+}
+
+void downmixToMonoScalar(const float* input, float* output, size_t numFrames, uint16_t channels) {
+    for (size_t i = 0; i < numFrames; ++i) {
+        float sum = 0.0f;
+        for (uint16_t ch = 0; ch < channels; ++ch) {
+            sum += input[i * channels + ch];
+        }
+        output[i] = sum / channels;
+    }
+}
+
+namespace {
+
+using FloatToS16Kernel = void (*)(const float* input, int16_t* output, size_t numSamples);
+using DitheredKernel = void (*)(const float* input, int16_t* output, size_t numSamples, DitherState& dither);
+using S16ToFloatKernel = void (*)(const int16_t* input, float* output, size_t numSamples);
+// Stereo only; other layouts use the scalar loop
+using DownmixKernel = void (*)(const float* input, float* output, size_t numFrames);
+
+void downmixStereoScalar(const float* input, float* output, size_t numFrames) {
+    downmixToMonoScalar(input, output, numFrames, 2);
+}
+
+#if defined(PHANTOM_ARCH_X86)
+
+// ============================================================================
+// SSE2 kernels
+// ============================================================================
+
+PHANTOM_TARGET("sse2")
+inline __m128i xorshift32x4(__m128i& s) {
+    s = _mm_xor_si128(s, _mm_slli_epi32(s, 13));
+    s = _mm_xor_si128(s, _mm_srli_epi32(s, 17));
+    s = _mm_xor_si128(s, _mm_slli_epi32(s, 5));
+    return s;
+}
+
+PHANTOM_TARGET("sse2")
+inline __m128 uniformx4(__m128i r) {
+    return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(r, 8)), _mm_set1_ps(UNIFORM_SCALE));
+}
+
+PHANTOM_TARGET("sse2")
+inline __m128i clampRound(__m128 scaled) {
+    // Zero NaN lanes (unordered with themselves) so NaN -> 0 like toS16()
+    scaled = _mm_and_ps(scaled, _mm_cmpord_ps(scaled, scaled));
+    scaled = _mm_max_ps(scaled, _mm_set1_ps(S16_MIN));
+    scaled = _mm_min_ps(scaled, _mm_set1_ps(S16_MAX));
+    return _mm_cvtps_epi32(scaled);
+}
+
+PHANTOM_TARGET("sse2")
+void floatToS16Sse2(const float* input, int16_t* output, size_t numSamples) {
+    const __m128 scale = _mm_set1_ps(S16_SCALE);
+    size_t i = 0;
+    for (; i + 8 <= numSamples; i += 8) {
+        const __m128i lo = clampRound(_mm_mul_ps(_mm_loadu_ps(input + i), scale));
+        const __m128i hi = clampRound(_mm_mul_ps(_mm_loadu_ps(input + i + 4), scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packs_epi32(lo, hi));
+    }
+    floatToS16Scalar(input + i, output + i, numSamples - i);
+}
+
+PHANTOM_TARGET("sse2")
+void floatToS16DitheredSse2(const float* input, int16_t* output, size_t numSamples, DitherState& dither) {
+    const __m128 scale = _mm_set1_ps(S16_SCALE);
+    __m128i state = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither.lanes));
+    size_t i = 0;
+    for (; i + 4 <= numSamples; i += 4) {
+        const __m128 a = uniformx4(xorshift32x4(state));
+        const __m128 b = uniformx4(xorshift32x4(state));
+        const __m128 scaled = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(input + i), scale), _mm_sub_ps(a, b));
+        const __m128i packed = _mm_packs_epi32(clampRound(scaled), _mm_setzero_si128());
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(output + i), packed);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dither.lanes), state);
+
+    // Tail samples use lanes 0..n-1, as in the scalar kernel
+    for (; i < numSamples; ++i) {
+        const float noise = tpdfNoise(dither.lanes[i & 3]);
+        output[i] = toS16(input[i] * S16_SCALE + noise);
+    }
+}
+
+PHANTOM_TARGET("sse2")
+void s16ToFloatSse2(const int16_t* input, float* output, size_t numSamples) {
+    const __m128 scale = _mm_set1_ps(S16_INV_SCALE);
+    size_t i = 0;
+    for (; i + 8 <= numSamples; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        // Sign-extend by unpacking into the high halves and shifting back
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    s16ToFloatScalar(input + i, output + i, numSamples - i);
+}
+
+PHANTOM_TARGET("sse2")
+void downmixStereoSse2(const float* input, float* output, size_t numFrames) {
+    const __m128 half = _mm_set1_ps(0.5f);
+    size_t i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        const __m128 a = _mm_loadu_ps(input + 2 * i);      // L0 R0 L1 R1
+        const __m128 b = _mm_loadu_ps(input + 2 * i + 4);  // L2 R2 L3 R3
+        const __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+    }
+    downmixToMonoScalar(input + 2 * i, output + i, numFrames - i, 2);
+}
+
+// ============================================================================
+// SSE4.1 kernels
+// ============================================================================
+
+PHANTOM_TARGET("sse4.1")
+void s16ToFloatSse41(const int16_t* input, float* output, size_t numSamples) {
+    const __m128 scale = _mm_set1_ps(S16_INV_SCALE);
+    size_t i = 0;
+    for (; i + 8 <= numSamples; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        const __m128i lo = _mm_cvtepi16_epi32(v);
+        const __m128i hi = _mm_cvtepi16_epi32(_mm_unpackhi_epi64(v, v));
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    s16ToFloatScalar(input + i, output + i, numSamples - i);
+}
+
+// ============================================================================
+// AVX2 kernels
+// ============================================================================
+
+PHANTOM_TARGET("avx2")
+inline __m256i clampRound8(__m256 scaled) {
+    scaled = _mm256_and_ps(scaled, _mm256_cmp_ps(scaled, scaled, _CMP_ORD_Q));
+    scaled = _mm256_max_ps(scaled, _mm256_set1_ps(S16_MIN));
+    scaled = _mm256_min_ps(scaled, _mm256_set1_ps(S16_MAX));
+    return _mm256_cvtps_epi32(scaled);
+}
+
+PHANTOM_TARGET("avx2")
+void floatToS16Avx2(const float* input, int16_t* output, size_t numSamples) {
+    const __m256 scale = _mm256_set1_ps(S16_SCALE);
+    size_t i = 0;
+    for (; i + 16 <= numSamples; i += 16) {
+        const __m256i lo = clampRound8(_mm256_mul_ps(_mm256_loadu_ps(input + i), scale));
+        const __m256i hi = clampRound8(_mm256_mul_ps(_mm256_loadu_ps(input + i + 8), scale));
+        // packs works per 128-bit lane; put the 64-bit quarters back in order
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), packed);
+    }
+    _mm256_zeroupper();  // The SSE tail would otherwise pay for dirty upper halves
+    floatToS16Sse2(input + i, output + i, numSamples - i);
+}
+
+PHANTOM_TARGET("avx2")
+void s16ToFloatAvx2(const int16_t* input, float* output, size_t numSamples) {
+    const __m256 scale = _mm256_set1_ps(S16_INV_SCALE);
+    size_t i = 0;
+    for (; i + 16 <= numSamples; i += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 8));
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(a)), scale));
+        _mm256_storeu_ps(output + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(b)), scale));
+    }
+    _mm256_zeroupper();
+    s16ToFloatSse41(input + i, output + i, numSamples - i);
+}
+
+PHANTOM_TARGET("avx2")
+void downmixStereoAvx2(const float* input, float* output, size_t numFrames) {
+    const __m256 half = _mm256_set1_ps(0.5f);
+    // Left samples to the low half, right samples to the high half
+    const __m256i split = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    size_t i = 0;
+    for (; i + 8 <= numFrames; i += 8) {
+        const __m256 a = _mm256_permutevar8x32_ps(_mm256_loadu_ps(input + 2 * i), split);
+        const __m256 b = _mm256_permutevar8x32_ps(_mm256_loadu_ps(input + 2 * i + 8), split);
+        const __m256 left = _mm256_permute2f128_ps(a, b, 0x20);
+        const __m256 right = _mm256_permute2f128_ps(a, b, 0x31);
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_add_ps(left, right), half));
+    }
+    _mm256_zeroupper();
+    downmixStereoSse2(input + 2 * i, output + i, numFrames - i);
+}
+
+#elif defined(PHANTOM_ARCH_ARM64)
+
+// ============================================================================
+// NEON kernels
+// ============================================================================
+
+inline uint32x4_t xorshift32x4(uint32x4_t& s) {
+    s = veorq_u32(s, vshlq_n_u32(s, 13));
+    s = veorq_u32(s, vshrq_n_u32(s, 17));
+    s = veorq_u32(s, vshlq_n_u32(s, 5));
+    return s;
+}
+
+inline float32x4_t uniformx4(uint32x4_t r) {
+    return vmulq_n_f32(vcvtq_f32_u32(vshrq_n_u32(r, 8)), UNIFORM_SCALE);
+}
+
+inline int32x4_t clampRound(float32x4_t scaled) {
+    // Zero NaN lanes (not equal to themselves) so NaN -> 0 like toS16()
+    scaled = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(scaled), vceqq_f32(scaled, scaled)));
+    scaled = vmaxq_f32(scaled, vdupq_n_f32(S16_MIN));
+    scaled = vminq_f32(scaled, vdupq_n_f32(S16_MAX));
+    return vcvtnq_s32_f32(scaled);
+}
+
+void floatToS16Neon(const float* input, int16_t* output, size_t numSamples) {
+    size_t i = 0;
+    for (; i + 4 <= numSamples; i += 4) {
+        const int32x4_t v = clampRound(vmulq_n_f32(vld1q_f32(input + i), S16_SCALE));
+        vst1_s16(output + i, vqmovn_s32(v));
+    }
+    floatToS16Scalar(input + i, output + i, numSamples - i);
+}
+
+void floatToS16DitheredNeon(const float* input, int16_t* output, size_t numSamples, DitherState& dither) {
+    uint32x4_t state = vld1q_u32(dither.lanes);
+    size_t i = 0;
+    for (; i + 4 <= numSamples; i += 4) {
+        const float32x4_t a = uniformx4(xorshift32x4(state));
+        const float32x4_t b = uniformx4(xorshift32x4(state));
+        const float32x4_t scaled = vaddq_f32(vmulq_n_f32(vld1q_f32(input + i), S16_SCALE), vsubq_f32(a, b));
+        vst1_s16(output + i, vqmovn_s32(clampRound(scaled)));
+    }
+    vst1q_u32(dither.lanes, state);
+
+    for (; i < numSamples; ++i) {
+        const float noise = tpdfNoise(dither.lanes[i & 3]);
+        output[i] = toS16(input[i] * S16_SCALE + noise);
+    }
+}
+
+void s16ToFloatNeon(const int16_t* input, float* output, size_t numSamples) {
+    size_t i = 0;
+    for (; i + 4 <= numSamples; i += 4) {
+        const int32x4_t v = vmovl_s16(vld1_s16(input + i));
+        vst1q_f32(output + i, vmulq_n_f32(vcvtq_f32_s32(v), S16_INV_SCALE));
+    }
+    s16ToFloatScalar(input + i, output + i, numSamples - i);
+}
+
+void downmixStereoNeon(const float* input, float* output, size_t numFrames) {
+    size_t i = 0;
+    for (; i + 4 <= numFrames; i += 4) {
+        const float32x4x2_t v = vld2q_f32(input + 2 * i);  // Deinterleaves L and R
+        vst1q_f32(output + i, vmulq_n_f32(vaddq_f32(v.val[0], v.val[1]), 0.5f));
+    }
+    downmixToMonoScalar(input + 2 * i, output + i, numFrames - i, 2);
+}
+
+#endif
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+struct Kernels {
+    SimdIsa isa = SimdIsa::Scalar;
+    FloatToS16Kernel floatToS16 = floatToS16Scalar;
+    DitheredKernel floatToS16Dithered = floatToS16DitheredScalar;
+    S16ToFloatKernel s16ToFloat = s16ToFloatScalar;
+    DownmixKernel downmixStereo = downmixStereoScalar;
+};
+
+Kernels kernelsFor(SimdIsa isa) {
+    Kernels k;
+    if (!isaSupported(isa)) return k;
+#if defined(PHANTOM_ARCH_X86)
+    switch (isa) {
+        case SimdIsa::AVX2:
+            k.floatToS16 = floatToS16Avx2;
+            k.floatToS16Dithered = floatToS16DitheredSse2;
+            k.s16ToFloat = s16ToFloatAvx2;
+            k.downmixStereo = downmixStereoAvx2;
+            break;
+        case SimdIsa::SSE41:
+            k.floatToS16 = floatToS16Sse2;
+            k.floatToS16Dithered = floatToS16DitheredSse2;
+            k.s16ToFloat = s16ToFloatSse41;
+            k.downmixStereo = downmixStereoSse2;
+            break;
+        case SimdIsa::SSSE3:
+        case SimdIsa::SSE2:
+            k.floatToS16 = floatToS16Sse2;
+            k.floatToS16Dithered = floatToS16DitheredSse2;
+            k.s16ToFloat = s16ToFloatSse2;
+            k.downmixStereo = downmixStereoSse2;
+            break;
+        default:
+            return k;
+    }
+    k.isa = isa;
+#elif defined(PHANTOM_ARCH_ARM64)
+    if (isa == SimdIsa::NEON) {
+        k.isa = isa;
+        k.floatToS16 = floatToS16Neon;
+        k.floatToS16Dithered = floatToS16DitheredNeon;
+        k.s16ToFloat = s16ToFloatNeon;
+        k.downmixStereo = downmixStereoNeon;
+    }
+#endif
+    return k;
+}
+
+const Kernels& defaultKernels() {
+    static const Kernels kernels = kernelsFor(preferredIsa());
+    return kernels;
+}
+
+void downmixWith(const Kernels& kernels, const float* input, float* output, size_t numFrames, uint16_t channels) {
+    if (channels == 2) {
+        kernels.downmixStereo(input, output, numFrames);
+    } else {
+        downmixToMonoScalar(input, output, numFrames, channels);
+    }
+}
+
+} // namespace
+
+void floatToS16(const float* input, int16_t* output, size_t numSamples) {
+    defaultKernels().floatToS16(input, output, numSamples);
+}
+
+void floatToS16(const float* input, int16_t* output, size_t numSamples, SimdIsa isa) {
+    kernelsFor(isa).floatToS16(input, output, numSamples);
+}
+
+void floatToS16Dithered(const float* input, int16_t* output, size_t numSamples, DitherState& dither) {
+    defaultKernels().floatToS16Dithered(input, output, numSamples, dither);
+}
+
+void floatToS16Dithered(const float* input, int16_t* output, size_t numSamples, DitherState& dither,
+                        SimdIsa isa) {
+    kernelsFor(isa).floatToS16Dithered(input, output, numSamples, dither);
+}
+
+void s16ToFloat(const int16_t* input, float* output, size_t numSamples) {
+    defaultKernels().s16ToFloat(input, output, numSamples);
+}
+
+void s16ToFloat(const int16_t* input, float* output, size_t numSamples, SimdIsa isa) {
+    kernelsFor(isa).s16ToFloat(input, output, numSamples);
+}
+
+void downmixToMono(const float* input, float* output, size_t numFrames, uint16_t channels) {
+    downmixWith(defaultKernels(), input, output, numFrames, channels);
+}
+
+void downmixToMono(const float* input, float* output, size_t numFrames, uint16_t channels, SimdIsa isa) {
+    downmixWith(kernelsFor(isa), input, output, numFrames, channels);
+}
+
+SimdIsa sampleFormatIsa() {
+    return defaultKernels().isa;
+}
+
+} // namespace phantom
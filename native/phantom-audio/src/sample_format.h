@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "cpu_features.h"
+
+namespace phantom {
+
+/**
+ * Sample representation used between capture and feature extraction.
+ *
+ * F32 is the original pipeline. S16 keeps audio as int16 in buffers, the
+ * shared ring and over IPC (half the memory and bandwidth) and converts to
+ * float only right before whisper. Full scale is 32768 in both directions,
+ * so s16ToFloat(floatToS16(x)) is within half an LSB of x for |x| < 1.
+ */
+enum class SampleFormat : uint8_t {
+    F32,
+    S16
+};
+
+// Wire/header name ("f32" or "s16")
+const char* sampleFormatName(SampleFormat format);
+
+// Parse "f32"/"s16" (case-sensitive); returns false for anything else
+bool parseSampleFormat(const std::string& name, SampleFormat* format);
+
+inline size_t bytesPerSample(SampleFormat format) {
+    return format == SampleFormat::S16 ? sizeof(int16_t) : sizeof(float);
+}
+
+/**
+ * State for TPDF dither. Four independent xorshift32 generators; sample i
+ * of a call uses generator i % 4, so the SIMD and scalar kernels produce
+ * identical output for the same seed.
+ */
+struct DitherState {
+    uint32_t lanes[4];
+
+    explicit DitherState(uint32_t seed = 0x9E3779B9u);
+};
+
+/*
+ * The converters below use the best kernels for this CPU, picked once at
+ * runtime; the SimdIsa overloads are for tests and benchmarks.
+ */
+
+// Round to nearest and saturate to [-32768, 32767]
+void floatToS16(const float* input, int16_t* output, size_t numSamples);
+void floatToS16(const float* input, int16_t* output, size_t numSamples, SimdIsa isa);
+
+// As floatToS16 with +/-1 LSB triangular dither added before rounding
+void floatToS16Dithered(const float* input, int16_t* output, size_t numSamples, DitherState& dither);
+void floatToS16Dithered(const float* input, int16_t* output, size_t numSamples, DitherState& dither,
+                        SimdIsa isa);
+
+// Exact conversion to [-1, 1)
+void s16ToFloat(const int16_t* input, float* output, size_t numSamples);
+void s16ToFloat(const int16_t* input, float* output, size_t numSamples, SimdIsa isa);
+
+// Average interleaved channels into one (stereo has SIMD kernels)
+void downmixToMono(const float* input, float* output, size_t numFrames, uint16_t channels);
+void downmixToMono(const float* input, float* output, size_t numFrames, uint16_t channels, SimdIsa isa);
+
+// Scalar reference implementations (the SIMD kernels must match these)
+void floatToS16Scalar(const float* input, int16_t* output, size_t numSamples);
+void floatToS16DitheredScalar(const float* input, int16_t* output, size_t numSamples, DitherState& dither);
+void s16ToFloatScalar(const int16_t* input, float* output, size_t numSamples);
+void downmixToMonoScalar(const float* input, float* output, size_t numFrames, uint16_t channels);
+
+// Level the default converters were bound for
+SimdIsa sampleFormatIsa();
+
+} // namespace phantom
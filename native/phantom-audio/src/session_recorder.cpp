@@ -0,0 +1,392 @@
+#include "session_recorder.h"
+#include "sample_format.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace phantom {
+
+namespace {
+
+const char SESSION_MAGIC[8] = {'P', 'H', 'S', 'E', 'S', 'S', 'N', '1'};
+
+// Samples start on a page boundary after the index
+constexpr uint64_t DATA_ALIGNMENT = 4096;
+
+uint64_t unixNowMs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                     std::chrono::system_clock::now().time_since_epoch())
+                                     .count());
+}
+
+uint64_t dataOffsetFor(uint32_t indexCapacity) {
+    const uint64_t end = sizeof(SessionFileHeader) + static_cast<uint64_t>(indexCapacity) * sizeof(SessionIndexEntry);
+    return (end + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+}
+
+bool seekTo(std::FILE* file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+} // namespace
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+SessionRecorder::~SessionRecorder() {
+    close();
+}
+
+bool SessionRecorder::create(const std::string& path, uint64_t capacitySamples, uint32_t sampleRate) {
+    close();
+
+    m_path = path;
+    m_dropped = 0;
+    const uint64_t dataOffset = dataOffsetFor(INDEX_CAPACITY);
+    const uint64_t size = dataOffset + capacitySamples * sizeof(int16_t);
+    m_mappedSize = static_cast<size_t>(size);
+
+    void* base = nullptr;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        m_lastError = "Failed to create session file: " + path;
+        return false;
+    }
+    m_file = file;
+
+    // Mapping past the end grows the file to its full size up front
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32),
+                                        static_cast<DWORD>(size & 0xFFFFFFFF), nullptr);
+    if (!mapping) {
+        m_lastError = "Failed to map session file: " + path;
+        close();
+        return false;
+    }
+    m_mapping = mapping;
+
+    base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, m_mappedSize);
+    if (!base) {
+        m_lastError = "Failed to map session file: " + path;
+        close();
+        return false;
+    }
+#else
+    int fd = ::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0600);
+    if (fd < 0) {
+        m_lastError = "Failed to create session file " + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    // Reserve the blocks now, so a full disk fails here and not as a
+    // fault on the capture thread; not every filesystem can
+    int rc = ENOTSUP;
+#ifdef __linux__
+    rc = posix_fallocate(fd, 0, static_cast<off_t>(size));
+#endif
+    if (rc != 0 && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        m_lastError = "Failed to size session file " + path + ": " + std::strerror(errno);
+        ::close(fd);
+        ::unlink(path.c_str());
+        return false;
+    }
+    base = mmap(nullptr, m_mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        m_lastError = std::string("mmap failed: ") + std::strerror(errno);
+        ::unlink(path.c_str());
+        return false;
+    }
+#endif
+
+    m_header = new (base) SessionFileHeader();
+    std::memcpy(m_header->magic, SESSION_MAGIC, sizeof(SESSION_MAGIC));
+    m_header->version = VERSION;
+    m_header->headerSize = sizeof(SessionFileHeader);
+    m_header->sampleRate = sampleRate;
+    m_header->channels = 1;
+    m_header->format = FORMAT_S16;
+    m_header->indexCapacity = INDEX_CAPACITY;
+    m_header->capacity = capacitySamples;
+    m_header->dataOffset = dataOffset;
+    m_header->createdUnixMs = unixNowMs();
+    m_header->samplesWritten.store(0, std::memory_order_release);
+    m_header->indexEntries.store(0, std::memory_order_release);
+    m_index = reinterpret_cast<SessionIndexEntry*>(static_cast<uint8_t*>(base) + sizeof(SessionFileHeader));
+    m_data = reinterpret_cast<int16_t*>(static_cast<uint8_t*>(base) + dataOffset);
+
+    std::cerr << "[SessionRecorder] Recording to " << path << " (" << capacitySamples / sampleRate / 60
+              << " min)" << std::endl;
+    return true;
+}
+
+std::string SessionRecorder::defaultPath() {
+    const std::time_t now = std::time(nullptr);
+    char name[64];
+    std::strftime(name, sizeof(name), "phantom-session-%Y%m%d-%H%M%S.phrec", std::localtime(&now));
+
+    std::error_code ec;
+    const std::filesystem::path dir = std::filesystem::temp_directory_path(ec);
+    return ec ? name : (dir / name).string();
+}
+
+uint64_t SessionRecorder::samplesWritten() const {
+    return m_header ? m_header->samplesWritten.load(std::memory_order_relaxed) : 0;
+}
+
+size_t SessionRecorder::reserve(size_t numSamples, uint64_t* first) {
+    const uint64_t written = m_header->samplesWritten.load(std::memory_order_relaxed);
+    const size_t fit = static_cast<size_t>(std::min<uint64_t>(numSamples, m_header->capacity - written));
+    m_dropped += numSamples - fit;
+    *first = written;
+    return fit;
+}
+
+void SessionRecorder::addEntry(SessionMark mark, uint64_t sample, uint64_t count) {
+    const uint32_t entries = m_header->indexEntries.load(std::memory_order_relaxed);
+    if (entries >= m_header->indexCapacity) return;  // The audio is still recorded
+
+    SessionIndexEntry& entry = m_index[entries];
+    entry.sample = sample;
+    entry.count = count;
+    entry.unixMs = unixNowMs();
+    entry.mark = static_cast<uint32_t>(mark);
+    entry.reserved = 0;
+    m_header->indexEntries.store(entries + 1, std::memory_order_release);
+}
+
+void SessionRecorder::markStart() {
+    if (!m_header) return;
+    addEntry(SessionMark::Start, m_header->samplesWritten.load(std::memory_order_relaxed), 0);
+}
+
+void SessionRecorder::write(const float* samples, size_t numSamples) {
+    if (!m_header || !samples || numSamples == 0) return;
+
+    uint64_t first;
+    const size_t fit = reserve(numSamples, &first);
+    floatToS16(samples, m_data + first, fit);
+    m_header->samplesWritten.store(first + fit, std::memory_order_release);
+}
+
+void SessionRecorder::write(const int16_t* samples, size_t numSamples) {
+    if (!m_header || !samples || numSamples == 0) return;
+
+    uint64_t first;
+    const size_t fit = reserve(numSamples, &first);
+    std::memcpy(m_data + first, samples, fit * sizeof(int16_t));
+    m_header->samplesWritten.store(first + fit, std::memory_order_release);
+}
+
+void SessionRecorder::writeSilence(size_t numSamples) {
+    if (!m_header || numSamples == 0) return;
+
+    uint64_t first;
+    const size_t fit = reserve(numSamples, &first);
+    if (fit == 0) return;
+
+    // Silence packets arrive one at a time; a run is one entry
+    const uint32_t entries = m_header->indexEntries.load(std::memory_order_relaxed);
+    SessionIndexEntry* last = entries > 0 ? &m_index[entries - 1] : nullptr;
+    if (last && last->mark == static_cast<uint32_t>(SessionMark::Silence) && last->sample + last->count == first) {
+        last->count += fit;
+    } else {
+        addEntry(SessionMark::Silence, first, fit);
+    }
+    m_header->samplesWritten.store(first + fit, std::memory_order_release);
+}
+
+// Samples first, then the header and index that point into them: each
+// sync returns once its pages are on disk, so what a flush publishes is
+// durable. The OS may also write pages back on its own, in any order, so
+// after a power cut the audio recorded since the last flush can read as
+// zeros and its index entries as blanks.
+void SessionRecorder::flush() {
+    if (!m_header) return;
+    uint8_t* base = reinterpret_cast<uint8_t*>(m_header);
+    const uint64_t dataOffset = m_header->dataOffset;
+    const uint64_t end = dataOffset + m_header->samplesWritten.load(std::memory_order_acquire) * sizeof(int16_t);
+#ifdef _WIN32
+    if (end > dataOffset) FlushViewOfFile(base + dataOffset, static_cast<SIZE_T>(end - dataOffset));
+    FlushFileBuffers(static_cast<HANDLE>(m_file));
+    FlushViewOfFile(base, static_cast<SIZE_T>(dataOffset));
+    FlushFileBuffers(static_cast<HANDLE>(m_file));
+#else
+    // dataOffset is only 4K-aligned; msync wants the system page size
+    const uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    const uint64_t from = dataOffset / page * page;
+    if (end > from) msync(base + from, static_cast<size_t>(end - from), MS_SYNC);
+    msync(base, static_cast<size_t>(dataOffset), MS_SYNC);
+#endif
+}
+
+void SessionRecorder::close() {
+    const uint64_t used = m_header
+        ? m_header->dataOffset + m_header->samplesWritten.load(std::memory_order_acquire) * sizeof(int16_t)
+        : 0;
+    if (m_header && m_dropped > 0) {
+        std::cerr << "[SessionRecorder] Segment full; " << m_dropped << " samples not recorded" << std::endl;
+    }
+
+#ifdef _WIN32
+    if (m_header) {
+        FlushViewOfFile(m_header, 0);
+        UnmapViewOfFile(m_header);
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+    if (m_file) {
+        if (used > 0) {
+            LARGE_INTEGER end;
+            end.QuadPart = static_cast<LONGLONG>(used);
+            if (SetFilePointerEx(m_file, end, nullptr, FILE_BEGIN)) SetEndOfFile(m_file);
+        }
+        CloseHandle(m_file);
+        m_file = nullptr;
+    }
+#else
+    if (m_header) {
+        msync(m_header, m_mappedSize, MS_SYNC);
+        munmap(m_header, m_mappedSize);
+        if (truncate(m_path.c_str(), static_cast<off_t>(used)) != 0) {
+            std::cerr << "[SessionRecorder] Could not trim " << m_path << ": " << std::strerror(errno) << std::endl;
+        }
+    }
+#endif
+    m_header = nullptr;
+    m_index = nullptr;
+    m_data = nullptr;
+    m_mappedSize = 0;
+}
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+SessionReader::~SessionReader() {
+    close();
+}
+
+bool SessionReader::isSessionFile(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    char magic[sizeof(SESSION_MAGIC)];
+    const bool match = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                       std::memcmp(magic, SESSION_MAGIC, sizeof(magic)) == 0;
+    std::fclose(file);
+    return match;
+}
+
+bool SessionReader::open(const std::string& path) {
+    close();
+
+    m_file = std::fopen(path.c_str(), "rb");
+    if (!m_file) {
+        m_lastError = "Cannot open session file: " + path;
+        return false;
+    }
+
+    alignas(SessionFileHeader) unsigned char raw[sizeof(SessionFileHeader)];
+    if (std::fread(raw, 1, sizeof(raw), m_file) != sizeof(raw)) {
+        m_lastError = "Session file is truncated: " + path;
+        close();
+        return false;
+    }
+    // The index and data areas must lie within the file, so a damaged
+    // header cannot size the index beyond what is there to read
+    std::error_code ec;
+    const uint64_t fileSize = std::filesystem::file_size(path, ec);
+    const SessionFileHeader* header = reinterpret_cast<const SessionFileHeader*>(raw);
+    if (ec || std::memcmp(header->magic, SESSION_MAGIC, sizeof(SESSION_MAGIC)) != 0 ||
+        header->version != SessionRecorder::VERSION || header->format != SessionRecorder::FORMAT_S16 ||
+        header->channels != 1 || header->sampleRate == 0 ||
+        header->dataOffset < dataOffsetFor(header->indexCapacity) || header->dataOffset > fileSize) {
+        m_lastError = "Not a supported session file: " + path;
+        close();
+        return false;
+    }
+
+    m_sampleRate = header->sampleRate;
+    m_dataOffset = header->dataOffset;
+    m_createdUnixMs = header->createdUnixMs;
+    m_samples = std::min({header->samplesWritten.load(std::memory_order_relaxed), header->capacity,
+                          (fileSize - header->dataOffset) / sizeof(int16_t)});
+
+    const uint32_t entries = std::min(header->indexEntries.load(std::memory_order_relaxed), header->indexCapacity);
+    m_entries.resize(entries);
+    if (entries > 0 && std::fread(m_entries.data(), sizeof(SessionIndexEntry), entries, m_file) != entries) {
+        m_lastError = "Session index is truncated: " + path;
+        close();
+        return false;
+    }
+
+    // An entry extended after the last published sample ends there; one the
+    // disk never received (power cut before a flush) is blank and dropped
+    for (SessionIndexEntry& entry : m_entries) {
+        entry.sample = std::min(entry.sample, m_samples);
+        entry.count = std::min(entry.count, m_samples - entry.sample);
+    }
+    m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(),
+                                   [](const SessionIndexEntry& entry) {
+                                       return entry.mark != static_cast<uint32_t>(SessionMark::Start) &&
+                                              entry.mark != static_cast<uint32_t>(SessionMark::Silence);
+                                   }),
+                    m_entries.end());
+    return true;
+}
+
+void SessionReader::close() {
+    if (m_file) {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+    m_samples = 0;
+    m_entries.clear();
+}
+
+bool SessionReader::read(uint64_t start, uint64_t end, std::vector<float>& out) {
+    out.clear();
+    if (!m_file) {
+        m_lastError = "No session file open";
+        return false;
+    }
+    end = std::min(end, m_samples);
+    if (start >= end) return true;
+
+    const size_t count = static_cast<size_t>(end - start);
+    m_raw.resize(count);
+    if (!seekTo(m_file, m_dataOffset + start * sizeof(int16_t)) ||
+        std::fread(m_raw.data(), sizeof(int16_t), count, m_file) != count) {
+        m_lastError = "Session audio is truncated";
+        return false;
+    }
+    out.resize(count);
+    s16ToFloat(m_raw.data(), out.data(), count);
+    return true;
+}
+
+} // namespace phantom
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace phantom {
+
+/**
+ * Layout of a session recording (.phrec). The header is followed by an
+ * index of `indexCapacity` entries, then, from `dataOffset`, room for
+ * `capacity` int16 samples of the 16kHz mono stream. Digital silence is
+ * recorded as zeros, so sample n of the file is sample n of the session.
+ *
+ * The file is preallocated and written through a memory mapping. Samples
+ * and index entries are written before the counter that publishes them is
+ * advanced (release), so whatever the process dies doing, the file holds
+ * a consistent recording of the first samplesWritten samples. A power cut
+ * only keeps what SessionRecorder::flush() wrote to disk for certain.
+ */
+struct SessionFileHeader {
+    char magic[8];                          // "PHSESSN1"
+    uint32_t version;                       // SessionRecorder::VERSION
+    uint32_t headerSize;                    // sizeof(SessionFileHeader)
+    uint32_t sampleRate;                    // 16000
+    uint32_t channels;                      // 1
+    uint32_t format;                        // 2 = int16
+    uint32_t indexCapacity;                 // Entries in the index area
+    uint64_t capacity;                      // Samples the data area holds
+    uint64_t dataOffset;                    // File offset of sample 0
+    uint64_t createdUnixMs;
+    std::atomic<uint64_t> samplesWritten;   // Samples recorded so far
+    std::atomic<uint32_t> indexEntries;     // Index entries written so far
+    uint32_t reserved0;
+    uint8_t reserved[56];
+};
+
+static_assert(sizeof(SessionFileHeader) == 128, "session header must stay 128 bytes");
+
+enum class SessionMark : uint32_t {
+    Start = 1,      // Capture (re)started at `unixMs`
+    Silence = 2     // `count` samples of digital silence
+};
+
+struct SessionIndexEntry {
+    uint64_t sample;    // Where the entry begins
+    uint64_t count;     // Samples covered (0 for Start)
+    uint64_t unixMs;    // Wall clock when it began
+    uint32_t mark;      // SessionMark
+    uint32_t reserved;
+};
+
+static_assert(sizeof(SessionIndexEntry) == 32, "session index entries must stay 32 bytes");
+
+/**
+ * Records the 16kHz stream to a preallocated, memory-mapped segment file,
+ * for recovery after a crash and for re-transcribing later (for instance
+ * with a larger model, via --transcribe). Writing is a copy into mapped
+ * memory: the writer makes no system calls. A full segment stops
+ * recording; the samples that did not fit are counted.
+ */
+class SessionRecorder {
+public:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t FORMAT_S16 = 2;
+    static constexpr uint32_t INDEX_CAPACITY = 4096;
+
+    SessionRecorder() = default;
+    ~SessionRecorder();
+
+    SessionRecorder(const SessionRecorder&) = delete;
+    SessionRecorder& operator=(const SessionRecorder&) = delete;
+
+    /**
+     * Create (or replace) the segment file
+     * @param capacitySamples Samples the file has room for
+     */
+    bool create(const std::string& path, uint64_t capacitySamples, uint32_t sampleRate = 16000);
+
+    // Note that capture (re)started now
+    void markStart();
+
+    // Append samples (converted to int16)
+    void write(const float* samples, size_t numSamples);
+    void write(const int16_t* samples, size_t numSamples);
+
+    // Append digital silence; the preallocated file already holds the zeros
+    void writeSilence(size_t numSamples);
+
+    // Write the samples, then the index, to disk; blocks, so not from the capture thread
+    void flush();
+
+    // Flush, then shrink the file to what was recorded
+    void close();
+
+    // Per-process default path in the temp directory
+    static std::string defaultPath();
+
+    bool isOpen() const { return m_header != nullptr; }
+    const std::string& getPath() const { return m_path; }
+    uint64_t samplesWritten() const;
+    uint64_t droppedSamples() const { return m_dropped; }
+    const std::string& getLastError() const { return m_lastError; }
+
+private:
+    // Claim room for up to numSamples; returns the first sample and the count that fits
+    size_t reserve(size_t numSamples, uint64_t* first);
+    void addEntry(SessionMark mark, uint64_t sample, uint64_t count);
+
+    SessionFileHeader* m_header = nullptr;
+    SessionIndexEntry* m_index = nullptr;
+    int16_t* m_data = nullptr;
+    size_t m_mappedSize = 0;
+    uint64_t m_dropped = 0;
+    std::string m_path;
+    std::string m_lastError;
+
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+};
+
+/**
+ * Reads a session recording, including one still being written or left
+ * behind by a crash: only samples and entries already published count.
+ */
+class SessionReader {
+public:
+    SessionReader() = default;
+    ~SessionReader();
+
+    SessionReader(const SessionReader&) = delete;
+    SessionReader& operator=(const SessionReader&) = delete;
+
+    // Whether `path` starts like a session recording
+    static bool isSessionFile(const std::string& path);
+
+    bool open(const std::string& path);
+    void close();
+
+    /**
+     * Samples [start, end) as float, clamped to what was recorded
+     * @return false (see getLastError) if the file could not be read
+     */
+    bool read(uint64_t start, uint64_t end, std::vector<float>& out);
+
+    uint64_t samples() const { return m_samples; }
+    uint32_t sampleRate() const { return m_sampleRate; }
+    uint64_t createdUnixMs() const { return m_createdUnixMs; }
+    const std::vector<SessionIndexEntry>& entries() const { return m_entries; }
+    const std::string& getLastError() const { return m_lastError; }
+
+private:
+    std::FILE* m_file = nullptr;
+    uint64_t m_samples = 0;
+    uint64_t m_dataOffset = 0;
+    uint32_t m_sampleRate = 0;
+    uint64_t m_createdUnixMs = 0;
+    std::vector<SessionIndexEntry> m_entries;
+    std::vector<int16_t> m_raw;
+    std::string m_lastError;
+};
+
+} // namespace phantom
@@ -0,0 +1,454 @@
+#include "shared_audio_ring.h"
+#include <iostream>
+#include <cstring>
+#include <new>
+#include <algorithm>
+#include <climits>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <thread>
+#include <chrono>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <ctime>
+#endif
+#endif
+
+namespace phantom {
+
+static const char RING_MAGIC[8] = {'P', 'H', 'A', 'U', 'R', 'I', 'N', 'G'};
+
+static uint32_t headerFormat(SampleFormat format) {
+    return format == SampleFormat::S16 ? SharedAudioRing::FORMAT_S16 : SharedAudioRing::FORMAT_F32;
+}
+
+static uint32_t roundUpPow2(uint32_t value) {
+    uint32_t result = 1;
+    while (result < value && result < (1u << 31)) {
+        result <<= 1;
+    }
+    return result;
+}
+
+#ifdef _WIN32
+static std::string mappingName(const std::string& name) {
+    return "Local\\" + name;
+}
+
+static std::string eventName(const std::string& name) {
+    return "Local\\" + name + "-notify";
+}
+#endif
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+SharedAudioRing::~SharedAudioRing() {
+    close();
+}
+
+bool SharedAudioRing::create(const std::string& name, uint32_t capacitySamples, uint32_t sampleRate,
+                             SampleFormat format) {
+    close();
+
+    m_name = name;
+    m_format = format;
+    m_capacity = roundUpPow2(std::max<uint32_t>(capacitySamples, 1024));
+    m_mappedSize = sizeof(SharedAudioRingHeader) + static_cast<size_t>(m_capacity) * bytesPerSample(format);
+
+    void* base = nullptr;
+
+#ifdef _WIN32
+    char tempDir[MAX_PATH] = {0};
+    DWORD len = GetTempPathA(MAX_PATH, tempDir);
+    if (len == 0 || len > MAX_PATH) {
+        m_lastError = "Failed to resolve temp directory";
+        return false;
+    }
+    m_path = std::string(tempDir) + name + ".ring";
+
+    // Temporary + delete-on-close keeps the pages in the cache and removes
+    // the file when the last handle goes away
+    HANDLE file = CreateFileA(m_path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        m_lastError = "Failed to create ring file: " + m_path;
+        return false;
+    }
+    m_file = file;
+
+    const uint64_t size = m_mappedSize;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(size >> 32), static_cast<DWORD>(size & 0xFFFFFFFF),
+                                        mappingName(name).c_str());
+    if (!mapping) {
+        m_lastError = "Failed to create file mapping: " + name;
+        close();
+        return false;
+    }
+    m_mapping = mapping;
+
+    base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, m_mappedSize);
+    if (!base) {
+        m_lastError = "Failed to map ring: " + name;
+        close();
+        return false;
+    }
+
+    // Auto-reset: a publish with no reader waiting stays signaled until the
+    // next wait instead of being lost
+    m_event = CreateEventA(nullptr, FALSE, FALSE, eventName(name).c_str());
+#else
+    const std::string shmName = "/" + name;
+    shm_unlink(shmName.c_str());
+    int fd = shm_open(shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        m_lastError = "shm_open failed for " + shmName + ": " + std::strerror(errno);
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(m_mappedSize)) != 0) {
+        m_lastError = std::string("ftruncate failed: ") + std::strerror(errno);
+        ::close(fd);
+        shm_unlink(shmName.c_str());
+        return false;
+    }
+    base = mmap(nullptr, m_mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        m_lastError = std::string("mmap failed: ") + std::strerror(errno);
+        shm_unlink(shmName.c_str());
+        return false;
+    }
+#ifdef __linux__
+    m_path = "/dev/shm/" + name;
+#endif
+#endif
+
+    m_header = new (base) SharedAudioRingHeader();
+    std::memcpy(m_header->magic, RING_MAGIC, sizeof(RING_MAGIC));
+    m_header->version = VERSION;
+    m_header->headerSize = sizeof(SharedAudioRingHeader);
+    m_header->sampleRate = sampleRate;
+    m_header->channels = 1;
+    m_header->capacity = m_capacity;
+    m_header->format = headerFormat(format);
+    m_header->writeSeq.store(0, std::memory_order_release);
+    m_header->claimSeq.store(0, std::memory_order_release);
+    m_header->notifySeq.store(0, std::memory_order_release);
+#ifdef _WIN32
+    m_header->writerPid = static_cast<uint32_t>(GetCurrentProcessId());
+#else
+    m_header->writerPid = static_cast<uint32_t>(getpid());
+#endif
+    m_data = reinterpret_cast<uint8_t*>(base) + sizeof(SharedAudioRingHeader);
+
+    std::cerr << "[SharedAudioRing] Created " << name << " (" << m_capacity << " "
+              << sampleFormatName(format) << " samples)" << std::endl;
+    return true;
+}
+
+std::string SharedAudioRing::defaultName() {
+#ifdef _WIN32
+    return "phantom-audio-" + std::to_string(GetCurrentProcessId());
+#else
+    return "phantom-audio-" + std::to_string(getpid());
+#endif
+}
+
+void SharedAudioRing::write(const float* samples, size_t numSamples) {
+    if (!m_header || !samples || numSamples == 0) return;
+
+    if (m_format == SampleFormat::F32) {
+        writeRaw(reinterpret_cast<const uint8_t*>(samples), numSamples);
+        return;
+    }
+    m_convertBuffer.resize(numSamples * sizeof(int16_t));
+    int16_t* converted = reinterpret_cast<int16_t*>(m_convertBuffer.data());
+    floatToS16(samples, converted, numSamples);
+    writeRaw(m_convertBuffer.data(), numSamples);
+}
+
+void SharedAudioRing::write(const int16_t* samples, size_t numSamples) {
+    if (!m_header || !samples || numSamples == 0) return;
+
+    if (m_format == SampleFormat::S16) {
+        writeRaw(reinterpret_cast<const uint8_t*>(samples), numSamples);
+        return;
+    }
+    m_convertBuffer.resize(numSamples * sizeof(float));
+    float* converted = reinterpret_cast<float*>(m_convertBuffer.data());
+    s16ToFloat(samples, converted, numSamples);
+    writeRaw(m_convertBuffer.data(), numSamples);
+}
+
+void SharedAudioRing::writeRaw(const uint8_t* samples, size_t numSamples) {
+    const size_t sampleBytes = bytesPerSample(m_format);
+
+    // Only the most recent `capacity` samples can survive anyway
+    uint64_t seq = m_header->writeSeq.load(std::memory_order_relaxed);
+    if (numSamples > m_capacity) {
+        samples += (numSamples - m_capacity) * sampleBytes;
+        seq += numSamples - m_capacity;
+        numSamples = m_capacity;
+    }
+
+    // Claim the range before touching it, so a reader that copies any of
+    // the new bytes also sees the claim when it re-checks
+    m_header->claimSeq.store(seq + numSamples, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const size_t mask = m_capacity - 1;
+    const size_t start = static_cast<size_t>(seq) & mask;
+    const size_t first = std::min(numSamples, static_cast<size_t>(m_capacity) - start);
+
+    std::memcpy(m_data + start * sampleBytes, samples, first * sampleBytes);
+    if (first < numSamples) {
+        std::memcpy(m_data, samples + first * sampleBytes, (numSamples - first) * sampleBytes);
+    }
+
+    m_header->writeSeq.store(seq + numSamples, std::memory_order_release);
+    m_header->notifySeq.fetch_add(1, std::memory_order_release);
+    notifyReaders();
+}
+
+void SharedAudioRing::notifyReaders() {
+#ifdef _WIN32
+    // Releases one waiting reader, or the next one to wait. Readers wait
+    // with a timeout and re-check writeSeq, so others are only delayed.
+    if (m_event) {
+        SetEvent(m_event);
+    }
+#elif defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_header->notifySeq), FUTEX_WAKE, INT_MAX,
+            nullptr, nullptr, 0);
+#endif
+}
+
+void SharedAudioRing::close() {
+#ifdef _WIN32
+    if (m_header) {
+        UnmapViewOfFile(m_header);
+    }
+    if (m_event) {
+        CloseHandle(m_event);
+        m_event = nullptr;
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+    if (m_file) {
+        CloseHandle(m_file);
+        m_file = nullptr;
+    }
+#else
+    if (m_header) {
+        munmap(m_header, m_mappedSize);
+        shm_unlink(("/" + m_name).c_str());
+    }
+#endif
+    m_header = nullptr;
+    m_data = nullptr;
+    m_mappedSize = 0;
+}
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+SharedAudioRingReader::~SharedAudioRingReader() {
+    close();
+}
+
+bool SharedAudioRingReader::open(const std::string& name) {
+    close();
+
+    const void* base = nullptr;
+
+#ifdef _WIN32
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, mappingName(name).c_str());
+    if (!mapping) {
+        m_lastError = "Failed to open ring: " + name;
+        return false;
+    }
+    m_mapping = mapping;
+
+    // Map the header first to learn the full size
+    const void* headerView = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(SharedAudioRingHeader));
+    if (!headerView) {
+        m_lastError = "Failed to map ring header: " + name;
+        close();
+        return false;
+    }
+    const uint32_t capacity = static_cast<const SharedAudioRingHeader*>(headerView)->capacity;
+    const uint32_t format = static_cast<const SharedAudioRingHeader*>(headerView)->format;
+    UnmapViewOfFile(headerView);
+
+    const size_t sampleBytes = format == SharedAudioRing::FORMAT_S16 ? sizeof(int16_t) : sizeof(float);
+    m_mappedSize = sizeof(SharedAudioRingHeader) + static_cast<size_t>(capacity) * sampleBytes;
+    base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, m_mappedSize);
+    m_event = OpenEventA(SYNCHRONIZE, FALSE, eventName(name).c_str());
+#else
+    int fd = shm_open(("/" + name).c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        m_lastError = "Failed to open ring " + name + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SharedAudioRingHeader)) {
+        m_lastError = "Ring " + name + " is truncated";
+        ::close(fd);
+        return false;
+    }
+    m_mappedSize = static_cast<size_t>(st.st_size);
+    void* mapped = mmap(nullptr, m_mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped != MAP_FAILED) {
+        base = mapped;
+    }
+#endif
+
+    if (!base) {
+        m_lastError = "Failed to map ring: " + name;
+        close();
+        return false;
+    }
+
+    m_header = static_cast<const SharedAudioRingHeader*>(base);
+    if (std::memcmp(m_header->magic, RING_MAGIC, sizeof(RING_MAGIC)) != 0 ||
+        m_header->version != SharedAudioRing::VERSION ||
+        (m_header->format != SharedAudioRing::FORMAT_F32 && m_header->format != SharedAudioRing::FORMAT_S16)) {
+        m_lastError = "Ring " + name + " has an unsupported layout";
+        close();
+        return false;
+    }
+
+    m_capacity = m_header->capacity;
+    m_format = m_header->format == SharedAudioRing::FORMAT_S16 ? SampleFormat::S16 : SampleFormat::F32;
+    m_data = reinterpret_cast<const uint8_t*>(base) + m_header->headerSize;
+    m_readSeq = m_header->writeSeq.load(std::memory_order_acquire);
+    return true;
+}
+
+void SharedAudioRingReader::close() {
+#ifdef _WIN32
+    if (m_header) {
+        UnmapViewOfFile(m_header);
+    }
+    if (m_event) {
+        CloseHandle(m_event);
+        m_event = nullptr;
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+#else
+    if (m_header) {
+        munmap(const_cast<SharedAudioRingHeader*>(m_header), m_mappedSize);
+    }
+#endif
+    m_header = nullptr;
+    m_data = nullptr;
+    m_mappedSize = 0;
+}
+
+size_t SharedAudioRingReader::read(float* dst, size_t maxSamples, uint64_t* dropped) {
+    if (dropped) *dropped = 0;
+    if (!m_header || !dst || maxSamples == 0) return 0;
+
+    if (m_format == SampleFormat::F32) {
+        return readRaw(reinterpret_cast<uint8_t*>(dst), maxSamples, dropped);
+    }
+    m_convertBuffer.resize(maxSamples * sizeof(int16_t));
+    const size_t count = readRaw(m_convertBuffer.data(), maxSamples, dropped);
+    s16ToFloat(reinterpret_cast<const int16_t*>(m_convertBuffer.data()), dst, count);
+    return count;
+}
+
+size_t SharedAudioRingReader::read(int16_t* dst, size_t maxSamples, uint64_t* dropped) {
+    if (dropped) *dropped = 0;
+    if (!m_header || !dst || maxSamples == 0) return 0;
+
+    if (m_format == SampleFormat::S16) {
+        return readRaw(reinterpret_cast<uint8_t*>(dst), maxSamples, dropped);
+    }
+    m_convertBuffer.resize(maxSamples * sizeof(float));
+    const size_t count = readRaw(m_convertBuffer.data(), maxSamples, dropped);
+    floatToS16(reinterpret_cast<const float*>(m_convertBuffer.data()), dst, count);
+    return count;
+}
+
+size_t SharedAudioRingReader::readRaw(uint8_t* dst, size_t maxSamples, uint64_t* dropped) {
+    uint64_t writeSeq = m_header->writeSeq.load(std::memory_order_acquire);
+    if (writeSeq - m_readSeq > m_capacity) {
+        // Fell behind; skip to the oldest sample still in the ring
+        if (dropped) *dropped = writeSeq - m_capacity - m_readSeq;
+        m_readSeq = writeSeq - m_capacity;
+    }
+
+    const size_t available = static_cast<size_t>(writeSeq - m_readSeq);
+    const size_t count = std::min(available, maxSamples);
+    if (count == 0) return 0;
+
+    const size_t mask = m_capacity - 1;
+    const size_t start = static_cast<size_t>(m_readSeq) & mask;
+    const size_t first = std::min(count, static_cast<size_t>(m_capacity) - start);
+    const size_t sampleBytes = bytesPerSample(m_format);
+    std::memcpy(dst, m_data + start * sampleBytes, first * sampleBytes);
+    if (first < count) {
+        std::memcpy(dst + first * sampleBytes, m_data, (count - first) * sampleBytes);
+    }
+
+    // Validate: no write, even one still in progress, may have reached the
+    // range we just copied
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t claimed = m_header->claimSeq.load(std::memory_order_relaxed);
+    if (claimed - m_readSeq > m_capacity) {
+        const uint64_t oldest = claimed - m_capacity;
+        if (dropped) *dropped += oldest - m_readSeq;
+        m_readSeq = oldest;
+        return 0;
+    }
+
+    m_readSeq += count;
+    return count;
+}
+
+bool SharedAudioRingReader::wait(int timeoutMs) {
+    if (!m_header) return false;
+    if (m_header->writeSeq.load(std::memory_order_acquire) != m_readSeq) return true;
+
+#ifdef _WIN32
+    if (m_event) {
+        WaitForSingleObject(m_event, static_cast<DWORD>(timeoutMs));
+    } else {
+        Sleep(static_cast<DWORD>(std::min(timeoutMs, 10)));
+    }
+#elif defined(__linux__)
+    const uint32_t observed = m_header->notifySeq.load(std::memory_order_acquire);
+    if (m_header->writeSeq.load(std::memory_order_acquire) != m_readSeq) return true;
+    struct timespec ts;
+    ts.tv_sec = timeoutMs / 1000;
+    ts.tv_nsec = static_cast<long>(timeoutMs % 1000) * 1000000L;
+    syscall(SYS_futex, const_cast<uint32_t*>(reinterpret_cast<const uint32_t*>(&m_header->notifySeq)),
+            FUTEX_WAIT, observed, &ts, nullptr, 0);
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(std::min(timeoutMs, 10)));
+#endif
+
+    return m_header->writeSeq.load(std::memory_order_acquire) != m_readSeq;
+}
+
+} // namespace phantom
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "sample_format.h"
+
+namespace phantom {
+
+/**
+ * Layout of the shared audio ring. The header is followed directly by
+ * `capacity` samples (capacity is a power of two) in the header's format.
+ *
+ * Writes follow a seqlock: the writer first claims the range it is about
+ * to overwrite by advancing claimSeq, then copies the samples, then
+ * publishes them by advancing writeSeq (release). Readers keep their own
+ * read sequence, copy [readSeq, writeSeq) and re-check claimSeq afterwards:
+ * if a write that had begun, finished or not, reaches more than `capacity`
+ * past the start of the copied range, part of the copy may be torn and it
+ * is discarded. notifySeq is bumped after every publish and is used as the
+ * futex word on Linux.
+ */
+struct SharedAudioRingHeader {
+    char magic[8];                      // "PHAURING"
+    uint32_t version;                   // SharedAudioRing::VERSION
+    uint32_t headerSize;                // sizeof(SharedAudioRingHeader)
+    uint32_t sampleRate;                // 16000
+    uint32_t channels;                  // 1
+    uint32_t capacity;                  // samples in the data area
+    uint32_t format;                    // 1 = float32, 2 = int16
+    std::atomic<uint64_t> writeSeq;     // total samples ever published
+    std::atomic<uint32_t> notifySeq;    // incremented on every publish
+    uint32_t writerPid;
+    std::atomic<uint64_t> claimSeq;     // end of the write in progress (== writeSeq when idle)
+    uint8_t reserved[8];
+};
+
+static_assert(sizeof(SharedAudioRingHeader) == 64, "ring header must stay 64 bytes");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring needs address-free 64-bit atomics");
+
+/**
+ * Single-writer, multi-reader ring of 16kHz mono audio in shared memory.
+ *
+ * POSIX: a shm_open() object (readable as /dev/shm/<name> on Linux).
+ * Windows: a named file mapping backed by a temporary file, so consumers
+ * that cannot map memory (e.g. Node) can still read it by path.
+ */
+class SharedAudioRing {
+public:
+    static constexpr uint32_t VERSION = 2;
+    static constexpr uint32_t FORMAT_F32 = 1;
+    static constexpr uint32_t FORMAT_S16 = 2;
+
+    SharedAudioRing() = default;
+    ~SharedAudioRing();
+
+    SharedAudioRing(const SharedAudioRing&) = delete;
+    SharedAudioRing& operator=(const SharedAudioRing&) = delete;
+
+    /**
+     * Create the ring
+     * @param name Object name (no slashes)
+     * @param capacitySamples Rounded up to a power of two
+     * @param sampleRate Sample rate written to the header
+     * @param format Sample format stored in the ring
+     */
+    bool create(const std::string& name, uint32_t capacitySamples, uint32_t sampleRate = 16000,
+                SampleFormat format = SampleFormat::F32);
+
+    /**
+     * Publish samples and wake waiting readers. Never blocks; readers that
+     * fall more than `capacity` behind lose data. Samples are converted if
+     * they do not match the ring's format.
+     */
+    void write(const float* samples, size_t numSamples);
+    void write(const int16_t* samples, size_t numSamples);
+
+    void close();
+
+    // Per-process default object name ("phantom-audio-<pid>")
+    static std::string defaultName();
+
+    bool isOpen() const { return m_header != nullptr; }
+    const std::string& getName() const { return m_name; }
+    // Filesystem path of the backing object, empty if it has none
+    const std::string& getPath() const { return m_path; }
+    uint32_t getCapacity() const { return m_capacity; }
+    SampleFormat getFormat() const { return m_format; }
+    const std::string& getLastError() const { return m_lastError; }
+
+private:
+    void writeRaw(const uint8_t* samples, size_t numSamples);
+    void notifyReaders();
+
+    SharedAudioRingHeader* m_header = nullptr;
+    uint8_t* m_data = nullptr;
+    size_t m_mappedSize = 0;
+    uint32_t m_capacity = 0;
+    SampleFormat m_format = SampleFormat::F32;
+    std::vector<uint8_t> m_convertBuffer;
+    std::string m_name;
+    std::string m_path;
+    std::string m_lastError;
+
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+    void* m_event = nullptr;
+#endif
+};
+
+/**
+ * Reader side of SharedAudioRing for native consumers
+ */
+class SharedAudioRingReader {
+public:
+    SharedAudioRingReader() = default;
+    ~SharedAudioRingReader();
+
+    SharedAudioRingReader(const SharedAudioRingReader&) = delete;
+    SharedAudioRingReader& operator=(const SharedAudioRingReader&) = delete;
+
+    // Open an existing ring; reading starts at the current write position
+    bool open(const std::string& name);
+    void close();
+
+    /**
+     * Copy up to maxSamples new samples into dst, converting from the
+     * ring's format if needed
+     * @param dropped Receives the number of samples lost to overruns
+     * @return Number of samples copied
+     */
+    size_t read(float* dst, size_t maxSamples, uint64_t* dropped = nullptr);
+    size_t read(int16_t* dst, size_t maxSamples, uint64_t* dropped = nullptr);
+
+    // Block until new samples are published or the timeout expires
+    bool wait(int timeoutMs);
+
+    uint64_t getReadSequence() const { return m_readSeq; }
+    SampleFormat getFormat() const { return m_format; }
+    const std::string& getLastError() const { return m_lastError; }
+
+private:
+    size_t readRaw(uint8_t* dst, size_t maxSamples, uint64_t* dropped);
+
+    const SharedAudioRingHeader* m_header = nullptr;
+    const uint8_t* m_data = nullptr;
+    size_t m_mappedSize = 0;
+    uint32_t m_capacity = 0;
+    SampleFormat m_format = SampleFormat::F32;
+    std::vector<uint8_t> m_convertBuffer;
+    uint64_t m_readSeq = 0;
+    std::string m_lastError;
+
+#ifdef _WIN32
+    void* m_mapping = nullptr;
+    void* m_event = nullptr;
+#endif
+};
+
+} // namespace phantom
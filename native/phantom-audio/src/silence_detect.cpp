@@ -0,0 +1,209 @@
+#include "silence_detect.h"
+
+#include <cmath>
+
+#if defined(PHANTOM_ARCH_X86)
+#include <immintrin.h>
+#elif defined(PHANTOM_ARCH_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace phantom {
+
+namespace {
+
+using SilentF32Kernel = bool (*)(const float* samples, size_t numSamples, float floor);
+using SilentS16Kernel = bool (*)(const int16_t* samples, size_t numSamples, int16_t floor);
+
+// ============================================================================
+// Scalar kernels
+// ============================================================================
+
+bool isSilentF32Scalar(const float* samples, size_t numSamples, float floor) {
+    for (size_t i = 0; i < numSamples; ++i) {
+        // Written so NaN fails the test
+        if (!(std::fabs(samples[i]) <= floor)) return false;
+    }
+    return true;
+}
+
+bool isSilentS16Scalar(const int16_t* samples, size_t numSamples, int16_t floor) {
+    const int32_t limit = floor;
+    for (size_t i = 0; i < numSamples; ++i) {
+        const int32_t s = samples[i];
+        if (s > limit || s < -limit) return false;
+    }
+    return true;
+}
+
+#if defined(PHANTOM_ARCH_X86)
+
+// ============================================================================
+// SSE2 kernels
+// ============================================================================
+
+PHANTOM_TARGET("sse2")
+bool isSilentF32Sse2(const float* samples, size_t numSamples, float floor) {
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 limit = _mm_set1_ps(floor);
+    size_t i = 0;
+    for (; i + 8 <= numSamples; i += 8) {
+        const __m128 a = _mm_and_ps(_mm_loadu_ps(samples + i), absMask);
+        const __m128 b = _mm_and_ps(_mm_loadu_ps(samples + i + 4), absMask);
+        // Not-less-or-equal is also true for NaN
+        const __m128 loud = _mm_or_ps(_mm_cmpnle_ps(a, limit), _mm_cmpnle_ps(b, limit));
+        if (_mm_movemask_ps(loud)) return false;
+    }
+    return isSilentF32Scalar(samples + i, numSamples - i, floor);
+}
+
+PHANTOM_TARGET("sse2")
+bool isSilentS16Sse2(const int16_t* samples, size_t numSamples, int16_t floor) {
+    if (floor < 0) return numSamples == 0;
+    const __m128i upper = _mm_set1_epi16(floor);
+    const __m128i lower = _mm_set1_epi16(static_cast<int16_t>(-floor));
+    size_t i = 0;
+    for (; i + 8 <= numSamples; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i));
+        const __m128i loud = _mm_or_si128(_mm_cmpgt_epi16(v, upper), _mm_cmplt_epi16(v, lower));
+        if (_mm_movemask_epi8(loud)) return false;
+    }
+    return isSilentS16Scalar(samples + i, numSamples - i, floor);
+}
+
+// ============================================================================
+// AVX2 kernels
+// ============================================================================
+
+PHANTOM_TARGET("avx2")
+bool isSilentF32Avx2(const float* samples, size_t numSamples, float floor) {
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const __m256 limit = _mm256_set1_ps(floor);
+    size_t i = 0;
+    for (; i + 32 <= numSamples; i += 32) {
+        __m256 loud = _mm256_setzero_ps();
+        for (size_t j = 0; j < 32; j += 8) {
+            const __m256 v = _mm256_and_ps(_mm256_loadu_ps(samples + i + j), absMask);
+            loud = _mm256_or_ps(loud, _mm256_cmp_ps(v, limit, _CMP_NLE_UQ));
+        }
+        if (_mm256_movemask_ps(loud)) return false;
+    }
+    _mm256_zeroupper();  // The SSE tail would otherwise pay for dirty upper halves
+    return isSilentF32Sse2(samples + i, numSamples - i, floor);
+}
+
+PHANTOM_TARGET("avx2")
+bool isSilentS16Avx2(const int16_t* samples, size_t numSamples, int16_t floor) {
+    if (floor < 0) return numSamples == 0;
+    const __m256i upper = _mm256_set1_epi16(floor);
+    const __m256i lower = _mm256_set1_epi16(static_cast<int16_t>(-floor));
+    size_t i = 0;
+    for (; i + 16 <= numSamples; i += 16) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + i));
+        const __m256i loud = _mm256_or_si256(_mm256_cmpgt_epi16(v, upper), _mm256_cmpgt_epi16(lower, v));
+        if (_mm256_movemask_epi8(loud)) return false;
+    }
+    _mm256_zeroupper();
+    return isSilentS16Sse2(samples + i, numSamples - i, floor);
+}
+
+#elif defined(PHANTOM_ARCH_ARM64)
+
+// ============================================================================
+// NEON kernels
+// ============================================================================
+
+bool isSilentF32Neon(const float* samples, size_t numSamples, float floor) {
+    const float32x4_t limit = vdupq_n_f32(floor);
+    size_t i = 0;
+    for (; i + 8 <= numSamples; i += 8) {
+        // Less-or-equal is false for NaN, so NaN clears its lane
+        const uint32x4_t quiet = vandq_u32(vcleq_f32(vabsq_f32(vld1q_f32(samples + i)), limit),
+                                           vcleq_f32(vabsq_f32(vld1q_f32(samples + i + 4)), limit));
+        if (vminvq_u32(quiet) == 0) return false;
+    }
+    return isSilentF32Scalar(samples + i, numSamples - i, floor);
+}
+
+bool isSilentS16Neon(const int16_t* samples, size_t numSamples, int16_t floor) {
+    if (floor < 0) return numSamples == 0;
+    const int16x8_t limit = vdupq_n_s16(floor);
+    size_t i = 0;
+    for (; i + 8 <= numSamples; i += 8) {
+        // Saturating abs, so -32768 becomes 32767 instead of wrapping
+        const uint16x8_t loud = vcgtq_s16(vqabsq_s16(vld1q_s16(samples + i)), limit);
+        if (vmaxvq_u16(loud) != 0) return false;
+    }
+    return isSilentS16Scalar(samples + i, numSamples - i, floor);
+}
+
+#endif
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+struct Kernels {
+    SimdIsa isa = SimdIsa::Scalar;
+    SilentF32Kernel f32 = isSilentF32Scalar;
+    SilentS16Kernel s16 = isSilentS16Scalar;
+};
+
+Kernels kernelsFor(SimdIsa isa) {
+    Kernels k;
+    if (!isaSupported(isa)) return k;
+#if defined(PHANTOM_ARCH_X86)
+    switch (isa) {
+        case SimdIsa::AVX2:
+            k.isa = SimdIsa::AVX2;
+            k.f32 = isSilentF32Avx2;
+            k.s16 = isSilentS16Avx2;
+            break;
+        case SimdIsa::SSE41:
+        case SimdIsa::SSSE3:
+        case SimdIsa::SSE2:
+            k.isa = SimdIsa::SSE2;
+            k.f32 = isSilentF32Sse2;
+            k.s16 = isSilentS16Sse2;
+            break;
+        default:
+            break;
+    }
+#elif defined(PHANTOM_ARCH_ARM64)
+    if (isa == SimdIsa::NEON) {
+        k.isa = SimdIsa::NEON;
+        k.f32 = isSilentF32Neon;
+        k.s16 = isSilentS16Neon;
+    }
+#endif
+    return k;
+}
+
+const Kernels& defaultKernels() {
+    static const Kernels kernels = kernelsFor(preferredIsa());
+    return kernels;
+}
+
+} // namespace
+
+bool isSilent(const float* samples, size_t numSamples, float floor) {
+    return defaultKernels().f32(samples, numSamples, floor);
+}
+
+bool isSilent(const float* samples, size_t numSamples, float floor, SimdIsa isa) {
+    return kernelsFor(isa).f32(samples, numSamples, floor);
+}
+
+bool isSilent(const int16_t* samples, size_t numSamples, int16_t floor) {
+    return defaultKernels().s16(samples, numSamples, floor);
+}
+
+bool isSilent(const int16_t* samples, size_t numSamples, int16_t floor, SimdIsa isa) {
+    return kernelsFor(isa).s16(samples, numSamples, floor);
+}
+
+SimdIsa silenceDetectIsa() {
+    return defaultKernels().isa;
+}
+
+} // namespace phantom
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "cpu_features.h"
+
+namespace phantom {
+
+/**
+ * Digital-silence check for capture packets. A loopback device with
+ * nothing playing delivers zeros (or dither-level noise), and such packets
+ * skip conversion, resampling, buffering and IPC entirely.
+ *
+ * A packet is silent when every |sample| <= floor; NaN counts as sound.
+ * The kernels stop at the first loud block, so real audio costs a few
+ * loads. The default overloads use the best kernel for this CPU; the
+ * SimdIsa overloads are for tests and benchmarks.
+ */
+
+// One 16-bit LSB: anything quieter is inaudible after conversion anyway
+constexpr float DIGITAL_SILENCE_FLOOR = 1.0f / 32768.0f;
+constexpr int16_t DIGITAL_SILENCE_FLOOR_S16 = 1;
+
+bool isSilent(const float* samples, size_t numSamples, float floor);
+bool isSilent(const float* samples, size_t numSamples, float floor, SimdIsa isa);
+
+bool isSilent(const int16_t* samples, size_t numSamples, int16_t floor);
+bool isSilent(const int16_t* samples, size_t numSamples, int16_t floor, SimdIsa isa);
+
+// Level the default kernels were bound for
+SimdIsa silenceDetectIsa();
+
+} // namespace phantom
@@ -0,0 +1,83 @@
+#include "silence_split.h"
+#include "frame_features.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace phantom {
+
+namespace {
+
+constexpr size_t WINDOW_FRAMES = 5;
+
+} // namespace
+
+std::vector<AudioSpan> splitAtSilences(const float* samples, size_t numSamples,
+                                       const SplitOptions& options) {
+    std::vector<AudioSpan> spans;
+    if (numSamples == 0) return spans;
+
+    // 50ms windows of five 10ms feature frames
+    const size_t frameSamples = std::max<size_t>(1, options.sampleRate / 100);
+    const size_t window = frameSamples * WINDOW_FRAMES;
+    const size_t maxSamples = std::max(window,
+        static_cast<size_t>(options.maxSeconds * static_cast<double>(options.sampleRate)));
+    const size_t minSamples = std::min(maxSamples - window,
+        static_cast<size_t>(std::max(0.0, options.minSeconds) * static_cast<double>(options.sampleRate)));
+
+    // Mean absolute amplitude per window (the last one may be short)
+    const std::vector<FrameFeatures> frames = computeFrameFeatures(samples, numSamples, frameSamples);
+    const size_t numWindows = (numSamples + window - 1) / window;
+    std::vector<float> energy(numWindows);
+    for (size_t w = 0; w < numWindows; ++w) {
+        const size_t begin = w * window;
+        const size_t end = std::min(begin + window, numSamples);
+        float sum = 0.0f;
+        const size_t lastFrame = std::min(frames.size(), (w + 1) * WINDOW_FRAMES);
+        for (size_t f = w * WINDOW_FRAMES; f < lastFrame; ++f) {
+            sum += frames[f].meanAbs * static_cast<float>(frameSamples);
+        }
+        // Samples past the last whole frame
+        for (size_t i = std::max(begin, frames.size() * frameSamples); i < end; ++i) {
+            sum += std::abs(samples[i]);
+        }
+        energy[w] = sum / static_cast<float>(end - begin);
+    }
+
+    auto addSpan = [&](size_t start, size_t end) {
+        if (options.threshold > 0.0f) {
+            const size_t firstWindow = start / window;
+            const size_t lastWindow = (end - 1) / window;
+            bool speech = false;
+            for (size_t w = firstWindow; w <= lastWindow && !speech; ++w) {
+                speech = energy[w] > options.threshold;
+            }
+            if (!speech) return;
+        }
+        spans.push_back(AudioSpan{start, end});
+    };
+
+    size_t pos = 0;
+    while (numSamples - pos > maxSamples) {
+        // Quietest whole window in [pos + min, pos + max). Windows within 10%
+        // of it count as equally quiet and the latest wins, so segments stay
+        // long through continuous speech.
+        const size_t firstWindow = (pos + minSamples + window - 1) / window;
+        const size_t lastWindow = (pos + maxSamples) / window;  // Exclusive
+        float quietest = energy[firstWindow];
+        for (size_t w = firstWindow; w < lastWindow; ++w) {
+            quietest = std::min(quietest, energy[w]);
+        }
+        size_t best = firstWindow;
+        for (size_t w = firstWindow; w < lastWindow; ++w) {
+            if (energy[w] <= quietest * 1.1f) best = w;
+        }
+        const size_t cut = std::max(best * window + window / 2, pos + 1);
+        addSpan(pos, cut);
+        pos = cut;
+    }
+    addSpan(pos, numSamples);
+    return spans;
+}
+
+} // namespace phantom
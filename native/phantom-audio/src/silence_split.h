@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace phantom {
+
+// Half-open sample range [start, end)
+struct AudioSpan {
+    size_t start = 0;
+    size_t end = 0;
+};
+
+/**
+ * How a long recording is cut into independently decodable segments.
+ * Cuts land in the quietest 50ms window between minSeconds and maxSeconds
+ * after the previous cut, so words are rarely split. Segments whose every
+ * window is at or below `threshold` (mean absolute amplitude) are dropped;
+ * a threshold <= 0 keeps them all.
+ */
+struct SplitOptions {
+    size_t sampleRate = 16000;
+    double minSeconds = 10.0;
+    double maxSeconds = 28.0;  // Whisper decodes at most 30s at a time
+    float threshold = 0.01f;
+};
+
+std::vector<AudioSpan> splitAtSilences(const float* samples, size_t numSamples,
+                                       const SplitOptions& options);
+
+} // namespace phantom
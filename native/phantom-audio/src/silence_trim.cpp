@@ -0,0 +1,77 @@
+#include "silence_trim.h"
+
+#include <algorithm>
+
+namespace phantom {
+
+namespace {
+
+constexpr size_t WINDOW_FRAMES = 5;  // 50ms of 10ms frames
+
+} // namespace
+
+size_t trimSilence(std::vector<float>& samples, float threshold, size_t sampleRate) {
+    if (samples.empty() || threshold <= 0.0f) return 0;
+
+    const size_t frameSamples = sampleRate / 100;
+    if (frameSamples == 0) return 0;
+    return trimSilence(samples, threshold, sampleRate,
+                       computeFrameFeatures(samples.data(), samples.size(), frameSamples), 0);
+}
+
+size_t trimSilence(std::vector<float>& samples, float threshold, size_t sampleRate,
+                   const std::vector<FrameFeatures>& frames, size_t leadSamples) {
+    if (samples.empty() || threshold <= 0.0f) return 0;
+    if (frames.size() < WINDOW_FRAMES) return 0;
+
+    const size_t frameSamples = sampleRate / 100;
+    const size_t margin = sampleRate / 40;  // Half a window
+
+    // Frames are equal-sized, so the window mean is the mean of frame means
+    const float windowThreshold = threshold * WINDOW_FRAMES;
+    float windowSum = 0.0f;
+    for (size_t f = 0; f < WINDOW_FRAMES - 1; ++f) {
+        windowSum += frames[f].meanAbs;
+    }
+
+    bool found = false;
+    size_t firstLoud = 0;
+    size_t lastLoud = 0;
+    for (size_t f = WINDOW_FRAMES - 1; f < frames.size(); ++f) {
+        windowSum += frames[f].meanAbs;
+        if (windowSum > windowThreshold) {
+            const size_t window = f + 1 - WINDOW_FRAMES;
+            if (!found) firstLoud = window;
+            lastLoud = window;
+            found = true;
+        }
+        windowSum -= frames[f + 1 - WINDOW_FRAMES].meanAbs;
+    }
+    if (!found) return 0;
+
+    // The windows say there is speech; the frames inside them place it
+    size_t firstFrame = firstLoud;
+    while (firstFrame + 1 < firstLoud + WINDOW_FRAMES && frames[firstFrame].meanAbs <= threshold) {
+        ++firstFrame;
+    }
+    size_t lastFrame = lastLoud + WINDOW_FRAMES - 1;
+    while (lastFrame > lastLoud && frames[lastFrame].meanAbs <= threshold) {
+        --lastFrame;
+    }
+
+    const size_t speechStart = leadSamples + firstFrame * frameSamples;
+    const size_t speechEnd = leadSamples + (lastFrame + 1) * frameSamples;
+    const size_t start = speechStart > margin ? speechStart - margin : 0;
+    const size_t end = std::min(speechEnd + margin, samples.size());
+    if (start >= end) return 0;
+
+    if (end < samples.size()) {
+        samples.resize(end);
+    }
+    if (start > 0) {
+        samples.erase(samples.begin(), samples.begin() + start);
+    }
+    return start;
+}
+
+} // namespace phantom
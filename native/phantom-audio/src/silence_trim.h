@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "frame_features.h"
+
+namespace phantom {
+
+/**
+ * Energy-based trim of leading and trailing silence from a chunk before
+ * it is transcribed. Windows of 50ms (five 10ms feature frames, hop 10ms)
+ * whose mean absolute amplitude stays at or below `threshold` count as
+ * silence; inside the outermost loud windows, speech starts and ends at
+ * the loud frames, and half a window of margin is kept around it. A
+ * threshold <= 0 leaves the chunk untouched, as does a chunk with no
+ * window above it. Returns the number of samples removed from the front.
+ */
+size_t trimSilence(std::vector<float>& samples, float threshold, size_t sampleRate);
+
+/**
+ * Same, reading precomputed 10ms frames (sampleRate / 100 samples each)
+ * instead of rescanning the audio. frames[0] starts `leadSamples` into
+ * `samples`; audio not covered by a frame counts as silence.
+ */
+size_t trimSilence(std::vector<float>& samples, float threshold, size_t sampleRate,
+                   const std::vector<FrameFeatures>& frames, size_t leadSamples);
+
+} // namespace phantom
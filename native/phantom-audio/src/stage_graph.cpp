@@ -0,0 +1,231 @@
+#include "stage_graph.h"
+#include "pipeline_metrics.h"
+#include "trace_recorder.h"
+
+#include <algorithm>
+
+namespace phantom {
+
+// ============================================================================
+// StageOutput
+// ============================================================================
+
+StagePacket& StageOutput::acquire() {
+    StagePacket& packet = m_graph.acquire();
+    m_acquired.push_back(&packet);
+    return packet;
+}
+
+void StageOutput::emit(const StagePacket& packet) {
+    m_emitted.push_back(const_cast<StagePacket*>(&packet));
+}
+
+// ============================================================================
+// StageGraph
+// ============================================================================
+
+StageGraph::~StageGraph() {
+    stop();
+    for (StagePacket* packet : m_packets) delete packet;
+}
+
+int StageGraph::addStage(const char* name, StageFunction function, size_t capacity, Overflow overflow) {
+    if (isRunning()) {
+        m_lastError = "Cannot add a stage while the graph is running";
+        return -1;
+    }
+    Stage stage;
+    stage.name = name;
+    stage.function = std::move(function);
+    stage.capacity = std::max<size_t>(capacity, 1);
+    stage.overflow = overflow;
+    stage.stats.name = name;
+    m_stages.push_back(std::move(stage));
+    return static_cast<int>(m_stages.size()) - 1;
+}
+
+bool StageGraph::connect(int from, int to) {
+    if (isRunning()) {
+        m_lastError = "Cannot connect stages while the graph is running";
+        return false;
+    }
+    if (from < 0 || to <= from || to >= static_cast<int>(m_stages.size())) {
+        m_lastError = "Stages must be connected upstream to downstream";
+        return false;
+    }
+    m_stages[from].downstream.push_back(to);
+    m_stages[to].upstream.push_back(from);
+    return true;
+}
+
+void StageGraph::start(int workers) {
+    if (isRunning()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = false;
+        m_started = true;
+    }
+    for (int i = 0; i < std::max(workers, 1); ++i) {
+        m_workers.emplace_back(&StageGraph::workerLoop, this);
+    }
+}
+
+void StageGraph::stop() {
+    if (!isRunning()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_workCv.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_started = false;
+}
+
+StagePacket& StageGraph::acquire() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return *acquireLocked();
+}
+
+bool StageGraph::push(int index, StagePacket& packet) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Stage& stage = m_stages[index];
+    if (stage.overflow == Overflow::Block) {
+        // Without workers nothing would make room
+        m_spaceCv.wait(lock, [&] { return stage.queue.size() < stage.capacity || !m_started; });
+    }
+    const bool queued = enqueue(stage, &packet, metricsNowUs());
+    release(&packet);
+    return queued;
+}
+
+void StageGraph::drain() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_spaceCv.wait(lock, [&] { return idle() || !m_started; });
+}
+
+std::vector<StageStats> StageGraph::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<StageStats> out;
+    for (const Stage& stage : m_stages) out.push_back(stage.stats);
+    return out;
+}
+
+void StageGraph::workerLoop() {
+    TraceRecorder::instance().setThreadName("pipeline");
+    StageOutput out(*this);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_workCv.wait(lock, [&] { return !m_ready.empty() || (m_stopping && idle()); });
+        if (m_ready.empty()) return;
+
+        const int index = m_ready.front();
+        m_ready.pop_front();
+        Stage& stage = m_stages[index];
+        stage.scheduled = false;
+        stage.running = true;
+        ++m_active;
+        const Entry entry = stage.queue.front();
+        stage.queue.pop_front();
+        --m_queued;
+        metrics().stageWait.record(metricsNowUs() - entry.queuedUs);
+
+        lock.unlock();
+        {
+            TraceSpan span(stage.name);
+            stage.function(*entry.packet, out);
+        }
+        lock.lock();
+
+        const uint64_t now = metricsNowUs();
+        for (StagePacket* packet : out.m_emitted) {
+            for (const int next : stage.downstream) enqueue(m_stages[next], packet, now);
+        }
+        out.m_emitted.clear();
+        for (StagePacket* packet : out.m_acquired) release(packet);
+        out.m_acquired.clear();
+        release(entry.packet);
+
+        ++stage.stats.processed;
+        stage.running = false;
+        --m_active;
+
+        // Its queue may hold more, and upstream stages may have been
+        // waiting for room in it
+        schedule(index);
+        for (const int previous : stage.upstream) schedule(previous);
+        m_spaceCv.notify_all();
+        if (m_stopping && idle()) m_workCv.notify_all();
+    }
+}
+
+// Caller must hold m_mutex
+StagePacket* StageGraph::acquireLocked() {
+    StagePacket* packet;
+    if (m_free.empty()) {
+        packet = new StagePacket();
+        m_packets.push_back(packet);
+    } else {
+        packet = m_free.back();
+        m_free.pop_back();
+    }
+    packet->kind = PacketKind::Audio;
+    packet->format = SampleFormat::F32;
+    packet->numSamples = 0;
+    packet->m_refs = 1;
+    return packet;
+}
+
+// Caller must hold m_mutex
+void StageGraph::release(StagePacket* packet) {
+    if (--packet->m_refs == 0) m_free.push_back(packet);
+}
+
+// Queue a packet, or drop it if the stage is full and drops. A Block
+// stage only overfills by what one upstream run emits. Caller must hold
+// m_mutex.
+bool StageGraph::enqueue(Stage& stage, StagePacket* packet, uint64_t nowUs) {
+    if (stage.overflow == Overflow::Drop && stage.queue.size() >= stage.capacity) {
+        ++stage.stats.dropped;
+        metrics().stageDrops.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    ++packet->m_refs;
+    stage.queue.push_back({packet, nowUs});
+    ++m_queued;
+    stage.stats.maxDepth = std::max(stage.stats.maxDepth, stage.queue.size());
+    schedule(static_cast<int>(&stage - m_stages.data()));
+    return true;
+}
+
+// Caller must hold m_mutex
+bool StageGraph::canRun(const Stage& stage) const {
+    if (stage.queue.empty() || stage.scheduled || stage.running) return false;
+    for (const int next : stage.downstream) {
+        const Stage& downstream = m_stages[next];
+        if (downstream.overflow == Overflow::Block && downstream.queue.size() >= downstream.capacity) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Caller must hold m_mutex
+void StageGraph::schedule(int index) {
+    Stage& stage = m_stages[index];
+    if (!canRun(stage)) return;
+    stage.scheduled = true;
+    m_ready.push_back(index);
+    m_workCv.notify_one();
+}
+
+// Caller must hold m_mutex
+bool StageGraph::idle() const {
+    return m_queued == 0 && m_active == 0;
+}
+
+} // namespace phantom
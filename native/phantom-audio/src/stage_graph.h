@@ -0,0 +1,197 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sample_format.h"
+
+namespace phantom {
+
+enum class PacketKind {
+    Audio,      // numSamples samples in `format`
+    Silence     // numSamples samples of silence, not stored
+};
+
+/**
+ * One unit of work flowing through a StageGraph: a capture packet or a
+ * silence run. Packets come from the graph's pool and are shared, not
+ * copied, when a stage fans out, so stages only read them.
+ */
+struct StagePacket {
+    PacketKind kind = PacketKind::Audio;
+    SampleFormat format = SampleFormat::F32;
+    std::vector<float> f32;
+    std::vector<int16_t> s16;
+    std::vector<uint8_t> device;    // Raw capture buffer; numSamples counts its frames
+    size_t numSamples = 0;
+
+private:
+    friend class StageGraph;
+    int m_refs = 0;
+};
+
+// What a full input queue does to a packet sent to it
+enum class Overflow {
+    Block,      // Hold the sender: the source waits, an upstream stage is not run
+    Drop        // Drop the packet and count it
+};
+
+class StageGraph;
+
+/**
+ * Handed to a stage while it runs: sends packets to the stage's
+ * downstream stages once it returns.
+ */
+class StageOutput {
+public:
+    // A fresh packet to fill and emit (returned to the pool if not emitted)
+    StagePacket& acquire();
+
+    // Send a packet (the input, or one from acquire()) to every downstream stage
+    void emit(const StagePacket& packet);
+
+private:
+    friend class StageGraph;
+    explicit StageOutput(StageGraph& graph) : m_graph(graph) {}
+
+    StageGraph& m_graph;
+    std::vector<StagePacket*> m_acquired;
+    std::vector<StagePacket*> m_emitted;
+};
+
+using StageFunction = std::function<void(const StagePacket& packet, StageOutput& out)>;
+
+struct StageStats {
+    const char* name = "";
+    uint64_t processed = 0;
+    uint64_t dropped = 0;
+    size_t maxDepth = 0;        // Most packets ever queued
+};
+
+/**
+ * A pipeline of stages joined by bounded queues, run by a small pool of
+ * worker threads.
+ *
+ * Each stage runs on at most one worker at a time and sees its packets in
+ * order, so a stage's own state needs no locking. A stage with several
+ * downstream stages sends every packet to all of them. Backpressure is
+ * explicit per stage: when a stage's queue is full, a Block stage holds
+ * whoever is sending (the source waits in push(); an upstream stage is
+ * not scheduled until there is room), and a Drop stage drops the packet
+ * and counts it.
+ *
+ * The shape is fixed before start(). Stages are added upstream first, so
+ * the graph cannot have cycles.
+ */
+class StageGraph {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 64;
+
+    StageGraph() = default;
+    ~StageGraph();
+
+    StageGraph(const StageGraph&) = delete;
+    StageGraph& operator=(const StageGraph&) = delete;
+
+    /**
+     * Add a stage. `name` must be a string literal (it names trace spans).
+     * @return The stage's id
+     */
+    int addStage(const char* name, StageFunction function, size_t capacity = DEFAULT_CAPACITY,
+                 Overflow overflow = Overflow::Block);
+
+    /**
+     * Send everything `from` emits to `to` as well
+     * @return false (see getLastError) unless `to` was added after `from`
+     */
+    bool connect(int from, int to);
+
+    /**
+     * Start `workers` worker threads (at least 1)
+     */
+    void start(int workers);
+
+    /**
+     * Finish every queued packet, then stop the workers
+     */
+    void stop();
+
+    bool isRunning() const { return !m_workers.empty(); }
+
+    /**
+     * A fresh packet for push(). Safe from any thread; reuses the storage
+     * of finished packets, so steady state does not allocate.
+     */
+    StagePacket& acquire();
+
+    /**
+     * Queue a packet (from acquire()) at a stage. Safe from any thread.
+     * Waits for room at a Block stage.
+     * @return false if a Drop stage's queue was full and the packet was dropped
+     */
+    bool push(int stage, StagePacket& packet);
+
+    /**
+     * Wait until every queued packet has been processed
+     */
+    void drain();
+
+    std::vector<StageStats> stats() const;
+    const std::string& getLastError() const { return m_lastError; }
+
+private:
+    friend class StageOutput;
+
+    struct Entry {
+        StagePacket* packet;
+        uint64_t queuedUs;
+    };
+
+    struct Stage {
+        const char* name;
+        StageFunction function;
+        size_t capacity;
+        Overflow overflow;
+        std::vector<int> downstream;
+        std::vector<int> upstream;
+        std::deque<Entry> queue;
+        bool scheduled = false;     // In m_ready
+        bool running = false;
+        StageStats stats;
+    };
+
+    void workerLoop();
+
+    // The rest must be called with m_mutex held
+    StagePacket* acquireLocked();
+    void release(StagePacket* packet);
+    bool enqueue(Stage& stage, StagePacket* packet, uint64_t nowUs);
+    bool canRun(const Stage& stage) const;
+    void schedule(int stage);
+    bool idle() const;
+
+    std::vector<Stage> m_stages;
+    std::vector<std::thread> m_workers;
+    std::string m_lastError;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workCv;       // A stage became ready, or stopping
+    std::condition_variable m_spaceCv;      // A queue shrank or a stage finished
+    std::deque<int> m_ready;
+    size_t m_queued = 0;                    // Packets in all queues
+    size_t m_active = 0;                    // Stages running
+    bool m_started = false;                 // Workers are running
+    bool m_stopping = false;
+
+    std::vector<StagePacket*> m_free;
+    std::vector<StagePacket*> m_packets;    // Everything allocated, for the destructor
+};
+
+} // namespace phantom
@@ -0,0 +1,310 @@
+#include "text_encoding.h"
+
+#if defined(PHANTOM_ARCH_X86)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace phantom {
+
+namespace {
+
+const char BASE64_TABLE[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Non-zero for bytes that must be escaped inside a JSON string
+struct EscapeTable {
+    uint8_t needsEscape[256];
+    EscapeTable() {
+        for (int c = 0; c < 256; ++c) {
+            needsEscape[c] = (c < 0x20 || c == '"' || c == '\\') ? 1 : 0;
+        }
+    }
+};
+
+const EscapeTable& escapeTable() {
+    static const EscapeTable table;
+    return table;
+}
+
+using Base64Kernel = void (*)(char* dst, const uint8_t* src, size_t numBytes);
+using FindEscapeKernel = size_t (*)(const char* data, size_t pos, size_t length);
+
+// ============================================================================
+// Scalar kernels
+// ============================================================================
+
+void base64Scalar(char* dst, const uint8_t* src, size_t numBytes) {
+    size_t i = 0;
+    for (; i + 3 <= numBytes; i += 3) {
+        const uint32_t triple = (static_cast<uint32_t>(src[i]) << 16) |
+                                (static_cast<uint32_t>(src[i + 1]) << 8) | src[i + 2];
+        dst[0] = BASE64_TABLE[(triple >> 18) & 0x3F];
+        dst[1] = BASE64_TABLE[(triple >> 12) & 0x3F];
+        dst[2] = BASE64_TABLE[(triple >> 6) & 0x3F];
+        dst[3] = BASE64_TABLE[triple & 0x3F];
+        dst += 4;
+    }
+
+    const size_t remaining = numBytes - i;
+    if (remaining > 0) {
+        uint32_t triple = static_cast<uint32_t>(src[i]) << 16;
+        if (remaining > 1) triple |= static_cast<uint32_t>(src[i + 1]) << 8;
+        dst[0] = BASE64_TABLE[(triple >> 18) & 0x3F];
+        dst[1] = BASE64_TABLE[(triple >> 12) & 0x3F];
+        dst[2] = remaining > 1 ? BASE64_TABLE[(triple >> 6) & 0x3F] : '=';
+        dst[3] = '=';
+    }
+}
+
+// Index of the first byte at or after pos that needs escaping, or length
+size_t findEscapeScalar(const char* data, size_t pos, size_t length) {
+    const uint8_t* table = escapeTable().needsEscape;
+    while (pos < length && !table[static_cast<uint8_t>(data[pos])]) {
+        ++pos;
+    }
+    return pos;
+}
+
+#if defined(PHANTOM_ARCH_X86)
+
+inline int lowestSetBit(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// ============================================================================
+// SSE2 / SSSE3 kernels
+// ============================================================================
+
+// Base64 of 12 input bytes per iteration (Mula/Lemire): reshuffle into
+// 32-bit groups, split out the four 6-bit indices with multiplies, then map
+// indices to ASCII with one pshufb on a table of range offsets.
+PHANTOM_TARGET("ssse3")
+void base64Ssse3(char* dst, const uint8_t* src, size_t numBytes) {
+    const __m128i shuffle = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m128i maskAc = _mm_set1_epi32(0x0FC0FC00);
+    const __m128i mulAc = _mm_set1_epi32(0x04000040);
+    const __m128i maskBd = _mm_set1_epi32(0x003F03F0);
+    const __m128i mulBd = _mm_set1_epi32(0x01000010);
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                          '/' - 63, 'A', 0, 0);
+
+    size_t i = 0;
+    // 16-byte loads, 12 bytes consumed
+    for (; i + 16 <= numBytes; i += 12) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        in = _mm_shuffle_epi8(in, shuffle);
+        const __m128i ac = _mm_mulhi_epu16(_mm_and_si128(in, maskAc), mulAc);
+        const __m128i bd = _mm_mullo_epi16(_mm_and_si128(in, maskBd), mulBd);
+        const __m128i indices = _mm_or_si128(ac, bd);
+
+        __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        const __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+        const __m128i ascii = _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), ascii);
+        dst += 16;
+    }
+
+    base64Scalar(dst, src + i, numBytes - i);
+}
+
+// Mask of bytes that are '"', '\\' or below 0x20 (unsigned)
+PHANTOM_TARGET("sse2")
+size_t findEscapeSse2(const char* data, size_t pos, size_t length) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+
+    for (; pos + 16 <= length; pos += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        const __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+            _mm_cmpeq_epi8(_mm_max_epu8(v, control), control));
+        const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(special));
+        if (mask) return pos + lowestSetBit(mask);
+    }
+    return findEscapeScalar(data, pos, length);
+}
+
+// ============================================================================
+// AVX2 kernels
+// ============================================================================
+
+PHANTOM_TARGET("avx2")
+void base64Avx2(char* dst, const uint8_t* src, size_t numBytes) {
+    const __m256i shuffle = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                             1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i maskAc = _mm256_set1_epi32(0x0FC0FC00);
+    const __m256i mulAc = _mm256_set1_epi32(0x04000040);
+    const __m256i maskBd = _mm256_set1_epi32(0x003F03F0);
+    const __m256i mulBd = _mm256_set1_epi32(0x01000010);
+    const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                             '/' - 63, 'A', 0, 0,
+                                             'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                             '/' - 63, 'A', 0, 0);
+
+    size_t i = 0;
+    // Each 128-bit lane takes 12 bytes: [i, i+12) low, [i+12, i+24) high
+    for (; i + 28 <= numBytes; i += 24) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 12));
+        __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        in = _mm256_shuffle_epi8(in, shuffle);
+        const __m256i ac = _mm256_mulhi_epu16(_mm256_and_si256(in, maskAc), mulAc);
+        const __m256i bd = _mm256_mullo_epi16(_mm256_and_si256(in, maskBd), mulBd);
+        const __m256i indices = _mm256_or_si256(ac, bd);
+
+        __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        const __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        range = _mm256_or_si256(range, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+        const __m256i ascii = _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indices);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), ascii);
+        dst += 32;
+    }
+
+    _mm256_zeroupper();  // The SSSE3 tail would otherwise pay for dirty upper halves
+    base64Ssse3(dst, src + i, numBytes - i);
+}
+
+PHANTOM_TARGET("avx2")
+size_t findEscapeAvx2(const char* data, size_t pos, size_t length) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+
+    for (; pos + 32 <= length; pos += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        const __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)),
+            _mm256_cmpeq_epi8(_mm256_max_epu8(v, control), control));
+        const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(special));
+        if (mask) return pos + lowestSetBit(mask);
+    }
+    _mm256_zeroupper();
+    return findEscapeSse2(data, pos, length);
+}
+
+#endif // PHANTOM_ARCH_X86
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+struct Kernels {
+    SimdIsa isa = SimdIsa::Scalar;
+    Base64Kernel base64 = base64Scalar;
+    FindEscapeKernel findEscape = findEscapeScalar;
+};
+
+Kernels kernelsFor(SimdIsa isa) {
+    Kernels k;
+#if defined(PHANTOM_ARCH_X86)
+    if (!isaSupported(isa)) return k;
+    switch (isa) {
+        case SimdIsa::AVX2:
+            k.isa = SimdIsa::AVX2;
+            k.base64 = base64Avx2;
+            k.findEscape = findEscapeAvx2;
+            break;
+        case SimdIsa::SSE41:
+        case SimdIsa::SSSE3:
+            k.isa = SimdIsa::SSSE3;
+            k.base64 = base64Ssse3;
+            k.findEscape = findEscapeSse2;
+            break;
+        case SimdIsa::SSE2:
+            k.isa = SimdIsa::SSE2;
+            k.findEscape = findEscapeSse2;
+            break;
+        default:
+            break;
+    }
+#else
+    (void)isa;
+#endif
+    return k;
+}
+
+const Kernels& defaultKernels() {
+    static const Kernels kernels = kernelsFor(preferredIsa());
+    return kernels;
+}
+
+void appendEscapedChar(std::string& out, unsigned char c) {
+    static const char HEX[] = "0123456789abcdef";
+    switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default: {
+            // Control character - use unicode escape
+            const char escaped[6] = {'\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xF]};
+            out.append(escaped, sizeof(escaped));
+            break;
+        }
+    }
+}
+
+void appendBase64With(const Kernels& kernels, std::string& out, const uint8_t* data, size_t numBytes) {
+    if (numBytes == 0) return;
+    const size_t offset = out.size();
+    out.resize(offset + base64EncodedLength(numBytes));
+    kernels.base64(&out[offset], data, numBytes);
+}
+
+void appendJsonEscapedWith(const Kernels& kernels, std::string& out, const char* data, size_t length) {
+    // Typical text needs few escapes; avoid regrowing per run
+    if (out.capacity() < out.size() + length) {
+        out.reserve(out.size() + length + length / 8 + 16);
+    }
+
+    size_t pos = 0;
+    while (pos < length) {
+        const size_t special = kernels.findEscape(data, pos, length);
+        out.append(data + pos, special - pos);
+        if (special == length) break;
+        appendEscapedChar(out, static_cast<unsigned char>(data[special]));
+        pos = special + 1;
+    }
+}
+
+} // namespace
+
+void appendBase64(std::string& out, const uint8_t* data, size_t numBytes) {
+    appendBase64With(defaultKernels(), out, data, numBytes);
+}
+
+void appendBase64(std::string& out, const uint8_t* data, size_t numBytes, SimdIsa isa) {
+    appendBase64With(kernelsFor(isa), out, data, numBytes);
+}
+
+void appendJsonEscaped(std::string& out, const char* data, size_t length) {
+    appendJsonEscapedWith(defaultKernels(), out, data, length);
+}
+
+void appendJsonEscaped(std::string& out, const char* data, size_t length, SimdIsa isa) {
+    appendJsonEscapedWith(kernelsFor(isa), out, data, length);
+}
+
+SimdIsa textEncodingIsa() {
+    return defaultKernels().isa;
+}
+
+} // namespace phantom
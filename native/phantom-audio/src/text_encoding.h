@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "cpu_features.h"
+
+namespace phantom {
+
+/**
+ * Base64 and JSON string escaping for the protocol layer.
+ *
+ * Both append to a caller-owned string, so a buffer kept across calls stops
+ * allocating once it has grown. The default overloads use the best kernel
+ * for this CPU (AVX2, SSSE3/SSE2 or scalar, chosen once at runtime); the
+ * SimdIsa overloads pick one explicitly for tests and benchmarks and fall
+ * back to scalar if it is not supported.
+ */
+
+inline size_t base64EncodedLength(size_t numBytes) {
+    return ((numBytes + 2) / 3) * 4;
+}
+
+// Standard alphabet with '=' padding, no line breaks
+void appendBase64(std::string& out, const uint8_t* data, size_t numBytes);
+void appendBase64(std::string& out, const uint8_t* data, size_t numBytes, SimdIsa isa);
+
+/**
+ * Escape for use inside a JSON string literal: quote, backslash and control
+ * characters (\b \f \n \r \t or \u00XX). Runs of clean bytes are copied in
+ * one go; UTF-8 passes through unchanged.
+ */
+void appendJsonEscaped(std::string& out, const char* data, size_t length);
+void appendJsonEscaped(std::string& out, const char* data, size_t length, SimdIsa isa);
+
+// Level the default kernels were bound for
+SimdIsa textEncodingIsa();
+
+} // namespace phantom
@@ -0,0 +1,220 @@
+#include "trace_recorder.h"
+
+#include <cstdio>
+#include <iostream>
+
+namespace phantom {
+
+namespace {
+    struct TraceEvent {
+        const char* name;
+        const char* argName;
+        int64_t arg;
+        uint64_t startUs;
+        uint64_t durationUs;
+    };
+
+    // Written trace is flushed to disk in pieces of about this size
+    constexpr size_t FLUSH_BYTES = 1 << 20;
+
+    thread_local TraceThreadBuffer* t_buffer = nullptr;
+}
+
+/**
+ * Single-writer span log for one thread. The owner publishes each event
+ * with a release store of `count`; a reader that acquires `count` may read
+ * every event below it. Blocks are allocated by the owner on first use and
+ * reused by later sessions: the owner clears count and dropped itself the
+ * first time it records in a new session, then publishes that session's
+ * generation. Readers skip buffers still on an older generation.
+ */
+struct TraceThreadBuffer {
+    uint32_t tid = 0;
+    std::atomic<uint64_t> generation{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<TraceEvent*> blocks[TraceRecorder::MAX_BLOCKS] = {};
+    std::atomic<size_t> count{0};
+    std::atomic<uint64_t> dropped{0};
+};
+
+TraceRecorder& TraceRecorder::instance() {
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+TraceThreadBuffer* TraceRecorder::threadBuffer() {
+    if (!t_buffer) {
+        auto* buffer = new TraceThreadBuffer();
+        std::lock_guard<std::mutex> lock(m_threadsMutex);
+        buffer->tid = static_cast<uint32_t>(m_threads.size() + 1);
+        m_threads.push_back(buffer);
+        t_buffer = buffer;
+    }
+    return t_buffer;
+}
+
+bool TraceRecorder::start(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        m_lastError = "Cannot create trace file: " + path;
+        return false;
+    }
+    std::fclose(file);
+
+    // Buffers are not touched here: a thread may be mid-append. Moving to a
+    // new generation makes each owner start over on its next span.
+    m_enabled.store(false, std::memory_order_relaxed);
+    m_path = path;
+    m_sessionStartUs = metricsNowUs();
+    m_eventCount = 0;
+    m_droppedCount = 0;
+    m_generation.fetch_add(1, std::memory_order_release);
+    m_enabled.store(true, std::memory_order_release);
+
+    std::cerr << "[Trace] Recording to " << path << std::endl;
+    return true;
+}
+
+void TraceRecorder::record(const char* name, uint64_t startUs, uint64_t durationUs,
+                           const char* argName, int64_t arg) {
+    if (!m_enabled.load(std::memory_order_acquire)) return;
+
+    TraceThreadBuffer* buffer = threadBuffer();
+    const uint64_t generation = m_generation.load(std::memory_order_acquire);
+    if (buffer->generation.load(std::memory_order_relaxed) != generation) {
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+        buffer->generation.store(generation, std::memory_order_release);
+    }
+
+    const size_t index = buffer->count.load(std::memory_order_relaxed);
+    const size_t blockIndex = index / BLOCK_EVENTS;
+    if (blockIndex >= MAX_BLOCKS) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    TraceEvent* block = buffer->blocks[blockIndex].load(std::memory_order_relaxed);
+    if (!block) {
+        block = new TraceEvent[BLOCK_EVENTS];
+        buffer->blocks[blockIndex].store(block, std::memory_order_release);
+    }
+    block[index % BLOCK_EVENTS] = TraceEvent{name, argName, arg, startUs, durationUs};
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void TraceRecorder::setThreadName(const char* name) {
+    threadBuffer()->name.store(name, std::memory_order_relaxed);
+}
+
+namespace {
+    void appendMetadata(std::string& out, const char* kind, uint32_t tid, const char* name) {
+        out += "{\"name\":\"";
+        out += kind;
+        out += "\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+        out += std::to_string(tid);
+        out += ",\"args\":{\"name\":\"";
+        out += name;
+        out += "\"}}";
+    }
+
+    // Serialize all buffers; with a file the text is written out as it grows
+    uint64_t writeTrace(std::string& out, std::FILE* file, uint64_t generation, uint64_t sessionStartUs,
+                        const std::vector<TraceThreadBuffer*>& threads, bool* ok) {
+        uint64_t events = 0;
+        out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        appendMetadata(out, "process_name", 0, "phantom-audio");
+
+        for (const TraceThreadBuffer* buffer : threads) {
+            if (buffer->generation.load(std::memory_order_acquire) != generation) continue;
+            const size_t count = buffer->count.load(std::memory_order_acquire);
+            const char* threadName = buffer->name.load(std::memory_order_relaxed);
+            if (count == 0) continue;
+
+            const std::string tid = std::to_string(buffer->tid);
+            if (threadName) {
+                out += ',';
+                appendMetadata(out, "thread_name", buffer->tid, threadName);
+            }
+
+            for (size_t i = 0; i < count; ++i) {
+                const TraceEvent* block =
+                    buffer->blocks[i / TraceRecorder::BLOCK_EVENTS].load(std::memory_order_acquire);
+                const TraceEvent& e = block[i % TraceRecorder::BLOCK_EVENTS];
+                // A span still open when the session was restarted can predate it
+                if (e.startUs < sessionStartUs) continue;
+
+                out += ",{\"name\":\"";
+                out += e.name;
+                out += "\",\"cat\":\"pipeline\",\"ph\":\"X\",\"ts\":";
+                out += std::to_string(e.startUs - sessionStartUs);
+                out += ",\"dur\":";
+                out += std::to_string(e.durationUs);
+                out += ",\"pid\":1,\"tid\":";
+                out += tid;
+                if (e.argName) {
+                    out += ",\"args\":{\"";
+                    out += e.argName;
+                    out += "\":";
+                    out += std::to_string(e.arg);
+                    out += '}';
+                }
+                out += '}';
+                ++events;
+
+                if (file && out.size() >= FLUSH_BYTES) {
+                    *ok &= std::fwrite(out.data(), 1, out.size(), file) == out.size();
+                    out.clear();
+                }
+            }
+        }
+        out += "]}\n";
+        return events;
+    }
+}
+
+void TraceRecorder::appendJson(std::string& out) const {
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+    bool ok = true;
+    writeTrace(out, nullptr, m_generation.load(std::memory_order_acquire), m_sessionStartUs, m_threads, &ok);
+}
+
+bool TraceRecorder::stop() {
+    if (!m_enabled.exchange(false, std::memory_order_acq_rel)) {
+        m_lastError = "Tracing is not enabled";
+        return false;
+    }
+
+    std::FILE* file = std::fopen(m_path.c_str(), "wb");
+    if (!file) {
+        m_lastError = "Cannot write trace file: " + m_path;
+        return false;
+    }
+
+    bool ok = true;
+    std::string out;
+    out.reserve(FLUSH_BYTES + 4096);
+    {
+        std::lock_guard<std::mutex> lock(m_threadsMutex);
+        const uint64_t generation = m_generation.load(std::memory_order_acquire);
+        m_eventCount = writeTrace(out, file, generation, m_sessionStartUs, m_threads, &ok);
+        m_droppedCount = 0;
+        for (const TraceThreadBuffer* buffer : m_threads) {
+            if (buffer->generation.load(std::memory_order_acquire) != generation) continue;
+            m_droppedCount += buffer->dropped.load(std::memory_order_relaxed);
+        }
+    }
+    ok &= std::fwrite(out.data(), 1, out.size(), file) == out.size();
+    ok &= std::fclose(file) == 0;
+
+    if (!ok) {
+        m_lastError = "Failed writing trace file: " + m_path;
+        return false;
+    }
+    std::cerr << "[Trace] Wrote " << m_eventCount << " spans to " << m_path;
+    if (m_droppedCount > 0) std::cerr << " (" << m_droppedCount << " dropped)";
+    std::cerr << std::endl;
+    return true;
+}
+
+} // namespace phantom
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "pipeline_metrics.h"
+
+namespace phantom {
+
+struct TraceThreadBuffer;
+
+/**
+ * Opt-in span recorder producing Chrome trace-event JSON (opens in
+ * chrome://tracing and ui.perfetto.dev). Each thread appends to its own
+ * buffer without locks or allocation on the hot path; the buffers are only
+ * walked when the trace is written. While disabled a span costs one
+ * relaxed atomic load.
+ */
+class TraceRecorder {
+public:
+    // Events kept per thread per session; further spans are counted as dropped
+    static constexpr size_t BLOCK_EVENTS = 4096;
+    static constexpr size_t MAX_BLOCKS = 256;
+
+    static TraceRecorder& instance();
+
+    /**
+     * Start a new session that will be written to `path` on stop().
+     * Restarting discards the previous session's spans.
+     * @return false (see getLastError) if the file cannot be created
+     */
+    bool start(const std::string& path);
+
+    /**
+     * Stop recording and write the trace file
+     * @return false (see getLastError) if writing failed
+     */
+    bool stop();
+
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+    const std::string& getPath() const { return m_path; }
+    const std::string& getLastError() const { return m_lastError; }
+
+    // Spans recorded / dropped in the last stopped session
+    uint64_t eventCount() const { return m_eventCount; }
+    uint64_t droppedCount() const { return m_droppedCount; }
+
+    /**
+     * Record a complete span. `name` and `argName` must be string literals
+     * (they are stored by pointer). Timestamps are metricsNowUs() values.
+     */
+    void record(const char* name, uint64_t startUs, uint64_t durationUs,
+                const char* argName = nullptr, int64_t arg = 0);
+
+    // Label the calling thread in the trace (string literal)
+    void setThreadName(const char* name);
+
+    // Serialize the current spans as Chrome trace JSON
+    void appendJson(std::string& out) const;
+
+private:
+    TraceRecorder() = default;
+    TraceThreadBuffer* threadBuffer();
+
+    std::atomic<bool> m_enabled{false};
+    // Bumped by start(); each thread clears its own buffer when it sees a
+    // new generation, so no other thread ever writes a buffer's count
+    std::atomic<uint64_t> m_generation{0};
+    uint64_t m_sessionStartUs = 0;
+    std::string m_path;
+    std::string m_lastError;
+    uint64_t m_eventCount = 0;
+    uint64_t m_droppedCount = 0;
+
+    // Registered thread buffers; they live until process exit since
+    // thread_local pointers to them may outlive a session
+    mutable std::mutex m_threadsMutex;
+    std::vector<TraceThreadBuffer*> m_threads;
+};
+
+/**
+ * RAII span: records [construction, destruction) when tracing is on.
+ */
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, const char* argName = nullptr, int64_t arg = 0)
+        : m_name(name), m_argName(argName), m_arg(arg),
+          m_start(TraceRecorder::instance().isEnabled() ? metricsNowUs() : 0) {}
+    ~TraceSpan() {
+        if (m_start != 0 && TraceRecorder::instance().isEnabled()) {
+            TraceRecorder::instance().record(m_name, m_start, metricsNowUs() - m_start, m_argName, m_arg);
+        }
+    }
+
+    // Attach a value known only once the span is running
+    void setArg(const char* argName, int64_t arg) { m_argName = argName; m_arg = arg; }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* m_name;
+    const char* m_argName;
+    int64_t m_arg;
+    uint64_t m_start;
+};
+
+} // namespace phantom
@@ -0,0 +1,77 @@
+#include "transcript_delta.h"
+
+#include <algorithm>
+
+namespace phantom {
+
+namespace {
+
+bool isContinuationByte(char c) {
+    return (static_cast<uint8_t>(c) & 0xC0) == 0x80;
+}
+
+} // namespace
+
+bool TranscriptDeltaEncoder::encode(uint64_t segment, const std::string& text, TranscriptDelta& delta) {
+    delta.segment = segment;
+    if (!m_open || segment != m_segment) {
+        m_open = true;
+        m_segment = segment;
+        m_text = text;
+        delta.keep = 0;
+        delta.text = text;
+        return true;
+    }
+    if (text == m_text) return false;
+
+    // Shared bytes, backed off to the start of a character so a changed
+    // character is replaced whole
+    const size_t limit = std::min(text.size(), m_text.size());
+    size_t common = 0;
+    while (common < limit && text[common] == m_text[common]) ++common;
+    while (common > 0 && ((common < text.size() && isContinuationByte(text[common])) ||
+                          (common < m_text.size() && isContinuationByte(m_text[common])))) {
+        --common;
+    }
+
+    delta.keep = utf16Length(text.data(), common);
+    delta.text.assign(text, common, std::string::npos);
+    m_text = text;
+    return true;
+}
+
+void TranscriptDeltaEncoder::finish(uint64_t segment) {
+    if (m_open && segment == m_segment) {
+        m_open = false;
+        m_text.clear();
+    }
+}
+
+void TranscriptDeltaEncoder::reset() {
+    m_open = false;
+    m_segment = 0;
+    m_text.clear();
+}
+
+size_t utf16Length(const char* data, size_t length) {
+    // One unit per character, two for those beyond the BMP (4-byte UTF-8)
+    size_t units = 0;
+    for (size_t i = 0; i < length; ++i) {
+        const uint8_t byte = static_cast<uint8_t>(data[i]);
+        if ((byte & 0xC0) != 0x80) ++units;
+        if (byte >= 0xF0) ++units;
+    }
+    return units;
+}
+
+size_t completeUtf8Length(const char* data, size_t length) {
+    // Back up to the last lead byte and see whether its sequence fits
+    size_t lead = length;
+    while (lead > 0 && length - lead < 4 && isContinuationByte(data[lead - 1])) --lead;
+    if (lead == 0) return length;
+    const uint8_t byte = static_cast<uint8_t>(data[lead - 1]);
+    const size_t needed = byte >= 0xF0 ? 4 : byte >= 0xE0 ? 3 : byte >= 0xC0 ? 2 : 1;
+    return length - lead + 1 >= needed ? length : lead - 1;
+}
+
+} // namespace phantom
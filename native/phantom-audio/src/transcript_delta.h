@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace phantom {
+
+/**
+ * A partial transcript as an edit of the last one sent for its segment:
+ * keep the first `keep` characters, then append `text`. `keep` counts
+ * UTF-16 code units, the way the renderer's strings index.
+ */
+struct TranscriptDelta {
+    uint64_t segment = 0;
+    size_t keep = 0;
+    std::string text;
+};
+
+/**
+ * Turns successive partial hypotheses of a segment into deltas, so what a
+ * partial costs to send and render scales with what changed rather than
+ * with the length of the utterance. The first partial of a segment is
+ * sent whole (keep 0). Not thread-safe.
+ */
+class TranscriptDeltaEncoder {
+public:
+    /**
+     * Delta from the last partial of `segment` to `text`
+     * @return false if the text has not changed
+     */
+    bool encode(uint64_t segment, const std::string& text, TranscriptDelta& delta);
+
+    // The segment got its final; forget its text
+    void finish(uint64_t segment);
+
+    void reset();
+
+private:
+    bool m_open = false;
+    uint64_t m_segment = 0;
+    std::string m_text;
+};
+
+// Length in UTF-16 code units of UTF-8 text
+size_t utf16Length(const char* data, size_t length);
+
+// Length of UTF-8 text without a character cut off at its end
+size_t completeUtf8Length(const char* data, size_t length);
+
+} // namespace phantom
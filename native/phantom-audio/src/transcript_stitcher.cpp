@@ -0,0 +1,151 @@
+#include "transcript_stitcher.h"
+
+#include <algorithm>
+
+namespace phantom {
+
+namespace {
+
+// Ids compared at the seam; longer repeats are not timestamp drift
+constexpr size_t SEAM_TOKENS = 8;
+
+// How far past the committed end a repeated word may start (100ms)
+constexpr uint64_t SEAM_TOLERANCE_SAMPLES = 1600;
+
+// Scripts written without spaces between words, where every character
+// is a place a word may end: Thai, Lao, Myanmar, Khmer, CJK and kana
+constexpr uint32_t UNSPACED_RANGES[][2] = {
+    {0x0E00, 0x0EFF}, {0x1000, 0x109F}, {0x1780, 0x17FF}, {0x2E80, 0x9FFF},
+    {0xF900, 0xFAFF}, {0xFF00, 0xFFEF}, {0x20000, 0x3FFFF},
+};
+
+bool continuesCharacter(const std::string& text) {
+    return !text.empty() && (static_cast<uint8_t>(text[0]) & 0xC0) == 0x80;
+}
+
+// Whether the character `text` starts with is from an unspaced script. A
+// byte-level token may hold only the first bytes of a character; it counts
+// when every completion of those bytes is in the same range.
+bool startsUnspacedCharacter(const std::string& text) {
+    const uint8_t lead = text.empty() ? 0 : static_cast<uint8_t>(text[0]);
+    size_t length = 0;
+    uint32_t low = 0;
+    if (lead >= 0xF0 && lead < 0xF8) { length = 4; low = lead & 0x07; }
+    else if (lead >= 0xE0) { length = 3; low = lead & 0x0F; }
+    else if (lead >= 0xC0) { length = 2; low = lead & 0x1F; }
+    if (length == 0 || lead >= 0xF8) return false;
+
+    uint32_t high = low;
+    for (size_t i = 1; i < length; ++i) {
+        const bool known = i < text.size() && (static_cast<uint8_t>(text[i]) & 0xC0) == 0x80;
+        const uint32_t bits = known ? static_cast<uint8_t>(text[i]) & 0x3F : 0;
+        low = (low << 6) | bits;
+        high = (high << 6) | (known ? bits : 0x3F);
+    }
+    for (const auto& range : UNSPACED_RANGES) {
+        if (low >= range[0] && high <= range[1]) return true;
+    }
+    return false;
+}
+
+// Whisper's BPE marks a new word with a leading space; other tokens
+// continue the previous word or attach punctuation to it. Characters of
+// unspaced scripts each start a word, and when a chunk has no spaces at
+// all every token but the tail of a split character does.
+bool startsWord(const std::string& text, bool spaced) {
+    if (text.empty() || continuesCharacter(text)) return false;
+    return text[0] == ' ' || !spaced || startsUnspacedCharacter(text);
+}
+
+bool hasSpacedWords(const std::vector<StreamToken>& tokens) {
+    return std::any_of(tokens.begin(), tokens.end(),
+                       [](const StreamToken& token) { return !token.text.empty() && token.text[0] == ' '; });
+}
+
+uint64_t midpoint(const StreamToken& token) {
+    return token.startSample + (std::max(token.endSample, token.startSample) - token.startSample) / 2;
+}
+
+// Text of tokens [begin, end) without surrounding whitespace
+std::string joinTrimmed(const std::vector<StreamToken>& tokens, size_t begin, size_t end) {
+    std::string text;
+    for (size_t i = begin; i < end; ++i) text += tokens[i].text;
+    const size_t first = text.find_first_not_of(" \t\n\r");
+    if (first == std::string::npos) return "";
+    const size_t last = text.find_last_not_of(" \t\n\r");
+    return text.substr(first, last - first + 1);
+}
+
+template <typename T>
+void keepLast(std::vector<T>& values, size_t count) {
+    if (values.size() > count) {
+        values.erase(values.begin(), values.end() - static_cast<std::ptrdiff_t>(count));
+    }
+}
+
+} // namespace
+
+void TranscriptStitcher::reset() {
+    m_prompt.clear();
+    m_recent.clear();
+    m_committedEnd = 0;
+    m_dropped = 0;
+    m_pending.clear();
+}
+
+void TranscriptStitcher::setMaxPromptTokens(size_t count) {
+    m_maxPromptTokens = count;
+    keepLast(m_prompt, count);
+}
+
+// Token timestamps drift by a frame or two between decodes, so a word
+// ending the last commit may come back just past it. A repeat of the last
+// committed ids starting right at the seam is that word again.
+size_t TranscriptStitcher::repeatAtSeam(const std::vector<StreamToken>& tokens, size_t begin, bool spaced) const {
+    if (begin >= tokens.size() || m_recent.empty()) return 0;
+    if (tokens[begin].startSample >= m_committedEnd + SEAM_TOLERANCE_SAMPLES) return 0;
+
+    const size_t longest = std::min(m_recent.size(), tokens.size() - begin);
+    for (size_t length = longest; length > 0; --length) {
+        const bool wholeWords = begin + length == tokens.size() || startsWord(tokens[begin + length].text, spaced);
+        if (wholeWords && std::equal(m_recent.end() - static_cast<std::ptrdiff_t>(length), m_recent.end(),
+                                     tokens.begin() + static_cast<std::ptrdiff_t>(begin),
+                                     [](int32_t id, const StreamToken& token) { return id == token.id; })) {
+            return length;
+        }
+    }
+    return 0;
+}
+
+std::string TranscriptStitcher::stitch(const std::vector<StreamToken>& tokens, uint64_t commitLimit) {
+    const bool spaced = hasSpacedWords(tokens);
+
+    // Audio an earlier chunk committed, the rest of any word cut there, and
+    // the tail of a character whose first bytes the chunk does not have
+    size_t begin = 0;
+    while (begin < tokens.size() &&
+           (midpoint(tokens[begin]) < m_committedEnd || continuesCharacter(tokens[begin].text) ||
+            (begin > 0 && !startsWord(tokens[begin].text, spaced)))) {
+        ++begin;
+    }
+    begin += repeatAtSeam(tokens, begin, spaced);
+    m_dropped = begin;
+
+    // Words that start before the limit, finished; the rest is the next chunk's
+    size_t end = begin;
+    while (end < tokens.size() && tokens[end].startSample < commitLimit) ++end;
+    while (end < tokens.size() && end > begin && !startsWord(tokens[end].text, spaced)) ++end;
+    m_pending = joinTrimmed(tokens, end, tokens.size());
+    if (end == begin) return "";
+
+    for (size_t i = begin; i < end; ++i) {
+        m_prompt.push_back(tokens[i].id);
+        m_recent.push_back(tokens[i].id);
+    }
+    keepLast(m_prompt, m_maxPromptTokens);
+    keepLast(m_recent, SEAM_TOKENS);
+    m_committedEnd = std::max(m_committedEnd, std::max(tokens[end - 1].endSample, tokens[end - 1].startSample));
+    return joinTrimmed(tokens, begin, end);
+}
+
+} // namespace phantom
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace phantom {
+
+/**
+ * One decoded text token placed on the stream clock: 16kHz samples
+ * counted from WhisperWrapper::start(), like TranscriptSource.
+ */
+struct StreamToken {
+    int32_t id = 0;
+    uint64_t startSample = 0;
+    uint64_t endSample = 0;
+    std::string text;           // As whisper spells it, with its leading space; bytes, not always whole characters
+};
+
+// Commit limit for a chunk that nothing will overlap (a flush or the last one)
+constexpr uint64_t COMMIT_ALL = UINT64_MAX;
+
+/**
+ * Joins the tokens of overlapping chunks into one transcript in which each
+ * word appears once, and keeps the committed tokens as the prompt for the
+ * next decode.
+ *
+ * Consecutive chunks share some audio. Tokens in that overlap are committed
+ * by one chunk only: a chunk commits the words that start before its
+ * commit limit (where the next chunk begins), and the next chunk, which
+ * hears the rest of them with more context, drops whatever lies in audio
+ * already committed. Decisions are made per word, so a word is never
+ * split between chunks. In scripts written without spaces (Chinese,
+ * Japanese, Thai) each character counts as a word.
+ */
+class TranscriptStitcher {
+public:
+    // Forget everything (new stream)
+    void reset();
+
+    // Forget the prompt but keep the stream position (e.g. the language changed)
+    void clearPrompt() { m_prompt.clear(); }
+
+    // Keep at most `count` tokens of prompt (0 = decode every chunk cold)
+    void setMaxPromptTokens(size_t count);
+
+    // Most recently committed tokens, oldest first
+    const std::vector<int32_t>& prompt() const { return m_prompt; }
+
+    // End of the last committed token
+    uint64_t committedSample() const { return m_committedEnd; }
+
+    /**
+     * Commit the new part of one chunk's tokens (in decode order) and
+     * return its text, whitespace-trimmed. Words starting at or after
+     * `commitLimit` are left for the next chunk.
+     */
+    std::string stitch(const std::vector<StreamToken>& tokens, uint64_t commitLimit);
+
+    // Tokens the last stitch() dropped as already committed
+    size_t droppedTokens() const { return m_dropped; }
+
+    // Words the last stitch() left for the next chunk, whitespace-trimmed:
+    // a guess at what comes next, for partial transcripts
+    const std::string& pendingText() const { return m_pending; }
+
+private:
+    size_t repeatAtSeam(const std::vector<StreamToken>& tokens, size_t begin, bool spaced) const;
+
+    std::vector<int32_t> m_prompt;
+    std::vector<int32_t> m_recent;      // Last few committed ids, for the seam check
+    size_t m_maxPromptTokens = 64;
+    uint64_t m_committedEnd = 0;
+    size_t m_dropped = 0;
+    std::string m_pending;
+};
+
+} // namespace phantom
@@ -0,0 +1,34 @@
+#include "transcription_config.h"
+
+namespace phantom {
+
+const char* vadModeName(VadMode mode) {
+    switch (mode) {
+        case VadMode::Off: return "off";
+        case VadMode::Normal: return "normal";
+        case VadMode::Aggressive: return "aggressive";
+    }
+    return "normal";
+}
+
+bool parseVadMode(std::string_view name, VadMode* mode) {
+    const VadMode modes[] = {VadMode::Off, VadMode::Normal, VadMode::Aggressive};
+    for (VadMode candidate : modes) {
+        if (name == vadModeName(candidate)) {
+            *mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+float vadThreshold(VadMode mode) {
+    switch (mode) {
+        case VadMode::Off: return 0.0f;
+        case VadMode::Normal: return 0.01f;
+        case VadMode::Aggressive: return 0.02f;
+    }
+    return 0.01f;
+}
+
+} // namespace phantom
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+namespace phantom {
+
+/**
+ * How aggressively silence is trimmed from a chunk before it is decoded.
+ * Off decodes chunks as captured; Aggressive also drops quiet speech-free
+ * edges that Normal keeps, trading recall on soft speech for fewer
+ * hallucinations and less decode time.
+ */
+enum class VadMode {
+    Off,
+    Normal,
+    Aggressive
+};
+
+const char* vadModeName(VadMode mode);
+bool parseVadMode(std::string_view name, VadMode* mode);
+
+// Mean-absolute-amplitude threshold used by trimSilence (0 = no trimming)
+float vadThreshold(VadMode mode);
+
+/**
+ * Tuning knobs for live transcription. Changed at runtime with
+ * {"cmd":"config",...}; a new config is picked up between chunks, never
+ * part-way through one.
+ */
+struct TranscriptionConfig {
+    int chunkMs = 2000;
+    int threads = 0;                // 0 = all hardware threads
+    int beamSize = 1;               // 1 = greedy decoding
+    std::string language = "en";    // Whisper language code or "auto"
+    VadMode vad = VadMode::Normal;
+    int contextTokens = 64;         // Prompt carried between chunks; 0 = decode each chunk cold
+    int decodeBudgetMs = 1000;      // Per-chunk time for re-decoding doubtful results; 0 = never
+    bool denoise = false;           // Spectral noise suppression ahead of the transcriber
+    int silenceFlushMs = 300;       // Digital silence that ends an utterance; shorter gaps stay inline
+};
+
+// Accepted ranges for config fields. Chunks keep 500ms of overlap, so they
+// must be longer than that to make progress.
+constexpr int MIN_CHUNK_MS = 1000;
+constexpr int MAX_CHUNK_MS = 30000;
+constexpr int MAX_THREADS = 64;
+constexpr int MAX_BEAM_SIZE = 8;
+constexpr size_t MAX_LANGUAGE_LENGTH = 7;
+constexpr int MAX_CONTEXT_TOKENS = 224;     // Half of whisper's text context, its own prompt limit
+constexpr int MAX_DECODE_BUDGET_MS = 30000;
+constexpr int MAX_SILENCE_FLUSH_MS = 10000;
+
+} // namespace phantom
@@ -0,0 +1,42 @@
+#include "transcription_engine.h"
+#include "pipeline_metrics.h"
+#include "repetition_guard.h"
+
+namespace phantom {
+
+namespace {
+    constexpr size_t SAMPLE_RATE = 16000;
+}
+
+bool decodeGuarded(TranscriptionEngine& engine, DecodeRequest request, DecodeResult& result,
+                   DecodeQuality* quality) {
+    // Bound the work a chunk can take: a token limit in line with its length
+    request.maxTokens = maxTokensForAudio(request.numSamples, SAMPLE_RATE, request.language);
+    if (!engine.decode(request, result)) {
+        return false;
+    }
+
+    PipelineMetrics& stats = metrics();
+    if (result.generatedTokens >= request.maxTokens) {
+        stats.tokenCapHits.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // A loop, whether stopped early or by the limit, keeps its first repeat
+    std::vector<int32_t> ids;
+    ids.reserve(result.tokens.size());
+    for (const StreamToken& token : result.tokens) ids.push_back(token.id);
+    const RepetitionLoop loop = findRepetitionLoop(ids.data(), ids.size());
+    if (loop.found()) {
+        stats.decodeLoops.fetch_add(1, std::memory_order_relaxed);
+        result.tokens.resize(loop.keep());
+        result.logprobs.resize(loop.keep());
+    }
+
+    std::string decodedText;
+    for (const StreamToken& token : result.tokens) decodedText += token.text;
+    *quality = measureDecodeQuality(result.logprobs, decodedText);
+    quality->looped = loop.found();
+    return true;
+}
+
+} // namespace phantom
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "decode_policy.h"
+#include "transcript_stitcher.h"
+
+namespace phantom {
+
+/**
+ * One decoding pass over a chunk of 16kHz mono audio
+ */
+struct DecodeRequest {
+    const float* samples = nullptr;
+    size_t numSamples = 0;
+    uint64_t firstSample = 0;                       // Stream position of samples[0]
+    DecodeAttempt attempt;                          // Strategy (see DecodePolicy)
+    const char* language = "en";                    // Language code, or "auto" to detect per chunk
+    int threads = 1;
+    const std::vector<int32_t>* prompt = nullptr;   // Committed tokens to condition on
+    int maxTokens = 0;                              // Token limit for the pass (0 = none)
+};
+
+/**
+ * What a pass produced. Tokens are text only (no timestamps or other
+ * specials) and placed on the stream clock, clamped to the chunk.
+ */
+struct DecodeResult {
+    std::vector<StreamToken> tokens;
+    std::vector<float> logprobs;        // One per token
+    int generatedTokens = 0;            // Every token generated, specials included
+
+    // Encoder/decoder split, when the engine reports one (0 = unknown)
+    uint64_t encodeUs = 0;
+    uint64_t decodeUs = 0;
+    uint64_t encoderBeginUs = 0;        // Set while tracing: when the encoder started
+};
+
+/**
+ * Speech-to-text backend behind WhisperWrapper's chunking, stitching and
+ * decode policy. WhisperEngine runs whisper.cpp; MockEngine returns
+ * scripted text after a scripted delay, so the rest of the pipeline can be
+ * tested and benchmarked without a model. Calls come from the processing
+ * thread only.
+ */
+class TranscriptionEngine {
+public:
+    virtual ~TranscriptionEngine() = default;
+
+    // Short name for logs ("whisper", "mock")
+    virtual const char* name() const = 0;
+
+    /**
+     * Language ids: codes map to ids in [0, maxLanguageId()], and
+     * detectLanguage() reports a probability for each
+     * @return -1 if `code` is not supported
+     */
+    virtual int languageId(const std::string& code) const = 0;
+    virtual const char* languageCode(int id) const = 0;
+    virtual int maxLanguageId() const = 0;
+
+    /**
+     * Probability of each language id for `samples`
+     * @param probs Resized to maxLanguageId() + 1
+     * @return false if detection could not run
+     */
+    virtual bool detectLanguage(const float* samples, size_t numSamples, int threads,
+                                std::vector<float>& probs) = 0;
+
+    // Run one pass; false (see getLastError) if it failed
+    virtual bool decode(const DecodeRequest& request, DecodeResult& result) = 0;
+
+    const std::string& getLastError() const { return m_lastError; }
+
+protected:
+    std::string m_lastError;
+};
+
+/**
+ * One pass through `engine` with the guards every caller applies: a token
+ * limit in line with the audio's length (request.maxTokens is set here,
+ * see maxTokensForAudio) and a repetition loop at the end of the result
+ * cut back to its first repeat. Engines that can also end a looping
+ * sequence early (WhisperEngine's logits filter) do so on their own.
+ * Counts token-limit hits and loops in metrics().
+ * @param quality Measured on the tokens kept
+ * @return false (see engine.getLastError()) if the pass failed
+ */
+bool decodeGuarded(TranscriptionEngine& engine, DecodeRequest request, DecodeResult& result,
+                   DecodeQuality* quality);
+
+} // namespace phantom
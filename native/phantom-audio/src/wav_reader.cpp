@@ -0,0 +1,160 @@
+#include "wav_reader.h"
+
+#include <cstring>
+
+namespace phantom {
+
+namespace {
+    constexpr uint16_t WAVE_FORMAT_PCM = 0x0001;
+    constexpr uint16_t WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+    constexpr uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+    uint16_t getLE16(const uint8_t* p) {
+        return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    uint32_t getLE32(const uint8_t* p) {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+}
+
+WavReader::~WavReader() {
+    close();
+}
+
+void WavReader::close() {
+    if (m_file) {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+bool WavReader::open(const std::string& path) {
+    close();
+    m_totalFrames = 0;
+    m_framesRead = 0;
+
+    m_file = std::fopen(path.c_str(), "rb");
+    if (!m_file) {
+        m_lastError = "Cannot open " + path;
+        return false;
+    }
+
+    uint8_t riff[12];
+    if (std::fread(riff, 1, sizeof(riff), m_file) != sizeof(riff) ||
+        std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0) {
+        m_lastError = "Not a RIFF/WAVE file: " + path;
+        close();
+        return false;
+    }
+
+    // Walk the chunks until "data"; "fmt " must come before it
+    bool haveFormat = false;
+    uint16_t formatTag = 0;
+    for (;;) {
+        uint8_t header[8];
+        if (std::fread(header, 1, sizeof(header), m_file) != sizeof(header)) {
+            m_lastError = "No data chunk in " + path;
+            close();
+            return false;
+        }
+        const uint32_t size = getLE32(header + 4);
+
+        if (std::memcmp(header, "fmt ", 4) == 0) {
+            uint8_t fmt[40] = {};
+            const size_t toRead = size < sizeof(fmt) ? size : sizeof(fmt);
+            if (size < 16 || std::fread(fmt, 1, toRead, m_file) != toRead) {
+                m_lastError = "Truncated fmt chunk in " + path;
+                close();
+                return false;
+            }
+            formatTag = getLE16(fmt);
+            m_channels = getLE16(fmt + 2);
+            m_sampleRate = getLE32(fmt + 4);
+            m_bitsPerSample = getLE16(fmt + 14);
+            if (formatTag == WAVE_FORMAT_EXTENSIBLE && size >= 26) {
+                formatTag = getLE16(fmt + 24);  // First two bytes of the subformat GUID
+            }
+            haveFormat = true;
+            // Skip the rest of the chunk (and its pad byte)
+            std::fseek(m_file, static_cast<long>(size - toRead + (size & 1)), SEEK_CUR);
+        } else if (std::memcmp(header, "data", 4) == 0) {
+            if (!haveFormat) {
+                m_lastError = "data chunk before fmt chunk in " + path;
+                close();
+                return false;
+            }
+            const uint32_t frameBytes = static_cast<uint32_t>(m_channels) * (m_bitsPerSample / 8);
+            m_totalFrames = frameBytes ? size / frameBytes : 0;
+            break;
+        } else {
+            std::fseek(m_file, static_cast<long>(size + (size & 1)), SEEK_CUR);
+        }
+    }
+
+    m_float = formatTag == WAVE_FORMAT_IEEE_FLOAT;
+    const bool supported = m_channels > 0 && m_sampleRate > 0 &&
+        ((formatTag == WAVE_FORMAT_PCM &&
+          (m_bitsPerSample == 16 || m_bitsPerSample == 24 || m_bitsPerSample == 32)) ||
+         (m_float && m_bitsPerSample == 32));
+    if (!supported) {
+        m_lastError = "Unsupported WAV encoding (format " + std::to_string(formatTag) + ", " +
+                      std::to_string(m_bitsPerSample) + "-bit) in " + path;
+        close();
+        return false;
+    }
+    return true;
+}
+
+size_t WavReader::read(float* out, size_t maxFrames) {
+    if (!m_file || m_framesRead >= m_totalFrames) return 0;
+
+    const uint64_t remaining = m_totalFrames - m_framesRead;
+    const size_t frames = static_cast<size_t>(remaining < maxFrames ? remaining : maxFrames);
+    const size_t bytesPerSample = m_bitsPerSample / 8;
+    const size_t samples = frames * m_channels;
+
+    m_raw.resize(samples * bytesPerSample);
+    const size_t got = std::fread(m_raw.data(), 1, m_raw.size(), m_file) / (bytesPerSample * m_channels);
+    const size_t gotSamples = got * m_channels;
+    const uint8_t* p = m_raw.data();
+
+    if (m_float) {
+        std::memcpy(out, p, gotSamples * sizeof(float));
+    } else if (m_bitsPerSample == 16) {
+        for (size_t i = 0; i < gotSamples; ++i) {
+            out[i] = static_cast<float>(static_cast<int16_t>(getLE16(p + 2 * i))) / 32768.0f;
+        }
+    } else if (m_bitsPerSample == 24) {
+        for (size_t i = 0; i < gotSamples; ++i) {
+            const uint8_t* s = p + 3 * i;
+            // Sign-extend via the top byte of an int32
+            const int32_t v = static_cast<int32_t>(static_cast<uint32_t>(s[0]) << 8 |
+                                                   static_cast<uint32_t>(s[1]) << 16 |
+                                                   static_cast<uint32_t>(s[2]) << 24) >> 8;
+            out[i] = static_cast<float>(v) / 8388608.0f;
+        }
+    } else {
+        for (size_t i = 0; i < gotSamples; ++i) {
+            out[i] = static_cast<float>(static_cast<int32_t>(getLE32(p + 4 * i))) / 2147483648.0f;
+        }
+    }
+
+    m_framesRead += got;
+    if (got < frames) {
+        // Truncated file: stop at what was actually there
+        m_totalFrames = m_framesRead;
+    }
+    return got;
+}
+
+std::vector<float> WavReader::readAll() {
+    const uint64_t remaining = m_totalFrames - m_framesRead;
+    std::vector<float> samples(static_cast<size_t>(remaining) * m_channels);
+    const size_t frames = read(samples.data(), static_cast<size_t>(remaining));
+    samples.resize(frames * m_channels);
+    return samples;
+}
+
+} // namespace phantom
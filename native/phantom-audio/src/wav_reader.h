@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace phantom {
+
+/**
+ * Streaming reader for RIFF/WAVE files: 16/24/32-bit integer PCM and
+ * 32-bit float, any rate and channel count (WAVE_FORMAT_EXTENSIBLE
+ * included). Samples come out as interleaved float in [-1, 1), in the
+ * same scaling AudioCapture uses for device audio.
+ */
+class WavReader {
+public:
+    WavReader() = default;
+    ~WavReader();
+
+    WavReader(const WavReader&) = delete;
+    WavReader& operator=(const WavReader&) = delete;
+
+    /**
+     * Open a file and parse its header
+     * @return false (see getLastError) if it is missing or not supported
+     */
+    bool open(const std::string& path);
+    void close();
+
+    /**
+     * Read up to maxFrames frames (maxFrames * channels() samples)
+     * @return frames read; 0 at the end of the data
+     */
+    size_t read(float* out, size_t maxFrames);
+
+    // Read every remaining frame
+    std::vector<float> readAll();
+
+    uint32_t sampleRate() const { return m_sampleRate; }
+    uint16_t channels() const { return m_channels; }
+    uint64_t totalFrames() const { return m_totalFrames; }
+    double durationSeconds() const {
+        return m_sampleRate ? static_cast<double>(m_totalFrames) / m_sampleRate : 0.0;
+    }
+
+    const std::string& getLastError() const { return m_lastError; }
+
+private:
+    std::FILE* m_file = nullptr;
+    uint32_t m_sampleRate = 0;
+    uint16_t m_channels = 0;
+    uint16_t m_bitsPerSample = 0;
+    bool m_float = false;
+    uint64_t m_totalFrames = 0;
+    uint64_t m_framesRead = 0;
+    std::vector<uint8_t> m_raw;
+    std::string m_lastError;
+};
+
+} // namespace phantom
@@ -0,0 +1,251 @@
+#include "whisper_engine.h"
+#include "whisper.h"
+#include "pipeline_metrics.h"
+#include "repetition_guard.h"
+#include "trace_recorder.h"
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+namespace phantom {
+
+namespace {
+
+constexpr int64_t SAMPLE_RATE = 16000;
+
+// Text tokens looked at for a loop: enough for MIN_LOOP_REPEATS of the longest n-gram
+constexpr size_t LOOP_WINDOW = 16;
+
+struct LoopGuard {
+    whisper_token eot = 0;
+    int vocabSize = 0;
+};
+
+// Whisper's logits callback, run before each token is sampled (from
+// several threads at once with multiple decoders). A sequence that has
+// started looping gets end-of-text as its only choice, so a runaway decode
+// costs a few tokens instead of running to the token limit.
+void endLoopingSequence(whisper_context*, whisper_state*, const whisper_token_data* tokens, int numTokens,
+                        float* logits, void* userData) {
+    const LoopGuard& guard = *static_cast<const LoopGuard*>(userData);
+    int32_t recent[LOOP_WINDOW];
+    size_t count = 0;
+    for (int i = numTokens - 1; i >= 0 && count < LOOP_WINDOW; --i) {
+        if (tokens[i].id < guard.eot) recent[count++] = tokens[i].id;
+    }
+    std::reverse(recent, recent + count);
+    if (!findRepetitionLoop(recent, count).found()) return;
+
+    for (int i = 0; i < guard.vocabSize; ++i) {
+        if (i != guard.eot) logits[i] = -INFINITY;
+    }
+}
+
+} // namespace
+
+WhisperEngine::~WhisperEngine() {
+    if (m_state) {
+        whisper_free_state(m_state);
+        m_state = nullptr;
+    }
+    if (m_context && m_ownsContext) {
+        whisper_free(m_context);
+    }
+    m_context = nullptr;
+}
+
+bool WhisperEngine::loadModel(const std::string& modelPath) {
+    return load(modelPath, true);
+}
+
+bool WhisperEngine::loadSharedModel(const std::string& modelPath) {
+    return load(modelPath, false);
+}
+
+bool WhisperEngine::load(const std::string& modelPath, bool withState) {
+    if (m_context) {
+        whisper_free(m_context);
+        m_context = nullptr;
+    }
+
+    std::cerr << "[Whisper] Loading model: " << modelPath << std::endl;
+
+    // Initialize whisper context
+    struct whisper_context_params cparams = whisper_context_default_params();
+    cparams.use_gpu = true;  // Use GPU if available (CUDA/Metal)
+
+    // A shared model holds only the weights; each worker adds its own state
+    m_context = withState ? whisper_init_from_file_with_params(modelPath.c_str(), cparams)
+                          : whisper_init_from_file_with_params_no_state(modelPath.c_str(), cparams);
+    m_sharedOnly = !withState;
+
+    if (!m_context) {
+        m_lastError = "Failed to load Whisper model from: " + modelPath;
+        std::cerr << "[Whisper] " << m_lastError << std::endl;
+        return false;
+    }
+
+    std::cerr << "[Whisper] Model loaded successfully" << std::endl;
+    return true;
+}
+
+std::unique_ptr<WhisperEngine> WhisperEngine::createWorker() const {
+    if (!m_context) return nullptr;
+    whisper_state* state = whisper_init_state(m_context);
+    if (!state) return nullptr;
+
+    std::unique_ptr<WhisperEngine> worker(new WhisperEngine());
+    worker->m_context = m_context;
+    worker->m_state = state;
+    worker->m_ownsContext = false;
+    return worker;
+}
+
+int WhisperEngine::languageId(const std::string& code) const {
+    return whisper_lang_id(code.c_str());
+}
+
+const char* WhisperEngine::languageCode(int id) const {
+    return whisper_lang_str(id);
+}
+
+int WhisperEngine::maxLanguageId() const {
+    return whisper_lang_max_id();
+}
+
+bool WhisperEngine::detectLanguage(const float* samples, size_t numSamples, int threads,
+                                   std::vector<float>& probs) {
+    if (!m_context || m_sharedOnly) return false;
+    probs.assign(static_cast<size_t>(whisper_lang_max_id()) + 1, 0.0f);
+    if (m_state) {
+        if (whisper_pcm_to_mel_with_state(m_context, m_state, samples, static_cast<int>(numSamples), threads) != 0) {
+            return false;
+        }
+        return whisper_lang_auto_detect_with_state(m_context, m_state, 0, threads, probs.data()) >= 0;
+    }
+    if (whisper_pcm_to_mel(m_context, samples, static_cast<int>(numSamples), threads) != 0) {
+        return false;
+    }
+    return whisper_lang_auto_detect(m_context, 0, threads, probs.data()) >= 0;
+}
+
+// One whisper pass with the given strategy
+bool WhisperEngine::decode(const DecodeRequest& request, DecodeResult& result) {
+    if (!m_context) {
+        m_lastError = "No model loaded";
+        return false;
+    }
+    if (m_sharedOnly) {
+        m_lastError = "The shared model only decodes through its workers";
+        return false;
+    }
+
+    const DecodeAttempt& attempt = request.attempt;
+    const bool beamSearch = attempt.tier == DecodeTier::Beam;
+    whisper_full_params params = whisper_full_default_params(
+        beamSearch ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY);
+    if (beamSearch) {
+        params.beam_search.beam_size = attempt.beamSize;
+    }
+
+    // Fallback is DecodePolicy's call, made against the latency budget;
+    // whisper's built-in one would retry at every temperature up to 1.0
+    params.temperature = attempt.temperature;
+    params.temperature_inc = 0.0f;
+    params.greedy.best_of = attempt.bestOf;
+
+    params.print_realtime = false;
+    params.print_progress = false;
+    params.print_timestamps = false;
+    params.print_special = false;
+    params.translate = false;
+    params.language = request.language;
+    params.n_threads = request.threads;
+    params.offset_ms = 0;
+    params.single_segment = true;
+
+    // Context comes from the stitcher's committed tokens only: whisper's own
+    // carry-over would also hold text that was decoded but never committed
+    params.no_context = true;
+    if (request.prompt && !request.prompt->empty()) {
+        params.prompt_tokens = request.prompt->data();
+        params.prompt_n_tokens = static_cast<int>(request.prompt->size());
+    }
+
+    // Per-token times place the overlap's words against the last commit
+    params.token_timestamps = true;
+
+    // Suppress blank tokens
+    params.suppress_blank = true;
+
+    // Bound the work a chunk can take: the caller's token limit, and an
+    // early end to sequences caught in a loop
+    params.max_tokens = request.maxTokens;
+    LoopGuard loopGuard;
+    loopGuard.eot = whisper_token_eot(m_context);
+    loopGuard.vocabSize = whisper_n_vocab(m_context);
+    params.logits_filter_callback = endLoopingSequence;
+    params.logits_filter_callback_user_data = &loopGuard;
+
+    // Note when the encoder starts so a trace can place encode/decode
+    result.encoderBeginUs = 0;
+    if (TraceRecorder::instance().isEnabled()) {
+        params.encoder_begin_callback = [](whisper_context*, whisper_state*, void* userData) {
+            *static_cast<uint64_t*>(userData) = metricsNowUs();
+            return true;
+        };
+        params.encoder_begin_callback_user_data = &result.encoderBeginUs;
+    }
+
+    // Run inference; whisper keeps timings for the context's own state only
+    int status;
+    if (m_state) {
+        status = whisper_full_with_state(m_context, m_state, params, request.samples,
+                                         static_cast<int>(request.numSamples));
+    } else {
+        whisper_reset_timings(m_context);
+        status = whisper_full(m_context, params, request.samples, static_cast<int>(request.numSamples));
+
+        if (const whisper_timings* timings = whisper_get_timings(m_context)) {
+            result.encodeUs = static_cast<uint64_t>(timings->encode_ms * 1000.0f);
+            result.decodeUs = static_cast<uint64_t>(
+                (timings->decode_ms + timings->batchd_ms + timings->prompt_ms) * 1000.0f);
+        }
+    }
+
+    if (status != 0) {
+        m_lastError = "Transcription failed with code: " + std::to_string(status);
+        std::cerr << "[Whisper] " << m_lastError << std::endl;
+        return false;
+    }
+
+    // Text tokens only; timestamps and other specials sort after EOT.
+    // Token times are in 10ms units from the start of the chunk.
+    const whisper_token eot = loopGuard.eot;
+    const uint64_t firstSample = request.firstSample;
+    const uint64_t lastSample = firstSample + request.numSamples;
+    const int numSegments = m_state ? whisper_full_n_segments_from_state(m_state) : whisper_full_n_segments(m_context);
+    for (int segment = 0; segment < numSegments; ++segment) {
+        const int numTokens = m_state ? whisper_full_n_tokens_from_state(m_state, segment)
+                                      : whisper_full_n_tokens(m_context, segment);
+        result.generatedTokens += numTokens;
+        for (int i = 0; i < numTokens; ++i) {
+            const whisper_token_data data = m_state ? whisper_full_get_token_data_from_state(m_state, segment, i)
+                                                    : whisper_full_get_token_data(m_context, segment, i);
+            const char* text = m_state ? whisper_full_get_token_text_from_state(m_context, m_state, segment, i)
+                                       : whisper_full_get_token_text(m_context, segment, i);
+            if (data.id >= eot || !text) continue;
+
+            StreamToken token;
+            token.id = data.id;
+            token.startSample = std::min(lastSample, firstSample + std::max<int64_t>(data.t0, 0) * SAMPLE_RATE / 100);
+            token.endSample = std::min(lastSample, firstSample + std::max<int64_t>(data.t1, 0) * SAMPLE_RATE / 100);
+            token.text = text;
+            result.logprobs.push_back(data.plog);
+            result.tokens.push_back(std::move(token));
+        }
+    }
+    return true;
+}
+
+} // namespace phantom
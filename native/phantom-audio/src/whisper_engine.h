@@ -0,0 +1,70 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "transcription_engine.h"
+
+// Forward declare whisper types
+struct whisper_context;
+struct whisper_state;
+
+namespace phantom {
+
+/**
+ * whisper.cpp backend. Decodes with per-token timestamps, ends sequences
+ * caught in a repetition loop early, and reports whisper's own
+ * encode/decode split.
+ *
+ * For parallel decoding, one engine loads the model with
+ * loadSharedModel() and createWorker() hands out engines that each decode
+ * on their own whisper_state over it, so a worker costs a state rather
+ * than a model. Workers do not report the encode/decode split.
+ */
+class WhisperEngine : public TranscriptionEngine {
+public:
+    WhisperEngine() = default;
+    ~WhisperEngine() override;
+
+    WhisperEngine(const WhisperEngine&) = delete;
+    WhisperEngine& operator=(const WhisperEngine&) = delete;
+
+    /**
+     * Load a Whisper model
+     * @param modelPath Path to the GGML model file
+     * @return true if model loaded successfully
+     */
+    bool loadModel(const std::string& modelPath);
+
+    /**
+     * Load a model for createWorker() only; this engine cannot decode itself
+     */
+    bool loadSharedModel(const std::string& modelPath);
+
+    /**
+     * An engine decoding on its own state with this engine's model. This
+     * engine must outlive it.
+     * @return nullptr if no model is loaded or no state could be allocated
+     */
+    std::unique_ptr<WhisperEngine> createWorker() const;
+
+    bool isModelLoaded() const { return m_context != nullptr; }
+
+    const char* name() const override { return "whisper"; }
+    int languageId(const std::string& code) const override;
+    const char* languageCode(int id) const override;
+    int maxLanguageId() const override;
+    bool detectLanguage(const float* samples, size_t numSamples, int threads,
+                        std::vector<float>& probs) override;
+    bool decode(const DecodeRequest& request, DecodeResult& result) override;
+
+private:
+    bool load(const std::string& modelPath, bool withState);
+
+    whisper_context* m_context = nullptr;
+    whisper_state* m_state = nullptr;   // A worker's own state (see createWorker)
+    bool m_ownsContext = true;
+    bool m_sharedOnly = false;          // Loaded by loadSharedModel()
+};
+
+} // namespace phantom
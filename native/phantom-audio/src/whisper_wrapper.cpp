@@ -1,5 +1,8 @@
 #include "whisper_wrapper.h"
-#include "whisper.h"
+#include "pipeline_metrics.h"
+#include "trace_recorder.h"
+#include "silence_trim.h"
+#include "transcript_delta.h"
 #include <iostream>
 #include <cmath>
 #include <algorithm>
@@ -12,39 +15,74 @@ WhisperWrapper::WhisperWrapper() = default;
 
 WhisperWrapper::~WhisperWrapper() {
     stop();
-    if (m_context) {
-        whisper_free(m_context);
-        m_context = nullptr;
-    }
 }
 
-bool WhisperWrapper::loadModel(const std::string& modelPath) {
-    if (m_context) {
-        whisper_free(m_context);
-        m_context = nullptr;
+void WhisperWrapper::setEngine(std::unique_ptr<TranscriptionEngine> engine) {
+    if (m_running.load()) {
+        std::cerr << "[Whisper] Cannot change the engine while running" << std::endl;
+        return;
     }
+    m_engine = std::move(engine);
+    if (m_engine) {
+        std::cerr << "[Whisper] Engine: " << m_engine->name() << std::endl;
+    }
+}
 
-    std::cout << "[Whisper] Loading model: " << modelPath << std::endl;
-
-    // Initialize whisper context
-    struct whisper_context_params cparams = whisper_context_default_params();
-    cparams.use_gpu = true;  // Use GPU if available (CUDA/Metal)
+void WhisperWrapper::setChunkDuration(float seconds) {
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    m_pendingConfig.chunkMs = static_cast<int>(seconds * 1000.0f);
+    m_configChanged = true;
+}
 
-    m_context = whisper_init_from_file_with_params(modelPath.c_str(), cparams);
-    
-    if (!m_context) {
-        m_lastError = "Failed to load Whisper model from: " + modelPath;
-        std::cerr << "[Whisper] " << m_lastError << std::endl;
+bool WhisperWrapper::setConfig(const TranscriptionConfig& config) {
+    if (config.language != "auto" && m_engine && m_engine->languageId(config.language) < 0) {
+        m_lastError = "Unsupported language: " + config.language;
         return false;
     }
 
-    std::cout << "[Whisper] Model loaded successfully" << std::endl;
+    m_denoise.store(config.denoise);
+    m_silenceFlushSamples.store(static_cast<size_t>(config.silenceFlushMs) * SAMPLE_RATE / 1000);
+
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    m_pendingConfig = config;
+    m_configChanged = true;
     return true;
 }
 
+TranscriptionConfig WhisperWrapper::getConfig() const {
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    return m_pendingConfig;
+}
+
+void WhisperWrapper::redetectLanguage() {
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    m_redetectLanguage = true;
+    m_configChanged = true;
+}
+
+// Adopt the latest config (processing thread, between chunks)
+void WhisperWrapper::refreshConfig() {
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    if (!m_configChanged) return;
+
+    // A prompt in the old language would steer the decoder back to it
+    if (m_pendingConfig.language != m_config.language || m_redetectLanguage) {
+        m_stitcher.clearPrompt();
+        m_language.reset();
+    }
+    m_config = m_pendingConfig;
+    m_configChanged = false;
+    m_redetectLanguage = false;
+    m_stitcher.setMaxPromptTokens(static_cast<size_t>(m_config.contextTokens));
+    std::cerr << "[Whisper] Config: chunk " << m_config.chunkMs << "ms, threads " << m_config.threads
+              << ", beam " << m_config.beamSize << ", language " << m_config.language
+              << ", vad " << vadModeName(m_config.vad) << ", context " << m_config.contextTokens
+              << " tokens, denoise " << (m_config.denoise ? "on" : "off") << std::endl;
+}
+
 void WhisperWrapper::start(TranscriptionCallback callback) {
-    if (!m_context) {
-        std::cerr << "[Whisper] Cannot start - no model loaded" << std::endl;
+    if (!m_engine) {
+        std::cerr << "[Whisper] Cannot start - no engine" << std::endl;
         return;
     }
 
@@ -58,11 +96,18 @@ void WhisperWrapper::start(TranscriptionCallback callback) {
     // Clear any existing audio
     {
         std::lock_guard<std::mutex> lock(m_mutex);
-        m_audioBuffer.clear();
+        discardBuffered();
+        m_flushed.clear();
+        m_features.reset();
+        m_streamSamples = 0;
+        m_heldSilence = 0;
+        m_skippingSilence = false;
+        m_denoising = false;
     }
+    m_stitcher.reset();
 
     m_processThread = std::thread(&WhisperWrapper::processLoop, this);
-    std::cout << "[Whisper] Started transcription" << std::endl;
+    std::cerr << "[Whisper] Started transcription" << std::endl;
 }
 
 void WhisperWrapper::stop() {
@@ -77,7 +122,7 @@ void WhisperWrapper::stop() {
         m_processThread.join();
     }
 
-    std::cout << "[Whisper] Stopped transcription" << std::endl;
+    std::cerr << "[Whisper] Stopped transcription" << std::endl;
 }
 
 void WhisperWrapper::addAudioChunk(const float* samples, size_t numSamples) {
@@ -87,171 +132,473 @@ void WhisperWrapper::addAudioChunk(const float* samples, size_t numSamples) {
 
     {
         std::lock_guard<std::mutex> lock(m_mutex);
-        m_audioBuffer.insert(m_audioBuffer.end(), samples, samples + numSamples);
+        placeHeldSilence();
+        samples = denoise(samples, numSamples);
+        m_buffer.append(samples, numSamples);
+        m_features.append(samples, numSamples);
+        afterAppend(numSamples);
+    }
+    m_cv.notify_one();
+}
+
+void WhisperWrapper::addAudioChunk(const int16_t* samples, size_t numSamples) {
+    if (!m_running.load() || numSamples == 0) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        placeHeldSilence();
+        if (syncDenoising()) {
+            // The denoiser works on float
+            m_denoiseInput.resize(numSamples);
+            s16ToFloat(samples, m_denoiseInput.data(), numSamples);
+            const float* denoised = denoise(m_denoiseInput.data(), numSamples);
+            m_buffer.append(denoised, numSamples);
+            m_features.append(denoised, numSamples);
+        } else {
+            m_buffer.append(samples, numSamples);
+            m_features.append(samples, numSamples);
+        }
+        afterAppend(numSamples);
     }
     m_cv.notify_one();
 }
 
+void WhisperWrapper::addSilence(size_t numSamples) {
+    if (!m_running.load() || numSamples == 0) {
+        return;
+    }
+
+    bool flushed = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_skippingSilence) {
+            m_heldSilence += numSamples;
+            if (m_heldSilence < m_silenceFlushSamples.load(std::memory_order_relaxed)) {
+                return;
+            }
+            numSamples = m_heldSilence;
+            m_heldSilence = 0;
+            m_skippingSilence = true;
+
+            // Speech still inside the denoiser belongs before the silence
+            if (m_denoising) {
+                m_denoised.clear();
+                const size_t drained = m_denoiser.drain(numSamples, m_denoised);
+                m_buffer.append(m_denoised.data(), drained);
+                m_features.append(m_denoised.data(), drained);
+                afterAppend(drained);
+                numSamples -= drained;
+            }
+            if (m_buffer.size() > 0) {
+                flushForSilence();
+                flushed = !m_flushed.empty();
+            }
+        }
+        // The buffer is empty, so its head stays at the end of the stream
+        m_streamSamples += numSamples;
+        m_features.skip(numSamples);
+        m_features.discardBefore(m_streamSamples / m_features.frameSamples());
+    }
+    if (flushed) {
+        m_cv.notify_one();
+    }
+}
+
+// Follow config.denoise before audio is buffered, on every input path.
+// Turning it on starts from a clean state; audio in flight when it is
+// turned off is dropped. Caller must hold m_mutex.
+bool WhisperWrapper::syncDenoising() {
+    const bool enabled = m_denoise.load(std::memory_order_relaxed);
+    if (enabled != m_denoising) {
+        m_denoising = enabled;
+        m_denoiser.reset();
+    }
+    return m_denoising;
+}
+
+// Denoise incoming audio if config.denoise is on; returns the samples to
+// buffer (as many as were given, LATENCY_SAMPLES late). Caller must hold
+// m_mutex.
+const float* WhisperWrapper::denoise(const float* samples, size_t numSamples) {
+    if (!syncDenoising()) return samples;
+
+    StageTimer timer(metrics().denoise);
+    TraceSpan span("denoise");
+    m_denoised.clear();
+    m_denoiser.process(samples, numSamples, m_denoised);
+    return m_denoised.data();
+}
+
+// Buffer silence held back by addSilence() as zeros, now that audio has
+// resumed within config.silenceFlushMs. Caller must hold m_mutex.
+void WhisperWrapper::placeHeldSilence() {
+    m_skippingSilence = false;
+    if (m_heldSilence == 0) return;
+
+    m_silence.assign(m_heldSilence, 0.0f);
+    m_heldSilence = 0;
+    const float* samples = denoise(m_silence.data(), m_silence.size());
+    m_buffer.append(samples, m_silence.size());
+    m_features.append(samples, m_silence.size());
+    afterAppend(m_silence.size());
+}
+
+// Queue what is buffered as a final chunk, as stop() would. Anything not
+// longer than the overlap has already been decoded or is too short to be
+// worth it. Caller must hold m_mutex.
+void WhisperWrapper::flushForSilence() {
+    FlushedChunk pending;
+    pending.source.startSample = m_streamSamples - m_buffer.size();
+    if (!takeChunk(pending.samples, m_buffer.size(), true)) {
+        m_buffer.clear();
+        metrics().bufferSamples.set(0);
+        return;
+    }
+    pending.source.endSample = pending.source.startSample + pending.samples.size();
+    pending.readyUs = m_lastAppendUs;
+    pending.featureLead = takeFeatures(pending.source, pending.features);
+    m_flushed.push_back(std::move(pending));
+    metrics().bufferSamples.set(0);
+}
+
+size_t WhisperWrapper::pendingSamples() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_buffer.size();
+}
+
+// Caller must hold m_mutex
+void WhisperWrapper::afterAppend(size_t numSamples) {
+    m_lastAppendUs = metricsNowUs();
+    m_streamSamples += numSamples;
+    metrics().bufferSamples.set(m_buffer.size());
+}
+
+// Copy the feature frames of a chunk just taken and forget those behind
+// the new buffer head. Returns where the first frame starts in the chunk.
+// Caller must hold m_mutex.
+size_t WhisperWrapper::takeFeatures(const TranscriptSource& source, std::vector<FrameFeatures>& features) {
+    const uint64_t firstFrame = m_features.copyFrames(source.startSample, source.endSample, features);
+    const uint64_t headSample = m_streamSamples - m_buffer.size();
+    m_features.discardBefore(headSample / m_features.frameSamples());
+    return static_cast<size_t>(firstFrame * m_features.frameSamples() - source.startSample);
+}
+
+// Drop audio that will never be transcribed. Caller must hold m_mutex.
+void WhisperWrapper::discardBuffered() {
+    metrics().droppedSamples.fetch_add(m_buffer.size(), std::memory_order_relaxed);
+    m_buffer.clear();
+    metrics().bufferSamples.set(0);
+}
+
+// Move the next chunk out of the buffer, keeping 0.5s of overlap for
+// context. When draining, take whatever is left (at least 0.5s).
+// Caller must hold m_mutex.
+bool WhisperWrapper::takeChunk(std::vector<float>& chunk, size_t chunkSamples, bool draining) {
+    return m_buffer.takeChunk(chunk, chunkSamples, OVERLAP_SAMPLES, draining);
+}
+
 void WhisperWrapper::processLoop() {
-    const size_t chunkSamples = static_cast<size_t>(m_chunkDuration * SAMPLE_RATE);
-    
-    while (m_running.load()) {
+    PipelineMetrics& stats = metrics();
+    TraceRecorder::instance().setThreadName("whisper");
+
+    for (bool last = false; !last;) {
+        refreshConfig();
+        const size_t chunkSamples = static_cast<size_t>(m_config.chunkMs) * SAMPLE_RATE / 1000;
         std::vector<float> chunk;
+        uint64_t chunkReadyUs = 0;
+        TranscriptSource source;
+        std::vector<FrameFeatures> features;
+        size_t featureLead = 0;
+        uint64_t commitLimit = COMMIT_ALL;  // Nothing overlaps flushed or last chunks
+        size_t backlog = 0;                 // Audio queued behind this chunk
 
         {
             std::unique_lock<std::mutex> lock(m_mutex);
             
             // Wait until we have enough audio or should stop
             m_cv.wait_for(lock, std::chrono::milliseconds(100), [&] {
-                return m_audioBuffer.size() >= chunkSamples || !m_running.load();
+                return m_buffer.size() >= chunkSamples || !m_flushed.empty() || !m_running.load();
             });
 
-            if (!m_running.load()) {
-                // Process any remaining audio before exiting
-                if (m_audioBuffer.size() > SAMPLE_RATE / 2) {  // At least 0.5s
-                    chunk = std::move(m_audioBuffer);
-                    m_audioBuffer.clear();
+            if (!m_flushed.empty()) {
+                // Speech that ended in silence goes first; it is older
+                FlushedChunk& pending = m_flushed.front();
+                chunk = std::move(pending.samples);
+                source = pending.source;
+                chunkReadyUs = pending.readyUs;
+                features = std::move(pending.features);
+                featureLead = pending.featureLead;
+                m_flushed.pop_front();
+            } else {
+                const size_t buffered = m_buffer.size();
+                if (!m_running.load()) {
+                    // Process any remaining audio (at least 0.5s) before exiting
+                    if (!takeChunk(chunk, chunkSamples, true)) {
+                        discardBuffered();
+                        break;
+                    }
+                    last = true;
+                } else if (!takeChunk(chunk, chunkSamples, false)) {
+                    continue;
                 } else {
-                    break;
-                }
-            } else if (m_audioBuffer.size() >= chunkSamples) {
-                // Take the chunk
-                chunk.assign(m_audioBuffer.begin(), m_audioBuffer.begin() + chunkSamples);
-                // Keep some overlap for context (0.5 seconds)
-                size_t overlap = SAMPLE_RATE / 2;
-                if (m_audioBuffer.size() > overlap) {
-                    m_audioBuffer.erase(m_audioBuffer.begin(), 
-                                       m_audioBuffer.begin() + chunkSamples - overlap);
+                    commitLimit = m_streamSamples - m_buffer.size();  // Where the next chunk starts
                 }
-            } else {
-                continue;
+
+                // The buffer's head sits `buffered` samples behind the stream
+                source.startSample = m_streamSamples - buffered;
+                source.endSample = source.startSample + chunk.size();
+                featureLead = takeFeatures(source, features);
+
+                // Audio queued behind this chunk arrived after its last sample
+                const size_t later = buffered > chunk.size() ? buffered - chunk.size() : 0;
+                const uint64_t laterUs = static_cast<uint64_t>(later) * 1000000 / SAMPLE_RATE;
+                chunkReadyUs = m_lastAppendUs > laterUs ? m_lastAppendUs - laterUs : 0;
+                stats.bufferDepthMs.record(static_cast<uint64_t>(buffered) * 1000 / SAMPLE_RATE);
+                stats.bufferSamples.set(m_buffer.size());
             }
+
+            backlog = m_buffer.size();
+            for (const FlushedChunk& pending : m_flushed) backlog += pending.samples.size();
         }
 
         if (!chunk.empty()) {
+            TraceSpan chunkSpan("chunk", "samples", static_cast<int64_t>(chunk.size()));
+
             // Trim silence from beginning and end
-            trimSilence(chunk);
+            size_t trimmed = 0;
+            {
+                StageTimer timer(stats.vad);
+                TraceSpan span("vad");
+                trimmed = trimSilence(chunk, vadThreshold(m_config.vad), SAMPLE_RATE, features, featureLead);
+            }
 
             if (chunk.size() > SAMPLE_RATE / 4) {  // At least 0.25s of audio
-                std::string text = transcribe(chunk);
-                
-                if (!text.empty() && m_callback) {
-                    // For now, all results are treated as final
-                    // Could implement VAD for partial results
-                    m_callback(text, true);
+                const uint64_t now = metricsNowUs();
+                stats.queueWait.record(chunkReadyUs && now > chunkReadyUs ? now - chunkReadyUs : 0);
+
+                std::vector<StreamToken> tokens;
+                const bool decoded = transcribe(chunk, source.startSample + trimmed, backlog, tokens);
+                stats.chunksTranscribed.fetch_add(1, std::memory_order_relaxed);
+
+                // Only words this chunk is the first to hear in full
+                std::string text;
+                if (decoded) {
+                    text = m_stitcher.stitch(tokens, commitLimit);
+                    stats.overlapTokens.fetch_add(m_stitcher.droppedTokens(), std::memory_order_relaxed);
                 }
+                if (!text.empty()) {
+                    std::cerr << "[Whisper] Transcribed in " << (metricsNowUs() - now) / 1000 << "ms: " << text
+                              << std::endl;
+                }
+
+                updateSegment(text, decoded ? m_stitcher.pendingText() : std::string(), source,
+                              commitLimit == COMMIT_ALL);
+            } else {
+                stats.chunksSkipped.fetch_add(1, std::memory_order_relaxed);
+                if (commitLimit == COMMIT_ALL) closeSegment();
             }
         }
     }
+    closeSegment();
 }
 
-std::string WhisperWrapper::transcribe(const std::vector<float>& samples) {
-    if (!m_context || samples.empty()) {
-        return "";
-    }
-
-    // Set up whisper parameters
-    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-    
-    params.print_realtime = false;
-    params.print_progress = false;
-    params.print_timestamps = false;
-    params.print_special = false;
-    params.translate = false;
-    params.language = "en";
-    params.n_threads = std::max(1u, std::thread::hardware_concurrency());  // Use all CPU cores
-    params.offset_ms = 0;
-    params.no_context = true;
-    params.single_segment = true;
-    
-    // Suppress blank tokens
-    params.suppress_blank = true;
-
-    // Run inference
-    auto start = std::chrono::high_resolution_clock::now();
-    
-    int result = whisper_full(m_context, params, samples.data(), static_cast<int>(samples.size()));
-    
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-
-    if (result != 0) {
-        std::cerr << "[Whisper] Transcription failed with code: " << result << std::endl;
-        return "";
-    }
-
-    // Get transcription result
-    std::string output;
-    int numSegments = whisper_full_n_segments(m_context);
-    
-    for (int i = 0; i < numSegments; ++i) {
-        const char* text = whisper_full_get_segment_text(m_context, i);
-        if (text) {
-            if (!output.empty()) {
-                output += " ";
-            }
-            output += text;
-        }
+// Add a chunk's committed words to the open segment and report it: as a
+// partial while it runs, as a final when it ends. `pending` is what the
+// chunk heard past its commit limit, shown but left for the next chunk.
+void WhisperWrapper::updateSegment(const std::string& text, const std::string& pending,
+                                   const TranscriptSource& source, bool speechEnded) {
+    if (m_segmentText.empty() && !m_segmentShown) {
+        m_segmentSource.startSample = source.startSample;
+    }
+    m_segmentSource.endSample = source.endSample;
+    if (!text.empty()) {
+        if (!m_segmentText.empty()) m_segmentText += ' ';
+        m_segmentText += text;
     }
 
-    // Trim whitespace
-    size_t start_pos = output.find_first_not_of(" \t\n\r");
-    size_t end_pos = output.find_last_not_of(" \t\n\r");
-    if (start_pos != std::string::npos && end_pos != std::string::npos) {
-        output = output.substr(start_pos, end_pos - start_pos + 1);
+    const char last = m_segmentText.empty() ? '\0' : m_segmentText.back();
+    const bool sentenceEnded = last == '.' || last == '?' || last == '!';
+    if (speechEnded || sentenceEnded ||
+        m_segmentSource.endSample - m_segmentSource.startSample >= MAX_SEGMENT_SAMPLES) {
+        closeSegment();
+        // The held-back words open the next segment
+        m_segmentSource.startSample = source.startSample;
     }
 
-    if (!output.empty()) {
-        std::cout << "[Whisper] Transcribed in " << duration.count() << "ms: " << output << std::endl;
+    // The guess can end in the first bytes of a character whose rest the
+    // next chunk has; the renderer counts `keep` in whole characters
+    std::string partial = m_segmentText;
+    const size_t pendingLength = completeUtf8Length(pending.data(), pending.size());
+    if (pendingLength > 0) {
+        if (!partial.empty()) partial += ' ';
+        partial.append(pending, 0, pendingLength);
     }
+    if (partial.empty() || !m_callback) return;
+    m_segmentShown = true;
+    m_segmentSource.segment = m_segment;
+    m_callback(partial, false, m_segmentSource);
+}
 
-    return output;
+// Send the open segment's final, if it has text or a partial to replace
+void WhisperWrapper::closeSegment() {
+    if (m_segmentText.empty() && !m_segmentShown) return;
+    m_segmentSource.segment = m_segment;
+    if (m_callback) {
+        m_callback(m_segmentText, true, m_segmentSource);
+    }
+    ++m_segment;
+    m_segmentText.clear();
+    m_segmentShown = false;
 }
 
-void WhisperWrapper::trimSilence(std::vector<float>& samples) {
-    if (samples.empty()) return;
+// Inference wall time, the engine's encode/decode split (if it reports
+// one) and real-time factor. With tracing on, the split is also laid out
+// as spans starting where the encoder began.
+void WhisperWrapper::recordInferenceMetrics(uint64_t startUs, uint64_t endUs, size_t numSamples,
+                                            const DecodeResult& result) {
+    PipelineMetrics& stats = metrics();
+    const uint64_t elapsed = endUs > startUs ? endUs - startUs : 0;
+    stats.inference.record(elapsed);
+
+    TraceRecorder& trace = TraceRecorder::instance();
+    if (trace.isEnabled()) {
+        trace.record("whisper_full", startUs, elapsed, "samples", static_cast<int64_t>(numSamples));
+    }
 
-    const float threshold = 0.01f;  // Silence threshold
-    const size_t windowSize = SAMPLE_RATE / 20;  // 50ms window
+    if (result.encodeUs > 0 || result.decodeUs > 0) {
+        stats.encode.record(result.encodeUs);
+        stats.decode.record(result.decodeUs);
 
-    // Find first non-silent sample
-    size_t start = 0;
-    for (size_t i = 0; i < samples.size() - windowSize; i += windowSize / 2) {
-        float energy = 0.0f;
-        for (size_t j = i; j < i + windowSize && j < samples.size(); ++j) {
-            energy += std::abs(samples[j]);
-        }
-        energy /= windowSize;
-        
-        if (energy > threshold) {
-            start = (i >= windowSize / 2) ? i - windowSize / 2 : 0;
-            break;
+        if (trace.isEnabled() && result.encoderBeginUs >= startUs) {
+            const uint64_t encodeEndUs = std::min(result.encoderBeginUs + result.encodeUs, endUs);
+            trace.record("encode", result.encoderBeginUs, encodeEndUs - result.encoderBeginUs);
+            trace.record("decode", encodeEndUs, endUs - encodeEndUs);
         }
     }
 
-    // Find last non-silent sample
-    size_t end = samples.size();
-    for (size_t i = samples.size(); i > windowSize; i -= windowSize / 2) {
-        float energy = 0.0f;
-        size_t windowStart = i - windowSize;
-        for (size_t j = windowStart; j < i; ++j) {
-            energy += std::abs(samples[j]);
+    const uint64_t audioUs = static_cast<uint64_t>(numSamples) * 1000000 / SAMPLE_RATE;
+    if (audioUs > 0) {
+        stats.rtfMilli.record(elapsed * 1000 / audioUs);
+    }
+}
+
+// Decode one chunk into text tokens on the stream clock; `firstSample` is
+// where samples[0] sits in the stream. Starts cheap and re-decodes a
+// doubtful result while the chunk's latency budget allows (see
+// DecodePolicy), keeping the most plausible result.
+bool WhisperWrapper::transcribe(const std::vector<float>& samples, uint64_t firstSample, size_t backlogSamples,
+                                std::vector<StreamToken>& tokens) {
+    if (!m_engine || samples.empty()) {
+        return false;
+    }
+
+    PipelineMetrics& stats = metrics();
+    const uint64_t audioUs = static_cast<uint64_t>(samples.size()) * 1000000 / SAMPLE_RATE;
+    const uint64_t backlogUs = static_cast<uint64_t>(backlogSamples) * 1000000 / SAMPLE_RATE;
+    const uint64_t budgetUs = static_cast<uint64_t>(m_config.decodeBudgetMs) * 1000;
+    const uint64_t startUs = metricsNowUs();
+
+    const bool autoLanguage = m_config.language == "auto";
+    if (autoLanguage && !m_language.settled()) {
+        detectLanguage(samples);
+    }
+
+    DecodeAttempt attempt = m_policy.first(m_config.beamSize);
+    DecodeQuality best;
+    bool decoded = false;
+    for (size_t attempts = 1;; ++attempts) {
+        std::vector<StreamToken> candidate;
+        DecodeQuality quality;
+        const uint64_t attemptStartUs = metricsNowUs();
+        if (decode(samples, attempt, firstSample, candidate, &quality)) {
+            m_policy.recordCost(attempt.tier, metricsNowUs() - attemptStartUs, audioUs);
+            if (!decoded || DecodePolicy::isBetter(quality, best)) {
+                tokens = std::move(candidate);
+                best = quality;
+            }
+            decoded = true;
+        } else if (!decoded) {
+            return false;
         }
-        energy /= windowSize;
-        
-        if (energy > threshold) {
-            end = std::min(i + windowSize / 2, samples.size());
+
+        DecodeAttempt retry;
+        if (!m_policy.next(attempt, quality, attempts, metricsNowUs() - startUs, budgetUs, audioUs, backlogUs,
+                           &retry)) {
+            if (m_policy.looksPoor(quality) && attempts < DecodePolicy::MAX_ATTEMPTS && budgetUs > 0) {
+                stats.redecodesSkipped.fetch_add(1, std::memory_order_relaxed);
+            }
             break;
         }
+        std::cerr << "[Whisper] Re-decoding with " << decodeTierName(retry.tier) << " (avg logprob "
+                  << quality.avgLogprob << ", compression " << quality.compressionRatio << ")" << std::endl;
+        stats.redecodes.fetch_add(1, std::memory_order_relaxed);
+        attempt = retry;
+    }
+
+    // Even the best decode keeps failing: the speaker may have switched language
+    if (decoded && autoLanguage && m_language.recordDecode(best.avgLogprob, best.tokens)) {
+        std::cerr << "[Whisper] Decodes in " << decodeLanguage() << " look unlikely; detecting the language again"
+                  << std::endl;
+        m_stitcher.clearPrompt();
     }
+    return decoded;
+}
 
-    if (start < end && start > 0) {
-        samples.erase(samples.begin(), samples.begin() + start);
-        end -= start;
+// Language identification over one chunk of speech, a vote towards the
+// session's language. Costs an encoder pass, so it only runs until the
+// language is settled.
+void WhisperWrapper::detectLanguage(const std::vector<float>& samples) {
+    TraceSpan span("language_id");
+    std::vector<float> probs;
+    if (!m_engine->detectLanguage(samples.data(), samples.size(), decodeThreads(), probs)) {
+        return;
     }
-    if (end < samples.size()) {
-        samples.resize(end);
+    metrics().languageDetections.fetch_add(1, std::memory_order_relaxed);
+
+    if (m_language.addDetection(probs.data(), probs.size(), samples.size())) {
+        std::cerr << "[Whisper] Language: " << m_engine->languageCode(m_language.language()) << " (p "
+                  << m_language.probability() << "), kept for the session" << std::endl;
     }
 }
 
+// The configured language, or in "auto" mode the session's best guess so
+// far (the engine detects per chunk only if no guess could be made)
+const char* WhisperWrapper::decodeLanguage() const {
+    if (m_config.language != "auto") return m_config.language.c_str();
+    const char* code = m_language.language() >= 0 ? m_engine->languageCode(m_language.language()) : nullptr;
+    return code ? code : "auto";
+}
+
+int WhisperWrapper::decodeThreads() const {
+    return m_config.threads > 0
+        ? m_config.threads
+        : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));  // Use all CPU cores
+}
+
+// One engine pass with the given strategy; loops are trimmed and the
+// result scored in decodeGuarded(), whatever the engine
+bool WhisperWrapper::decode(const std::vector<float>& samples, const DecodeAttempt& attempt, uint64_t firstSample,
+                            std::vector<StreamToken>& tokens, DecodeQuality* quality) {
+    DecodeRequest request;
+    request.samples = samples.data();
+    request.numSamples = samples.size();
+    request.firstSample = firstSample;
+    request.attempt = attempt;
+    request.language = decodeLanguage();
+    request.threads = decodeThreads();
+    request.prompt = &m_stitcher.prompt();
+
+    DecodeResult result;
+    const uint64_t startUs = metricsNowUs();
+    const bool ok = decodeGuarded(*m_engine, request, result, quality);
+    recordInferenceMetrics(startUs, metricsNowUs(), samples.size(), result);
+    if (!ok) {
+        return false;
+    }
+    tokens = std::move(result.tokens);
+    return true;
+}
+
 } // namespace phantom
@@ -8,33 +8,63 @@
 #include <thread>
 #include <condition_variable>
 #include <queue>
-
-// Forward declare whisper types
-struct whisper_context;
+#include <deque>
+#include <cstdint>
+#include <memory>
+
+#include "sample_format.h"
+#include "audio_chunk_buffer.h"
+#include "frame_features.h"
+#include "transcription_config.h"
+#include "transcript_stitcher.h"
+#include "decode_policy.h"
+#include "language_tracker.h"
+#include "noise_suppressor.h"
+#include "transcription_engine.h"
 
 namespace phantom {
 
 /**
- * Callback for transcription results
+ * Audio a transcript was decoded from, in 16kHz samples counted from
+ * start(). Covers the segment's chunks so far, including any trimmed
+ * silence and the overlap shared with the chunk before.
+ */
+struct TranscriptSource {
+    uint64_t startSample = 0;
+    uint64_t endSample = 0;
+    uint64_t segment = 0;       // Partials revise a segment; one final closes it
+};
+
+/**
+ * Callback for transcription results. Each decoded chunk updates the
+ * open segment: a partial holds its whole text so far, the committed
+ * words plus a guess at the next ones. The segment's final follows once
+ * (committed words only) when speech stops, a sentence ends or the
+ * segment reaches MAX_SEGMENT_SAMPLES; later text starts a new segment.
  * @param text Transcribed text
  * @param isFinal Whether this is a final result (vs partial)
+ * @param source Stream range and segment the text belongs to
  */
-using TranscriptionCallback = std::function<void(const std::string& text, bool isFinal)>;
+using TranscriptionCallback =
+    std::function<void(const std::string& text, bool isFinal, const TranscriptSource& source)>;
 
 /**
- * Wrapper around whisper.cpp for speech-to-text
+ * Live speech-to-text: buffers the 16kHz stream into overlapping chunks,
+ * decodes them with a TranscriptionEngine (whisper.cpp, or a mock) and
+ * stitches the results into one transcript
  */
 class WhisperWrapper {
 public:
+    // Longest a segment runs without a sentence end before it is made final (10s)
+    static constexpr uint64_t MAX_SEGMENT_SAMPLES = 160000;
+
     WhisperWrapper();
     ~WhisperWrapper();
 
     /**
-     * Load a Whisper model
-     * @param modelPath Path to the GGML model file
-     * @return true if model loaded successfully
+     * Use `engine` for decoding (call while stopped)
      */
-    bool loadModel(const std::string& modelPath);
+    void setEngine(std::unique_ptr<TranscriptionEngine> engine);
 
     /**
      * Start transcription with the given callback
@@ -55,9 +85,37 @@ public:
     void addAudioChunk(const float* samples, size_t numSamples);
 
     /**
-     * Check if model is loaded
+     * Add 16-bit samples (16kHz mono)
+     */
+    void addAudioChunk(const int16_t* samples, size_t numSamples);
+
+    /**
+     * Account for numSamples of digital silence that were not captured as
+     * audio. Once a run reaches config.silenceFlushMs, speech buffered
+     * before it is queued for decoding right away (it would otherwise wait
+     * for audio that is not coming) and the stream clock moves past the
+     * silence. A shorter run is held back and buffered as zeros when audio
+     * resumes, so a brief gap does not split an utterance.
+     */
+    void addSilence(size_t numSamples);
+
+    /**
+     * Choose how pending audio is buffered (call before start()).
+     * S16 halves buffer memory; chunks are converted to float right
+     * before they are handed to whisper.
+     */
+    void setSampleFormat(SampleFormat format) { m_buffer.setFormat(format); }
+    SampleFormat getSampleFormat() const { return m_buffer.getFormat(); }
+
+    /**
+     * Samples buffered but not yet taken for transcription
      */
-    bool isModelLoaded() const { return m_context != nullptr; }
+    size_t pendingSamples();
+
+    /**
+     * Check if an engine is set
+     */
+    bool hasEngine() const { return m_engine != nullptr; }
 
     /**
      * Get last error message
@@ -67,14 +125,51 @@ public:
     /**
      * Set the chunk duration for processing (in seconds)
      */
-    void setChunkDuration(float seconds) { m_chunkDuration = seconds; }
+    void setChunkDuration(float seconds);
+
+    /**
+     * Replace the transcription config. Safe to call while running: the
+     * processing thread switches over before its next chunk, so a chunk is
+     * always decoded with one consistent config.
+     * @return false (see getLastError) if the language is not supported
+     */
+    bool setConfig(const TranscriptionConfig& config);
+
+    /**
+     * Latest config set (possibly not yet picked up by the processing thread)
+     */
+    TranscriptionConfig getConfig() const;
+
+    /**
+     * With language "auto", identify the language again from the next
+     * chunk of speech instead of keeping the one found for the session
+     */
+    void redetectLanguage();
 
 private:
     void processLoop();
-    std::string transcribe(const std::vector<float>& samples);
-    void trimSilence(std::vector<float>& samples);
-
-    whisper_context* m_context = nullptr;
+    void refreshConfig();
+    void discardBuffered();
+    void afterAppend(size_t numSamples);
+    bool syncDenoising();
+    const float* denoise(const float* samples, size_t numSamples);
+    void placeHeldSilence();
+    bool takeChunk(std::vector<float>& chunk, size_t chunkSamples, bool draining);
+    void flushForSilence();
+    size_t takeFeatures(const TranscriptSource& source, std::vector<FrameFeatures>& features);
+    bool transcribe(const std::vector<float>& samples, uint64_t firstSample, size_t backlogSamples,
+                    std::vector<StreamToken>& tokens);
+    bool decode(const std::vector<float>& samples, const DecodeAttempt& attempt, uint64_t firstSample,
+                std::vector<StreamToken>& tokens, DecodeQuality* quality);
+    void recordInferenceMetrics(uint64_t startUs, uint64_t endUs, size_t numSamples, const DecodeResult& result);
+    void detectLanguage(const std::vector<float>& samples);
+    const char* decodeLanguage() const;
+    int decodeThreads() const;
+    void updateSegment(const std::string& text, const std::string& pending, const TranscriptSource& source,
+                       bool speechEnded);
+    void closeSegment();
+
+    std::unique_ptr<TranscriptionEngine> m_engine;
     std::string m_lastError;
 
     // Processing state
@@ -83,10 +178,57 @@ private:
     std::mutex m_mutex;
     std::condition_variable m_cv;
 
-    // Audio buffer
-    std::vector<float> m_audioBuffer;
-    float m_chunkDuration = 2.0f;  // Process in 2-second chunks
+    // A chunk cut short by silence, decoded ahead of the buffer
+    struct FlushedChunk {
+        std::vector<float> samples;
+        TranscriptSource source;
+        uint64_t readyUs = 0;
+        std::vector<FrameFeatures> features;
+        size_t featureLead = 0;
+    };
+
+    // Audio waiting to be transcribed, guarded by m_mutex
+    AudioChunkBuffer m_buffer;
+    std::deque<FlushedChunk> m_flushed;
+    FrameFeatureStream m_features;  // Levels of the buffered audio, by stream frame
+    uint64_t m_lastAppendUs = 0;    // When the newest buffered sample arrived
+    uint64_t m_streamSamples = 0;   // Samples appended since start()
+    size_t m_heldSilence = 0;       // Silence too brief (so far) to flush on
+    bool m_skippingSilence = false; // The current silence run was flushed
+    std::vector<float> m_silence;   // Zeros standing in for held silence
+    std::atomic<size_t> m_silenceFlushSamples{
+        static_cast<size_t>(TranscriptionConfig().silenceFlushMs) * SAMPLE_RATE / 1000};
+
+    // Optional denoising of incoming audio, guarded by m_mutex. m_denoise
+    // follows config.denoise; m_denoising is whether the denoiser is in use
+    std::atomic<bool> m_denoise{false};
+    bool m_denoising = false;
+    NoiseSuppressor m_denoiser;
+    std::vector<float> m_denoised;
+    std::vector<float> m_denoiseInput;
+
+    // Config: m_pendingConfig is written by setConfig() under m_configMutex;
+    // m_config is the processing thread's copy, refreshed between chunks
+    mutable std::mutex m_configMutex;
+    TranscriptionConfig m_pendingConfig;
+    bool m_configChanged = false;
+    bool m_redetectLanguage = false;
+    TranscriptionConfig m_config;
+
+    // Committed tokens and the prompt they make (processing thread only)
+    TranscriptStitcher m_stitcher;
+    DecodePolicy m_policy;
+    LanguageTracker m_language;     // Session language in "auto" mode
+
+    // The segment being transcribed (processing thread only). Ids keep
+    // counting across sessions, so a client never sees one reused.
+    uint64_t m_segment = 0;
+    std::string m_segmentText;      // Committed words
+    TranscriptSource m_segmentSource;
+    bool m_segmentShown = false;    // A partial has been sent
+
     static constexpr size_t SAMPLE_RATE = 16000;
+    static constexpr size_t OVERLAP_SAMPLES = SAMPLE_RATE / 2;  // Re-read by the next chunk
 
     // Callback
     TranscriptionCallback m_callback;
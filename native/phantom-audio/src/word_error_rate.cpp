@@ -0,0 +1,95 @@
+#include "word_error_rate.h"
+
+#include <cstdint>
+#include <utility>
+
+namespace phantom {
+
+WordErrorCounts& WordErrorCounts::operator+=(const WordErrorCounts& other) {
+    substitutions += other.substitutions;
+    deletions += other.deletions;
+    insertions += other.insertions;
+    referenceWords += other.referenceWords;
+    return *this;
+}
+
+std::vector<std::string> normalizeWords(const std::string& text) {
+    std::vector<std::string> words;
+    std::string word;
+
+    auto flush = [&] {
+        // Apostrophes only count inside a word ('quoted' -> quoted)
+        while (!word.empty() && word.back() == '\'') word.pop_back();
+        size_t lead = 0;
+        while (lead < word.size() && word[lead] == '\'') ++lead;
+        if (lead < word.size()) words.push_back(word.substr(lead));
+        word.clear();
+    };
+
+    for (char ch : text) {
+        const unsigned char c = static_cast<unsigned char>(ch);
+        if (c >= 'A' && c <= 'Z') {
+            word += static_cast<char>(c - 'A' + 'a');
+        } else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c >= 0x80 || c == '\'') {
+            word += ch;
+        } else {
+            // Spaces, punctuation and hyphens all separate words
+            flush();
+        }
+    }
+    flush();
+    return words;
+}
+
+WordErrorCounts countWordErrors(const std::string& reference, const std::string& hypothesis) {
+    const std::vector<std::string> ref = normalizeWords(reference);
+    const std::vector<std::string> hyp = normalizeWords(hypothesis);
+
+    // One row of the Levenshtein table at a time, tracking the edit mix of
+    // each cell's best path so the totals split into S/D/I
+    struct Cell {
+        uint32_t cost;
+        uint32_t subs;
+        uint32_t dels;
+        uint32_t ins;
+    };
+    std::vector<Cell> previous(hyp.size() + 1);
+    std::vector<Cell> current(hyp.size() + 1);
+    for (size_t j = 0; j <= hyp.size(); ++j) {
+        previous[j] = Cell{static_cast<uint32_t>(j), 0, 0, static_cast<uint32_t>(j)};
+    }
+
+    for (size_t i = 1; i <= ref.size(); ++i) {
+        current[0] = Cell{static_cast<uint32_t>(i), 0, static_cast<uint32_t>(i), 0};
+        for (size_t j = 1; j <= hyp.size(); ++j) {
+            const bool match = ref[i - 1] == hyp[j - 1];
+            Cell best = previous[j - 1];
+            if (!match) {
+                best.cost++;
+                best.subs++;
+            }
+            if (previous[j].cost + 1 < best.cost) {
+                best = previous[j];
+                best.cost++;
+                best.dels++;
+            }
+            if (current[j - 1].cost + 1 < best.cost) {
+                best = current[j - 1];
+                best.cost++;
+                best.ins++;
+            }
+            current[j] = best;
+        }
+        std::swap(previous, current);
+    }
+
+    const Cell& result = previous[hyp.size()];
+    WordErrorCounts counts;
+    counts.substitutions = result.subs;
+    counts.deletions = result.dels;
+    counts.insertions = result.ins;
+    counts.referenceWords = ref.size();
+    return counts;
+}
+
+} // namespace phantom
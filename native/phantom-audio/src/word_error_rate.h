@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace phantom {
+
+/**
+ * Word-level edit counts between a reference transcript and a hypothesis.
+ * WER = (substitutions + deletions + insertions) / reference words; counts
+ * from several files can be summed for a corpus-level rate.
+ */
+struct WordErrorCounts {
+    size_t substitutions = 0;
+    size_t deletions = 0;
+    size_t insertions = 0;
+    size_t referenceWords = 0;
+
+    size_t errors() const { return substitutions + deletions + insertions; }
+    double rate() const {
+        return referenceWords ? static_cast<double>(errors()) / referenceWords : (errors() ? 1.0 : 0.0);
+    }
+
+    WordErrorCounts& operator+=(const WordErrorCounts& other);
+};
+
+/**
+ * Split text into comparable words: ASCII letters are lowercased and
+ * punctuation is dropped (apostrophes inside words are kept, so "don't"
+ * stays one word). Bytes >= 0x80 are kept as-is, so UTF-8 survives.
+ */
+std::vector<std::string> normalizeWords(const std::string& text);
+
+// Minimum edit alignment of the normalized words
+WordErrorCounts countWordErrors(const std::string& reference, const std::string& hypothesis);
+
+} // namespace phantom
@@ -0,0 +1,88 @@
+#include "test_harness.h"
+#include "audio_chunk_buffer.h"
+#include "silence_trim.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+std::vector<float> ramp(size_t n, size_t start) {
+    std::vector<float> samples(n);
+    for (size_t i = 0; i < n; ++i) {
+        samples[i] = static_cast<float>((start + i) % 1000) / 1000.0f;
+    }
+    return samples;
+}
+
+} // namespace
+
+TEST(AudioChunkBuffer, TakesChunksWithOverlap) {
+    AudioChunkBuffer buffer;
+    const std::vector<float> audio = ramp(2500, 0);
+    buffer.append(audio.data(), audio.size());
+    CHECK_EQ(buffer.size(), static_cast<size_t>(2500));
+
+    std::vector<float> chunk;
+    CHECK(buffer.takeChunk(chunk, 1000, 200, false));
+    CHECK_EQ(chunk.size(), static_cast<size_t>(1000));
+    CHECK(chunk[0] == audio[0]);
+    // The last 200 samples of the chunk start the next one
+    CHECK_EQ(buffer.size(), static_cast<size_t>(1700));
+    CHECK(buffer.takeChunk(chunk, 1000, 200, false));
+    CHECK(chunk[0] == audio[800]);
+
+    CHECK(!buffer.takeChunk(chunk, 1000, 200, false));
+    CHECK(buffer.takeChunk(chunk, 1000, 200, true));
+    CHECK_EQ(chunk.size(), static_cast<size_t>(900));
+    CHECK_EQ(buffer.size(), static_cast<size_t>(0));
+    CHECK(!buffer.takeChunk(chunk, 1000, 200, true));
+}
+
+TEST(AudioChunkBuffer, S16StorageConvertsOnce) {
+    AudioChunkBuffer buffer;
+    buffer.setFormat(SampleFormat::S16);
+    const std::vector<float> audio = ramp(1200, 7);
+    buffer.append(audio.data(), 600);
+
+    std::vector<int16_t> pcm(600);
+    floatToS16(audio.data() + 600, pcm.data(), pcm.size());
+    buffer.append(pcm.data(), pcm.size());
+
+    std::vector<float> chunk;
+    CHECK(buffer.takeChunk(chunk, 1200, 0, false));
+    CHECK_EQ(chunk.size(), static_cast<size_t>(1200));
+    for (size_t i = 0; i < chunk.size(); ++i) {
+        CHECK_NEAR(chunk[i], audio[i], 1.0 / 32768.0);
+    }
+
+    // Switching format drops what was buffered
+    buffer.append(audio.data(), 10);
+    buffer.setFormat(SampleFormat::F32);
+    CHECK_EQ(buffer.size(), static_cast<size_t>(0));
+}
+
+TEST(TrimSilence, KeepsSpeechWithMargin) {
+    const size_t rate = 16000;
+    std::vector<float> samples(2 * rate, 0.0f);
+    for (size_t i = rate / 2; i < 3 * rate / 2; ++i) {
+        samples[i] = 0.5f * std::sin(0.1f * static_cast<float>(i));
+    }
+
+    std::vector<float> trimmed = samples;
+    trimSilence(trimmed, 0.01f, rate);
+    // About 1s of speech plus up to a window of margin on each side
+    CHECK(trimmed.size() >= rate);
+    CHECK(trimmed.size() <= rate + 2 * rate / 20);
+
+    std::vector<float> untouched = samples;
+    trimSilence(untouched, 0.0f, rate);
+    CHECK(untouched == samples);
+
+    std::vector<float> tiny(100, 0.0f);
+    trimSilence(tiny, 0.01f, rate);
+    CHECK_EQ(tiny.size(), static_cast<size_t>(100));
+}
@@ -0,0 +1,95 @@
+#include "test_harness.h"
+#include "audio_forwarder.h"
+#include "shared_audio_ring.h"
+
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+const size_t RATE = 16000;
+
+// Protocol output goes to a string instead of the test's stdout
+struct CaptureStdout {
+    std::ostringstream out;
+    std::streambuf* saved = std::cout.rdbuf(out.rdbuf());
+    ~CaptureStdout() { std::cout.rdbuf(saved); }
+};
+
+float toneAt(size_t n) {
+    return 0.3f * static_cast<float>(std::sin(2.0 * 3.14159265358979 * 440.0 * n / RATE));
+}
+
+// A 440Hz tone in 10ms packets
+void forwardTone(AudioForwarder& forwarder, size_t numSamples) {
+    std::vector<float> packet(RATE / 100);
+    for (size_t done = 0; done < numSamples; done += packet.size()) {
+        for (size_t i = 0; i < packet.size(); ++i) packet[i] = toneAt(done + i);
+        forwarder.forward(packet.data(), packet.size());
+    }
+}
+
+} // namespace
+
+TEST(AudioForwarder, RingKeepsEveryPacketWithFlacNegotiated) {
+    CaptureStdout capture;
+    SharedAudioRing ring;
+    CHECK(ring.create(SharedAudioRing::defaultName() + "-forward", 1 << 16));
+    SharedAudioRingReader reader;
+    CHECK(reader.open(SharedAudioRing::defaultName() + "-forward"));
+
+    AudioForwarder forwarder;
+    forwarder.setRing(&ring);
+    forwarder.setStreamAudio(true);
+    forwardTone(forwarder, RATE / 2);
+    forwarder.enableFlac(0);
+    CHECK(forwarder.isFlacEnabled());
+    forwardTone(forwarder, RATE / 2);
+
+    // The ring advanced by every sample, before and after FLAC was negotiated
+    std::vector<float> buffer(2 * RATE);
+    uint64_t dropped = 0;
+    CHECK_EQ(reader.read(buffer.data(), buffer.size(), &dropped), RATE);
+    CHECK_EQ(dropped, static_cast<uint64_t>(0));
+    CHECK_NEAR(buffer[RATE - 1], toneAt(RATE / 2 - 1), 1e-6f);
+
+    // ... while stdout carried the FLAC segment
+    CHECK(forwarder.flacEncoder()->inSegment());
+    CHECK_EQ(forwarder.flacEncoder()->getSegmentSamples(), static_cast<uint64_t>(RATE / 2));
+    forwarder.finishFlacSegment();
+    CHECK(!forwarder.flacEncoder()->inSegment());
+    CHECK(!capture.out.str().empty());
+}
+
+TEST(AudioForwarder, BriefSilenceStaysInTheFlacSegment) {
+    CaptureStdout capture;
+    AudioForwarder forwarder;
+    forwarder.enableFlac(0);
+
+    // A 10ms gap between words: held, then encoded into the open segment
+    forwardTone(forwarder, RATE / 2);
+    forwarder.forwardSilence(RATE / 100);
+    CHECK(forwarder.flacEncoder()->inSegment());
+    forwardTone(forwarder, RATE / 2);
+    CHECK(forwarder.flacEncoder()->inSegment());
+    CHECK_EQ(forwarder.flacEncoder()->getSegmentSamples(), static_cast<uint64_t>(RATE + RATE / 100));
+
+    // A run reaching silence_flush_ms (300ms by default) closes the segment
+    for (int i = 0; i < 29; ++i) forwarder.forwardSilence(RATE / 100);
+    CHECK(forwarder.flacEncoder()->inSegment());
+    forwarder.forwardSilence(RATE / 100);
+    CHECK(!forwarder.flacEncoder()->inSegment());
+
+    // The next segment starts with the audio, not the silence before it
+    forwardTone(forwarder, RATE / 10);
+    CHECK_EQ(forwarder.flacEncoder()->getSegmentSamples(), static_cast<uint64_t>(RATE / 10));
+
+    // With no minimum, any silence closes it
+    forwarder.setSilenceFlushMs(0);
+    forwarder.forwardSilence(RATE / 100);
+    CHECK(!forwarder.flacEncoder()->inSegment());
+}
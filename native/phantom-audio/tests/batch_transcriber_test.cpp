@@ -0,0 +1,202 @@
+#include "test_harness.h"
+#include "batch_transcriber.h"
+#include "mock_engine.h"
+#include "session_recorder.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+const char* const OUTPUT_PATH = "phantom-audio-batch-test.jsonl";
+constexpr uint32_t RATE = 16000;
+
+std::vector<float> tone(size_t numSamples) {
+    std::vector<float> samples(numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+        samples[i] = 0.3f * static_cast<float>(std::sin(2.0 * 3.14159265358979 * 440.0 * i / RATE));
+    }
+    return samples;
+}
+
+void putLE(std::vector<uint8_t>& out, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+// 16kHz mono 16-bit PCM
+void writeWav(const char* path, const std::vector<float>& samples) {
+    std::vector<uint8_t> file;
+    file.insert(file.end(), {'R', 'I', 'F', 'F'});
+    putLE(file, 0, 4);
+    file.insert(file.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+    putLE(file, 16, 4);
+    putLE(file, 1, 2);
+    putLE(file, 1, 2);
+    putLE(file, RATE, 4);
+    putLE(file, RATE * 2, 4);
+    putLE(file, 2, 2);
+    putLE(file, 16, 2);
+    file.insert(file.end(), {'d', 'a', 't', 'a'});
+    putLE(file, static_cast<uint32_t>(samples.size() * 2), 4);
+    for (const float s : samples) putLE(file, static_cast<uint16_t>(static_cast<int16_t>(s * 32767.0f)), 2);
+
+    std::FILE* f = std::fopen(path, "wb");
+    std::fwrite(file.data(), 1, file.size(), f);
+    std::fclose(f);
+}
+
+// Every worker answers "hello world" after rtf times the segment's length
+EngineFactory mockEngines(double realTimeFactor = 0.0) {
+    return [realTimeFactor]() -> std::unique_ptr<TranscriptionEngine> {
+        MockEngineScript script;
+        script.texts = {"hello world"};
+        script.realTimeFactor = realTimeFactor;
+        return std::unique_ptr<TranscriptionEngine>(new MockEngine(script));
+    };
+}
+
+BatchOptions batchOptions(std::vector<std::string> files, int workers) {
+    BatchOptions options;
+    options.files = std::move(files);
+    options.outputPath = OUTPUT_PATH;
+    options.workers = workers;
+    options.config.threads = 1;
+    return options;
+}
+
+std::vector<std::string> readLines() {
+    std::ifstream in(OUTPUT_PATH);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(in, line);) lines.push_back(line);
+    return lines;
+}
+
+// A string or number field of one output line ("" if absent)
+std::string field(const std::string& line, const std::string& key) {
+    const std::string name = "\"" + key + "\":";
+    size_t pos = line.find(name);
+    if (pos == std::string::npos) return "";
+    pos += name.size();
+    if (line[pos] == '"') {
+        return line.substr(pos + 1, line.find('"', pos + 1) - pos - 1);
+    }
+    return line.substr(pos, line.find_first_of(",}", pos) - pos);
+}
+
+// "type file" per line, to compare the order of a run's output
+std::vector<std::string> outline(const std::vector<std::string>& lines) {
+    std::vector<std::string> out;
+    for (const std::string& line : lines) out.push_back(field(line, "type") + " " + field(line, "file"));
+    return out;
+}
+
+} // namespace
+
+TEST(BatchTranscriber, TranscribesOnlyTheRequestedRange) {
+    // The same 5s of audio as a WAV and as a session recording
+    const std::vector<float> audio = tone(RATE * 5);
+    writeWav("phantom-audio-batch-range.wav", audio);
+    {
+        SessionRecorder recorder;
+        CHECK(recorder.create("phantom-audio-batch-range.phrec", audio.size()));
+        recorder.markStart();
+        recorder.write(audio.data(), audio.size());
+    }
+
+    for (const char* file : {"phantom-audio-batch-range.wav", "phantom-audio-batch-range.phrec"}) {
+        BatchOptions options = batchOptions({file}, 1);
+        options.fromSeconds = 1.0;
+        options.toSeconds = 3.0;
+        BatchTranscriber batch(mockEngines());
+        CHECK(batch.run(options));
+
+        // Times are from the start of the file, the duration is the range's
+        const std::vector<std::string> lines = readLines();
+        CHECK_EQ(lines.size(), static_cast<size_t>(3));
+        CHECK(field(lines[0], "type") == "segment");
+        CHECK(field(lines[0], "start_ms") == "1000");
+        CHECK(field(lines[0], "end_ms") == "3000");
+        CHECK(field(lines[0], "text") == "hello world");
+        CHECK(field(lines[1], "type") == "file");
+        CHECK(field(lines[1], "duration_ms") == "2000");
+        CHECK(field(lines[1], "segments") == "1");
+    }
+
+    // A range starting past the end leaves nothing to decode
+    BatchOptions options = batchOptions({"phantom-audio-batch-range.wav"}, 1);
+    options.fromSeconds = 10.0;
+    BatchTranscriber batch(mockEngines());
+    CHECK(batch.run(options));
+    const std::vector<std::string> lines = readLines();
+    CHECK_EQ(lines.size(), static_cast<size_t>(2));
+    CHECK(field(lines[0], "duration_ms") == "0");
+
+    std::remove("phantom-audio-batch-range.wav");
+    std::remove("phantom-audio-batch-range.phrec");
+    std::remove(OUTPUT_PATH);
+}
+
+TEST(BatchTranscriber, WritesInInputOrderWhateverFinishesFirst) {
+    // The long file's segment takes ~200ms; the short ones finish on the
+    // other worker well before it and must wait for it
+    writeWav("phantom-audio-batch-long.wav", tone(RATE * 10));
+    writeWav("phantom-audio-batch-short.wav", tone(RATE));
+    BatchOptions options = batchOptions({"phantom-audio-batch-long.wav", "phantom-audio-batch-short.wav",
+                                         "phantom-audio-batch-short.wav"}, 2);
+    BatchTranscriber batch(mockEngines(0.02));
+    CHECK(batch.run(options));
+
+    const std::vector<std::string> expected = {
+        "segment phantom-audio-batch-long.wav", "file phantom-audio-batch-long.wav",
+        "segment phantom-audio-batch-short.wav", "file phantom-audio-batch-short.wav",
+        "segment phantom-audio-batch-short.wav", "file phantom-audio-batch-short.wav",
+        "summary "};
+    CHECK(outline(readLines()) == expected);
+    CHECK(field(readLines().back(), "workers") == "2");
+
+    std::remove("phantom-audio-batch-long.wav");
+    std::remove("phantom-audio-batch-short.wav");
+    std::remove(OUTPUT_PATH);
+}
+
+TEST(BatchTranscriber, AnUnreadableFileGetsOnlyItsErrorLine) {
+    writeWav("phantom-audio-batch-ok.wav", tone(RATE * 2));
+    BatchOptions options = batchOptions({"phantom-audio-batch-ok.wav", "phantom-audio-batch-missing.wav",
+                                         "phantom-audio-batch-ok.wav"}, 2);
+    BatchTranscriber batch(mockEngines());
+    CHECK(!batch.run(options));
+    CHECK(batch.getLastError() == "1 file(s) could not be transcribed");
+
+    // The files after it are still transcribed, in order
+    const std::vector<std::string> lines = readLines();
+    const std::vector<std::string> expected = {
+        "segment phantom-audio-batch-ok.wav", "file phantom-audio-batch-ok.wav",
+        "error phantom-audio-batch-missing.wav",
+        "segment phantom-audio-batch-ok.wav", "file phantom-audio-batch-ok.wav",
+        "summary "};
+    CHECK(outline(lines) == expected);
+    CHECK(!field(lines[2], "message").empty());
+    CHECK(field(lines.back(), "files") == "3");
+    CHECK(field(lines.back(), "failed") == "1");
+    CHECK(field(lines.back(), "audio_s") == "4.000");
+
+    std::remove("phantom-audio-batch-ok.wav");
+    std::remove(OUTPUT_PATH);
+}
+
+TEST(BatchTranscriber, RejectsWhatTheEngineCannotDecode) {
+    BatchOptions options = batchOptions({"phantom-audio-batch-none.wav"}, 1);
+    options.config.language = "xx";
+    BatchTranscriber unsupported(mockEngines());
+    CHECK(!unsupported.run(options));
+    CHECK(unsupported.getLastError() == "Unsupported language: xx");
+
+    BatchTranscriber noEngine([]() { return std::unique_ptr<TranscriptionEngine>(); });
+    CHECK(!noEngine.run(options));
+}
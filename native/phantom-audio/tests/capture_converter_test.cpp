@@ -0,0 +1,105 @@
+#include "test_harness.h"
+#include "capture_converter.h"
+#include "audio_resampler.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+// Interleaved device buffer of one sample type, as raw bytes
+template <typename T>
+std::vector<uint8_t> toBytes(const std::vector<T>& samples) {
+    std::vector<uint8_t> bytes(samples.size() * sizeof(T));
+    std::memcpy(bytes.data(), samples.data(), bytes.size());
+    return bytes;
+}
+
+} // namespace
+
+TEST(CaptureConverter, MatchesTheResamplerForEveryDeviceType) {
+    // 10ms of 48kHz stereo: a ramp on the left, its negation on the right
+    const size_t frames = 480;
+    std::vector<int16_t> s16(frames * 2);
+    std::vector<int32_t> s32(frames * 2);
+    std::vector<float> f32(frames * 2);
+    for (size_t i = 0; i < frames; ++i) {
+        const int16_t left = static_cast<int16_t>(i * 64);
+        const int16_t right = static_cast<int16_t>(-static_cast<int>(i) * 32);
+        s16[i * 2] = left;
+        s16[i * 2 + 1] = right;
+        s32[i * 2] = static_cast<int32_t>(left) * 65536;
+        s32[i * 2 + 1] = static_cast<int32_t>(right) * 65536;
+        f32[i * 2] = left / 32768.0f;
+        f32[i * 2 + 1] = right / 32768.0f;
+    }
+
+    AudioResampler reference(48000, 2, 16000);
+    const std::vector<float> expected = reference.process(f32.data(), frames);
+    CHECK_EQ(expected.size(), static_cast<size_t>(160));
+
+    const DeviceSampleType types[] = {DeviceSampleType::F32, DeviceSampleType::S16, DeviceSampleType::S32};
+    const std::vector<uint8_t> buffers[] = {toBytes(f32), toBytes(s16), toBytes(s32)};
+    for (int t = 0; t < 3; ++t) {
+        DeviceFormat format;
+        format.type = types[t];
+        CaptureConverter converter(format);
+        CHECK_EQ(buffers[t].size(), frames * format.bytesPerFrame());
+
+        std::vector<float> output;
+        converter.process(buffers[t].data(), frames, output);
+        CHECK_EQ(output.size(), expected.size());
+        for (size_t i = 0; i < output.size(); ++i) {
+            CHECK_NEAR(output[i], expected[i], 1e-6);
+        }
+    }
+}
+
+TEST(CaptureConverter, ReusesTheOutputBuffer) {
+    // The convert stage hands in pooled packet storage: once it has grown,
+    // steady packets must not reallocate it
+    DeviceFormat format;
+    format.type = DeviceSampleType::S16;
+    format.sampleRate = 44100;
+    CaptureConverter converter(format);
+    const std::vector<uint8_t> packet = toBytes(std::vector<int16_t>(441 * 2, 1000));
+
+    std::vector<float> output;
+    output.reserve(256);
+    const float* storage = output.data();
+    size_t total = 0;
+    for (int i = 0; i < 100; ++i) {
+        converter.process(packet.data(), 441, output);
+        CHECK(output.data() == storage);
+        total += output.size();
+    }
+    CHECK_EQ(total, static_cast<size_t>(16000));
+}
+
+TEST(CaptureConverter, SkipKeepsThePhaseOfProcess) {
+    DeviceFormat format;
+    format.sampleRate = 44100;
+    CaptureConverter processed(format);
+    CaptureConverter skipped(format);
+    const std::vector<uint8_t> silence = toBytes(std::vector<float>(441 * 2, 0.0f));
+
+    std::vector<float> output;
+    size_t processedTotal = 0;
+    size_t skippedTotal = 0;
+    for (int i = 0; i < 50; ++i) {
+        processed.process(silence.data(), 441, output);
+        processedTotal += output.size();
+        skippedTotal += skipped.skip(441);
+        CHECK_EQ(skippedTotal, processedTotal);
+        CHECK(processed.outputSamples(441) + 1 >= output.size());
+        CHECK(processed.outputSamples(441) <= output.size());
+    }
+
+    processed.reset();
+    processed.process(nullptr, 441, output);
+    CHECK(output.empty());
+}
@@ -0,0 +1,99 @@
+#include "test_harness.h"
+#include "decode_policy.h"
+
+#include <string>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+DecodeQuality quality(float avgLogprob, float compression, size_t tokens = 10) {
+    DecodeQuality q;
+    q.avgLogprob = avgLogprob;
+    q.compressionRatio = compression;
+    q.tokens = tokens;
+    return q;
+}
+
+constexpr uint64_t SECOND = 1000000;
+
+} // namespace
+
+TEST(DecodePolicy, CompressionRatioFlagsLoops) {
+    CHECK(compressionRatio("") == 1.0f);
+    CHECK(compressionRatio("So the quarterly numbers came in a bit under what we forecast.") <
+          DecodePolicy::COMPRESSION_THRESHOLD);
+    CHECK(compressionRatio("Thank you. Thank you. Thank you. Thank you. Thank you. Thank you.") >
+          DecodePolicy::COMPRESSION_THRESHOLD);
+    CHECK(compressionRatio(std::string(200, 'a')) > 10.0f);
+
+    const DecodeQuality measured = measureDecodeQuality({-0.5f, -1.5f}, " Hello there");
+    CHECK_EQ(measured.tokens, static_cast<size_t>(2));
+    CHECK_NEAR(measured.avgLogprob, -1.0f, 1e-6f);
+}
+
+TEST(DecodePolicy, EscalatesOnlyDoubtfulResults) {
+    DecodePolicy policy;
+    const DecodeAttempt greedy = policy.first(1);
+    CHECK(greedy.tier == DecodeTier::Greedy);
+    CHECK(policy.first(4).tier == DecodeTier::Beam);
+    CHECK_EQ(policy.first(4).beamSize, 4);
+
+    DecodeAttempt next;
+    CHECK(!policy.next(greedy, quality(-0.3f, 1.2f), 1, 0, 10 * SECOND, 2 * SECOND, 0, &next));
+    CHECK(!policy.next(greedy, quality(0.0f, 1.0f, 0), 1, 0, 10 * SECOND, 2 * SECOND, 0, &next));
+
+    // Unsure: beam search, then sampling at rising temperatures
+    CHECK(policy.next(greedy, quality(-1.4f, 1.2f), 1, 0, 10 * SECOND, 2 * SECOND, 0, &next));
+    CHECK(next.tier == DecodeTier::Beam);
+    CHECK(policy.next(next, quality(-1.2f, 1.2f), 2, 0, 10 * SECOND, 2 * SECOND, 0, &next));
+    CHECK(next.tier == DecodeTier::Temperature);
+    CHECK_NEAR(next.temperature, 0.2f, 1e-6f);
+    CHECK(!policy.next(next, quality(-1.2f, 1.2f), DecodePolicy::MAX_ATTEMPTS, 0, 10 * SECOND, 2 * SECOND, 0,
+                       &next));
+
+    // Looping goes straight to sampling
+    CHECK(policy.next(greedy, quality(-0.2f, 4.0f), 1, 0, 10 * SECOND, 2 * SECOND, 0, &next));
+    CHECK(next.tier == DecodeTier::Temperature);
+
+    // So does a loop cut short before it could inflate the compression ratio
+    DecodeQuality looped = quality(-0.2f, 1.2f);
+    looped.looped = true;
+    CHECK(policy.looksPoor(looped));
+    CHECK(policy.next(greedy, looped, 1, 0, 10 * SECOND, 2 * SECOND, 0, &next));
+    CHECK(next.tier == DecodeTier::Temperature);
+    CHECK(DecodePolicy::isBetter(quality(-1.5f, 1.2f), looped));
+}
+
+TEST(DecodePolicy, RespectsBudgetAndBacklog) {
+    DecodePolicy policy;
+    const DecodeAttempt greedy = policy.first(1);
+    policy.recordCost(DecodeTier::Greedy, 400000, 2 * SECOND);  // 0.2x real time
+    CHECK_EQ(policy.estimateUs(DecodeTier::Greedy, 2 * SECOND), static_cast<uint64_t>(400000));
+    const uint64_t beamUs = policy.estimateUs(DecodeTier::Beam, 2 * SECOND);
+    CHECK(beamUs > 400000);
+
+    DecodeAttempt next;
+    const DecodeQuality unsure = quality(-1.5f, 1.2f);
+    CHECK(policy.next(greedy, unsure, 1, 400000, 400000 + beamUs, 2 * SECOND, 0, &next));
+    CHECK(!policy.next(greedy, unsure, 1, 400000, 400000 + beamUs - 1, 2 * SECOND, 0, &next));
+    CHECK(!policy.next(greedy, unsure, 1, 0, 0, 2 * SECOND, 0, &next));
+
+    // Four seconds queued owe 0.8s of greedy decoding first
+    CHECK(!policy.next(greedy, unsure, 1, 400000, 400000 + beamUs, 2 * SECOND, 4 * SECOND, &next));
+    CHECK(policy.next(greedy, unsure, 1, 400000, 1200000 + beamUs, 2 * SECOND, 4 * SECOND, &next));
+
+    // Measured costs replace the estimate, smoothed
+    policy.recordCost(DecodeTier::Beam, 2000000, 2 * SECOND);
+    CHECK_EQ(policy.estimateUs(DecodeTier::Beam, 2 * SECOND), static_cast<uint64_t>(2000000));
+    policy.recordCost(DecodeTier::Beam, 1000000, 2 * SECOND);
+    CHECK(policy.estimateUs(DecodeTier::Beam, 2 * SECOND) < 2000000);
+}
+
+TEST(DecodePolicy, PrefersPlausibleResult) {
+    CHECK(DecodePolicy::isBetter(quality(-0.5f, 1.2f), quality(-1.5f, 1.2f)));
+    CHECK(!DecodePolicy::isBetter(quality(-1.5f, 1.2f), quality(-0.5f, 1.2f)));
+    CHECK(DecodePolicy::isBetter(quality(-1.5f, 1.2f), quality(-0.1f, 5.0f)));  // No loop beats confidence
+    CHECK(!DecodePolicy::isBetter(quality(0.0f, 1.0f, 0), quality(-1.5f, 1.2f)));
+}
@@ -0,0 +1,336 @@
+#include "test_harness.h"
+#include "flac_encoder.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+// ============================================================================
+// Reference decoder for the subset the encoder writes (16-bit mono, fixed
+// block size, Rice residuals), written from the format spec rather than
+// from the encoder so the two cannot share a misreading
+// ============================================================================
+
+class BitReader {
+public:
+    BitReader(const std::vector<uint8_t>& data, size_t pos) : m_data(data), m_bit(pos * 8) {}
+
+    bool read(int bits, uint32_t* value) {
+        if (m_bit + static_cast<size_t>(bits) > m_data.size() * 8) return false;
+        uint32_t v = 0;
+        for (int i = 0; i < bits; ++i, ++m_bit) {
+            v = (v << 1) | ((m_data[m_bit / 8] >> (7 - m_bit % 8)) & 1);
+        }
+        *value = v;
+        return true;
+    }
+
+    bool readSigned(int bits, int32_t* value) {
+        uint32_t raw = 0;
+        if (!read(bits, &raw)) return false;
+        const uint32_t sign = 1u << (bits - 1);
+        *value = static_cast<int32_t>((raw ^ sign) - sign);
+        return true;
+    }
+
+    bool readUnary(uint32_t* zeros) {
+        uint32_t bit = 0;
+        *zeros = 0;
+        while (read(1, &bit) && bit == 0) ++*zeros;
+        return bit == 1;
+    }
+
+    void alignToByte() { m_bit = (m_bit + 7) & ~static_cast<size_t>(7); }
+    size_t bytePos() const { return m_bit / 8; }
+
+private:
+    const std::vector<uint8_t>& m_data;
+    size_t m_bit;
+};
+
+uint8_t referenceCrc8(const uint8_t* data, size_t len) {
+    uint32_t crc = 0;
+    for (size_t i = 0; i < len; ++i) {
+        for (int b = 7; b >= 0; --b) {
+            const uint32_t top = ((crc >> 7) ^ (data[i] >> b)) & 1;
+            crc = ((crc << 1) & 0xFF) ^ (top ? 0x07 : 0);
+        }
+    }
+    return static_cast<uint8_t>(crc);
+}
+
+uint16_t referenceCrc16(const uint8_t* data, size_t len) {
+    uint32_t crc = 0;
+    for (size_t i = 0; i < len; ++i) {
+        for (int b = 7; b >= 0; --b) {
+            const uint32_t top = ((crc >> 15) ^ (data[i] >> b)) & 1;
+            crc = ((crc << 1) & 0xFFFF) ^ (top ? 0x8005 : 0);
+        }
+    }
+    return static_cast<uint16_t>(crc);
+}
+
+enum class DecodeResult { Ok, BadHeader, BadCrc8, BadSubframe, BadCrc16 };
+
+struct Decoded {
+    std::vector<int16_t> samples;
+    uint32_t sampleRate = 0;
+    int subframeTypes[4] = {};  // Constant, Verbatim, Fixed, Lpc
+};
+
+bool readResidual(BitReader& br, uint32_t blockSize, int order, int32_t* residual) {
+    uint32_t method = 0;
+    uint32_t partitionOrder = 0;
+    if (!br.read(2, &method) || method != 0 || !br.read(4, &partitionOrder)) return false;
+    const uint32_t parts = 1u << partitionOrder;
+    if ((blockSize % parts) != 0 || (blockSize / parts) < static_cast<uint32_t>(order)) return false;
+    uint32_t i = static_cast<uint32_t>(order);
+    for (uint32_t p = 0; p < parts; ++p) {
+        uint32_t param = 0;
+        if (!br.read(4, &param) || param == 15) return false;
+        const uint32_t end = (p + 1) * (blockSize / parts);
+        for (; i < end; ++i) {
+            uint32_t high = 0;
+            uint32_t low = 0;
+            if (!br.readUnary(&high) || !br.read(static_cast<int>(param), &low)) return false;
+            const uint32_t folded = (high << param) | low;
+            residual[i] = static_cast<int32_t>(folded >> 1) ^ -static_cast<int32_t>(folded & 1);
+        }
+    }
+    return true;
+}
+
+bool readSubframe(BitReader& br, uint32_t blockSize, int32_t* out, Decoded& decoded) {
+    uint32_t pad = 0;
+    uint32_t type = 0;
+    uint32_t wasted = 0;
+    if (!br.read(1, &pad) || pad != 0 || !br.read(6, &type) || !br.read(1, &wasted) || wasted != 0) return false;
+
+    if (type == 0) {
+        ++decoded.subframeTypes[0];
+        int32_t value = 0;
+        if (!br.readSigned(16, &value)) return false;
+        for (uint32_t i = 0; i < blockSize; ++i) out[i] = value;
+        return true;
+    }
+    if (type == 1) {
+        ++decoded.subframeTypes[1];
+        for (uint32_t i = 0; i < blockSize; ++i) {
+            if (!br.readSigned(16, &out[i])) return false;
+        }
+        return true;
+    }
+
+    const bool lpc = type >= 32;
+    if (!lpc && (type < 8 || type > 12)) return false;
+    const int order = lpc ? static_cast<int>(type) - 31 : static_cast<int>(type) - 8;
+    ++decoded.subframeTypes[lpc ? 3 : 2];
+    for (int i = 0; i < order; ++i) {
+        if (!br.readSigned(16, &out[i])) return false;
+    }
+
+    int32_t coefs[32] = {};
+    int32_t shift = 0;
+    if (lpc) {
+        uint32_t precision = 0;
+        if (!br.read(4, &precision) || precision == 15 || !br.readSigned(5, &shift) || shift < 0) return false;
+        for (int i = 0; i < order; ++i) {
+            if (!br.readSigned(static_cast<int>(precision) + 1, &coefs[i])) return false;
+        }
+    }
+
+    std::vector<int32_t> residual(blockSize);
+    if (!readResidual(br, blockSize, order, residual.data())) return false;
+
+    static const int32_t fixedCoefs[5][4] = {{0}, {1}, {2, -1}, {3, -3, 1}, {4, -6, 4, -1}};
+    for (uint32_t i = static_cast<uint32_t>(order); i < blockSize; ++i) {
+        int64_t prediction = 0;
+        for (int j = 0; j < order; ++j) {
+            prediction += static_cast<int64_t>(lpc ? coefs[j] : fixedCoefs[order][j]) * out[i - 1 - j];
+        }
+        out[i] = residual[i] + static_cast<int32_t>(prediction >> shift);
+    }
+    return true;
+}
+
+DecodeResult decodeFlac(const std::vector<uint8_t>& stream, Decoded& decoded) {
+    // "fLaC", then a single (last) STREAMINFO block
+    if (stream.size() < 42 || std::memcmp(stream.data(), "fLaC", 4) != 0 ||
+        stream[4] != 0x80 || stream[5] != 0 || stream[6] != 0 || stream[7] != 34) {
+        return DecodeResult::BadHeader;
+    }
+    BitReader info(stream, 8);
+    uint32_t minBlock = 0, maxBlock = 0, skip = 0, channels = 0, bits = 0;
+    info.read(16, &minBlock);
+    info.read(16, &maxBlock);
+    info.read(24, &skip);
+    info.read(24, &skip);
+    info.read(20, &decoded.sampleRate);
+    info.read(3, &channels);
+    info.read(5, &bits);
+    if (minBlock != maxBlock || channels != 0 || bits != 15) return DecodeResult::BadHeader;
+
+    size_t pos = 42;
+    uint32_t expectedFrame = 0;
+    while (pos < stream.size()) {
+        BitReader br(stream, pos);
+        uint32_t sync = 0, reserved = 0, strategy = 0, bsCode = 0, srCode = 0, channel = 0, size = 0, reserved2 = 0;
+        br.read(14, &sync);
+        br.read(1, &reserved);
+        br.read(1, &strategy);
+        br.read(4, &bsCode);
+        br.read(4, &srCode);
+        br.read(4, &channel);
+        br.read(3, &size);
+        br.read(1, &reserved2);
+        if (sync != 0x3FFE) return DecodeResult::BadHeader;
+
+        // Frame number, UTF-8 coded
+        uint32_t lead = 0;
+        if (!br.read(8, &lead)) return DecodeResult::BadHeader;
+        int extra = 0;
+        while (extra < 7 && (lead & (0x80u >> extra))) ++extra;
+        if (extra == 1 || extra > 6) return DecodeResult::BadHeader;
+        uint32_t frameNumber = extra == 0 ? lead : lead & (0x3Fu >> (extra - 1));
+        for (int i = 1; i < extra; ++i) {
+            uint32_t next = 0;
+            if (!br.read(8, &next) || (next & 0xC0) != 0x80) return DecodeResult::BadHeader;
+            frameNumber = (frameNumber << 6) | (next & 0x3F);
+        }
+
+        uint32_t blockSize = 0;
+        if (bsCode == 1) {
+            blockSize = 192;
+        } else if (bsCode >= 2 && bsCode <= 5) {
+            blockSize = 576u << (bsCode - 2);
+        } else if (bsCode == 6 || bsCode == 7) {
+            if (!br.read(bsCode == 6 ? 8 : 16, &blockSize)) return DecodeResult::BadHeader;
+            ++blockSize;
+        } else if (bsCode >= 8) {
+            blockSize = 256u << (bsCode - 8);
+        }
+
+        // Check the CRC before trusting any field it covers
+        uint32_t crc8 = 0;
+        const size_t headerEnd = br.bytePos();
+        if (!br.read(8, &crc8)) return DecodeResult::BadHeader;
+        if (crc8 != referenceCrc8(stream.data() + pos, headerEnd - pos)) return DecodeResult::BadCrc8;
+        if (reserved || strategy || channel != 0 || size != 4 || reserved2 || frameNumber != expectedFrame++ ||
+            blockSize == 0 || blockSize > maxBlock || (srCode != 5 && srCode != 0)) {
+            return DecodeResult::BadHeader;
+        }
+
+        std::vector<int32_t> block(blockSize);
+        if (!readSubframe(br, blockSize, block.data(), decoded)) return DecodeResult::BadSubframe;
+
+        br.alignToByte();
+        const size_t frameEnd = br.bytePos();
+        uint32_t crc16 = 0;
+        if (!br.read(16, &crc16)) return DecodeResult::BadSubframe;
+        if (crc16 != referenceCrc16(stream.data() + pos, frameEnd - pos)) return DecodeResult::BadCrc16;
+
+        for (int32_t s : block) {
+            if (s < -32768 || s > 32767) return DecodeResult::BadSubframe;
+            decoded.samples.push_back(static_cast<int16_t>(s));
+        }
+        pos = frameEnd + 2;
+    }
+    return DecodeResult::Ok;
+}
+
+// Silence, then speech-like tones with a syllable envelope, then a loud
+// chirp close to full scale
+std::vector<int16_t> testSignal(size_t samples) {
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> noise(-40, 40);
+    std::vector<int16_t> out(samples, 0);
+    for (size_t i = samples / 4; i < samples; ++i) {
+        const double t = static_cast<double>(i) / 16000.0;
+        double v = 0.0;
+        if (i < samples / 2) {
+            const double envelope = 0.5 + 0.5 * std::sin(2.0 * 3.14159265 * 4.0 * t);
+            v = envelope * (9000.0 * std::sin(2.0 * 3.14159265 * 220.0 * t) +
+                            3000.0 * std::sin(2.0 * 3.14159265 * 1330.0 * t)) + noise(rng);
+        } else {
+            v = 32700.0 * std::sin(2.0 * 3.14159265 * (200.0 + 3000.0 * t) * t);
+        }
+        out[i] = static_cast<int16_t>(std::lround(std::max(-32768.0, std::min(32767.0, v))));
+    }
+    return out;
+}
+
+std::vector<uint8_t> encodeAll(FlacEncoder& encoder, const std::vector<int16_t>& samples, size_t packet) {
+    std::vector<uint8_t> out;
+    encoder.beginSegment(out);
+    for (size_t i = 0; i < samples.size(); i += packet) {
+        encoder.encode(samples.data() + i, std::min(packet, samples.size() - i), out);
+    }
+    encoder.finishSegment(out);
+    return out;
+}
+
+} // namespace
+
+TEST(FlacEncoder, RoundTripsThroughAReferenceDecoder) {
+    // Odd packet sizes and a partial last block
+    const std::vector<int16_t> signal = testSignal(4096 * 5 + 1234);
+    FlacEncoder encoder(16000);
+    const std::vector<uint8_t> stream = encodeAll(encoder, signal, 157);
+
+    Decoded decoded;
+    CHECK(decodeFlac(stream, decoded) == DecodeResult::Ok);
+    CHECK_EQ(decoded.sampleRate, static_cast<uint32_t>(16000));
+    CHECK(decoded.samples == signal);
+    CHECK(decoded.subframeTypes[0] > 0);                              // The silent lead-in
+    CHECK(decoded.subframeTypes[2] + decoded.subframeTypes[3] > 0);  // Predicted speech
+    CHECK(stream.size() < signal.size() * sizeof(int16_t) * 3 / 4);
+
+    // A second segment is a standalone stream that restarts frame numbers
+    const std::vector<uint8_t> again = encodeAll(encoder, signal, 4096);
+    CHECK(again == stream);
+}
+
+TEST(FlacEncoder, FallsBackToVerbatimForNoise) {
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> full(-32768, 32767);
+    std::vector<int16_t> noise(4096 * 2 + 100);
+    for (int16_t& s : noise) s = static_cast<int16_t>(full(rng));
+
+    FlacEncoder encoder(16000);
+    const std::vector<uint8_t> stream = encodeAll(encoder, noise, 480);
+    Decoded decoded;
+    CHECK(decodeFlac(stream, decoded) == DecodeResult::Ok);
+    CHECK(decoded.samples == noise);
+    CHECK_EQ(decoded.subframeTypes[1], 3);
+    CHECK_EQ(decoded.subframeTypes[2] + decoded.subframeTypes[3], 0);
+}
+
+TEST(FlacEncoder, CrcsCoverHeaderAndFrame) {
+    const std::vector<int16_t> signal = testSignal(4096);
+    FlacEncoder encoder(16000);
+    const std::vector<uint8_t> stream = encodeAll(encoder, signal, 4096);
+    Decoded decoded;
+    CHECK(decodeFlac(stream, decoded) == DecodeResult::Ok);
+
+    // A changed frame number must fail CRC-8, a changed CRC-16 the footer check
+    Decoded bad;
+    std::vector<uint8_t> header = stream;
+    header[42 + 4] ^= 0x01;
+    CHECK(decodeFlac(header, bad) == DecodeResult::BadCrc8);
+    std::vector<uint8_t> footer = stream;
+    footer.back() ^= 0x01;
+    CHECK(decodeFlac(footer, bad) == DecodeResult::BadCrc16);
+
+    // Frames go straight into the caller's buffer: bytes already in it are
+    // left alone and stay out of the CRCs
+    std::vector<uint8_t> appended = {0xAA, 0x55, 0x01};
+    encoder.beginSegment(appended);
+    encoder.encode(signal.data(), signal.size(), appended);
+    encoder.finishSegment(appended);
+    CHECK(std::vector<uint8_t>(appended.begin() + 3, appended.end()) == stream);
+}
@@ -0,0 +1,151 @@
+#include "test_harness.h"
+#include "frame_features.h"
+#include "silence_trim.h"
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+const SimdIsa ALL_ISAS[] = {SimdIsa::Scalar, SimdIsa::SSE2, SimdIsa::SSSE3,
+                            SimdIsa::SSE41, SimdIsa::AVX2, SimdIsa::NEON};
+
+std::vector<float> noise(size_t n, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> out(n);
+    for (float& v : out) v = dist(rng);
+    return out;
+}
+
+bool near(float a, float b) {
+    return std::fabs(a - b) <= 1e-5f * std::max(1.0f, std::fabs(b));
+}
+
+bool sameFeatures(const FrameFeatures& a, const FrameFeatures& b) {
+    // Sums are reassociated by the vector kernels; peak and ZCR are exact
+    return near(a.meanAbs, b.meanAbs) && near(a.rms, b.rms) && a.peak == b.peak && a.zcr == b.zcr;
+}
+
+} // namespace
+
+TEST(FrameFeatures, KnownSignal) {
+    // +0.5, -0.5 alternating: every pair after the first crosses; the first
+    // sample only crosses when `previous` is negative
+    std::vector<float> frame(8);
+    for (size_t i = 0; i < frame.size(); ++i) frame[i] = i % 2 ? -0.5f : 0.5f;
+    for (SimdIsa isa : ALL_ISAS) {
+        FrameFeatures f;
+        computeFrameFeatures(frame.data(), 1, frame.size(), 0.0f, &f, isa);
+        CHECK(near(f.meanAbs, 0.5f));
+        CHECK(near(f.rms, 0.5f));
+        CHECK_EQ(f.peak, 0.5f);
+        CHECK_EQ(f.zcr, 7.0f / 8.0f);
+
+        computeFrameFeatures(frame.data(), 1, frame.size(), -1.0f, &f, isa);
+        CHECK_EQ(f.zcr, 1.0f);
+    }
+}
+
+TEST(FrameFeatures, KernelsMatchScalar) {
+    // Frame sizes around every kernel's block size, plus 10ms at 16k and 44.1k
+    const size_t sizes[] = {1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 160, 441};
+    for (size_t frameSamples : sizes) {
+        const size_t numFrames = 3;
+        const std::vector<float> samples = noise(frameSamples * numFrames, static_cast<uint32_t>(frameSamples));
+        std::vector<FrameFeatures> expected(numFrames);
+        computeFrameFeatures(samples.data(), numFrames, frameSamples, 0.25f, expected.data(),
+                             SimdIsa::Scalar);
+        for (SimdIsa isa : ALL_ISAS) {
+            std::vector<FrameFeatures> actual(numFrames);
+            computeFrameFeatures(samples.data(), numFrames, frameSamples, 0.25f, actual.data(), isa);
+            for (size_t f = 0; f < numFrames; ++f) {
+                CHECK(sameFeatures(actual[f], expected[f]));
+            }
+        }
+    }
+}
+
+TEST(FrameFeatures, StreamMatchesBatch) {
+    const std::vector<float> samples = noise(16000, 11);
+    const std::vector<FrameFeatures> expected = computeFrameFeatures(samples.data(), samples.size());
+    CHECK_EQ(expected.size(), static_cast<size_t>(100));
+
+    // Packet sizes that never line up with frames
+    FrameFeatureStream stream;
+    const size_t packets[] = {1, 37, 160, 441, 7, 300};
+    size_t pos = 0;
+    for (size_t i = 0; pos < samples.size(); ++i) {
+        const size_t n = std::min(packets[i % 6], samples.size() - pos);
+        stream.append(samples.data() + pos, n);
+        pos += n;
+    }
+    CHECK_EQ(stream.endFrame(), static_cast<uint64_t>(100));
+    for (uint64_t f = 0; f < stream.endFrame(); ++f) {
+        CHECK(sameFeatures(stream.at(f), expected[f]));
+    }
+
+    // Frames inside a sample range, numbered from the stream start
+    std::vector<FrameFeatures> copied;
+    CHECK_EQ(stream.copyFrames(1000, 2000, copied), static_cast<uint64_t>(7));  // ceil(1000/160)
+    CHECK_EQ(copied.size(), static_cast<size_t>(5));                            // frames 7..11
+
+    stream.discardBefore(50);
+    CHECK_EQ(stream.beginFrame(), static_cast<uint64_t>(50));
+    CHECK_EQ(stream.copyFrames(0, 16000, copied), static_cast<uint64_t>(50));
+    CHECK_EQ(copied.size(), static_cast<size_t>(50));
+}
+
+TEST(FrameFeatures, SkipAddsSilentFrames) {
+    FrameFeatureStream stream;
+    const std::vector<float> loud(80, 0.5f);
+    stream.append(loud.data(), loud.size());  // Half a frame
+    stream.skip(420);                         // Finishes it, two silent frames, 20 samples of another
+    CHECK_EQ(stream.endFrame(), static_cast<uint64_t>(3));
+    CHECK(near(stream.at(0).meanAbs, 0.25f));
+    CHECK_EQ(stream.at(1).peak, 0.0f);
+    CHECK_EQ(stream.at(2).rms, 0.0f);
+
+    const std::vector<float> rest(140, 0.5f);
+    stream.append(rest.data(), rest.size());
+    CHECK_EQ(stream.endFrame(), static_cast<uint64_t>(4));
+    CHECK(near(stream.at(3).meanAbs, 0.5f * 140.0f / 160.0f));
+
+    const std::vector<int16_t> s16(160, 16384);
+    stream.append(s16.data(), s16.size());
+    CHECK_EQ(stream.endFrame(), static_cast<uint64_t>(5));
+    CHECK(near(stream.at(4).peak, 0.5f));
+
+    stream.reset();
+    CHECK_EQ(stream.endFrame(), static_cast<uint64_t>(0));
+}
+
+TEST(FrameFeatures, TrimFromStreamMatchesRescan) {
+    const size_t rate = 16000;
+    std::vector<float> samples(2 * rate, 0.0f);
+    for (size_t i = rate / 2; i < 3 * rate / 2; ++i) {
+        samples[i] = 0.5f * std::sin(0.1f * static_cast<float>(i));
+    }
+    std::vector<float> rescanned = samples;
+    const size_t removed = trimSilence(rescanned, 0.01f, rate);
+    CHECK(removed >= rate / 2 - rate / 20 && removed <= rate / 2);  // Speech at 0.5s, minus the margin
+
+    // Chunk starting mid-frame in the stream: frames begin 100 samples in
+    FrameFeatureStream stream;
+    const std::vector<float> before(60, 0.0f);
+    stream.append(before.data(), before.size());
+    stream.append(samples.data(), samples.size());
+    std::vector<FrameFeatures> frames;
+    const uint64_t first = stream.copyFrames(60, 60 + samples.size(), frames);
+    std::vector<float> fromStream = samples;
+    trimSilence(fromStream, 0.01f, rate, frames, static_cast<size_t>(first * 160 - 60));
+
+    CHECK(fromStream.size() >= rate);
+    CHECK(fromStream.size() <= rate + 2 * rate / 20);
+    const long diff = static_cast<long>(fromStream.size()) - static_cast<long>(rescanned.size());
+    CHECK(diff >= -160 && diff <= 160);
+}
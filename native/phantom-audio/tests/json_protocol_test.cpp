@@ -0,0 +1,249 @@
+#include "test_harness.h"
+#include "json_protocol.h"
+#include "json_reader.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+
+using namespace phantom;
+
+// Count heap allocations so the command parser can be checked allocation-free
+namespace {
+    std::atomic<size_t> g_allocations{0};
+}
+
+void* operator new(std::size_t size) {
+    ++g_allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+TEST(JsonReader, ReadsMembersOfEveryType) {
+    JsonObjectReader reader(R"( {"s":"a\"b", "n":-12.5e1, "t":true, "f":false, "z":null,
+                                "o":{"x":[1,{"y":2}]}, "a":[], "i":42} )");
+    std::string_view key;
+    JsonValue value;
+
+    CHECK(reader.next(&key, &value));
+    CHECK(key == "s");
+    CHECK(value.type == JsonType::String);
+    CHECK(value.text == "a\\\"b");
+    CHECK(value.escaped);
+
+    CHECK(reader.next(&key, &value));
+    CHECK(value.type == JsonType::Number);
+    CHECK_NEAR(value.number, -125.0, 1e-9);
+    int n = 0;
+    CHECK(value.asInt(&n));
+    CHECK_EQ(n, -125);
+
+    CHECK(reader.next(&key, &value));
+    CHECK(value.type == JsonType::Bool && value.boolean);
+    CHECK(reader.next(&key, &value));
+    CHECK(value.type == JsonType::Bool && !value.boolean);
+    CHECK(reader.next(&key, &value));
+    CHECK(value.type == JsonType::Null);
+
+    CHECK(reader.next(&key, &value));
+    CHECK(key == "o");
+    CHECK(value.type == JsonType::Object);
+    CHECK(value.text == R"({"x":[1,{"y":2}]})");
+    CHECK(reader.next(&key, &value));
+    CHECK(value.type == JsonType::Array);
+
+    CHECK(reader.next(&key, &value));
+    CHECK(key == "i");
+    CHECK(value.asInt(&n));
+    CHECK_EQ(n, 42);
+
+    CHECK(!reader.next(&key, &value));
+    CHECK(!reader.failed());
+
+    reader.reset();
+    CHECK(reader.next(&key, &value));
+    CHECK(key == "s");
+}
+
+TEST(JsonReader, RejectsMalformedInput) {
+    const char* bad[] = {
+        "", "[]", "{", "{\"a\"}", "{\"a\":}", "{\"a\":1,}", "{\"a\":1 \"b\":2}",
+        "{\"a\":tru}", "{\"a\":01x}", "{\"a\":\"\\q\"}", "{\"a\":\"\\u12\"}",
+        "{\"a\":\"unterminated}", "{\"a\":[1,2}", "{\"a\":-}", "{\"a\":1.}",
+    };
+    for (const char* json : bad) {
+        JsonObjectReader reader(json);
+        std::string_view key;
+        JsonValue value;
+        while (reader.next(&key, &value)) {}
+        if (!reader.failed()) {
+            ::phantom::test::reportFailure(__FILE__, __LINE__, std::string("accepted: ") + json);
+        }
+    }
+
+    // Nesting deeper than commands ever use
+    std::string deep = "{\"a\":";
+    for (int i = 0; i < 64; ++i) deep += "[";
+    for (int i = 0; i < 64; ++i) deep += "]";
+    deep += "}";
+    JsonObjectReader reader(deep);
+    std::string_view key;
+    JsonValue value;
+    CHECK(!reader.next(&key, &value));
+    CHECK(reader.failed());
+}
+
+TEST(Command, ParsesExistingCommands) {
+    CHECK(parseCommand(R"({"cmd":"start"})").type == CommandType::Start);
+    CHECK(parseCommand(R"({ "cmd" : "STOP" })").type == CommandType::Stop);
+    CHECK(parseCommand(R"({"cmd":"exit"})").type == CommandType::Exit);
+    CHECK(parseCommand(R"({"cmd":"dance"})").type == CommandType::Unknown);
+    CHECK(parseCommand(R"({"command":"start"})").type == CommandType::Unknown);
+    CHECK(parseCommand("not json").type == CommandType::Unknown);
+
+    // "cmd" does not have to come first
+    const Command hello = parseCommand(
+        R"({"protocol":2,"batch_ms":100,"cmd":"hello","audio_format":"flac","segment_ms":-5})");
+    CHECK(hello.type == CommandType::Hello);
+    CHECK_EQ(hello.protocol, 2);
+    CHECK_EQ(hello.batchMs, 100);
+    CHECK(hello.audioFormat == ForwardFormat::Flac);
+    CHECK_EQ(hello.segmentMs, 0);
+
+    const Command v1 = parseCommand(R"({"cmd":"hello","audio_format":"s16"})");
+    CHECK_EQ(v1.protocol, 1);
+    CHECK(v1.audioFormat == ForwardFormat::S16);
+}
+
+TEST(Command, ParsesConfig) {
+    const Command cmd = parseCommand(
+        R"({"cmd":"config","chunk_ms":1500,"threads":6,"beam_size":4,"language":"DE","vad":"aggressive",)"
+        R"("context_tokens":0,"decode_budget_ms":0,"denoise":true,"silence_flush_ms":0})");
+    CHECK(cmd.type == CommandType::Config);
+    CHECK(cmd.error == nullptr);
+
+    TranscriptionConfig config;
+    cmd.applyTo(config);
+    CHECK_EQ(config.chunkMs, 1500);
+    CHECK_EQ(config.threads, 6);
+    CHECK_EQ(config.beamSize, 4);
+    CHECK(config.language == "de");
+    CHECK(config.vad == VadMode::Aggressive);
+    CHECK_EQ(config.contextTokens, 0);
+    CHECK_EQ(config.decodeBudgetMs, 0);
+    CHECK(config.denoise);
+    CHECK_EQ(config.silenceFlushMs, 0);
+
+    // Only the given fields change
+    const Command partial = parseCommand(R"({"cmd":"config","threads":0})");
+    partial.applyTo(config);
+    CHECK_EQ(config.threads, 0);
+    CHECK_EQ(config.chunkMs, 1500);
+    CHECK(config.language == "de");
+    CHECK(config.denoise);
+
+    const char* invalid[] = {
+        R"({"cmd":"config","chunk_ms":500})",
+        R"({"cmd":"config","chunk_ms":1500.5})",
+        R"({"cmd":"config","threads":"6"})",
+        R"({"cmd":"config","beam_size":0})",
+        R"({"cmd":"config","language":"english!"})",
+        R"({"cmd":"config","vad":"loud"})",
+        R"({"cmd":"config","context_tokens":225})",
+        R"({"cmd":"config","decode_budget_ms":-1})",
+        R"({"cmd":"config","denoise":1})",
+        R"({"cmd":"config","silence_flush_ms":10001})",
+        R"({"cmd":"config","chunkms":1500})",
+    };
+    for (const char* json : invalid) {
+        const Command bad = parseCommand(json);
+        CHECK(bad.type == CommandType::Config);
+        if (!bad.error) {
+            ::phantom::test::reportFailure(__FILE__, __LINE__, std::string("accepted: ") + json);
+        }
+    }
+}
+
+TEST(Command, ParsesMetricsRequest) {
+    const Command once = parseCommand(R"({"cmd":"metrics"})");
+    CHECK(once.type == CommandType::Metrics);
+    CHECK(once.error == nullptr);
+    CHECK_EQ(once.metricsIntervalMs, -1);
+    CHECK(!once.metricsReset);
+
+    const Command periodic = parseCommand(R"({"cmd":"metrics","interval_ms":5000,"reset":true})");
+    CHECK(periodic.error == nullptr);
+    CHECK_EQ(periodic.metricsIntervalMs, 5000);
+    CHECK(periodic.metricsReset);
+
+    CHECK(parseCommand(R"({"cmd":"metrics","interval_ms":-1})").error != nullptr);
+    CHECK(parseCommand(R"({"cmd":"metrics","reset":1})").error != nullptr);
+}
+
+TEST(Command, ParsesTraceRequest) {
+    const Command start = parseCommand(R"({"cmd":"trace","path":"C:\\Temp\\caf\u00e9 \ud83c\udfa4.json"})");
+    CHECK(start.type == CommandType::Trace);
+    CHECK(start.error == nullptr);
+    CHECK(start.traceEnabled);
+    CHECK(start.tracePath == "C:\\Temp\\caf\xC3\xA9 \xF0\x9F\x8E\xA4.json");
+
+    const Command stop = parseCommand(R"({"cmd":"trace","enabled":false})");
+    CHECK(!stop.traceEnabled);
+    CHECK(stop.tracePath.empty());
+
+    CHECK(parseCommand(R"({"cmd":"trace","path":""})").error != nullptr);
+    CHECK(parseCommand(R"({"cmd":"trace","path":"\ud83c"})").error != nullptr);
+    CHECK(parseCommand(R"({"cmd":"trace","enabled":"yes"})").error != nullptr);
+}
+
+TEST(Command, ParsesWithoutAllocating) {
+    const std::string line =
+        R"({"cmd":"config","chunk_ms":1500,"threads":6,"beam_size":2,"language":"en","vad":"off"})";
+    const std::string hello = R"({"cmd":"hello","protocol":2,"batch_ms":100,"audio_format":"s16"})";
+
+    const size_t before = g_allocations.load();
+    const Command config = parseCommand(line);
+    const Command negotiated = parseCommand(hello);
+    const size_t after = g_allocations.load();
+
+    CHECK(config.type == CommandType::Config);
+    CHECK(negotiated.type == CommandType::Hello);
+    CHECK_EQ(after - before, static_cast<size_t>(0));
+}
+
+TEST(Protocol, RepeatHelloStaysFramed) {
+    std::ostringstream out;
+    std::streambuf* saved = std::cout.rdbuf(out.rdbuf());
+    negotiateProtocol(parseCommand(R"({"cmd":"hello","protocol":2})"));
+    const int again = negotiateProtocol(parseCommand(R"({"cmd":"hello","protocol":1,"audio_format":"s16"})"));
+    std::cout.rdbuf(saved);
+
+    // The first reply is a JSON line, the second an event frame
+    CHECK_EQ(again, 2);
+    CHECK(isBinaryFraming());
+    const std::string bytes = out.str();
+    const size_t newline = bytes.find('\n');
+    CHECK(newline != std::string::npos);
+    CHECK(bytes.substr(0, newline).find(R"("framing":"binary")") != std::string::npos);
+
+    const std::string frame = bytes.substr(newline + 1);
+    CHECK(frame.size() > FRAME_HEADER_SIZE);
+    uint32_t length = 0;
+    for (int i = 3; i >= 0; --i) length = (length << 8) | static_cast<uint8_t>(frame[i]);
+    CHECK_EQ(static_cast<size_t>(length), frame.size() - FRAME_HEADER_SIZE);
+    CHECK_EQ(frame[4], static_cast<char>(FrameType::Event));
+    const std::string payload = frame.substr(FRAME_HEADER_SIZE);
+    CHECK(payload.find(R"("framing":"binary")") != std::string::npos);
+    CHECK(payload.find(R"("audio_format":"s16")") != std::string::npos);
+}
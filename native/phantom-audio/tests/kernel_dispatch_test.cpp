@@ -0,0 +1,32 @@
+#include "test_harness.h"
+#include "kernel_dispatch.h"
+
+#include <cstring>
+#include <string>
+
+using namespace phantom;
+
+TEST(KernelDispatch, BindsEveryModuleAtOrBelowPreferred) {
+    const std::vector<KernelBinding> kernels = bindKernels();
+    CHECK_EQ(kernels.size(), static_cast<size_t>(5));
+
+    const SimdIsa preferred = preferredIsa();
+    for (const KernelBinding& binding : kernels) {
+        CHECK(binding.module != nullptr && std::strlen(binding.module) > 0);
+        CHECK(isaSupported(binding.isa));
+        // Same family as the CPU's level, never above it
+        if (preferred == SimdIsa::NEON) {
+            CHECK(binding.isa == SimdIsa::NEON || binding.isa == SimdIsa::Scalar);
+        } else {
+            CHECK(binding.isa != SimdIsa::NEON);
+            CHECK(static_cast<int>(binding.isa) <= static_cast<int>(preferred));
+        }
+    }
+
+    // On x86 every module has an SSE2 kernel
+    if (preferred != SimdIsa::Scalar && preferred != SimdIsa::NEON) {
+        for (const KernelBinding& binding : kernels) {
+            CHECK(binding.isa != SimdIsa::Scalar);
+        }
+    }
+}
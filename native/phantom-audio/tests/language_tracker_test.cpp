@@ -0,0 +1,76 @@
+#include "test_harness.h"
+#include "language_tracker.h"
+
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+constexpr size_t SECOND = 16000;
+
+// Probabilities over four languages, `p` on `id` and the rest spread evenly
+std::vector<float> guess(int id, float p) {
+    std::vector<float> probs(4, (1.0f - p) / 3.0f);
+    probs[static_cast<size_t>(id)] = p;
+    return probs;
+}
+
+} // namespace
+
+TEST(LanguageTracker, SettlesAfterProbeOrWhenCertain) {
+    LanguageTracker tracker;
+    CHECK(!tracker.settled());
+    CHECK_EQ(tracker.language(), -1);
+
+    // Two seconds at 60%: a guess, not yet settled
+    std::vector<float> probs = guess(2, 0.6f);
+    CHECK(!tracker.addDetection(probs.data(), probs.size(), 2 * SECOND));
+    CHECK_EQ(tracker.language(), 2);
+    CHECK(!tracker.settled());
+
+    // A second chunk completes the probe; the longer vote wins
+    probs = guess(1, 0.7f);
+    CHECK(tracker.addDetection(probs.data(), probs.size(), SECOND));
+    CHECK(tracker.settled());
+    CHECK_EQ(tracker.language(), 2);
+    CHECK(tracker.probability() > 0.4f);
+
+    // Further detections are ignored once settled
+    probs = guess(3, 1.0f);
+    CHECK(!tracker.addDetection(probs.data(), probs.size(), 10 * SECOND));
+    CHECK_EQ(tracker.language(), 2);
+
+    // A certain first chunk settles at once
+    LanguageTracker certain;
+    probs = guess(0, 0.97f);
+    CHECK(certain.addDetection(probs.data(), probs.size(), SECOND));
+    CHECK_EQ(certain.language(), 0);
+    CHECK_NEAR(certain.probability(), 0.97f, 1e-4f);
+}
+
+TEST(LanguageTracker, RechecksAfterRunOfPoorDecodes) {
+    LanguageTracker tracker;
+    std::vector<float> probs = guess(1, 0.95f);
+    CHECK(tracker.addDetection(probs.data(), probs.size(), SECOND));
+
+    CHECK(!tracker.recordDecode(-1.5f, 10));
+    CHECK(!tracker.recordDecode(-1.5f, 10));
+    CHECK(!tracker.recordDecode(-0.3f, 10));    // A good decode starts the count over
+    CHECK(!tracker.recordDecode(-1.5f, 10));
+    CHECK(!tracker.recordDecode(-1.5f, 10));
+    CHECK(!tracker.recordDecode(-5.0f, 0));     // Nothing decoded: no evidence
+    CHECK(tracker.settled());
+    CHECK(tracker.recordDecode(-1.5f, 10));
+    CHECK(!tracker.settled());
+    CHECK_EQ(tracker.language(), -1);
+
+    // Probing starts over from scratch
+    probs = guess(3, 0.95f);
+    CHECK(tracker.addDetection(probs.data(), probs.size(), SECOND));
+    CHECK_EQ(tracker.language(), 3);
+
+    tracker.reset();
+    CHECK(!tracker.settled());
+    CHECK(!tracker.recordDecode(-3.0f, 10));
+}
@@ -0,0 +1,210 @@
+#include "test_harness.h"
+#include "model_cache.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace phantom;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const fs::path CACHE_DIR = fs::temp_directory_path() / "phantom-audio-model-cache-test";
+
+void resetDir() {
+    fs::remove_all(CACHE_DIR);
+    fs::create_directories(CACHE_DIR);
+}
+
+// ggml magic, 11 hparams ending in `ftype`, then `payload` filler bytes
+std::string writeModel(const char* name, int32_t ftype, size_t payload) {
+    const uint32_t magic = 0x67676d6c;
+    int32_t hparams[11] = {51865, 1500, 512, 8, 6, 448, 512, 8, 6, 80, ftype};
+    std::vector<uint8_t> filler(payload, 0x5a);
+
+    const std::string path = (CACHE_DIR / name).string();
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    std::fwrite(&magic, sizeof(magic), 1, f);
+    std::fwrite(hparams, sizeof(hparams), 1, f);
+    std::fwrite(filler.data(), 1, filler.size(), f);
+    std::fclose(f);
+    return path;
+}
+
+// Stands in for quantizeModel: a valid ggml header with the quantized ftype
+struct FakeConverter {
+    int* calls;
+    bool succeed;
+
+    bool operator()(const std::string& src, const std::string& dst, ModelQuant quant, std::string* error) const {
+        ++*calls;
+        if (!succeed) {
+            *error = "disk full";
+            std::FILE* f = std::fopen(dst.c_str(), "wb");  // Leaves a partial file behind
+            std::fclose(f);
+            return false;
+        }
+        (void)src;
+        const uint32_t magic = 0x67676d6c;
+        int32_t hparams[11] = {};
+        hparams[10] = 2000 + (quant == ModelQuant::Q8_0 ? 7 : 9);
+        std::FILE* f = std::fopen(dst.c_str(), "wb");
+        std::fwrite(&magic, sizeof(magic), 1, f);
+        std::fwrite(hparams, sizeof(hparams), 1, f);
+        std::fclose(f);
+        return true;
+    }
+};
+
+size_t countFiles() {
+    size_t count = 0;
+    for (const auto& entry : fs::directory_iterator(CACHE_DIR)) {
+        (void)entry;
+        ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+TEST(ModelCache, ParsesModesAndPicksQuantization) {
+    QuantizeMode mode = QuantizeMode::Off;
+    CHECK(parseQuantizeMode("q8_0", &mode));
+    CHECK(mode == QuantizeMode::Q8_0);
+    CHECK(parseQuantizeMode("auto", &mode));
+    CHECK(mode == QuantizeMode::Auto);
+    CHECK(!parseQuantizeMode("q4_0", &mode));
+    CHECK(mode == QuantizeMode::Auto);
+
+    const uint64_t gib = 1ull << 30;
+    CHECK(chooseModelQuant(SimdIsa::AVX2, 16 * gib) == ModelQuant::Q8_0);
+    CHECK(chooseModelQuant(SimdIsa::NEON, 8 * gib) == ModelQuant::Q8_0);
+    CHECK(chooseModelQuant(SimdIsa::AVX2, 4 * gib) == ModelQuant::Q5_1);
+    CHECK(chooseModelQuant(SimdIsa::SSE41, 32 * gib) == ModelQuant::Q5_1);
+}
+
+TEST(ModelCache, ReadsHeaderType) {
+    resetDir();
+    const ModelFileInfo f16 = readModelFileInfo(writeModel("f16.bin", 1, 64));
+    CHECK(f16.valid);
+    CHECK_EQ(f16.ftype, 1);
+    CHECK(f16.quantizable());
+
+    // Quantization version is stripped: 2009 is q5_1
+    const ModelFileInfo q51 = readModelFileInfo(writeModel("q5_1.bin", 2009, 64));
+    CHECK(q51.valid);
+    CHECK_EQ(q51.ftype, 9);
+    CHECK(!q51.quantizable());
+
+    std::FILE* f = std::fopen((CACHE_DIR / "junk.bin").string().c_str(), "wb");
+    std::fputs("not a model", f);
+    std::fclose(f);
+    CHECK(!readModelFileInfo((CACHE_DIR / "junk.bin").string()).valid);
+    CHECK(!readModelFileInfo((CACHE_DIR / "missing.bin").string()).valid);
+}
+
+TEST(ModelCache, KeyFollowsFileAndQuantization) {
+    resetDir();
+    const std::string path = writeModel("ggml-base.en.bin", 1, 4096);
+    const uint64_t key = modelCacheKey(path, ModelQuant::Q5_1);
+    CHECK(key != 0);
+    CHECK_EQ(modelCacheKey(path, ModelQuant::Q5_1), key);
+    CHECK(modelCacheKey(path, ModelQuant::Q8_0) != key);
+
+    writeModel("ggml-base.en.bin", 1, 4097);
+    CHECK(modelCacheKey(path, ModelQuant::Q5_1) != key);
+    CHECK_EQ(modelCacheKey((CACHE_DIR / "missing.bin").string(), ModelQuant::Q5_1), 0ull);
+
+    const std::string name = cachedModelName(path, ModelQuant::Q5_1, 0x0123456789abcdefull);
+    CHECK(name == "ggml-base.en-q5_1-0123456789abcdef.bin");
+}
+
+TEST(ModelCache, ConvertsOnceThenHits) {
+    resetDir();
+    int calls = 0;
+    ModelCache cache(FakeConverter{&calls, true});
+    const std::string path = writeModel("ggml-small.bin", 1, 1024);
+
+    const std::string first = cache.resolve(path, QuantizeMode::Q5_1, SimdIsa::AVX2, 0);
+    CHECK(first != path);
+    CHECK(cache.getLastError().empty());
+    CHECK(!cache.wasCacheHit());
+    CHECK_EQ(calls, 1);
+    CHECK(fs::path(first).parent_path() == CACHE_DIR);
+    CHECK_EQ(readModelFileInfo(first).ftype, 9);
+
+    const std::string second = cache.resolve(path, QuantizeMode::Q5_1, SimdIsa::AVX2, 0);
+    CHECK(second == first);
+    CHECK(cache.wasCacheHit());
+    CHECK_EQ(calls, 1);
+
+    // A different quantization is a different cache entry
+    const std::string q8 = cache.resolve(path, QuantizeMode::Q8_0, SimdIsa::AVX2, 0);
+    CHECK(q8 != first);
+    CHECK_EQ(calls, 2);
+}
+
+TEST(ModelCache, ReplacesStaleConversion) {
+    resetDir();
+    int calls = 0;
+    ModelCache cache(FakeConverter{&calls, true});
+    const std::string path = writeModel("ggml-small.bin", 1, 1024);
+    const std::string old = cache.resolve(path, QuantizeMode::Q5_1, SimdIsa::AVX2, 0);
+
+    writeModel("ggml-small.bin", 1, 2048);  // Model updated in place
+    const std::string fresh = cache.resolve(path, QuantizeMode::Q5_1, SimdIsa::AVX2, 0);
+    CHECK(fresh != old);
+    CHECK_EQ(calls, 2);
+    CHECK(!fs::exists(old));
+    CHECK(fs::exists(fresh));
+    CHECK_EQ(countFiles(), static_cast<size_t>(2));  // Model and one conversion
+}
+
+TEST(ModelCache, KeepsConversionsOfOtherFiles) {
+    resetDir();
+    int calls = 0;
+    ModelCache cache(FakeConverter{&calls, true});
+
+    // A same-named model from another folder, converted into this one as the
+    // shared temp-dir cache would, plus a user file that only looks similar
+    fs::create_directories(CACHE_DIR / "other");
+    const std::string elsewhere = writeModel("other/ggml-small.bin", 1, 512);
+    const uint64_t elsewhereKey = modelCacheKey(elsewhere, ModelQuant::Q5_1);
+    const fs::path foreign = CACHE_DIR / cachedModelName(elsewhere, ModelQuant::Q5_1, elsewhereKey);
+    const fs::path lookalike = CACHE_DIR / "ggml-small-q5_1-notes-on-q5_1!!!.bin";
+    std::fclose(std::fopen(foreign.string().c_str(), "wb"));
+    std::fclose(std::fopen(lookalike.string().c_str(), "wb"));
+
+    const std::string path = writeModel("ggml-small.bin", 1, 1024);
+    CHECK(modelCacheKey(path, ModelQuant::Q5_1) >> 32 != elsewhereKey >> 32);
+    const std::string converted = cache.resolve(path, QuantizeMode::Q5_1, SimdIsa::AVX2, 0);
+    CHECK(converted != path);
+    CHECK(fs::exists(foreign));
+    CHECK(fs::exists(lookalike));
+}
+
+TEST(ModelCache, FallsBackToOriginal) {
+    resetDir();
+    int calls = 0;
+    ModelCache cache(FakeConverter{&calls, true});
+    const std::string f16 = writeModel("ggml-f16.bin", 1, 256);
+    const std::string q51 = writeModel("ggml-q5_1.bin", 2009, 256);
+
+    CHECK(cache.resolve(f16, QuantizeMode::Off, SimdIsa::AVX2, 0) == f16);
+    CHECK(cache.resolve(q51, QuantizeMode::Auto, SimdIsa::AVX2, 0) == q51);
+    CHECK(cache.getLastError().empty());
+    CHECK(cache.resolve((CACHE_DIR / "missing.bin").string(), QuantizeMode::Auto, SimdIsa::AVX2, 0) ==
+          (CACHE_DIR / "missing.bin").string());
+    CHECK(!cache.getLastError().empty());
+    CHECK_EQ(calls, 0);
+
+    ModelCache failing(FakeConverter{&calls, false});
+    CHECK(failing.resolve(f16, QuantizeMode::Q8_0, SimdIsa::AVX2, 0) == f16);
+    CHECK(failing.getLastError().find("disk full") != std::string::npos);
+    CHECK_EQ(countFiles(), static_cast<size_t>(2));  // No partial files left
+    fs::remove_all(CACHE_DIR);
+}
@@ -0,0 +1,116 @@
+#include "test_harness.h"
+#include "noise_suppressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+const SimdIsa ALL_ISAS[] = {SimdIsa::Scalar, SimdIsa::SSE2, SimdIsa::SSSE3,
+                            SimdIsa::SSE41, SimdIsa::AVX2, SimdIsa::NEON};
+
+const double PI = 3.14159265358979323846;
+
+std::vector<float> noise(size_t n, float amplitude, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-amplitude, amplitude);
+    std::vector<float> out(n);
+    for (float& v : out) v = dist(rng);
+    return out;
+}
+
+float rms(const std::vector<float>& samples, size_t begin, size_t end) {
+    double sum = 0.0;
+    for (size_t i = begin; i < end; ++i) sum += static_cast<double>(samples[i]) * samples[i];
+    return static_cast<float>(std::sqrt(sum / static_cast<double>(end - begin)));
+}
+
+} // namespace
+
+TEST(RealFft, MatchesDftAndRoundTrips) {
+    const size_t n = 64;
+    const std::vector<float> input = noise(n, 1.0f, 7);
+    for (SimdIsa isa : ALL_ISAS) {
+        RealFft fft(n, isa);
+        std::vector<float> re(n / 2 + 1), im(n / 2 + 1);
+        fft.forward(input.data(), re.data(), im.data());
+
+        for (size_t k = 0; k <= n / 2; ++k) {
+            double dftRe = 0.0, dftIm = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                const double angle = -2.0 * PI * static_cast<double>(k * i) / n;
+                dftRe += input[i] * std::cos(angle);
+                dftIm += input[i] * std::sin(angle);
+            }
+            CHECK_NEAR(re[k], static_cast<float>(dftRe), 1e-4f);
+            CHECK_NEAR(im[k], static_cast<float>(dftIm), 1e-4f);
+        }
+
+        std::vector<float> output(n);
+        fft.inverse(re.data(), im.data(), output.data());
+        for (size_t i = 0; i < n; ++i) {
+            CHECK_NEAR(output[i], input[i], 1e-5f);
+        }
+    }
+}
+
+TEST(NoiseSuppressor, DelaysByFixedLatency) {
+    // Every call returns as many samples as it was given, whatever the sizes
+    NoiseSuppressor denoiser;
+    const std::vector<float> input = noise(16000, 0.5f, 3);
+    std::vector<float> out;
+    denoiser.process(input.data(), 1, out);
+    const size_t chunks[] = {7, 256, 1000, 13, 4096};
+    size_t fed = 1;
+    for (size_t i = 0; fed < input.size(); ++i) {
+        const size_t n = std::min(chunks[i % 5], input.size() - fed);
+        denoiser.process(input.data() + fed, n, out);
+        fed += n;
+    }
+    CHECK_EQ(out.size(), input.size());
+    CHECK_EQ(denoiser.drain(100000, out), NoiseSuppressor::LATENCY_SAMPLES);
+    CHECK_EQ(out.size(), input.size() + NoiseSuppressor::LATENCY_SAMPLES);
+
+    for (size_t i = 0; i < NoiseSuppressor::HOP; ++i) {
+        CHECK(out[i] == 0.0f);
+    }
+    // The output lines up with the input LATENCY_SAMPLES later
+    double aligned = 0.0, shifted = 0.0;
+    for (size_t i = 0; i < input.size(); ++i) {
+        aligned += out[i + NoiseSuppressor::LATENCY_SAMPLES] * input[i];
+        shifted += out[i + NoiseSuppressor::LATENCY_SAMPLES - 1] * input[i];
+    }
+    CHECK(aligned > 10.0 * std::fabs(shifted));
+}
+
+TEST(NoiseSuppressor, GatesStationaryNoiseKeepsTone) {
+    // 2s of noise, then 1s of a 1kHz tone over the same noise
+    const size_t rate = 16000;
+    std::vector<float> input = noise(3 * rate, 0.05f, 11);
+    for (size_t i = 2 * rate; i < input.size(); ++i) {
+        input[i] += 0.3f * static_cast<float>(std::sin(2.0 * PI * 1000.0 * i / rate));
+    }
+
+    for (SimdIsa isa : ALL_ISAS) {
+        NoiseSuppressor denoiser(isa);
+        std::vector<float> out;
+        denoiser.process(input.data(), input.size(), out);
+        denoiser.drain(NoiseSuppressor::LATENCY_SAMPLES, out);
+        const size_t delay = NoiseSuppressor::LATENCY_SAMPLES;
+
+        // At least 6dB less noise once the floor has settled
+        const float noiseIn = rms(input, rate, 2 * rate - delay);
+        const float noiseOut = rms(out, rate + delay, 2 * rate);
+        CHECK(noiseOut < 0.5f * noiseIn);
+
+        // The tone passes within about 1dB
+        const float toneIn = rms(input, 2 * rate + 1600, 3 * rate);
+        const float toneOut = rms(out, 2 * rate + 1600 + delay, 3 * rate + delay);
+        CHECK(toneOut > 0.89f * toneIn && toneOut < 1.12f * toneIn);
+    }
+}
@@ -0,0 +1,92 @@
+#include "test_harness.h"
+#include "pipeline_metrics.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace phantom;
+
+TEST(LatencyHistogram, BucketsAreContiguousAndPrecise) {
+    int previous = -1;
+    for (uint64_t v = 0; v < 200000; ++v) {
+        const int index = LatencyHistogram::bucketIndex(v);
+        // Indices never go backwards or skip
+        CHECK(index == previous || index == previous + 1);
+        CHECK(v <= LatencyHistogram::bucketUpperBound(index));
+        CHECK(LatencyHistogram::bucketUpperBound(index) - v <= v / 16);
+        previous = index;
+    }
+
+    const uint64_t huge = 1ULL << 50;
+    CHECK(LatencyHistogram::bucketIndex(huge) < LatencyHistogram::BUCKETS);
+    CHECK_EQ(LatencyHistogram::bucketIndex(huge), LatencyHistogram::BUCKETS - 1);
+}
+
+TEST(LatencyHistogram, Percentiles) {
+    LatencyHistogram h;
+    CHECK_EQ(h.percentile(50.0), static_cast<uint64_t>(0));
+
+    for (uint64_t v = 1; v <= 1000; ++v) h.record(v * 100);  // 100us .. 100ms
+    CHECK_EQ(h.count(), static_cast<uint64_t>(1000));
+    CHECK_EQ(h.max(), static_cast<uint64_t>(100000));
+    CHECK_NEAR(h.mean(), 50050.0, 1e-6);
+    CHECK_NEAR(static_cast<double>(h.percentile(50.0)), 50000.0, 50000.0 / 16);
+    CHECK_NEAR(static_cast<double>(h.percentile(99.0)), 99000.0, 99000.0 / 16);
+    CHECK_EQ(h.percentile(100.0), static_cast<uint64_t>(100000));
+
+    h.reset();
+    CHECK_EQ(h.count(), static_cast<uint64_t>(0));
+    CHECK_EQ(h.percentile(90.0), static_cast<uint64_t>(0));
+}
+
+TEST(LatencyHistogram, ConcurrentRecording) {
+    LatencyHistogram h;
+    const int threads = 4;
+    const int perThread = 50000;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&h, t] {
+            std::mt19937 rng(static_cast<uint32_t>(t));
+            std::uniform_int_distribution<uint64_t> dist(1, 1000000);
+            for (int i = 0; i < perThread; ++i) h.record(dist(rng));
+        });
+    }
+    for (std::thread& w : workers) w.join();
+
+    CHECK_EQ(h.count(), static_cast<uint64_t>(threads * perThread));
+    CHECK(h.max() <= 1000000);
+    CHECK(h.percentile(50.0) > 400000 && h.percentile(50.0) < 600000);
+}
+
+TEST(PipelineMetrics, ReportsEveryStage) {
+    PipelineMetrics m;
+    m.inference.record(800000);
+    m.rtfMilli.record(400);
+    m.chunksTranscribed.fetch_add(1);
+    m.bufferSamples.set(32000);
+    m.bufferSamples.set(16000);
+
+    std::string json = "{";
+    m.appendJson(json);
+    json += "}";
+
+    const char* keys[] = {"\"uptime_ms\":", "\"capture_interval_us\":", "\"resample_us\":",
+                          "\"queue_wait_us\":", "\"vad_us\":", "\"encode_us\":", "\"decode_us\":",
+                          "\"output_write_us\":", "\"dropped_samples\":0",
+                          "\"chunks_transcribed\":1", "\"buffer_samples\":16000",
+                          "\"buffer_samples_max\":32000", "\"rtf\":{\"count\":1,\"mean\":0.4"};
+    for (const char* key : keys) {
+        if (json.find(key) == std::string::npos) {
+            ::phantom::test::reportFailure(__FILE__, __LINE__, std::string("missing ") + key + " in " + json);
+        }
+    }
+
+    m.reset();
+    CHECK_EQ(m.inference.count(), static_cast<uint64_t>(0));
+    CHECK_EQ(m.chunksTranscribed.load(), static_cast<uint64_t>(0));
+    CHECK_EQ(m.bufferSamples.max(), static_cast<uint64_t>(16000));
+}
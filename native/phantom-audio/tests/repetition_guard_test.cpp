@@ -0,0 +1,58 @@
+#include "test_harness.h"
+#include "repetition_guard.h"
+
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+RepetitionLoop find(const std::vector<int32_t>& tokens) {
+    return findRepetitionLoop(tokens.data(), tokens.size());
+}
+
+} // namespace
+
+TEST(RepetitionGuard, FindsShortestLoopAtEnd) {
+    // "we said you you you you"
+    const RepetitionLoop unigram = find({7, 8, 5, 5, 5, 5});
+    CHECK_EQ(unigram.ngram, static_cast<size_t>(1));
+    CHECK_EQ(unigram.repeats, static_cast<size_t>(4));
+    CHECK_EQ(unigram.start, static_cast<size_t>(2));
+    CHECK_EQ(unigram.keep(), static_cast<size_t>(3));
+
+    // "Thank you. Thank you. Thank you." after one word
+    const RepetitionLoop trigram = find({9, 1, 2, 3, 1, 2, 3, 1, 2, 3});
+    CHECK_EQ(trigram.ngram, static_cast<size_t>(3));
+    CHECK_EQ(trigram.repeats, static_cast<size_t>(3));
+    CHECK_EQ(trigram.keep(), static_cast<size_t>(4));
+
+    const RepetitionLoop bigram = find({1, 2, 1, 2, 1, 2, 1, 2});
+    CHECK_EQ(bigram.ngram, static_cast<size_t>(2));
+    CHECK_EQ(bigram.repeats, static_cast<size_t>(4));
+    CHECK_EQ(bigram.start, static_cast<size_t>(0));
+}
+
+TEST(RepetitionGuard, IgnoresOrdinaryRepeats) {
+    CHECK(!find({}).found());
+    CHECK(!find({4, 4, 4}).found());                    // "no no no"
+    CHECK(!find({1, 2, 1, 2}).found());                 // Twice is not a loop
+    CHECK(!find({1, 2, 3, 4, 5, 6, 7, 8, 9}).found());
+    CHECK(!find({5, 5, 5, 5, 6}).found());              // Loop already over
+}
+
+TEST(RepetitionGuard, TokenLimitScalesWithAudio) {
+    CHECK_EQ(maxTokensForAudio(16000 * 10, 16000, "en"), 160);
+    CHECK_EQ(maxTokensForAudio(16000 / 2, 16000, "en"), 16);
+    CHECK_EQ(maxTokensForAudio(16000 * 10 + 1, 16000, "de"), 161);
+    CHECK_EQ(maxTokensForAudio(0, 16000, "en"), 16);
+}
+
+TEST(RepetitionGuard, TokenLimitLeavesRoomForDenseScripts) {
+    // Fast Mandarin or Thai runs past 16 tokens a second
+    CHECK_EQ(maxTokensForAudio(16000 * 10, 16000, "zh"), 480);
+    CHECK_EQ(maxTokensForAudio(16000 * 10, 16000, "th"), 480);
+    CHECK_EQ(maxTokensForAudio(16000 * 10, 16000, "ja"), 480);
+    CHECK_EQ(maxTokensForAudio(16000 * 10, 16000, "auto"), 480);
+    CHECK_EQ(maxTokensForAudio(16000 * 10, 16000, "es"), 160);
+}
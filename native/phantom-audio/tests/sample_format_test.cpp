@@ -0,0 +1,209 @@
+#include "test_harness.h"
+#include "sample_format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+const SimdIsa ALL_ISAS[] = {SimdIsa::Scalar, SimdIsa::SSE2, SimdIsa::SSSE3,
+                            SimdIsa::SSE41, SimdIsa::AVX2, SimdIsa::NEON};
+
+std::vector<float> makeSpeechLike(size_t numSamples) {
+    // Harmonic stack with a slow envelope plus a little noise
+    std::mt19937 rng(7);
+    std::normal_distribution<float> noise(0.0f, 0.002f);
+    std::vector<float> out(numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+        const float t = static_cast<float>(i) / 16000.0f;
+        const float envelope = 0.5f * (1.0f - std::cos(2.0f * 3.14159265f * 3.0f * t));
+        float v = 0.0f;
+        for (int h = 1; h <= 6; ++h) {
+            v += std::sin(2.0f * 3.14159265f * 140.0f * h * t) / static_cast<float>(h);
+        }
+        out[i] = 0.3f * envelope * v + noise(rng);
+    }
+    return out;
+}
+
+} // namespace
+
+TEST(SampleFormat, RoundTripWithinHalfLsb) {
+    std::vector<float> input(4001);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = -1.0f + 2.0f * static_cast<float>(i) / static_cast<float>(input.size());
+    }
+
+    std::vector<int16_t> s16(input.size());
+    std::vector<float> back(input.size());
+    floatToS16(input.data(), s16.data(), input.size());
+    s16ToFloat(s16.data(), back.data(), back.size());
+
+    for (size_t i = 0; i < input.size(); ++i) {
+        CHECK_NEAR(back[i], input[i], 0.5 / 32768.0 + 1e-9);
+    }
+}
+
+TEST(SampleFormat, SaturatesAndHandlesNonFinite) {
+    const float input[] = {1.0f, -1.0f, 2.0f, -2.0f, 0.0f,
+                           std::numeric_limits<float>::infinity(),
+                           -std::numeric_limits<float>::infinity(),
+                           std::numeric_limits<float>::quiet_NaN()};
+    const int16_t expected[] = {32767, -32768, 32767, -32768, 0, 32767, -32768, 0};
+    const size_t n = sizeof(input) / sizeof(input[0]);
+
+    int16_t out[n];
+    floatToS16(input, out, n);
+    for (size_t i = 0; i < n; ++i) CHECK_EQ(out[i], expected[i]);
+
+    floatToS16Scalar(input, out, n);
+    for (size_t i = 0; i < n; ++i) CHECK_EQ(out[i], expected[i]);
+
+    // NaN is silence on every kernel, dithered or not
+    std::vector<float> nans(37, std::numeric_limits<float>::quiet_NaN());
+    std::vector<int16_t> converted(nans.size());
+    for (SimdIsa isa : ALL_ISAS) {
+        floatToS16(nans.data(), converted.data(), nans.size(), isa);
+        CHECK(std::all_of(converted.begin(), converted.end(), [](int16_t s) { return s == 0; }));
+        DitherState dither(7);
+        floatToS16Dithered(nans.data(), converted.data(), nans.size(), dither, isa);
+        CHECK(std::all_of(converted.begin(), converted.end(), [](int16_t s) { return s == 0; }));
+    }
+}
+
+TEST(SampleFormat, SimdMatchesScalar) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(-1.2f, 1.2f);
+
+    // Cover every tail length around the vector widths
+    for (size_t n = 0; n < 40; ++n) {
+        std::vector<float> input(n);
+        for (float& v : input) v = dist(rng);
+        if (n > 20) {
+            input[3] = std::numeric_limits<float>::quiet_NaN();
+            input[17] = std::numeric_limits<float>::infinity();
+        }
+
+        std::vector<int16_t> scalar(n);
+        floatToS16Scalar(input.data(), scalar.data(), n);
+        std::vector<int16_t> ditheredScalar(n);
+        DitherState scalarDither(1234);
+        floatToS16DitheredScalar(input.data(), ditheredScalar.data(), n, scalarDither);
+
+        for (SimdIsa isa : ALL_ISAS) {
+            std::vector<int16_t> simd(n);
+            floatToS16(input.data(), simd.data(), n, isa);
+            CHECK(simd == scalar);
+
+            DitherState dither(1234);
+            floatToS16Dithered(input.data(), simd.data(), n, dither, isa);
+            CHECK(simd == ditheredScalar);
+            for (int lane = 0; lane < 4; ++lane) CHECK_EQ(dither.lanes[lane], scalarDither.lanes[lane]);
+        }
+    }
+
+    // Every int16 value, at offsets that leave every tail length
+    std::vector<int16_t> all(65536);
+    for (size_t i = 0; i < all.size(); ++i) all[i] = static_cast<int16_t>(static_cast<int32_t>(i) - 32768);
+    std::vector<float> scalar(all.size());
+    s16ToFloatScalar(all.data(), scalar.data(), all.size());
+    CHECK_EQ(scalar.front(), -1.0f);
+    for (SimdIsa isa : ALL_ISAS) {
+        for (size_t skip = 0; skip < 16; ++skip) {
+            std::vector<float> simd(all.size() - skip);
+            s16ToFloat(all.data() + skip, simd.data(), simd.size(), isa);
+            CHECK(std::equal(simd.begin(), simd.end(), scalar.begin() + skip));
+        }
+    }
+}
+
+TEST(SampleFormat, DownmixMatchesScalar) {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    const uint16_t layouts[] = {1, 2, 6};
+    for (uint16_t channels : layouts) {
+        for (size_t frames = 0; frames < 40; ++frames) {
+            std::vector<float> input(frames * channels);
+            for (float& v : input) v = dist(rng);
+            std::vector<float> scalar(frames);
+            downmixToMonoScalar(input.data(), scalar.data(), frames, channels);
+            for (SimdIsa isa : ALL_ISAS) {
+                std::vector<float> simd(frames);
+                downmixToMono(input.data(), simd.data(), frames, channels, isa);
+                CHECK(simd == scalar);
+            }
+        }
+    }
+
+    const float stereo[] = {1.0f, 0.0f, -0.5f, -0.25f};
+    float mono[2];
+    downmixToMono(stereo, mono, 2, 2);
+    CHECK_EQ(mono[0], 0.5f);
+    CHECK_EQ(mono[1], -0.375f);
+}
+
+TEST(SampleFormat, DitherIsUnbiasedAndBounded) {
+    // A level between two LSBs: plain rounding always picks the nearest
+    // step, dither must average out to the true value.
+    const float level = 100.3f / 32768.0f;
+    std::vector<float> input(100000, level);
+    std::vector<int16_t> out(input.size());
+
+    floatToS16(input.data(), out.data(), out.size());
+    CHECK_EQ(out[0], static_cast<int16_t>(100));
+
+    DitherState dither;
+    floatToS16Dithered(input.data(), out.data(), out.size(), dither);
+
+    double sum = 0.0;
+    for (int16_t v : out) {
+        sum += v;
+        CHECK(v >= 99 && v <= 102);
+    }
+    CHECK_NEAR(sum / static_cast<double>(out.size()), 100.3, 0.02);
+}
+
+TEST(SampleFormat, S16PathMatchesFloatPath) {
+    // The s16 pipeline converts at capture and back to float right before
+    // whisper. Check what whisper sees against the float pipeline.
+    const std::vector<float> reference = makeSpeechLike(16000 * 2);
+
+    for (int useDither = 0; useDither <= 1; ++useDither) {
+        std::vector<int16_t> stored(reference.size());
+        DitherState dither;
+        if (useDither) {
+            floatToS16Dithered(reference.data(), stored.data(), stored.size(), dither);
+        } else {
+            floatToS16(reference.data(), stored.data(), stored.size());
+        }
+
+        std::vector<float> features(reference.size());
+        s16ToFloat(stored.data(), features.data(), features.size());
+
+        double signal = 0.0, error = 0.0;
+        for (size_t i = 0; i < reference.size(); ++i) {
+            signal += static_cast<double>(reference[i]) * reference[i];
+            const double e = static_cast<double>(features[i]) - reference[i];
+            error += e * e;
+        }
+        const double snrDb = 10.0 * std::log10(signal / error);
+        CHECK(snrDb > (useDither ? 75.0 : 80.0));
+
+        // 50ms window energies (what trimSilence looks at) stay put
+        const size_t window = 800;
+        for (size_t start = 0; start + window <= reference.size(); start += window) {
+            double a = 0.0, b = 0.0;
+            for (size_t i = start; i < start + window; ++i) {
+                a += std::fabs(reference[i]);
+                b += std::fabs(features[i]);
+            }
+            CHECK_NEAR(a / window, b / window, 1.0 / 32768.0);
+        }
+    }
+}
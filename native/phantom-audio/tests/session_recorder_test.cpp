@@ -0,0 +1,135 @@
+#include "test_harness.h"
+#include "session_recorder.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+const char* const SESSION_PATH = "phantom-audio-session-test.phrec";
+
+// Overwrite part of a closed recording, as damage or a power cut would
+template <typename T>
+void patch(size_t offset, T value) {
+    std::FILE* file = std::fopen(SESSION_PATH, "r+b");
+    std::fseek(file, static_cast<long>(offset), SEEK_SET);
+    std::fwrite(&value, sizeof(value), 1, file);
+    std::fclose(file);
+}
+
+} // namespace
+
+TEST(SessionRecorder, ReadableWhileRecording) {
+    uintmax_t preallocated = 0;
+    {
+        SessionRecorder recorder;
+        CHECK(recorder.create(SESSION_PATH, 16000));
+        recorder.markStart();
+
+        const std::vector<float> tone = {0.5f, -0.5f, 0.25f, 0.0f};
+        recorder.write(tone.data(), tone.size());
+        recorder.writeSilence(100);
+        recorder.writeSilence(50);  // Same run
+        const std::vector<int16_t> pcm = {1000, -1000};
+        recorder.write(pcm.data(), pcm.size());
+        CHECK_EQ(recorder.samplesWritten(), static_cast<uint64_t>(156));
+        recorder.flush();
+        preallocated = std::filesystem::file_size(SESSION_PATH);
+
+        // Still open, as after a crash: everything published is there
+        CHECK(SessionReader::isSessionFile(SESSION_PATH));
+        SessionReader reader;
+        CHECK(reader.open(SESSION_PATH));
+        CHECK_EQ(reader.samples(), static_cast<uint64_t>(156));
+        CHECK_EQ(reader.sampleRate(), 16000u);
+
+        const std::vector<SessionIndexEntry>& entries = reader.entries();
+        CHECK_EQ(entries.size(), static_cast<size_t>(2));
+        CHECK_EQ(entries[0].mark, static_cast<uint32_t>(SessionMark::Start));
+        CHECK_EQ(entries[0].sample, static_cast<uint64_t>(0));
+        CHECK_EQ(entries[1].mark, static_cast<uint32_t>(SessionMark::Silence));
+        CHECK_EQ(entries[1].sample, static_cast<uint64_t>(4));
+        CHECK_EQ(entries[1].count, static_cast<uint64_t>(150));
+
+        std::vector<float> audio;
+        CHECK(reader.read(0, 4, audio));
+        CHECK_EQ(audio.size(), static_cast<size_t>(4));
+        CHECK_NEAR(audio[0], 0.5f, 1e-4f);
+        CHECK_NEAR(audio[1], -0.5f, 1e-4f);
+        CHECK(reader.read(100, 1000, audio));  // Clamped to what was recorded
+        CHECK_EQ(audio.size(), static_cast<size_t>(56));
+        CHECK(audio[0] == 0.0f);
+        CHECK_NEAR(audio[54], 1000.0f / 32768.0f, 1e-6f);
+    }
+
+    // Closing trims the preallocated file to the recording
+    SessionReader reader;
+    CHECK(reader.open(SESSION_PATH));
+    CHECK_EQ(reader.samples(), static_cast<uint64_t>(156));
+    std::vector<float> audio;
+    CHECK(reader.read(150, 156, audio));
+    CHECK_EQ(audio.size(), static_cast<size_t>(6));
+    reader.close();
+    CHECK_EQ(preallocated - std::filesystem::file_size(SESSION_PATH),
+             static_cast<uintmax_t>((16000 - 156) * sizeof(int16_t)));
+    std::remove(SESSION_PATH);
+}
+
+TEST(SessionRecorder, StopsWhenFull) {
+    {
+        SessionRecorder recorder;
+        CHECK(recorder.create(SESSION_PATH, 10));
+        const std::vector<float> samples(8, 0.1f);
+        recorder.write(samples.data(), samples.size());
+        recorder.write(samples.data(), samples.size());
+        recorder.writeSilence(5);
+        CHECK_EQ(recorder.samplesWritten(), static_cast<uint64_t>(10));
+        CHECK_EQ(recorder.droppedSamples(), static_cast<uint64_t>(11));
+    }
+
+    SessionReader reader;
+    CHECK(reader.open(SESSION_PATH));
+    CHECK_EQ(reader.samples(), static_cast<uint64_t>(10));
+    CHECK(reader.entries().empty());
+    reader.close();
+    std::remove(SESSION_PATH);
+
+    CHECK(!SessionReader::isSessionFile(SESSION_PATH));
+    CHECK(!reader.open(SESSION_PATH));
+}
+
+TEST(SessionRecorder, ReaderTrustsOnlyWhatTheFileHolds) {
+    {
+        SessionRecorder recorder;
+        CHECK(recorder.create(SESSION_PATH, 16000));
+        recorder.markStart();
+        recorder.writeSilence(100);
+        recorder.markStart();
+    }
+
+    // An index entry the disk never received reads as zeros
+    const size_t index = sizeof(SessionFileHeader);
+    patch(index + sizeof(SessionIndexEntry) + offsetof(SessionIndexEntry, mark), uint32_t{0});
+    SessionReader reader;
+    CHECK(reader.open(SESSION_PATH));
+    CHECK_EQ(reader.entries().size(), static_cast<size_t>(2));
+    CHECK_EQ(reader.entries()[1].mark, static_cast<uint32_t>(SessionMark::Start));
+    reader.close();
+
+    // A header claiming an index far larger than the file is rejected,
+    // not allocated
+    const uint32_t huge = 0xFFFFFFFFu;
+    const uint64_t hugeIndex = sizeof(SessionFileHeader) + uint64_t{huge} * sizeof(SessionIndexEntry);
+    const uint64_t hugeOffset = (hugeIndex + 4095) / 4096 * 4096;
+    patch(offsetof(SessionFileHeader, indexCapacity), huge);
+    patch(offsetof(SessionFileHeader, dataOffset), hugeOffset);
+    patch(offsetof(SessionFileHeader, indexEntries), huge);
+    CHECK(!reader.open(SESSION_PATH));
+    std::remove(SESSION_PATH);
+}
@@ -0,0 +1,133 @@
+#include "test_harness.h"
+#include "shared_audio_ring.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+// Sample n of the stream carries n modulo a period well above the capacity,
+// so a sample from the wrong lap or a torn copy shows up as a mismatch
+constexpr uint64_t PERIOD = 1 << 20;
+
+float sampleAt(uint64_t n) {
+    return static_cast<float>(n % PERIOD);
+}
+
+void writeRamp(SharedAudioRing& ring, uint64_t& next, size_t count) {
+    std::vector<float> samples(count);
+    for (size_t i = 0; i < count; ++i) samples[i] = sampleAt(next + i);
+    ring.write(samples.data(), count);
+    next += count;
+}
+
+// Samples read match the stream from where the reader says it resumed
+bool readMatches(SharedAudioRingReader& reader, std::vector<float>& buffer, size_t* count, uint64_t* dropped) {
+    const uint64_t before = reader.getReadSequence();
+    *count = reader.read(buffer.data(), buffer.size(), dropped);
+    const uint64_t start = before + *dropped;
+    if (reader.getReadSequence() != start + *count) return false;
+    for (size_t i = 0; i < *count; ++i) {
+        if (buffer[i] != sampleAt(start + i)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(SharedAudioRing, ReadsAcrossTheWrap) {
+    SharedAudioRing ring;
+    CHECK(ring.create(SharedAudioRing::defaultName() + "-wrap", 1000));
+    CHECK_EQ(ring.getCapacity(), static_cast<uint32_t>(1024));
+    SharedAudioRingReader reader;
+    CHECK(reader.open(SharedAudioRing::defaultName() + "-wrap"));
+
+    std::vector<float> buffer(1024);
+    uint64_t next = 0;
+    size_t count = 0;
+    uint64_t dropped = 0;
+    for (int i = 0; i < 20; ++i) {
+        writeRamp(ring, next, 700);
+        CHECK(reader.wait(0));
+        CHECK(readMatches(reader, buffer, &count, &dropped));
+        CHECK_EQ(count, static_cast<size_t>(700));
+        CHECK_EQ(dropped, static_cast<uint64_t>(0));
+    }
+    CHECK(!reader.wait(0));
+
+    // int16 readers of a float ring get the converted samples
+    std::vector<float> ones(8, 0.5f);
+    ring.write(ones.data(), ones.size());
+    std::vector<int16_t> s16(16);
+    CHECK_EQ(reader.read(s16.data(), s16.size()), static_cast<size_t>(8));
+    CHECK_EQ(s16[0], static_cast<int16_t>(16384));
+}
+
+TEST(SharedAudioRing, CountsOverrunAsDropped) {
+    SharedAudioRing ring;
+    CHECK(ring.create(SharedAudioRing::defaultName() + "-overrun", 1024));
+    SharedAudioRingReader reader;
+    CHECK(reader.open(SharedAudioRing::defaultName() + "-overrun"));
+
+    // 3000 samples into a 1024 ring: the reader resumes at the oldest survivor
+    std::vector<float> buffer(4096);
+    uint64_t next = 0;
+    writeRamp(ring, next, 1000);
+    writeRamp(ring, next, 2000);
+    size_t count = 0;
+    uint64_t dropped = 0;
+    CHECK(readMatches(reader, buffer, &count, &dropped));
+    CHECK_EQ(dropped, static_cast<uint64_t>(3000 - 1024));
+    CHECK_EQ(count, static_cast<size_t>(1024));
+
+    // A single write larger than the ring keeps only its tail
+    writeRamp(ring, next, 5000);
+    CHECK(readMatches(reader, buffer, &count, &dropped));
+    CHECK_EQ(dropped, static_cast<uint64_t>(5000 - 1024));
+    CHECK_EQ(count, static_cast<size_t>(1024));
+    CHECK_EQ(reader.getReadSequence(), static_cast<uint64_t>(8000));
+}
+
+TEST(SharedAudioRing, ReadsRacingTheWriterAreNeverTorn) {
+    SharedAudioRing ring;
+    CHECK(ring.create(SharedAudioRing::defaultName() + "-race", 65536));
+    SharedAudioRingReader reader;
+    CHECK(reader.open(SharedAudioRing::defaultName() + "-race"));
+
+    // The writer copies large slices of a precomputed ramp, so most of its
+    // time is spent inside the ring's copy
+    constexpr uint64_t TOTAL = 20000000;
+    std::vector<float> ramp(PERIOD + 65536);
+    for (size_t i = 0; i < ramp.size(); ++i) ramp[i] = sampleAt(i);
+    std::atomic<bool> done{false};
+    std::thread writer([&ring, &ramp, &done] {
+        uint64_t next = 0;
+        while (next < TOTAL) {
+            const size_t count = 8192 + static_cast<size_t>(next % 16381);
+            ring.write(ramp.data() + next % PERIOD, count);
+            next += count;
+        }
+        done.store(true);
+    });
+
+    // Small reads keep the reader a lap behind, where the writer is overwriting
+    std::vector<float> buffer(256);
+    uint64_t read = 0;
+    uint64_t lost = 0;
+    bool intact = true;
+    while (!done.load() || reader.wait(0)) {
+        size_t count = 0;
+        uint64_t dropped = 0;
+        intact = readMatches(reader, buffer, &count, &dropped) && intact;
+        read += count;
+        lost += dropped;
+    }
+    writer.join();
+
+    CHECK(intact);
+    CHECK_EQ(read + lost, reader.getReadSequence());
+    CHECK(read > 0);
+}
@@ -0,0 +1,83 @@
+#include "test_harness.h"
+#include "silence_detect.h"
+#include "audio_resampler.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+const SimdIsa ALL_ISAS[] = {SimdIsa::Scalar, SimdIsa::SSE2, SimdIsa::SSSE3,
+                            SimdIsa::SSE41, SimdIsa::AVX2, SimdIsa::NEON};
+
+} // namespace
+
+TEST(SilenceDetect, FloatKernelsFindOneLoudSample) {
+    // Lengths around every kernel's block size, loud sample at every index
+    for (size_t n = 0; n <= 40; ++n) {
+        std::vector<float> samples(n, 0.0f);
+        for (SimdIsa isa : ALL_ISAS) {
+            CHECK(isSilent(samples.data(), n, DIGITAL_SILENCE_FLOOR, isa));
+        }
+        for (size_t loud = 0; loud < n; ++loud) {
+            for (size_t i = 0; i < n; ++i) {
+                samples[i] = (i % 2 ? -1.0f : 1.0f) * DIGITAL_SILENCE_FLOOR;  // At the floor
+            }
+            samples[loud] = (loud % 2 ? -2.0f : 2.0f) * DIGITAL_SILENCE_FLOOR;
+            for (SimdIsa isa : ALL_ISAS) {
+                CHECK(!isSilent(samples.data(), n, DIGITAL_SILENCE_FLOOR, isa));
+            }
+            samples[loud] = std::numeric_limits<float>::quiet_NaN();
+            for (SimdIsa isa : ALL_ISAS) {
+                CHECK(!isSilent(samples.data(), n, DIGITAL_SILENCE_FLOOR, isa));
+            }
+        }
+    }
+}
+
+TEST(SilenceDetect, S16KernelsFindOneLoudSample) {
+    for (size_t n = 0; n <= 40; ++n) {
+        std::vector<int16_t> samples(n, 0);
+        for (size_t i = 0; i < n; ++i) {
+            samples[i] = static_cast<int16_t>(i % 3) - 1;  // -1, 0, 1
+        }
+        for (SimdIsa isa : ALL_ISAS) {
+            CHECK(isSilent(samples.data(), n, DIGITAL_SILENCE_FLOOR_S16, isa));
+        }
+        for (size_t loud = 0; loud < n; ++loud) {
+            const int16_t saved = samples[loud];
+            const int16_t values[] = {2, -2, 32767, -32768};
+            for (int16_t value : values) {
+                samples[loud] = value;
+                for (SimdIsa isa : ALL_ISAS) {
+                    CHECK(!isSilent(samples.data(), n, DIGITAL_SILENCE_FLOOR_S16, isa));
+                }
+            }
+            samples[loud] = saved;
+        }
+    }
+}
+
+TEST(SilenceDetect, ResamplerSkipKeepsTheClock) {
+    // 44.1kHz stereo in 10ms packets: the output count per packet varies,
+    // and skipping must land on the same count as resampling zeros
+    AudioResampler processed(44100, 2, 16000);
+    AudioResampler skipped(44100, 2, 16000);
+    const std::vector<float> silence(441 * 2, 0.0f);
+    size_t processedTotal = 0;
+    size_t skippedTotal = 0;
+    for (int packet = 0; packet < 1000; ++packet) {
+        processedTotal += processed.process(silence.data(), 441).size();
+        skippedTotal += skipped.skip(441);
+        CHECK_EQ(skippedTotal, processedTotal);
+    }
+    CHECK_EQ(skippedTotal, static_cast<size_t>(160000));
+
+    AudioResampler passthrough(16000, 1, 16000);
+    CHECK_EQ(passthrough.skip(160), static_cast<size_t>(160));
+    CHECK_EQ(passthrough.skip(0), static_cast<size_t>(0));
+}
@@ -0,0 +1,77 @@
+#include "test_harness.h"
+#include "silence_split.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+constexpr size_t RATE = 16000;
+
+// Tone everywhere except the given silent ranges (in seconds)
+std::vector<float> toneWithGaps(double seconds, const std::vector<std::pair<double, double>>& gaps) {
+    std::vector<float> samples(static_cast<size_t>(seconds * RATE));
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = 0.2f * static_cast<float>(std::sin(0.05 * static_cast<double>(i)));
+    }
+    for (const auto& gap : gaps) {
+        for (size_t i = static_cast<size_t>(gap.first * RATE); i < static_cast<size_t>(gap.second * RATE); ++i) {
+            samples[i] = 0.0f;
+        }
+    }
+    return samples;
+}
+
+} // namespace
+
+TEST(SilenceSplit, ShortAudioIsOneSegment) {
+    const std::vector<float> audio = toneWithGaps(5.0, {});
+    const std::vector<AudioSpan> spans = splitAtSilences(audio.data(), audio.size(), SplitOptions{});
+    CHECK_EQ(spans.size(), static_cast<size_t>(1));
+    CHECK_EQ(spans[0].start, static_cast<size_t>(0));
+    CHECK_EQ(spans[0].end, audio.size());
+    CHECK(splitAtSilences(audio.data(), 0, SplitOptions{}).empty());
+}
+
+TEST(SilenceSplit, CutsInsidePauses) {
+    // Pauses at 15s and 37s; a 60s recording needs at least three segments
+    const std::vector<float> audio = toneWithGaps(60.0, {{15.0, 15.5}, {37.0, 37.4}});
+    const std::vector<AudioSpan> spans = splitAtSilences(audio.data(), audio.size(), SplitOptions{});
+    CHECK_EQ(spans.size(), static_cast<size_t>(3));
+
+    CHECK(spans[0].end > 15 * RATE && spans[0].end < static_cast<size_t>(15.5 * RATE));
+    CHECK(spans[1].end > 37 * RATE && spans[1].end < static_cast<size_t>(37.4 * RATE));
+    size_t expectedStart = 0;
+    for (const AudioSpan& span : spans) {
+        CHECK_EQ(span.start, expectedStart);
+        CHECK(span.end - span.start <= 28 * RATE);
+        expectedStart = span.end;
+    }
+    CHECK_EQ(expectedStart, audio.size());
+}
+
+TEST(SilenceSplit, DropsSilentSegmentsAndForcesCuts) {
+    // Speech, then a minute of silence, then speech
+    std::vector<float> audio = toneWithGaps(90.0, {{10.0, 75.0}});
+    std::vector<AudioSpan> spans = splitAtSilences(audio.data(), audio.size(), SplitOptions{});
+    for (const AudioSpan& span : spans) {
+        CHECK(span.end - span.start <= 28 * RATE);
+        // Every kept segment holds some of the tone
+        CHECK(span.start < 10 * RATE || span.end > 75 * RATE);
+    }
+    CHECK(spans.front().start == 0);
+    CHECK(spans.back().end == audio.size());
+
+    // Without pauses the cuts fall at the maximum length
+    audio = toneWithGaps(60.0, {});
+    SplitOptions options;
+    options.threshold = 0.0f;
+    spans = splitAtSilences(audio.data(), audio.size(), options);
+    CHECK_EQ(spans.size(), static_cast<size_t>(3));
+    for (const AudioSpan& span : spans) {
+        CHECK(span.end - span.start <= 28 * RATE);
+        CHECK(span.end - span.start >= 4 * RATE);
+    }
+}
@@ -0,0 +1,143 @@
+#include "test_harness.h"
+#include "stage_graph.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+// What a sink stage saw: the first sample of each audio packet, or -N for N samples of silence
+struct Sink {
+    std::vector<float> seen;
+
+    void operator()(const StagePacket& packet, StageOutput&) {
+        seen.push_back(packet.kind == PacketKind::Silence ? -static_cast<float>(packet.numSamples) : packet.f32[0]);
+    }
+};
+
+void pushAudio(StageGraph& graph, int stage, float value) {
+    StagePacket& packet = graph.acquire();
+    packet.f32.assign(160, value);
+    packet.numSamples = 160;
+    graph.push(stage, packet);
+}
+
+} // namespace
+
+TEST(StageGraph, FansOutInOrder) {
+    StageGraph graph;
+    Sink first;
+    Sink second;
+    const int doubler = graph.addStage("double", [](const StagePacket& packet, StageOutput& out) {
+        if (packet.kind != PacketKind::Audio) {
+            out.emit(packet);
+            return;
+        }
+        StagePacket& doubled = out.acquire();
+        doubled.numSamples = packet.numSamples;
+        doubled.f32.resize(packet.numSamples);
+        for (size_t i = 0; i < packet.numSamples; ++i) doubled.f32[i] = 2.0f * packet.f32[i];
+        out.emit(doubled);
+    }, 8);
+    const int a = graph.addStage("first", [&first](const StagePacket& p, StageOutput& o) { first(p, o); }, 8);
+    const int b = graph.addStage("second", [&second](const StagePacket& p, StageOutput& o) { second(p, o); }, 8);
+    CHECK(graph.connect(doubler, a));
+    CHECK(graph.connect(doubler, b));
+    CHECK(!graph.connect(b, doubler));
+
+    graph.start(3);
+    CHECK(graph.addStage("late", Sink()) < 0);
+    for (int i = 1; i <= 500; ++i) {
+        if (i % 100 == 0) {
+            StagePacket& silence = graph.acquire();
+            silence.kind = PacketKind::Silence;
+            silence.numSamples = 320;
+            graph.push(doubler, silence);
+        } else {
+            pushAudio(graph, doubler, static_cast<float>(i));
+        }
+    }
+    graph.drain();
+
+    std::vector<float> expected;
+    for (int i = 1; i <= 500; ++i) expected.push_back(i % 100 == 0 ? -320.0f : 2.0f * i);
+    CHECK(first.seen == expected);
+    CHECK(second.seen == expected);
+    for (const StageStats& stage : graph.stats()) {
+        CHECK_EQ(stage.processed, static_cast<uint64_t>(500));
+        CHECK_EQ(stage.dropped, static_cast<uint64_t>(0));
+    }
+    graph.stop();
+}
+
+TEST(StageGraph, BlockingStageHoldsUpstream) {
+    // A slow sink backs the whole graph up to the source instead of
+    // letting its queue grow
+    StageGraph graph;
+    Sink sink;
+    const int pass = graph.addStage("pass", [](const StagePacket& packet, StageOutput& out) {
+        out.emit(packet);
+    }, 4);
+    const int slow = graph.addStage("slow", [&sink](const StagePacket& packet, StageOutput& out) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        sink(packet, out);
+    }, 2);
+    CHECK(graph.connect(pass, slow));
+
+    graph.start(2);
+    for (int i = 0; i < 50; ++i) pushAudio(graph, pass, static_cast<float>(i));
+    graph.stop();
+
+    CHECK_EQ(sink.seen.size(), static_cast<size_t>(50));
+    const std::vector<StageStats> stats = graph.stats();
+    CHECK(stats[0].maxDepth <= 4);
+    CHECK(stats[1].maxDepth <= 3);  // One emit past capacity at most
+    CHECK_EQ(stats[0].dropped + stats[1].dropped, static_cast<uint64_t>(0));
+}
+
+TEST(StageGraph, DroppingStageCountsOverflow) {
+    StageGraph graph;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool entered = false;
+    bool release = false;
+    const int gated = graph.addStage("gated", [&](const StagePacket&, StageOutput&) {
+        std::unique_lock<std::mutex> lock(mutex);
+        entered = true;
+        cv.notify_all();
+        cv.wait(lock, [&] { return release; });
+    }, 4, Overflow::Drop);
+
+    graph.start(1);
+    pushAudio(graph, gated, 0.0f);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return entered; });
+    }
+
+    // The stage is busy with the first packet: four fit, six are dropped
+    int queued = 0;
+    for (int i = 0; i < 10; ++i) {
+        StagePacket& packet = graph.acquire();
+        packet.kind = PacketKind::Silence;
+        packet.numSamples = 160;
+        queued += graph.push(gated, packet) ? 1 : 0;
+    }
+    CHECK_EQ(queued, 4);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        release = true;
+    }
+    cv.notify_all();
+    graph.stop();
+
+    const StageStats stats = graph.stats()[0];
+    CHECK_EQ(stats.processed, static_cast<uint64_t>(5));
+    CHECK_EQ(stats.dropped, static_cast<uint64_t>(6));
+    CHECK_EQ(stats.maxDepth, static_cast<size_t>(4));
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace phantom {
+namespace test {
+
+/**
+ * Minimal self-registering test harness (no external dependencies).
+ *
+ *   TEST(SampleFormat, RoundTrip) { CHECK(x == y); CHECK_NEAR(a, b, 1e-6); }
+ *
+ * phantom-audio-tests runs every registered test, or only those whose
+ * "Suite.Name" contains the first command-line argument.
+ */
+struct TestCase {
+    std::string name;
+    std::function<void()> body;
+};
+
+std::vector<TestCase>& registry();
+void reportFailure(const char* file, int line, const std::string& message);
+
+struct Registrar {
+    Registrar(const char* suite, const char* name, std::function<void()> body) {
+        registry().push_back({std::string(suite) + "." + name, std::move(body)});
+    }
+};
+
+} // namespace test
+} // namespace phantom
+
+#define TEST(suite, name)                                                        \
+    static void suite##_##name##_body();                                         \
+    static ::phantom::test::Registrar suite##_##name##_registrar(                \
+        #suite, #name, suite##_##name##_body);                                   \
+    static void suite##_##name##_body()
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) ::phantom::test::reportFailure(__FILE__, __LINE__, #cond);  \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                           \
+    do {                                                                         \
+        const auto& _a = (a);                                                    \
+        const auto& _b = (b);                                                    \
+        if (!(_a == _b)) {                                                       \
+            ::phantom::test::reportFailure(__FILE__, __LINE__,                   \
+                std::string(#a " == " #b " (") + std::to_string(_a) + " vs " +   \
+                std::to_string(_b) + ")");                                       \
+        }                                                                        \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tol)                                                    \
+    do {                                                                         \
+        const double _a = (a);                                                   \
+        const double _b = (b);                                                   \
+        if (!(std::fabs(_a - _b) <= (tol))) {                                    \
+            ::phantom::test::reportFailure(__FILE__, __LINE__,                   \
+                std::string(#a " ~= " #b " (") + std::to_string(_a) + " vs " +   \
+                std::to_string(_b) + ")");                                       \
+        }                                                                        \
+    } while (0)
@@ -0,0 +1,44 @@
+#include "test_harness.h"
+
+namespace phantom {
+namespace test {
+
+namespace {
+    int g_failures = 0;
+}
+
+std::vector<TestCase>& registry() {
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+void reportFailure(const char* file, int line, const std::string& message) {
+    std::cerr << file << ":" << line << ": FAILED: " << message << std::endl;
+    ++g_failures;
+}
+
+} // namespace test
+} // namespace phantom
+
+int main(int argc, char* argv[]) {
+    using namespace phantom::test;
+
+    const std::string filter = argc > 1 ? argv[1] : "";
+    int run = 0;
+    int failed = 0;
+
+    for (const TestCase& test : registry()) {
+        if (!filter.empty() && test.name.find(filter) == std::string::npos) continue;
+
+        const int before = g_failures;
+        test.body();
+        ++run;
+
+        const bool ok = g_failures == before;
+        if (!ok) ++failed;
+        std::cout << (ok ? "[ OK ] " : "[FAIL] ") << test.name << std::endl;
+    }
+
+    std::cout << run - failed << "/" << run << " tests passed" << std::endl;
+    return failed == 0 && run > 0 ? 0 : 1;
+}
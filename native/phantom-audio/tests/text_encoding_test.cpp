@@ -0,0 +1,110 @@
+#include "test_harness.h"
+#include "text_encoding.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+const SimdIsa ALL_ISAS[] = {SimdIsa::Scalar, SimdIsa::SSE2, SimdIsa::SSSE3,
+                            SimdIsa::SSE41, SimdIsa::AVX2, SimdIsa::NEON};
+
+std::string base64(const std::string& s, SimdIsa isa = SimdIsa::Scalar) {
+    std::string out;
+    appendBase64(out, reinterpret_cast<const uint8_t*>(s.data()), s.size(), isa);
+    return out;
+}
+
+std::string escaped(const std::string& s, SimdIsa isa = SimdIsa::Scalar) {
+    std::string out;
+    appendJsonEscaped(out, s.data(), s.size(), isa);
+    return out;
+}
+
+} // namespace
+
+TEST(TextEncoding, Base64KnownVectors) {
+    // RFC 4648 section 10
+    CHECK(base64("") == "");
+    CHECK(base64("f") == "Zg==");
+    CHECK(base64("fo") == "Zm8=");
+    CHECK(base64("foo") == "Zm9v");
+    CHECK(base64("foob") == "Zm9vYg==");
+    CHECK(base64("fooba") == "Zm9vYmE=");
+    CHECK(base64("foobar") == "Zm9vYmFy");
+
+    const uint8_t high[] = {0xFB, 0xFF, 0xBF};
+    std::string out;
+    appendBase64(out, high, sizeof(high));
+    CHECK(out == "+/+/");
+}
+
+TEST(TextEncoding, Base64KernelsMatchScalar) {
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    // Every length across the SIMD block sizes and their tails, then audio-sized
+    std::vector<size_t> lengths;
+    for (size_t n = 0; n <= 130; ++n) lengths.push_back(n);
+    lengths.push_back(6400);
+    lengths.push_back(6401);
+
+    for (size_t n : lengths) {
+        std::string input(n, '\0');
+        for (char& c : input) c = static_cast<char>(byte(rng));
+        const std::string expected = base64(input);
+        CHECK_EQ(expected.size(), base64EncodedLength(n));
+
+        for (SimdIsa isa : ALL_ISAS) {
+            CHECK(base64(input, isa) == expected);
+        }
+        std::string viaDefault;
+        appendBase64(viaDefault, reinterpret_cast<const uint8_t*>(input.data()), input.size());
+        CHECK(viaDefault == expected);
+    }
+}
+
+TEST(TextEncoding, AppendsToExistingBuffer) {
+    std::string out = "{\"data\":\"";
+    const uint8_t data[] = {'M', 'a', 'n'};
+    appendBase64(out, data, sizeof(data));
+    appendJsonEscaped(out, "\"", 1);
+    CHECK(out == "{\"data\":\"TWFu\\\"");
+}
+
+TEST(TextEncoding, EscapesJsonSpecials) {
+    CHECK(escaped("plain text") == "plain text");
+    CHECK(escaped("say \"hi\"") == "say \\\"hi\\\"");
+    CHECK(escaped("a\\b") == "a\\\\b");
+    CHECK(escaped("\b\f\n\r\t") == "\\b\\f\\n\\r\\t");
+    CHECK(escaped(std::string("\x01\x1f\x7f", 3)) == "\\u0001\\u001f\x7f");
+    CHECK(escaped(std::string("nul\0byte", 8)) == "nul\\u0000byte");
+    // UTF-8 passes through untouched
+    CHECK(escaped("caf\xC3\xA9 \xE2\x80\x94 \xF0\x9F\x8E\xA4") == "caf\xC3\xA9 \xE2\x80\x94 \xF0\x9F\x8E\xA4");
+}
+
+TEST(TextEncoding, EscapeKernelsMatchScalar) {
+    std::mt19937 rng(99);
+    // Mostly clean text with occasional specials, control bytes and UTF-8
+    const char alphabet[] = "abcdefghij ,.'?\"\\\n\t\x01\x1f\x7f\x80\xC3\xA9\xFF";
+    std::uniform_int_distribution<size_t> pick(0, sizeof(alphabet) - 2);
+    std::uniform_int_distribution<int> coin(0, 7);
+
+    for (size_t n = 0; n <= 200; ++n) {
+        std::string input(n, 'x');
+        for (char& c : input) {
+            if (coin(rng) == 0) c = alphabet[pick(rng)];
+        }
+        const std::string expected = escaped(input);
+        for (SimdIsa isa : ALL_ISAS) {
+            CHECK(escaped(input, isa) == expected);
+        }
+        std::string viaDefault;
+        appendJsonEscaped(viaDefault, input.data(), input.size());
+        CHECK(viaDefault == expected);
+    }
+}
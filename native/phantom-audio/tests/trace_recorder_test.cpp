@@ -0,0 +1,142 @@
+#include "test_harness.h"
+#include "trace_recorder.h"
+#include "json_reader.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+const char* const TRACE_PATH = "phantom-audio-trace-test.json";
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+size_t countOccurrences(const std::string& haystack, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = haystack.find(needle); pos != std::string::npos;
+         pos = haystack.find(needle, pos + needle.size())) {
+        ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+TEST(TraceRecorder, DisabledSpansRecordNothing) {
+    TraceRecorder& trace = TraceRecorder::instance();
+    CHECK(!trace.isEnabled());
+    { TraceSpan span("ignored"); }
+
+    const std::string path = TRACE_PATH;
+    CHECK(trace.start(path));
+    CHECK(trace.stop());
+    CHECK_EQ(trace.eventCount(), static_cast<uint64_t>(0));
+    CHECK(readFile(path).find("ignored") == std::string::npos);
+    CHECK(!trace.stop());
+    std::remove(path.c_str());
+}
+
+TEST(TraceRecorder, WritesSpansFromEveryThread) {
+    TraceRecorder& trace = TraceRecorder::instance();
+    const std::string path = TRACE_PATH;
+    CHECK(trace.start(path));
+
+    constexpr int THREADS = 4;
+    constexpr int SPANS = 10000;  // Crosses several buffer blocks
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([] {
+            TraceRecorder::instance().setThreadName("worker");
+            for (int i = 0; i < SPANS; ++i) {
+                TraceSpan span("work", "i", i);
+            }
+        });
+    }
+    { TraceSpan span("main_span"); }
+    for (std::thread& thread : threads) thread.join();
+
+    CHECK(trace.stop());
+    CHECK_EQ(trace.eventCount(), static_cast<uint64_t>(THREADS * SPANS + 1));
+    CHECK_EQ(trace.droppedCount(), static_cast<uint64_t>(0));
+
+    const std::string json = readFile(path);
+    CHECK_EQ(countOccurrences(json, "\"name\":\"work\""), static_cast<size_t>(THREADS * SPANS));
+    CHECK_EQ(countOccurrences(json, "\"name\":\"thread_name\""), static_cast<size_t>(THREADS));
+    CHECK_EQ(countOccurrences(json, "\"name\":\"main_span\""), static_cast<size_t>(1));
+
+    // The whole file is one valid JSON object holding the event array
+    JsonObjectReader reader(json);
+    std::string_view key;
+    JsonValue value;
+    bool sawEvents = false;
+    while (reader.next(&key, &value)) {
+        if (key == "traceEvents") sawEvents = value.type == JsonType::Array;
+    }
+    CHECK(!reader.failed());
+    CHECK(sawEvents);
+    std::remove(path.c_str());
+}
+
+TEST(TraceRecorder, RestartDiscardsPreviousSession) {
+    TraceRecorder& trace = TraceRecorder::instance();
+    const std::string path = TRACE_PATH;
+
+    CHECK(trace.start(path));
+    { TraceSpan span("first"); }
+    CHECK(trace.start(path));
+    { TraceSpan span("second"); }
+    CHECK(trace.stop());
+
+    const std::string json = readFile(path);
+    CHECK(json.find("\"first\"") == std::string::npos);
+    CHECK(json.find("\"second\"") != std::string::npos);
+    CHECK_EQ(trace.eventCount(), static_cast<uint64_t>(1));
+    std::remove(path.c_str());
+
+    CHECK(!trace.start("no-such-dir/trace.json"));
+    CHECK(!trace.isEnabled());
+}
+
+TEST(TraceRecorder, RestartsWhileThreadsRecord) {
+    // Sessions start and stop while other threads are mid-span; every
+    // session must contain exactly the spans it counts
+    TraceRecorder& trace = TraceRecorder::instance();
+    const std::string path = TRACE_PATH;
+    std::atomic<bool> running{true};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; ++t) {
+        threads.emplace_back([&running] {
+            while (running.load()) {
+                TraceSpan span("spin");
+            }
+        });
+    }
+
+    bool consistent = true;
+    for (int session = 0; session < 20; ++session) {
+        CHECK(trace.start(path));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (session % 2 == 0) CHECK(trace.start(path));
+        CHECK(trace.stop());
+        const std::string json = readFile(path);
+        consistent = consistent && countOccurrences(json, "\"name\":\"spin\"") == trace.eventCount();
+    }
+    running.store(false);
+    for (std::thread& thread : threads) thread.join();
+
+    CHECK(consistent);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,80 @@
+#include "test_harness.h"
+#include "transcript_delta.h"
+
+#include <string>
+
+using namespace phantom;
+
+TEST(TranscriptDelta, SendsOnlyTheChangedSuffix) {
+    TranscriptDeltaEncoder encoder;
+    TranscriptDelta delta;
+
+    CHECK(encoder.encode(3, "the quick", delta));
+    CHECK_EQ(delta.segment, static_cast<uint64_t>(3));
+    CHECK_EQ(delta.keep, static_cast<size_t>(0));
+    CHECK(delta.text == "the quick");
+
+    // Growing: only the new words
+    CHECK(encoder.encode(3, "the quick brown fox", delta));
+    CHECK_EQ(delta.keep, static_cast<size_t>(9));
+    CHECK(delta.text == " brown fox");
+
+    // A revised guess replaces the tail from where it differs
+    CHECK(encoder.encode(3, "the quick brown box", delta));
+    CHECK_EQ(delta.keep, static_cast<size_t>(16));
+    CHECK(delta.text == "box");
+
+    // Shrinking keeps a prefix and appends nothing
+    CHECK(encoder.encode(3, "the quick", delta));
+    CHECK_EQ(delta.keep, static_cast<size_t>(9));
+    CHECK(delta.text.empty());
+
+    CHECK(!encoder.encode(3, "the quick", delta));
+
+    // A new segment, or one after its final, starts from scratch
+    CHECK(encoder.encode(4, "jumps", delta));
+    CHECK_EQ(delta.keep, static_cast<size_t>(0));
+    encoder.finish(4);
+    CHECK(encoder.encode(4, "jumps", delta));
+    CHECK(delta.text == "jumps");
+}
+
+TEST(TranscriptDelta, CountsKeepInUtf16Units) {
+    TranscriptDeltaEncoder encoder;
+    TranscriptDelta delta;
+
+    // "é" is two UTF-8 bytes and one UTF-16 unit; U+1F600 is four bytes and two units
+    CHECK(encoder.encode(0, "caf\xC3\xA9 \xF0\x9F\x98\x80 ok", delta));
+    CHECK(encoder.encode(0, "caf\xC3\xA9 \xF0\x9F\x98\x80 okay", delta));
+    CHECK_EQ(delta.keep, static_cast<size_t>(10));
+    CHECK(delta.text == "ay");
+
+    // "é" -> "è" differ in their second byte: the whole character is resent
+    CHECK(encoder.encode(0, "caf\xC3\xA8", delta));
+    CHECK_EQ(delta.keep, static_cast<size_t>(3));
+    CHECK(delta.text == "\xC3\xA8");
+
+    CHECK_EQ(utf16Length("a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80", 10), static_cast<size_t>(5));
+}
+
+TEST(TranscriptDelta, PartialsEndOnWholeCharacters) {
+    // Byte-level tokens can stop a guess inside a character
+    CHECK_EQ(completeUtf8Length("caf\xC3", 4), static_cast<size_t>(3));
+    CHECK_EQ(completeUtf8Length("caf\xC3\xA9", 5), static_cast<size_t>(5));
+    CHECK_EQ(completeUtf8Length("a\xF0\x9F\x98", 4), static_cast<size_t>(1));
+    CHECK_EQ(completeUtf8Length("a\xF0\x9F\x98\x80", 5), static_cast<size_t>(5));
+    CHECK_EQ(completeUtf8Length("\xE2\x82", 2), static_cast<size_t>(0));
+    CHECK_EQ(completeUtf8Length("", 0), static_cast<size_t>(0));
+
+    // "é" split across two partials: the first is sent without its lead
+    // byte, so `keep` counts only characters the renderer already has
+    TranscriptDeltaEncoder encoder;
+    TranscriptDelta delta;
+    const std::string first = "le caf\xC3";
+    CHECK(encoder.encode(0, first.substr(0, completeUtf8Length(first.data(), first.size())), delta));
+    CHECK(delta.text == "le caf");
+    const std::string second = "le caf\xC3\xA9 noir";
+    CHECK(encoder.encode(0, second.substr(0, completeUtf8Length(second.data(), second.size())), delta));
+    CHECK_EQ(delta.keep, static_cast<size_t>(6));
+    CHECK(delta.text == "\xC3\xA9 noir");
+}
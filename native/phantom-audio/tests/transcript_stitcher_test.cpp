@@ -0,0 +1,125 @@
+#include "test_harness.h"
+#include "transcript_stitcher.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+// 10ms in stream samples, the resolution of whisper's token times
+constexpr uint64_t CS = 160;
+
+StreamToken token(int32_t id, const char* text, uint64_t startCs, uint64_t endCs) {
+    StreamToken t;
+    t.id = id;
+    t.text = text;
+    t.startSample = startCs * CS;
+    t.endSample = endCs * CS;
+    return t;
+}
+
+} // namespace
+
+TEST(TranscriptStitcher, DropsOverlapAndHoldsBackTail) {
+    TranscriptStitcher stitcher;
+
+    // Chunk 0-2s; the next chunk starts at 1.5s
+    const std::vector<StreamToken> first = {
+        token(1, " The", 10, 30), token(2, " quick", 30, 70), token(3, " brown", 80, 140),
+        token(4, " fox", 160, 190),
+    };
+    CHECK(stitcher.stitch(first, 150 * CS) == "The quick brown");
+    CHECK_EQ(stitcher.committedSample(), 140 * CS);
+    CHECK(stitcher.pendingText() == "fox");
+
+    // Chunk 1.5-3.5s decodes "brown" again from its tail, then "fox" in full
+    const std::vector<StreamToken> second = {
+        token(3, " brown", 120, 150), token(4, " fox", 160, 195), token(5, " jumps", 200, 240),
+    };
+    CHECK(stitcher.stitch(second, COMMIT_ALL) == "fox jumps");
+    CHECK_EQ(stitcher.droppedTokens(), static_cast<size_t>(1));
+    CHECK(stitcher.pendingText().empty());
+
+    const std::vector<int32_t> expected = {1, 2, 3, 4, 5};
+    CHECK(stitcher.prompt() == expected);
+}
+
+TEST(TranscriptStitcher, KeepsWordsWhole) {
+    TranscriptStitcher stitcher;
+
+    // "Stitching" is two tokens; it starts before the limit, so it is committed whole
+    const std::vector<StreamToken> first = {
+        token(1, " Token", 0, 40), token(2, " Stit", 140, 150), token(3, "ching", 150, 170),
+        token(4, ".", 170, 172), token(5, " Next", 180, 195),
+    };
+    CHECK(stitcher.stitch(first, 150 * CS) == "Token Stitching.");
+
+    // The next chunk hears "Stit" as part of the committed audio: its
+    // continuation goes with it even though its own midpoint is later
+    const std::vector<StreamToken> second = {
+        token(2, " Stit", 150, 160), token(3, "ching", 168, 180), token(5, " Next", 180, 195),
+    };
+    CHECK(stitcher.stitch(second, COMMIT_ALL) == "Next");
+}
+
+TEST(TranscriptStitcher, RecognizesRepeatAtSeam) {
+    TranscriptStitcher stitcher;
+    CHECK(stitcher.stitch({token(1, " Hello", 0, 50), token(2, " world", 60, 100)}, COMMIT_ALL) == "Hello world");
+
+    // Timestamps drifted past the commit, but it is the same word at the seam
+    CHECK(stitcher.stitch({token(2, " world", 101, 130), token(3, " again", 140, 170)}, COMMIT_ALL) == "again");
+
+    // A real repetition later on is kept
+    CHECK(stitcher.stitch({token(3, " again", 300, 330)}, COMMIT_ALL) == "again");
+}
+
+TEST(TranscriptStitcher, BoundsPromptAndResets) {
+    TranscriptStitcher stitcher;
+    stitcher.setMaxPromptTokens(3);
+    std::vector<StreamToken> tokens;
+    for (int32_t i = 0; i < 6; ++i) {
+        tokens.push_back(token(i, " w", static_cast<uint64_t>(i) * 10, static_cast<uint64_t>(i) * 10 + 8));
+    }
+    CHECK(stitcher.stitch(tokens, COMMIT_ALL) == "w w w w w w");
+    const std::vector<int32_t> expected = {3, 4, 5};
+    CHECK(stitcher.prompt() == expected);
+
+    stitcher.setMaxPromptTokens(0);
+    CHECK(stitcher.prompt().empty());
+
+    // Same audio again is all overlap, until reset() starts a new stream
+    CHECK(stitcher.stitch(tokens, COMMIT_ALL).empty());
+    CHECK_EQ(stitcher.droppedTokens(), static_cast<size_t>(6));
+    stitcher.reset();
+    CHECK_EQ(stitcher.committedSample(), 0ull);
+    CHECK(stitcher.stitch(tokens, COMMIT_ALL) == "w w w w w w");
+}
+
+TEST(TranscriptStitcher, StitchesTextWithoutSpaces) {
+    TranscriptStitcher stitcher;
+
+    // 今天天气很好: no token starts with a space, so each character is a word
+    const std::vector<StreamToken> first = {
+        token(1, "\xE4\xBB\x8A", 10, 30), token(2, "\xE5\xA4\xA9", 30, 50), token(2, "\xE5\xA4\xA9", 50, 70),
+        token(3, "\xE6\xB0\x94", 70, 100), token(4, "\xE5\xBE\x88", 140, 160), token(5, "\xE5\xA5\xBD", 160, 190),
+    };
+    CHECK(stitcher.stitch(first, 150 * CS) == "\xE4\xBB\x8A\xE5\xA4\xA9\xE5\xA4\xA9\xE6\xB0\x94\xE5\xBE\x88");
+    CHECK(stitcher.pendingText() == "\xE5\xA5\xBD");
+
+    // The next chunk splits 好 into two byte tokens, which stay together,
+    // and mixes in a spaced word; the CJK full stop after it is still a word
+    const std::vector<StreamToken> second = {
+        token(4, "\xE5\xBE\x88", 142, 160), token(6, "\xE5\xA5", 160, 180), token(7, "\xBD", 180, 195),
+        token(8, " OK", 200, 230), token(9, "\xE3\x80\x82", 230, 240),
+    };
+    CHECK(stitcher.stitch(second, 220 * CS) == "\xE5\xA5\xBD OK");
+    CHECK_EQ(stitcher.droppedTokens(), static_cast<size_t>(1));
+    CHECK(stitcher.pendingText() == "\xE3\x80\x82");
+
+    // A chunk cut inside a character resumes at the next whole one
+    CHECK(stitcher.stitch({token(7, "\xBD", 239, 241), token(9, "\xE3\x80\x82", 241, 250)}, COMMIT_ALL) ==
+          "\xE3\x80\x82");
+}
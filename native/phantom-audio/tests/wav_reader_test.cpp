@@ -0,0 +1,118 @@
+#include "test_harness.h"
+#include "wav_reader.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+const char* const WAV_PATH = "phantom-audio-wav-test.wav";
+
+void putLE(std::vector<uint8_t>& out, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+// Minimal WAV writer; `extensible` uses WAVE_FORMAT_EXTENSIBLE and adds a
+// LIST chunk before the data, like many recorders do
+void writeWav(const std::vector<uint8_t>& data, uint16_t tag, uint16_t channels, uint32_t rate,
+              uint16_t bits, bool extensible) {
+    std::vector<uint8_t> fmt;
+    putLE(fmt, extensible ? 0xFFFE : tag, 2);
+    putLE(fmt, channels, 2);
+    putLE(fmt, rate, 4);
+    putLE(fmt, rate * channels * bits / 8, 4);
+    putLE(fmt, channels * bits / 8, 2);
+    putLE(fmt, bits, 2);
+    if (extensible) {
+        putLE(fmt, 22, 2);
+        putLE(fmt, bits, 2);
+        putLE(fmt, 0, 4);
+        putLE(fmt, tag, 2);
+        for (int i = 0; i < 14; ++i) fmt.push_back(0);
+    }
+
+    std::vector<uint8_t> file;
+    file.insert(file.end(), {'R', 'I', 'F', 'F'});
+    putLE(file, 0, 4);  // Size is not checked
+    file.insert(file.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+    putLE(file, static_cast<uint32_t>(fmt.size()), 4);
+    file.insert(file.end(), fmt.begin(), fmt.end());
+    if (extensible) {
+        file.insert(file.end(), {'L', 'I', 'S', 'T'});
+        putLE(file, 3, 4);
+        file.insert(file.end(), {'a', 'b', 'c', 0});  // Odd size + pad byte
+    }
+    file.insert(file.end(), {'d', 'a', 't', 'a'});
+    putLE(file, static_cast<uint32_t>(data.size()), 4);
+    file.insert(file.end(), data.begin(), data.end());
+
+    std::FILE* f = std::fopen(WAV_PATH, "wb");
+    std::fwrite(file.data(), 1, file.size(), f);
+    std::fclose(f);
+}
+
+} // namespace
+
+TEST(WavReader, Reads16BitStereoInPackets) {
+    const int16_t pcm[] = {0, -32768, 16384, 32767, -16384, 1, 100, -100};
+    std::vector<uint8_t> data;
+    for (int16_t s : pcm) putLE(data, static_cast<uint16_t>(s), 2);
+    writeWav(data, 1, 2, 44100, 16, false);
+
+    WavReader reader;
+    CHECK(reader.open(WAV_PATH));
+    CHECK_EQ(reader.sampleRate(), static_cast<uint32_t>(44100));
+    CHECK_EQ(reader.channels(), static_cast<uint16_t>(2));
+    CHECK_EQ(reader.totalFrames(), static_cast<uint64_t>(4));
+
+    float out[6] = {};
+    CHECK_EQ(reader.read(out, 3), static_cast<size_t>(3));
+    CHECK_NEAR(out[1], -1.0f, 1e-9);
+    CHECK_NEAR(out[2], 0.5f, 1e-9);
+    CHECK_EQ(reader.read(out, 3), static_cast<size_t>(1));
+    CHECK_NEAR(out[0], 100.0f / 32768.0f, 1e-9);
+    CHECK_EQ(reader.read(out, 3), static_cast<size_t>(0));
+    std::remove(WAV_PATH);
+}
+
+TEST(WavReader, Reads24BitAndExtensibleFloat) {
+    std::vector<uint8_t> data;
+    putLE(data, 0x400000, 3);      // 0.5
+    putLE(data, 0xC00000, 3);      // -0.5
+    writeWav(data, 1, 1, 16000, 24, false);
+
+    WavReader reader;
+    CHECK(reader.open(WAV_PATH));
+    std::vector<float> samples = reader.readAll();
+    CHECK_EQ(samples.size(), static_cast<size_t>(2));
+    CHECK_NEAR(samples[0], 0.5f, 1e-9);
+    CHECK_NEAR(samples[1], -0.5f, 1e-9);
+
+    const float values[] = {0.25f, -0.75f, 1.0f};
+    data.assign(reinterpret_cast<const uint8_t*>(values),
+                reinterpret_cast<const uint8_t*>(values) + sizeof(values));
+    writeWav(data, 3, 1, 48000, 32, true);
+    CHECK(reader.open(WAV_PATH));
+    CHECK_EQ(reader.sampleRate(), static_cast<uint32_t>(48000));
+    samples = reader.readAll();
+    CHECK_EQ(samples.size(), static_cast<size_t>(3));
+    CHECK(std::memcmp(samples.data(), values, sizeof(values)) == 0);
+    reader.close();
+    std::remove(WAV_PATH);
+}
+
+TEST(WavReader, RejectsUnsupportedFiles) {
+    WavReader reader;
+    CHECK(!reader.open("no-such-file.wav"));
+
+    std::vector<uint8_t> data(8, 0);
+    writeWav(data, 1, 1, 16000, 8, false);  // 8-bit PCM
+    CHECK(!reader.open(WAV_PATH));
+    CHECK(reader.getLastError().find("Unsupported") != std::string::npos);
+    std::remove(WAV_PATH);
+}
@@ -0,0 +1,252 @@
+#include "test_harness.h"
+#include "mock_engine.h"
+#include "whisper_wrapper.h"
+
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace phantom;
+
+namespace {
+
+const size_t RATE = 16000;
+
+struct Update {
+    std::string text;
+    TranscriptSource source;
+};
+
+// A running pipeline on a mock engine, collecting its finals
+struct MockPipeline {
+    WhisperWrapper whisper;
+    MockEngine* engine = nullptr;
+    std::mutex mutex;
+    std::vector<Update> partials;
+    std::vector<Update> finals;
+
+    MockPipeline(const std::vector<std::string>& texts, bool denoise, int silenceFlushMs = 300) {
+        MockEngineScript script;
+        script.texts = texts;
+        auto owned = std::make_unique<MockEngine>(script);
+        engine = owned.get();
+        whisper.setEngine(std::move(owned));
+
+        TranscriptionConfig config;
+        config.chunkMs = 2000;
+        config.denoise = denoise;
+        config.silenceFlushMs = silenceFlushMs;
+        CHECK(whisper.setConfig(config));
+        whisper.start([this](const std::string& text, bool isFinal, const TranscriptSource& source) {
+            std::lock_guard<std::mutex> lock(mutex);
+            (isFinal ? finals : partials).push_back({text, source});
+        });
+    }
+
+    // A 440Hz tone in 10ms packets
+    void speak(size_t numSamples) {
+        std::vector<float> packet(RATE / 100);
+        for (size_t done = 0; done < numSamples; done += packet.size()) {
+            for (size_t i = 0; i < packet.size(); ++i) {
+                packet[i] = 0.3f * static_cast<float>(std::sin(2.0 * 3.14159265358979 * 440.0 * (done + i) / RATE));
+            }
+            whisper.addAudioChunk(packet.data(), packet.size());
+        }
+    }
+
+    // The same tone as int16, the way captured audio usually arrives
+    void speakS16(size_t numSamples) {
+        std::vector<int16_t> packet(RATE / 100);
+        for (size_t done = 0; done < numSamples; done += packet.size()) {
+            for (size_t i = 0; i < packet.size(); ++i) {
+                packet[i] = static_cast<int16_t>(
+                    9830.0 * std::sin(2.0 * 3.14159265358979 * 440.0 * (done + i) / RATE));
+            }
+            whisper.addAudioChunk(packet.data(), packet.size());
+        }
+    }
+
+    void setDenoise(bool denoise) {
+        TranscriptionConfig config;
+        config.chunkMs = 2000;
+        config.denoise = denoise;
+        CHECK(whisper.setConfig(config));
+    }
+
+    void waitForDecodes(uint64_t count) {
+        while (engine->decodes() < count) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+};
+
+} // namespace
+
+TEST(MockEngine, ScriptedDecodes) {
+    MockEngineScript script;
+    script.texts = {"hello world", "again"};
+    MockEngine engine(script);
+
+    const std::vector<float> audio(RATE, 0.0f);
+    DecodeRequest request;
+    request.samples = audio.data();
+    request.numSamples = audio.size();
+    request.firstSample = 1000;
+    request.maxTokens = 16;
+
+    DecodeResult first;
+    CHECK(engine.decode(request, first));
+    CHECK_EQ(first.tokens.size(), static_cast<size_t>(2));
+    CHECK(first.tokens[0].text == " hello");
+    CHECK_EQ(first.tokens[0].id, MockEngine::tokenId("hello"));
+    CHECK_EQ(first.tokens[0].startSample, static_cast<uint64_t>(1000));
+    CHECK_EQ(first.tokens[1].startSample, static_cast<uint64_t>(9000));
+    CHECK_EQ(first.tokens[1].endSample, static_cast<uint64_t>(17000));
+    CHECK_EQ(first.logprobs.size(), static_cast<size_t>(2));
+
+    DecodeResult second;
+    CHECK(engine.decode(request, second));
+    CHECK(second.tokens.size() == 1 && second.tokens[0].text == " again");
+
+    // The script cycles; the token limit cuts it short
+    request.maxTokens = 1;
+    DecodeResult third;
+    CHECK(engine.decode(request, third));
+    CHECK(third.tokens.size() == 1 && third.tokens[0].text == " hello");
+    CHECK_EQ(third.generatedTokens, 1);
+    CHECK_EQ(engine.decodes(), static_cast<uint64_t>(3));
+
+    std::vector<float> probs;
+    CHECK(engine.detectLanguage(audio.data(), audio.size(), 1, probs));
+    CHECK_EQ(probs.size(), static_cast<size_t>(engine.maxLanguageId() + 1));
+    CHECK_EQ(probs[static_cast<size_t>(engine.languageId("en"))], 1.0f);
+    CHECK(engine.languageId("xx") < 0);
+
+    CHECK(engine.configure("mock"));
+    CHECK(engine.configure("mock:latency_ms=5,rtf=0.5,text=a b,text=c"));
+    CHECK(!engine.configure("mock:speed=2"));
+    CHECK(!engine.configure("mock:latency_ms=-1"));
+    CHECK(!engine.configure("whisper"));
+}
+
+TEST(WhisperWrapper, TranscribesThroughMockEngine) {
+    // Speech shorter than a chunk, ended by silence, is decoded whole
+    MockPipeline pipeline({"one two three", "four five"}, false);
+    pipeline.speak(RATE * 3 / 2);
+    pipeline.whisper.addSilence(RATE / 2);
+    pipeline.speak(RATE);
+    pipeline.whisper.addSilence(RATE / 2);
+    pipeline.whisper.stop();
+
+    CHECK_EQ(pipeline.engine->decodes(), static_cast<uint64_t>(2));
+    CHECK_EQ(pipeline.finals.size(), static_cast<size_t>(2));
+    if (pipeline.finals.size() == 2) {
+        CHECK(pipeline.finals[0].text == "one two three");
+        CHECK_EQ(pipeline.finals[0].source.startSample, static_cast<uint64_t>(0));
+        CHECK_EQ(pipeline.finals[0].source.endSample, static_cast<uint64_t>(RATE * 3 / 2));
+        CHECK(pipeline.finals[1].text == "four five");
+        CHECK_EQ(pipeline.finals[1].source.startSample, static_cast<uint64_t>(2 * RATE));
+        CHECK_EQ(pipeline.finals[1].source.endSample, static_cast<uint64_t>(3 * RATE));
+    }
+}
+
+TEST(WhisperWrapper, BriefGapStaysInTheUtterance) {
+    // 100ms of silence is buffered as zeros; the 500ms after it flushes
+    MockPipeline pipeline({"one two three"}, false);
+    pipeline.speak(RATE * 4 / 5);
+    pipeline.whisper.addSilence(RATE / 10);
+    pipeline.speak(RATE * 4 / 5);
+    pipeline.whisper.addSilence(RATE / 10);
+    pipeline.whisper.addSilence(RATE / 5);
+    pipeline.waitForDecodes(1);
+    pipeline.whisper.stop();
+
+    CHECK_EQ(pipeline.engine->decodes(), static_cast<uint64_t>(1));
+    CHECK_EQ(pipeline.finals.size(), static_cast<size_t>(1));
+    if (!pipeline.finals.empty()) {
+        CHECK_EQ(pipeline.finals[0].source.startSample, static_cast<uint64_t>(0));
+        CHECK_EQ(pipeline.finals[0].source.endSample, static_cast<uint64_t>(RATE * 17 / 10));
+    }
+
+    // With no minimum, any silence flushes
+    MockPipeline eager({"one", "two"}, false, 0);
+    eager.speak(RATE * 4 / 5);
+    eager.whisper.addSilence(RATE / 10);
+    eager.speak(RATE * 4 / 5);
+    eager.whisper.addSilence(RATE / 10);
+    eager.whisper.stop();
+    CHECK_EQ(eager.engine->decodes(), static_cast<uint64_t>(2));
+}
+
+TEST(WhisperWrapper, DenoiserDrainsBeforeSilence) {
+    // The denoiser's delay moves the audio, not the stream clock
+    MockPipeline pipeline({"hello"}, true);
+    pipeline.speak(RATE);
+    pipeline.whisper.addSilence(RATE / 2);
+    pipeline.whisper.stop();
+
+    CHECK_EQ(pipeline.finals.size(), static_cast<size_t>(1));
+    if (!pipeline.finals.empty()) {
+        CHECK(pipeline.finals[0].text == "hello");
+        CHECK_EQ(pipeline.finals[0].source.startSample, static_cast<uint64_t>(0));
+        CHECK_EQ(pipeline.finals[0].source.endSample,
+                 static_cast<uint64_t>(RATE + NoiseSuppressor::LATENCY_SAMPLES));
+    }
+}
+
+TEST(WhisperWrapper, DenoiseTogglesOnInt16Input) {
+    // Turned off mid-utterance: nothing left in the denoiser is drained
+    // into the stream when silence follows
+    MockPipeline pipeline({"one", "two"}, true);
+    pipeline.speakS16(RATE / 2);
+    pipeline.setDenoise(false);
+    pipeline.speakS16(RATE / 2);
+    pipeline.whisper.addSilence(RATE / 2);
+    pipeline.waitForDecodes(1);
+
+    // Turned back on: the denoiser starts clean and drains at the next silence
+    pipeline.setDenoise(true);
+    pipeline.speakS16(RATE / 2);
+    pipeline.whisper.addSilence(RATE / 2);
+    pipeline.whisper.stop();
+
+    CHECK_EQ(pipeline.finals.size(), static_cast<size_t>(2));
+    if (pipeline.finals.size() == 2) {
+        CHECK_EQ(pipeline.finals[0].source.startSample, static_cast<uint64_t>(0));
+        CHECK_EQ(pipeline.finals[0].source.endSample, static_cast<uint64_t>(RATE));
+        CHECK_EQ(pipeline.finals[1].source.startSample, static_cast<uint64_t>(RATE * 3 / 2));
+        CHECK_EQ(pipeline.finals[1].source.endSample,
+                 static_cast<uint64_t>(2 * RATE + NoiseSuppressor::LATENCY_SAMPLES));
+    }
+}
+
+TEST(WhisperWrapper, RevisesSegmentsWithPartials) {
+    // Overlapping 2s chunks: each commits the words before the next
+    // chunk's start and shows the rest as a guess
+    MockPipeline pipeline({"so hello there. how", "how are you doing", "doing fine"}, false);
+    pipeline.speak(RATE * 9 / 2);
+    pipeline.waitForDecodes(2);
+    pipeline.whisper.stop();
+
+    std::vector<std::string> partials;
+    for (const Update& update : pipeline.partials) partials.push_back(update.text);
+    const std::vector<std::string> expectedPartials = {"how", "how are you doing"};
+    CHECK(partials == expectedPartials);
+
+    // The sentence end closes the first segment; the last chunk the second
+    CHECK_EQ(pipeline.finals.size(), static_cast<size_t>(2));
+    if (pipeline.finals.size() == 2 && pipeline.partials.size() == 2) {
+        CHECK(pipeline.finals[0].text == "so hello there.");
+        CHECK(pipeline.finals[1].text == "how are you doing fine");
+        const uint64_t first = pipeline.finals[0].source.segment;
+        CHECK_EQ(pipeline.partials[0].source.segment, first + 1);
+        CHECK_EQ(pipeline.partials[1].source.segment, first + 1);
+        CHECK_EQ(pipeline.finals[1].source.segment, first + 1);
+        CHECK_EQ(pipeline.finals[1].source.startSample, static_cast<uint64_t>(0));
+        CHECK_EQ(pipeline.finals[1].source.endSample, static_cast<uint64_t>(RATE * 9 / 2));
+    }
+}
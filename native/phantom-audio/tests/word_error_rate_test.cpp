@@ -0,0 +1,42 @@
+#include "test_harness.h"
+#include "word_error_rate.h"
+
+#include <string>
+#include <vector>
+
+using namespace phantom;
+
+TEST(WordErrorRate, NormalizesCaseAndPunctuation) {
+    const std::vector<std::string> words = normalizeWords("  Hello, WORLD! Don't 'quote' well-known 42.");
+    const std::vector<std::string> expected = {"hello", "world", "don't", "quote", "well", "known", "42"};
+    CHECK(words == expected);
+    CHECK(normalizeWords(" ... ").empty());
+}
+
+TEST(WordErrorRate, CountsEditKinds) {
+    WordErrorCounts same = countWordErrors("The cat sat.", "the cat sat");
+    CHECK_EQ(same.errors(), static_cast<size_t>(0));
+    CHECK_EQ(same.referenceWords, static_cast<size_t>(3));
+    CHECK_NEAR(same.rate(), 0.0, 1e-12);
+
+    WordErrorCounts sub = countWordErrors("the cat sat", "the bat sat");
+    CHECK_EQ(sub.substitutions, static_cast<size_t>(1));
+    CHECK_EQ(sub.errors(), static_cast<size_t>(1));
+
+    WordErrorCounts del = countWordErrors("the cat sat down", "the cat down");
+    CHECK_EQ(del.deletions, static_cast<size_t>(1));
+    CHECK_EQ(del.errors(), static_cast<size_t>(1));
+
+    WordErrorCounts ins = countWordErrors("the cat", "so the cat");
+    CHECK_EQ(ins.insertions, static_cast<size_t>(1));
+    CHECK_NEAR(ins.rate(), 0.5, 1e-12);
+
+    WordErrorCounts empty = countWordErrors("", "");
+    CHECK_NEAR(empty.rate(), 0.0, 1e-12);
+    CHECK_NEAR(countWordErrors("", "noise").rate(), 1.0, 1e-12);
+
+    WordErrorCounts total = sub;
+    total += del;
+    CHECK_EQ(total.referenceWords, static_cast<size_t>(7));
+    CHECK_NEAR(total.rate(), 2.0 / 7.0, 1e-12);
+}
@@ -43,6 +43,8 @@ interface MeetingAssistantIndicatorProps {
 interface TranscriptMessage {
   type: "partial" | "final";
   text: string;
+  segment?: number;
+  keep?: number;
 }
 
 const DEFAULT_AUDIO_PROMPT = `You are a senior software engineer participating in a technical meeting. Based on the conversation transcript below:
@@ -79,6 +81,8 @@ export function MeetingAssistantIndicator({ className = "" }: MeetingAssistantIn
   // Ref to access current transcript in keyboard handler
   const transcriptRef = useRef("");
   const currentPartialRef = useRef("");
+  // Untrimmed partial that the next partial's delta applies to
+  const rawPartialRef = useRef("");
   const audioPromptRef = useRef(DEFAULT_AUDIO_PROMPT);
   const wasCapturingRef = useRef(false);
   const isCapturingRef = useRef(false);
@@ -253,8 +257,17 @@ export function MeetingAssistantIndicator({ className = "" }: MeetingAssistantIn
     };
 
     const handleTranscript = (msg: TranscriptMessage) => {
-      const text = msg.text?.trim() || "";
-      
+      let text: string;
+      if (msg.type === "partial") {
+        // A partial keeps that much of the segment's last one and appends text
+        rawPartialRef.current = rawPartialRef.current.slice(0, msg.keep ?? 0) + (msg.text || "");
+        text = rawPartialRef.current.trim();
+      } else {
+        rawPartialRef.current = "";
+        setCurrentPartial("");
+        text = msg.text?.trim() || "";
+      }
+
       if (!text) return;
       
       // Filter out Whisper's special tokens
@@ -277,7 +290,6 @@ export function MeetingAssistantIndicator({ className = "" }: MeetingAssistantIn
       } else if (msg.type === "final" && text.length > 0) {
         // Only keep the last sentence for display, but accumulate for sending
         setTranscript((prev) => prev + (prev ? " " : "") + text);
-        setCurrentPartial("");
       }
     };
 
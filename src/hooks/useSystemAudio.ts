@@ -10,6 +10,8 @@ import { useState, useEffect, useCallback, useRef } from "react";
 interface TranscriptMessage {
   type: "partial" | "final";
   text: string;
+  segment?: number;
+  keep?: number;
 }
 
 interface TranscriptItem {
@@ -126,7 +128,8 @@ export function useSystemAudio(): UseSystemAudioReturn {
     cleanupFns.push(
       window.systemAudio.onTranscript((msg) => {
         if (msg.type === "partial") {
-          setCurrentPartial(msg.text);
+          // Keep that much of the segment's last partial, then append
+          setCurrentPartial((prev) => prev.slice(0, msg.keep ?? 0) + msg.text);
         } else if (msg.type === "final") {
           setCurrentPartial("");
           if (msg.text.trim()) {
@@ -7,7 +7,34 @@
 
 interface TranscriptMessage {
   type: "partial" | "final";
+  /** Final: the segment's whole text. Partial: what follows the kept prefix */
   text: string;
+  /** Transcript segment; its partials revise it, one final closes it */
+  segment?: number;
+  /** Partial: UTF-16 units of the segment's previous partial to keep before text */
+  keep?: number;
+}
+
+/** Live transcription settings; omitted fields are left unchanged */
+interface TranscriptionConfig {
+  /** Audio per decode, 1000-30000 ms */
+  chunk_ms?: number;
+  /** Decoder threads, 0 = all cores */
+  threads?: number;
+  /** Beam width, 1 = greedy */
+  beam_size?: number;
+  /** Whisper language code, or "auto" to detect it once per session (sending "auto" again re-detects) */
+  language?: string;
+  /** Silence trimming before decoding */
+  vad?: "off" | "normal" | "aggressive";
+  /** Committed tokens prompting the next chunk, 0-224 (0 = none) */
+  context_tokens?: number;
+  /** Time per chunk for re-decoding doubtful results, 0-30000 ms (0 = never) */
+  decode_budget_ms?: number;
+  /** Suppress steady background noise before transcribing (adds 32 ms latency) */
+  denoise?: boolean;
+  /** Digital silence that ends an utterance or FLAC segment, 0-10000 ms; shorter gaps are kept inline */
+  silence_flush_ms?: number;
 }
 
 interface SystemAudioState {
@@ -43,6 +70,12 @@ interface SystemAudioAPI {
     error?: string;
   }>;
   
+  /** Change local transcription settings; applies from the next chunk */
+  configure: (config: TranscriptionConfig) => Promise<{ success: boolean; error?: string }>;
+  
+  /** Subscribe to config confirmations */
+  onConfig: (callback: (config: TranscriptionConfig) => void) => () => void;
+  
   /** Subscribe to transcript events */
   onTranscript: (callback: (msg: TranscriptMessage) => void) => () => void;
   